@@ -63,78 +63,267 @@ static INLINE UINT rdpgfx_server_packet_init_header(wStream* s, UINT16 cmdId, UI
 	return rdpgfx_write_header(s, &header);
 }
 
+/**
+ * Function description
+ * Position in the packet, including the referenced payloads.
+ *
+ * @return position in bytes
+ */
+static INLINE size_t rdpgfx_server_packet_position(const RDPGFX_SERVER_PACKET* packet)
+{
+	return Stream_GetPosition(packet->s) + packet->payloadLength;
+}
+
+/**
+ * Function description
+ * Stream position of a packet position, which must not be inside a payload.
+ *
+ * @return position in the stream
+ */
+static size_t rdpgfx_server_packet_stream_position(const RDPGFX_SERVER_PACKET* packet,
+                                                   size_t position)
+{
+	size_t index;
+	size_t before = 0;
+
+	for (index = 0; index < packet->payloadCount; index++)
+	{
+		const RDPGFX_SERVER_PAYLOAD* payload = &packet->payloads[index];
+
+		if (payload->offset + before >= position)
+			break;
+
+		before += payload->length;
+	}
+
+	return position - before;
+}
+
 /**
  * Function description
  * Complete the rdpgfx packet header.
  *
- * @param s stream
- * @param start saved start pos of the packet in the stream
+ * @param packet packet
+ * @param start saved start pos of the PDU in the packet
  */
-static INLINE BOOL rdpgfx_server_packet_complete_header(wStream* s, size_t start)
+static INLINE BOOL rdpgfx_server_packet_complete_header(RDPGFX_SERVER_PACKET* packet, size_t start)
 {
+	wStream* s = packet->s;
 	const size_t current = Stream_GetPosition(s);
 	const size_t cap = Stream_Capacity(s);
-	if (cap < start + RDPGFX_HEADER_SIZE)
+	const size_t length = rdpgfx_server_packet_position(packet) - start;
+	const size_t header = rdpgfx_server_packet_stream_position(packet, start);
+	if ((cap < header + RDPGFX_HEADER_SIZE) || (length > UINT32_MAX))
 		return FALSE;
 	/* Fill actual length */
-	Stream_SetPosition(s, start + RDPGFX_HEADER_SIZE - sizeof(UINT32));
-	Stream_Write_UINT32(s, current - start); /* pduLength (4 bytes) */
+	Stream_SetPosition(s, header + RDPGFX_HEADER_SIZE - sizeof(UINT32));
+	Stream_Write_UINT32(s, (UINT32)length); /* pduLength (4 bytes) */
 	Stream_SetPosition(s, current);
 	return TRUE;
 }
 
 /**
  * Function description
- * Send the stream for rdpgfx server packet.
- * The packet would be compressed according to [MS-RDPEGFX].
+ * Reference payload data at the current position of the packet instead of copying it.
+ * The data must stay valid until the packet is sent.
+ *
+ * @return 0 on success, otherwise a Win32 error code
+ */
+static UINT rdpgfx_server_packet_write_payload(RDPGFX_SERVER_PACKET* packet, const BYTE* data,
+                                               size_t length)
+{
+	RDPGFX_SERVER_PAYLOAD* payload;
+
+	if (length == 0)
+		return CHANNEL_RC_OK;
+
+	if (packet->payloadCount >= ARRAYSIZE(packet->payloads))
+	{
+		if (!Stream_EnsureRemainingCapacity(packet->s, length))
+			return ERROR_OUTOFMEMORY;
+
+		Stream_Write(packet->s, data, length);
+		return CHANNEL_RC_OK;
+	}
+
+	payload = &packet->payloads[packet->payloadCount++];
+	payload->offset = Stream_GetPosition(packet->s);
+	payload->data = data;
+	payload->length = length;
+	packet->payloadLength += length;
+	return CHANNEL_RC_OK;
+}
+
+/**
+ * Function description
+ * Split the packet into channel buffers: stream ranges interleaved with the payloads.
+ *
+ * @return number of buffers written
+ */
+static size_t rdpgfx_server_packet_buffers(const RDPGFX_SERVER_PACKET* packet,
+                                           WTS_VIRTUAL_CHANNEL_BUFFER* buffers)
+{
+	size_t index;
+	size_t count = 0;
+	size_t offset = 0;
+	const BYTE* data = Stream_Buffer(packet->s);
+
+	for (index = 0; index < packet->payloadCount; index++)
+	{
+		const RDPGFX_SERVER_PAYLOAD* payload = &packet->payloads[index];
+		buffers[count].data = &data[offset];
+		buffers[count++].length = payload->offset - offset;
+		buffers[count].data = payload->data;
+		buffers[count++].length = payload->length;
+		offset = payload->offset;
+	}
+
+	buffers[count].data = &data[offset];
+	buffers[count++].length = Stream_GetPosition(packet->s) - offset;
+	return count;
+}
+
+/**
+ * Function description
+ * Send the rdpgfx server packet.
+ * The packet is framed as uncompressed ZGFX segments according to [MS-RDPEGFX] (the server
+ * side bulk compressor does not compress either). The segment headers are kept apart from
+ * the packet data, which is gathered directly into the channel chunks.
  *
  * @return 0 on success, otherwise a Win32 error code
  */
-static UINT rdpgfx_server_packet_send(RdpgfxServerContext* context, wStream* s)
+static UINT rdpgfx_server_packet_send(RdpgfxServerContext* context, RDPGFX_SERVER_PACKET* packet)
 {
 	UINT error;
-	UINT32 flags = 0;
+	size_t index;
+	size_t count;
+	size_t segment;
+	size_t segmentCount;
 	ULONG written;
-	BYTE* pSrcData = Stream_Buffer(s);
-	UINT32 SrcSize = Stream_GetPosition(s);
-	wStream* fs;
-	/* Allocate new stream with enough capacity. Additional overhead is
-	 * descriptor (1 bytes) + segmentCount (2 bytes) + uncompressedSize (4 bytes)
-	 * + segmentCount * size (4 bytes) */
-	fs = Stream_New(NULL, SrcSize + 7 + (SrcSize / ZGFX_SEGMENTED_MAXSIZE + 1) * 4);
+	size_t source = 0;
+	size_t sourceOffset = 0;
+	size_t total = 0;
+	BYTE* header = NULL;
+	BYTE* pos;
+	WTS_VIRTUAL_CHANNEL_BUFFER* buffers = NULL;
+	WTS_VIRTUAL_CHANNEL_BUFFER sources[2 * ARRAYSIZE(packet->payloads) + 1];
+	const size_t sourceCount = rdpgfx_server_packet_buffers(packet, sources);
+	const BYTE flags = ZGFX_PACKET_COMPR_TYPE_RDP8;
+
+	for (index = 0; index < sourceCount; index++)
+		total += sources[index].length;
+
+	if (total > UINT32_MAX)
+	{
+		error = ERROR_INVALID_DATA;
+		goto out;
+	}
+
+	segmentCount = (total + ZGFX_SEGMENTED_MAXSIZE - 1) / ZGFX_SEGMENTED_MAXSIZE;
+
+	if (segmentCount == 0)
+		segmentCount = 1;
 
-	if (!fs)
+	if (segmentCount > UINT16_MAX)
 	{
-		WLog_ERR(TAG, "Stream_New failed!");
-		error = CHANNEL_RC_NO_MEMORY;
+		error = ERROR_INVALID_DATA;
 		goto out;
 	}
 
-	if (zgfx_compress_to_stream(context->priv->zgfx, fs, pSrcData, SrcSize, &flags) < 0)
+	/* descriptor (1 byte) + segmentCount (2 bytes) + uncompressedSize (4 bytes)
+	 * + segmentCount * (size (4 bytes) + header (1 byte)) */
+	header = malloc(7 + segmentCount * 5);
+	/* each segment has its header and may split a source buffer */
+	buffers = calloc(2 * segmentCount + sourceCount, sizeof(WTS_VIRTUAL_CHANNEL_BUFFER));
+
+	if (!header || !buffers)
 	{
-		WLog_ERR(TAG, "zgfx_compress_to_stream failed!");
-		error = ERROR_INTERNAL_ERROR;
+		WLog_ERR(TAG, "Memory allocation failed!");
+		error = CHANNEL_RC_NO_MEMORY;
 		goto out;
 	}
 
-	if (!WTSVirtualChannelWrite(context->priv->rdpgfx_channel, (PCHAR)Stream_Buffer(fs),
-	                            Stream_GetPosition(fs), &written))
+	pos = header;
+	count = 0;
+
+	if (segmentCount == 1)
 	{
-		WLog_ERR(TAG, "WTSVirtualChannelWrite failed!");
+		*pos++ = ZGFX_SEGMENTED_SINGLE; /* descriptor (1 byte) */
+		*pos++ = flags;                 /* header (1 byte) */
+		buffers[count].data = header;
+		buffers[count++].length = 2;
+	}
+	else
+	{
+		*pos++ = ZGFX_SEGMENTED_MULTIPART;     /* descriptor (1 byte) */
+		Data_Write_UINT16(pos, segmentCount); /* segmentCount (2 bytes) */
+		Data_Write_UINT32(pos + 2, total);    /* uncompressedSize (4 bytes) */
+		pos += 6;
+	}
+
+	for (segment = 0; segment < segmentCount; segment++)
+	{
+		size_t length = MIN(total - segment * ZGFX_SEGMENTED_MAXSIZE, ZGFX_SEGMENTED_MAXSIZE);
+
+		if (segmentCount > 1)
+		{
+			Data_Write_UINT32(pos, length + 1); /* size (4 bytes) */
+			pos[4] = flags;                     /* header (1 byte) */
+
+			if (segment == 0)
+			{
+				buffers[count].data = header;
+				buffers[count++].length = 12;
+			}
+			else
+			{
+				buffers[count].data = pos;
+				buffers[count++].length = 5;
+			}
+
+			pos += 5;
+		}
+
+		while (length > 0)
+		{
+			const WTS_VIRTUAL_CHANNEL_BUFFER* src = &sources[source];
+			const size_t part = MIN(length, src->length - sourceOffset);
+			buffers[count].data = &src->data[sourceOffset];
+			buffers[count++].length = part;
+			length -= part;
+			sourceOffset += part;
+
+			if (sourceOffset == src->length)
+			{
+				source++;
+				sourceOffset = 0;
+			}
+		}
+	}
+
+	if (!FreeRDP_WTSVirtualChannelWriteGather(context->priv->rdpgfx_channel, buffers, count,
+	                                          &written))
+	{
+		WLog_ERR(TAG, "FreeRDP_WTSVirtualChannelWriteGather failed!");
 		error = ERROR_INTERNAL_ERROR;
 		goto out;
 	}
 
-	if (written < Stream_GetPosition(fs))
+	/* the packet stream was written by the PDU writers, the rest by the channel */
+	context->priv->bytesCopied += Stream_GetPosition(packet->s) + written;
+
+	if (written < total + (size_t)(pos - header))
 	{
 		WLog_WARN(TAG, "Unexpected bytes written: %" PRIu32 "/%" PRIuz "", written,
-		          Stream_GetPosition(fs));
+		          total + (size_t)(pos - header));
 	}
 
 	error = CHANNEL_RC_OK;
 out:
-	Stream_Free(fs, TRUE);
-	Stream_Free(s, TRUE);
+	free(buffers);
+	free(header);
+	Stream_Free(packet->s, TRUE);
+	packet->s = NULL;
 	return error;
 }
 
@@ -185,9 +374,11 @@ error:
  */
 static INLINE UINT rdpgfx_server_single_packet_send(RdpgfxServerContext* context, wStream* s)
 {
+	RDPGFX_SERVER_PACKET packet = { 0 };
+	packet.s = s;
 	/* Fill actual length */
-	rdpgfx_server_packet_complete_header(s, 0);
-	return rdpgfx_server_packet_send(context, s);
+	rdpgfx_server_packet_complete_header(&packet, 0);
+	return rdpgfx_server_packet_send(context, &packet);
 }
 
 /**
@@ -441,16 +632,16 @@ static UINT rdpgfx_send_end_frame_pdu(RdpgfxServerContext* context, const RDPGFX
  */
 static INLINE UINT32 rdpgfx_estimate_h264_avc420(const RDPGFX_AVC420_BITMAP_STREAM* havc420)
 {
-	/* H264 metadata + H264 stream. See rdpgfx_write_h264_avc420 */
+	/* H264 metadata, the H264 stream is referenced. See rdpgfx_write_h264_avc420 */
 	return sizeof(UINT32) /* numRegionRects */
 	       + 10           /* regionRects + quantQualityVals */
-	             * havc420->meta.numRegionRects +
-	       havc420->length;
+	             * havc420->meta.numRegionRects;
 }
 
 /**
  * Function description
- * Estimate surface command packet size in stream without header
+ * Estimate surface command packet size in stream without header.
+ * The bitmap data is referenced by the packet and not part of the stream.
  *
  * @return estimated size
  */
@@ -465,7 +656,7 @@ static INLINE UINT32 rdpgfx_estimate_surface_command(const RDPGFX_SURFACE_COMMAN
 	{
 		case RDPGFX_CODECID_CAPROGRESSIVE:
 		case RDPGFX_CODECID_CAPROGRESSIVE_V2:
-			return RDPGFX_WIRE_TO_SURFACE_PDU_2_SIZE + cmd->length;
+			return RDPGFX_WIRE_TO_SURFACE_PDU_2_SIZE;
 
 		case RDPGFX_CODECID_AVC420:
 			havc420 = (RDPGFX_AVC420_BITMAP_STREAM*)cmd->extra;
@@ -489,7 +680,7 @@ static INLINE UINT32 rdpgfx_estimate_surface_command(const RDPGFX_SURFACE_COMMAN
 			return RDPGFX_WIRE_TO_SURFACE_PDU_1_SIZE + h264Size;
 
 		default:
-			return RDPGFX_WIRE_TO_SURFACE_PDU_1_SIZE + cmd->length;
+			return RDPGFX_WIRE_TO_SURFACE_PDU_1_SIZE;
 	}
 }
 
@@ -557,21 +748,18 @@ static UINT rdpgfx_write_h264_metablock(wStream* s, const RDPGFX_H264_METABLOCK*
  *
  * @return 0 on success, otherwise a Win32 error code
  */
-static INLINE UINT rdpgfx_write_h264_avc420(wStream* s, RDPGFX_AVC420_BITMAP_STREAM* havc420)
+static INLINE UINT rdpgfx_write_h264_avc420(RDPGFX_SERVER_PACKET* packet,
+                                            RDPGFX_AVC420_BITMAP_STREAM* havc420)
 {
 	UINT error = CHANNEL_RC_OK;
 
-	if ((error = rdpgfx_write_h264_metablock(s, &(havc420->meta))))
+	if ((error = rdpgfx_write_h264_metablock(packet->s, &(havc420->meta))))
 	{
 		WLog_ERR(TAG, "rdpgfx_write_h264_metablock failed with error %" PRIu32 "!", error);
 		return error;
 	}
 
-	if (!Stream_EnsureRemainingCapacity(s, havc420->length))
-		return ERROR_OUTOFMEMORY;
-
-	Stream_Write(s, havc420->data, havc420->length);
-	return error;
+	return rdpgfx_server_packet_write_payload(packet, havc420->data, havc420->length);
 }
 
 /**
@@ -581,12 +769,15 @@ static INLINE UINT rdpgfx_write_h264_avc420(wStream* s, RDPGFX_AVC420_BITMAP_STR
  *
  * @return 0 on success, otherwise a Win32 error code
  */
-static UINT rdpgfx_write_surface_command(wStream* s, const RDPGFX_SURFACE_COMMAND* cmd)
+static UINT rdpgfx_write_surface_command(RDPGFX_SERVER_PACKET* packet,
+                                         const RDPGFX_SURFACE_COMMAND* cmd)
 {
+	wStream* s = packet->s;
 	UINT error = CHANNEL_RC_OK;
 	RDPGFX_AVC420_BITMAP_STREAM* havc420 = NULL;
 	RDPGFX_AVC444_BITMAP_STREAM* havc444 = NULL;
-	UINT32 bitmapDataStart = 0;
+	size_t bitmapDataStart = 0;
+	size_t bitmapDataEnd = 0;
 	UINT32 bitmapDataLength = 0;
 	UINT8 pixelFormat = 0;
 
@@ -608,7 +799,7 @@ static UINT rdpgfx_write_surface_command(wStream* s, const RDPGFX_SURFACE_COMMAN
 	if (cmd->codecId == RDPGFX_CODECID_CAPROGRESSIVE ||
 	    cmd->codecId == RDPGFX_CODECID_CAPROGRESSIVE_V2)
 	{
-		if (!Stream_EnsureRemainingCapacity(s, 13 + cmd->length))
+		if (!Stream_EnsureRemainingCapacity(s, 13))
 			return ERROR_INTERNAL_ERROR;
 		/* Write RDPGFX_CMDID_WIRETOSURFACE_2 format for CAPROGRESSIVE */
 		Stream_Write_UINT16(s, cmd->surfaceId); /* surfaceId (2 bytes) */
@@ -616,7 +807,7 @@ static UINT rdpgfx_write_surface_command(wStream* s, const RDPGFX_SURFACE_COMMAN
 		Stream_Write_UINT32(s, cmd->contextId); /* codecContextId (4 bytes) */
 		Stream_Write_UINT8(s, pixelFormat);     /* pixelFormat (1 byte) */
 		Stream_Write_UINT32(s, cmd->length);    /* bitmapDataLength (4 bytes) */
-		Stream_Write(s, cmd->data, cmd->length);
+		error = rdpgfx_server_packet_write_payload(packet, cmd->data, cmd->length);
 	}
 	else
 	{
@@ -631,12 +822,12 @@ static UINT rdpgfx_write_surface_command(wStream* s, const RDPGFX_SURFACE_COMMAN
 		Stream_Write_UINT16(s, cmd->right);     /* right (2 bytes) */
 		Stream_Write_UINT16(s, cmd->bottom);    /* bottom (2 bytes) */
 		Stream_Write_UINT32(s, cmd->length);    /* bitmapDataLength (4 bytes) */
-		bitmapDataStart = Stream_GetPosition(s);
+		bitmapDataStart = rdpgfx_server_packet_position(packet);
 
 		if (cmd->codecId == RDPGFX_CODECID_AVC420)
 		{
 			havc420 = (RDPGFX_AVC420_BITMAP_STREAM*)cmd->extra;
-			error = rdpgfx_write_h264_avc420(s, havc420);
+			error = rdpgfx_write_h264_avc420(packet, havc420);
 
 			if (error != CHANNEL_RC_OK)
 			{
@@ -653,7 +844,7 @@ static UINT rdpgfx_write_surface_command(wStream* s, const RDPGFX_SURFACE_COMMAN
 				return ERROR_INTERNAL_ERROR;
 			Stream_Write_UINT32(s, havc444->cbAvc420EncodedBitstream1 | (havc444->LC << 30UL));
 			/* avc420EncodedBitstream1 */
-			error = rdpgfx_write_h264_avc420(s, havc420);
+			error = rdpgfx_write_h264_avc420(packet, havc420);
 
 			if (error != CHANNEL_RC_OK)
 			{
@@ -665,7 +856,7 @@ static UINT rdpgfx_write_surface_command(wStream* s, const RDPGFX_SURFACE_COMMAN
 			if (havc444->LC == 0)
 			{
 				havc420 = &(havc444->bitstream[1]);
-				error = rdpgfx_write_h264_avc420(s, havc420);
+				error = rdpgfx_write_h264_avc420(packet, havc420);
 
 				if (error != CHANNEL_RC_OK)
 				{
@@ -676,19 +867,19 @@ static UINT rdpgfx_write_surface_command(wStream* s, const RDPGFX_SURFACE_COMMAN
 		}
 		else
 		{
-			if (!Stream_EnsureRemainingCapacity(s, cmd->length))
-				return ERROR_INTERNAL_ERROR;
-			Stream_Write(s, cmd->data, cmd->length);
+			error = rdpgfx_server_packet_write_payload(packet, cmd->data, cmd->length);
+
+			if (error != CHANNEL_RC_OK)
+				return error;
 		}
 
 		/* Fill actual bitmap data length */
-		bitmapDataLength = Stream_GetPosition(s) - bitmapDataStart;
-		Stream_SetPosition(s, bitmapDataStart - sizeof(UINT32));
-		if (!Stream_EnsureRemainingCapacity(s, 4))
-			return ERROR_INTERNAL_ERROR;
+		bitmapDataEnd = Stream_GetPosition(s);
+		bitmapDataLength = rdpgfx_server_packet_position(packet) - bitmapDataStart;
+		Stream_SetPosition(s, rdpgfx_server_packet_stream_position(packet, bitmapDataStart) -
+		                          sizeof(UINT32));
 		Stream_Write_UINT32(s, bitmapDataLength); /* bitmapDataLength (4 bytes) */
-		if (!Stream_SafeSeek(s, bitmapDataLength))
-			return ERROR_INTERNAL_ERROR;
+		Stream_SetPosition(s, bitmapDataEnd);
 	}
 
 	return error;
@@ -705,17 +896,17 @@ static UINT rdpgfx_send_surface_command(RdpgfxServerContext* context,
                                         const RDPGFX_SURFACE_COMMAND* cmd)
 {
 	UINT error = CHANNEL_RC_OK;
-	wStream* s;
-	s = rdpgfx_server_single_packet_new(rdpgfx_surface_command_cmdid(cmd),
-	                                    rdpgfx_estimate_surface_command(cmd));
+	RDPGFX_SERVER_PACKET packet = { 0 };
+	packet.s = rdpgfx_server_single_packet_new(rdpgfx_surface_command_cmdid(cmd),
+	                                           rdpgfx_estimate_surface_command(cmd));
 
-	if (!s)
+	if (!packet.s)
 	{
 		WLog_ERR(TAG, "rdpgfx_server_single_packet_new failed!");
 		return CHANNEL_RC_NO_MEMORY;
 	}
 
-	error = rdpgfx_write_surface_command(s, cmd);
+	error = rdpgfx_write_surface_command(&packet, cmd);
 
 	if (error != CHANNEL_RC_OK)
 	{
@@ -723,9 +914,15 @@ static UINT rdpgfx_send_surface_command(RdpgfxServerContext* context,
 		goto error;
 	}
 
-	return rdpgfx_server_single_packet_send(context, s);
+	if (!rdpgfx_server_packet_complete_header(&packet, 0))
+	{
+		error = ERROR_INTERNAL_ERROR;
+		goto error;
+	}
+
+	return rdpgfx_server_packet_send(context, &packet);
 error:
-	Stream_Free(s, TRUE);
+	Stream_Free(packet.s, TRUE);
 	return error;
 }
 
@@ -745,7 +942,10 @@ static UINT rdpgfx_send_surface_frame_command(RdpgfxServerContext* context,
 {
 	UINT error = CHANNEL_RC_OK;
 	wStream* s;
-	UINT32 position = 0;
+	size_t frameLength;
+	size_t bytesCopied;
+	RDPGFX_SERVER_PACKET packet = { 0 };
+	size_t position = 0;
 	UINT32 size = rdpgfx_pdu_length(rdpgfx_estimate_surface_command(cmd));
 
 	if (startFrame)
@@ -766,10 +966,12 @@ static UINT rdpgfx_send_surface_frame_command(RdpgfxServerContext* context,
 		return CHANNEL_RC_NO_MEMORY;
 	}
 
+	packet.s = s;
+
 	/* Write start frame if exists */
 	if (startFrame)
 	{
-		position = Stream_GetPosition(s);
+		position = rdpgfx_server_packet_position(&packet);
 		error = rdpgfx_server_packet_init_header(s, RDPGFX_CMDID_STARTFRAME, 0);
 
 		if (error != CHANNEL_RC_OK)
@@ -779,12 +981,12 @@ static UINT rdpgfx_send_surface_frame_command(RdpgfxServerContext* context,
 		}
 
 		if (!rdpgfx_write_start_frame_pdu(s, startFrame) ||
-		    !rdpgfx_server_packet_complete_header(s, position))
+		    !rdpgfx_server_packet_complete_header(&packet, position))
 			goto error;
 	}
 
 	/* Write RDPGFX_CMDID_WIRETOSURFACE_1 or RDPGFX_CMDID_WIRETOSURFACE_2 */
-	position = Stream_GetPosition(s);
+	position = rdpgfx_server_packet_position(&packet);
 	error = rdpgfx_server_packet_init_header(s, rdpgfx_surface_command_cmdid(cmd),
 	                                         0); // Actual length will be filled later
 
@@ -794,7 +996,7 @@ static UINT rdpgfx_send_surface_frame_command(RdpgfxServerContext* context,
 		goto error;
 	}
 
-	error = rdpgfx_write_surface_command(s, cmd);
+	error = rdpgfx_write_surface_command(&packet, cmd);
 
 	if (error != CHANNEL_RC_OK)
 	{
@@ -802,13 +1004,13 @@ static UINT rdpgfx_send_surface_frame_command(RdpgfxServerContext* context,
 		goto error;
 	}
 
-	if (!rdpgfx_server_packet_complete_header(s, position))
+	if (!rdpgfx_server_packet_complete_header(&packet, position))
 		goto error;
 
 	/* Write end frame if exists */
 	if (endFrame)
 	{
-		position = Stream_GetPosition(s);
+		position = rdpgfx_server_packet_position(&packet);
 		error = rdpgfx_server_packet_init_header(s, RDPGFX_CMDID_ENDFRAME, 0);
 
 		if (error != CHANNEL_RC_OK)
@@ -818,11 +1020,16 @@ static UINT rdpgfx_send_surface_frame_command(RdpgfxServerContext* context,
 		}
 
 		if (!rdpgfx_write_end_frame_pdu(s, endFrame) ||
-		    !rdpgfx_server_packet_complete_header(s, position))
+		    !rdpgfx_server_packet_complete_header(&packet, position))
 			goto error;
 	}
 
-	return rdpgfx_server_packet_send(context, s);
+	frameLength = rdpgfx_server_packet_position(&packet);
+	bytesCopied = context->priv->bytesCopied;
+	error = rdpgfx_server_packet_send(context, &packet);
+	WLog_VRB(TAG, "surface frame: %" PRIuz " bytes, %" PRIuz " bytes copied", frameLength,
+	         context->priv->bytesCopied - bytesCopied);
+	return error;
 error:
 	Stream_Free(s, TRUE);
 	return error;
@@ -23,6 +23,23 @@
 #include <freerdp/server/rdpgfx.h>
 #include <freerdp/codec/zgfx.h>
 
+/* Payload referenced by a packet, it follows the stream data up to offset */
+typedef struct
+{
+	size_t offset;
+	const BYTE* data;
+	size_t length;
+} RDPGFX_SERVER_PAYLOAD;
+
+/* A packet is the PDU stream with payloads (the codec output) referenced at their positions */
+typedef struct
+{
+	wStream* s;
+	size_t payloadLength;
+	size_t payloadCount;
+	RDPGFX_SERVER_PAYLOAD payloads[4];
+} RDPGFX_SERVER_PACKET;
+
 struct s_rdpgfx_server_private
 {
 	ZGFX_CONTEXT* zgfx;
@@ -35,6 +52,7 @@ struct s_rdpgfx_server_private
 	wStream* input_stream;
 	BOOL isOpened;
 	BOOL isReady;
+	size_t bytesCopied;
 };
 
 #endif /* FREERDP_CHANNEL_RDPGFX_SERVER_MAIN_H */
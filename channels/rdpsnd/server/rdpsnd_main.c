@@ -29,6 +29,7 @@
 #include <winpr/assert.h>
 #include <winpr/print.h>
 #include <winpr/stream.h>
+#include <winpr/sysinfo.h>
 
 #include <freerdp/channels/log.h>
 
@@ -671,7 +672,7 @@ static UINT rdpsnd_server_send_audio_pdu(RdpsndServerContext* context, UINT16 wT
 
 	if (context->clientVersion >= CHANNEL_VERSION_WIN_8)
 		return rdpsnd_server_send_wave2_pdu(context, context->selected_client_format, src, length,
-		                                    FALSE, wTimestamp, wTimestamp);
+		                                    FALSE, wTimestamp, (UINT32)GetTickCount64());
 	else
 		return rdpsnd_server_send_wave_pdu(context, wTimestamp);
 }
@@ -62,7 +62,7 @@ static UINT urb_write_completion(IUDEVICE* pdev, GENERIC_CHANNEL_CALLBACK* callb
 
 	if (Stream_Capacity(out) < OutputBufferSize + 36)
 	{
-		Stream_Free(out, TRUE);
+		Stream_Release(out);
 		return ERROR_INVALID_PARAMETER;
 	}
 
@@ -88,16 +88,17 @@ static UINT urb_write_completion(IUDEVICE* pdev, GENERIC_CHANNEL_CALLBACK* callb
 	if (!noAck)
 		return stream_write_and_free(callback->plugin, callback->channel, out);
 	else
-		Stream_Free(out, TRUE);
+		Stream_Release(out);
 
 	return ERROR_SUCCESS;
 }
 
-static wStream* urb_create_iocompletion(UINT32 InterfaceField, UINT32 MessageId, UINT32 RequestId,
+static wStream* urb_create_iocompletion(GENERIC_CHANNEL_CALLBACK* callback, UINT32 InterfaceField,
+                                        UINT32 MessageId, UINT32 RequestId,
                                         UINT32 OutputBufferSize)
 {
 	const UINT32 InterfaceId = (STREAM_ID_PROXY << 30) | (InterfaceField & 0x3FFFFFFF);
-	wStream* out = Stream_New(NULL, OutputBufferSize + 28);
+	wStream* out = urbdrc_stream_new(callback->plugin, OutputBufferSize + 28);
 
 	if (!out)
 		return NULL;
@@ -242,7 +243,8 @@ static UINT urbdrc_process_io_control(IUDEVICE* pdev, GENERIC_CHANNEL_CALLBACK*
 	Stream_Read_UINT32(s, OutputBufferSize);
 	Stream_Read_UINT32(s, RequestId);
 	InterfaceId = ((STREAM_ID_PROXY << 30) | pdev->get_ReqCompletion(pdev));
-	out = urb_create_iocompletion(InterfaceId, MessageId, RequestId, OutputBufferSize + 4);
+	out =
+	    urb_create_iocompletion(callback, InterfaceId, MessageId, RequestId, OutputBufferSize + 4);
 
 	if (!out)
 		return ERROR_OUTOFMEMORY;
@@ -268,7 +270,7 @@ static UINT urbdrc_process_io_control(IUDEVICE* pdev, GENERIC_CHANNEL_CALLBACK*
 			{
 				if (!Stream_SafeSeek(out, OutputBufferSize))
 				{
-					Stream_Free(out, TRUE);
+					Stream_Release(out);
 					return ERROR_INVALID_DATA;
 				}
 
@@ -297,7 +299,7 @@ static UINT urbdrc_process_io_control(IUDEVICE* pdev, GENERIC_CHANNEL_CALLBACK*
 			WLog_Print(urbdrc->log, WLOG_DEBUG,
 			           "urbdrc_process_io_control: unknown IoControlCode 0x%" PRIX32 "",
 			           IoControlCode);
-			Stream_Free(out, TRUE);
+			Stream_Release(out);
 			return ERROR_INVALID_OPERATION;
 	}
 
@@ -330,7 +332,7 @@ static UINT urbdrc_process_internal_io_control(IUDEVICE* pdev, GENERIC_CHANNEL_C
 	// TODO: Implement control code.
 	/** Fixme: Currently this is a FALSE bustime... */
 	frames = GetTickCount();
-	out = urb_create_iocompletion(InterfaceId, MessageId, RequestId, 4);
+	out = urb_create_iocompletion(callback, InterfaceId, MessageId, RequestId, 4);
 
 	if (!out)
 		return ERROR_OUTOFMEMORY;
@@ -369,7 +371,7 @@ static UINT urbdrc_process_query_device_text(IUDEVICE* pdev, GENERIC_CHANNEL_CAL
 	if (bufferSize != 0)
 		out_size += 2;
 
-	out = Stream_New(NULL, out_size);
+	out = urbdrc_stream_new(callback->plugin, out_size);
 
 	if (!out)
 		return ERROR_OUTOFMEMORY;
@@ -468,7 +470,7 @@ static UINT urb_select_configuration(IUDEVICE* pdev, GENERIC_CHANNEL_CALLBACK* c
 	else
 		out_size = 44;
 
-	out = Stream_New(NULL, out_size);
+	out = urbdrc_stream_new(callback->plugin, out_size);
 
 	if (!out)
 		return ERROR_OUTOFMEMORY;
@@ -510,7 +512,7 @@ static UINT urb_select_configuration(IUDEVICE* pdev, GENERIC_CHANNEL_CALLBACK* c
 	if (!noAck)
 		return stream_write_and_free(callback->plugin, callback->channel, out);
 	else
-		Stream_Free(out, TRUE);
+		Stream_Release(out);
 
 	return ERROR_SUCCESS;
 }
@@ -576,7 +578,7 @@ static UINT urb_select_interface(IUDEVICE* pdev, GENERIC_CHANNEL_CALLBACK* callb
 	MsInterface = MsConfig->MsInterfaces[InterfaceNumber];
 	interface_size = 16 + (MsInterface->NumberOfPipes * 20);
 	out_size = 36 + interface_size;
-	out = Stream_New(NULL, out_size);
+	out = urbdrc_stream_new(callback->plugin, out_size);
 
 	if (!out)
 		return ERROR_OUTOFMEMORY;
@@ -599,7 +601,7 @@ static UINT urb_select_interface(IUDEVICE* pdev, GENERIC_CHANNEL_CALLBACK* callb
 	if (!noAck)
 		return stream_write_and_free(callback->plugin, callback->channel, out);
 	else
-		Stream_Free(out, TRUE);
+		Stream_Release(out);
 
 	return ERROR_SUCCESS;
 }
@@ -666,7 +668,7 @@ static UINT urb_control_transfer(IUDEVICE* pdev, GENERIC_CHANNEL_CALLBACK* callb
 	}
 
 	out_size = 36 + OutputBufferSize;
-	out = Stream_New(NULL, out_size);
+	out = urbdrc_stream_new(callback->plugin, out_size);
 
 	if (!out)
 		return ERROR_OUTOFMEMORY;
@@ -684,7 +686,7 @@ static UINT urb_control_transfer(IUDEVICE* pdev, GENERIC_CHANNEL_CALLBACK* callb
 	                            Timeout))
 	{
 		WLog_Print(urbdrc->log, WLOG_ERROR, "control_transfer failed");
-		Stream_Free(out, TRUE);
+		Stream_Release(out);
 		return ERROR_INTERNAL_ERROR;
 	}
 
@@ -701,7 +703,7 @@ static void urb_bulk_transfer_cb(IUDEVICE* pdev, GENERIC_CHANNEL_CALLBACK* callb
 		urb_write_completion(pdev, callback, noAck, out, InterfaceId, MessageId, RequestId, status,
 		                     OutputBufferSize);
 	else
-		Stream_Free(out, TRUE);
+		Stream_Release(out);
 }
 
 static UINT urb_bulk_or_interrupt_transfer(IUDEVICE* pdev, GENERIC_CHANNEL_CALLBACK* callback,
@@ -857,7 +859,7 @@ static UINT urb_control_descriptor_request(IUDEVICE* pdev, GENERIC_CHANNEL_CALLB
 	}
 
 	out_size = 36ULL + OutputBufferSize;
-	out = Stream_New(NULL, out_size);
+	out = urbdrc_stream_new(callback->plugin, out_size);
 
 	if (!out)
 		return ERROR_OUTOFMEMORY;
@@ -891,7 +893,7 @@ static UINT urb_control_descriptor_request(IUDEVICE* pdev, GENERIC_CHANNEL_CALLB
 	                            &OutputBufferSize, Stream_Pointer(out), 1000))
 	{
 		WLog_Print(urbdrc->log, WLOG_ERROR, "get_descriptor failed");
-		Stream_Free(out, TRUE);
+		Stream_Release(out);
 		return ERROR_INTERNAL_ERROR;
 	}
 
@@ -937,7 +939,7 @@ static UINT urb_control_get_status_request(IUDEVICE* pdev, GENERIC_CHANNEL_CALLB
 	if (OutputBufferSize > UINT32_MAX - 36)
 		return ERROR_INVALID_DATA;
 	out_size = 36ULL + OutputBufferSize;
-	out = Stream_New(NULL, out_size);
+	out = urbdrc_stream_new(callback->plugin, out_size);
 
 	if (!out)
 		return ERROR_OUTOFMEMORY;
@@ -950,7 +952,7 @@ static UINT urb_control_get_status_request(IUDEVICE* pdev, GENERIC_CHANNEL_CALLB
 	                            1000))
 	{
 		WLog_Print(urbdrc->log, WLOG_ERROR, "control_transfer failed");
-		Stream_Free(out, TRUE);
+		Stream_Release(out);
 		return ERROR_INTERNAL_ERROR;
 	}
 
@@ -1001,7 +1003,7 @@ static UINT urb_control_vendor_or_class_request(IUDEVICE* pdev, GENERIC_CHANNEL_
 	}
 
 	out_size = 36ULL + OutputBufferSize;
-	out = Stream_New(NULL, out_size);
+	out = urbdrc_stream_new(callback->plugin, out_size);
 
 	if (!out)
 		return ERROR_OUTOFMEMORY;
@@ -1033,7 +1035,7 @@ static UINT urb_control_vendor_or_class_request(IUDEVICE* pdev, GENERIC_CHANNEL_
 	                            &usbd_status, &OutputBufferSize, Stream_Pointer(out), 2000))
 	{
 		WLog_Print(urbdrc->log, WLOG_ERROR, "control_transfer failed");
-		Stream_Free(out, TRUE);
+		Stream_Release(out);
 		return ERROR_INTERNAL_ERROR;
 	}
 
@@ -1091,7 +1093,7 @@ static UINT urb_os_feature_descriptor_request(IUDEVICE* pdev, GENERIC_CHANNEL_CA
 
 	InterfaceId = ((STREAM_ID_PROXY << 30) | pdev->get_ReqCompletion(pdev));
 	out_size = 36ULL + OutputBufferSize;
-	out = Stream_New(NULL, out_size);
+	out = urbdrc_stream_new(callback->plugin, out_size);
 
 	if (!out)
 		return ERROR_OUTOFMEMORY;
@@ -1196,7 +1198,7 @@ static UINT urb_pipe_request(IUDEVICE* pdev, GENERIC_CHANNEL_CALLBACK* callback,
 
 	/** send data */
 	out_size = 36;
-	out = Stream_New(NULL, out_size);
+	out = urbdrc_stream_new(callback->plugin, out_size);
 
 	if (!out)
 		return ERROR_OUTOFMEMORY;
@@ -1239,7 +1241,7 @@ static UINT urb_get_current_frame_number(IUDEVICE* pdev, GENERIC_CHANNEL_CALLBAC
 	/** Fixme: Need to fill actual frame number!!*/
 	dummy_frames = GetTickCount();
 	out_size = 40;
-	out = Stream_New(NULL, out_size);
+	out = urbdrc_stream_new(callback->plugin, out_size);
 
 	if (!out)
 		return ERROR_OUTOFMEMORY;
@@ -1261,7 +1263,7 @@ static UINT urb_get_current_frame_number(IUDEVICE* pdev, GENERIC_CHANNEL_CALLBAC
 	if (!noAck)
 		return stream_write_and_free(callback->plugin, callback->channel, out);
 	else
-		Stream_Free(out, TRUE);
+		Stream_Release(out);
 
 	return ERROR_SUCCESS;
 }
@@ -1302,7 +1304,7 @@ static UINT urb_control_get_configuration_request(IUDEVICE* pdev,
 	if (OutputBufferSize > UINT32_MAX - 36)
 		return ERROR_INVALID_DATA;
 	out_size = 36ULL + OutputBufferSize;
-	out = Stream_New(NULL, out_size);
+	out = urbdrc_stream_new(callback->plugin, out_size);
 
 	if (!out)
 		return ERROR_OUTOFMEMORY;
@@ -1315,7 +1317,7 @@ static UINT urb_control_get_configuration_request(IUDEVICE* pdev,
 	                            0, 0, &usbd_status, &OutputBufferSize, Stream_Pointer(out), 1000))
 	{
 		WLog_Print(urbdrc->log, WLOG_DEBUG, "control_transfer failed");
-		Stream_Free(out, TRUE);
+		Stream_Release(out);
 		return ERROR_INTERNAL_ERROR;
 	}
 
@@ -1361,7 +1363,7 @@ static UINT urb_control_get_interface_request(IUDEVICE* pdev, GENERIC_CHANNEL_CA
 	if (OutputBufferSize > UINT32_MAX - 36)
 		return ERROR_INVALID_DATA;
 	out_size = 36ULL + OutputBufferSize;
-	out = Stream_New(NULL, out_size);
+	out = urbdrc_stream_new(callback->plugin, out_size);
 
 	if (!out)
 		return ERROR_OUTOFMEMORY;
@@ -1373,7 +1375,7 @@ static UINT urb_control_get_interface_request(IUDEVICE* pdev, GENERIC_CHANNEL_CA
 	        0, InterfaceNr, &usbd_status, &OutputBufferSize, Stream_Pointer(out), 1000))
 	{
 		WLog_Print(urbdrc->log, WLOG_DEBUG, "control_transfer failed");
-		Stream_Free(out, TRUE);
+		Stream_Release(out);
 		return ERROR_INTERNAL_ERROR;
 	}
 
@@ -1423,7 +1425,7 @@ static UINT urb_control_feature_request(IUDEVICE* pdev, GENERIC_CHANNEL_CALLBACK
 			break;
 	}
 
-	out = Stream_New(NULL, 36ULL + OutputBufferSize);
+	out = urbdrc_stream_new(callback->plugin, 36ULL + OutputBufferSize);
 
 	if (!out)
 		return ERROR_OUTOFMEMORY;
@@ -1459,7 +1461,7 @@ static UINT urb_control_feature_request(IUDEVICE* pdev, GENERIC_CHANNEL_CALLBACK
 		default:
 			WLog_Print(urbdrc->log, WLOG_ERROR,
 			           "urb_control_feature_request: Error Command 0x%02" PRIx8 "", command);
-			Stream_Free(out, TRUE);
+			Stream_Release(out);
 			return ERROR_INTERNAL_ERROR;
 	}
 
@@ -1467,7 +1469,7 @@ static UINT urb_control_feature_request(IUDEVICE* pdev, GENERIC_CHANNEL_CALLBACK
 	                            Index, &usbd_status, &OutputBufferSize, Stream_Pointer(out), 1000))
 	{
 		WLog_Print(urbdrc->log, WLOG_DEBUG, "feature control transfer failed");
-		Stream_Free(out, TRUE);
+		Stream_Release(out);
 		return ERROR_INTERNAL_ERROR;
 	}
 
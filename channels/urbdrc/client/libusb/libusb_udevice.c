@@ -212,7 +212,7 @@ static ASYNC_TRANSFER_USER_DATA* async_transfer_user_data_new(IUDEVICE* idev, UI
 	if (!user_data)
 		return NULL;
 
-	user_data->data = Stream_New(NULL, offset + BufferSize + packetSize);
+	user_data->data = urbdrc_stream_new(&pdev->urbdrc->iface, offset + BufferSize + packetSize);
 
 	if (!user_data->data)
 	{
@@ -241,7 +241,8 @@ static void async_transfer_user_data_free(ASYNC_TRANSFER_USER_DATA* user_data)
 {
 	if (user_data)
 	{
-		Stream_Free(user_data->data, TRUE);
+		if (user_data->data)
+			Stream_Release(user_data->data);
 		free(user_data);
 	}
 }
@@ -26,6 +26,7 @@
 
 #include <winpr/pool.h>
 #include <winpr/print.h>
+#include <winpr/collections.h>
 
 #include <winpr/crt.h>
 #include <winpr/synch.h>
@@ -153,7 +154,7 @@ static UINT urbdrc_process_capability_request(GENERIC_CHANNEL_CALLBACK* callback
 
 	InterfaceId = ((STREAM_ID_NONE << 30) | CAPABILITIES_NEGOTIATOR);
 	out_size = 16;
-	out = Stream_New(NULL, out_size);
+	out = urbdrc_stream_new(callback->plugin, out_size);
 
 	if (!out)
 		return ERROR_OUTOFMEMORY;
@@ -205,7 +206,7 @@ static UINT urbdrc_process_channel_create(GENERIC_CHANNEL_CALLBACK* callback, wS
 
 	InterfaceId = ((STREAM_ID_PROXY << 30) | CLIENT_CHANNEL_NOTIFICATION);
 	out_size = 24;
-	out = Stream_New(NULL, out_size);
+	out = urbdrc_stream_new(callback->plugin, out_size);
 
 	if (!out)
 		return ERROR_OUTOFMEMORY;
@@ -223,7 +224,7 @@ static UINT urdbrc_send_virtual_channel_add(IWTSPlugin* plugin, IWTSVirtualChann
                                             UINT32 MessageId)
 {
 	const UINT32 InterfaceId = ((STREAM_ID_PROXY << 30) | CLIENT_DEVICE_SINK);
-	wStream* out = Stream_New(NULL, 12);
+	wStream* out = urbdrc_stream_new(plugin, 12);
 
 	if (!out)
 		return ERROR_OUTOFMEMORY;
@@ -312,7 +313,7 @@ static UINT urdbrc_send_usb_device_add(GENERIC_CHANNEL_CALLBACK* callback, IUDEV
 	size += (InstanceIdLen + 1) * 2 + (HardwareIdsLen[0] + 1) * 2 + 4 +
 	        (HardwareIdsLen[1] + 1) * 2 + 2 + 4 + (cchCompatIds)*2 + (ContainerIdLen + 1) * 2 + 4 +
 	        28;
-	out = Stream_New(NULL, size);
+	out = urbdrc_stream_new(callback->plugin, size);
 
 	if (!out)
 		return ERROR_OUTOFMEMORY;
@@ -737,6 +738,8 @@ static UINT urbdrc_plugin_terminated(IWTSPlugin* pPlugin)
 		udevman = NULL;
 	}
 
+	/* all transfers are gone with the devices, return their buffers last */
+	StreamPool_Free(urbdrc->pool);
 	free(urbdrc->subsystem);
 	free(urbdrc->listener_callback);
 	free(urbdrc);
@@ -961,6 +964,14 @@ UINT urbdrc_DVCPluginEntry(IDRDYNVC_ENTRY_POINTS* pEntryPoints)
 		if (!urbdrc)
 			return CHANNEL_RC_NO_MEMORY;
 
+		urbdrc->pool = StreamPool_New(TRUE, 4096);
+
+		if (!urbdrc->pool)
+		{
+			free(urbdrc);
+			return CHANNEL_RC_NO_MEMORY;
+		}
+
 		urbdrc->iface.Initialize = urbdrc_plugin_initialize;
 		urbdrc->iface.Terminated = urbdrc_plugin_terminated;
 		urbdrc->vchannel_status = INIT_CHANNEL_IN;
@@ -969,6 +980,7 @@ UINT urbdrc_DVCPluginEntry(IDRDYNVC_ENTRY_POINTS* pEntryPoints)
 		/* After we register the plugin free will be taken care of by dynamic channel */
 		if (status != CHANNEL_RC_OK)
 		{
+			StreamPool_Free(urbdrc->pool);
 			free(urbdrc);
 			goto fail;
 		}
@@ -992,6 +1004,21 @@ fail:
 	return status;
 }
 
+/**
+ * Outgoing messages and URB buffers are taken from a pool shared by all devices,
+ * completions recycle their buffer instead of allocating a new one per URB.
+ * Streams are given back with Stream_Release (done by stream_write_and_free)
+ */
+wStream* urbdrc_stream_new(IWTSPlugin* plugin, size_t size)
+{
+	URBDRC_PLUGIN* urbdrc = (URBDRC_PLUGIN*)plugin;
+
+	if (!urbdrc || !urbdrc->pool)
+		return NULL;
+
+	return StreamPool_Take(urbdrc->pool, size);
+}
+
 UINT stream_write_and_free(IWTSPlugin* plugin, IWTSVirtualChannel* channel, wStream* out)
 {
 	UINT rc;
@@ -1002,18 +1029,18 @@ UINT stream_write_and_free(IWTSPlugin* plugin, IWTSVirtualChannel* channel, wStr
 
 	if (!channel || !out || !urbdrc)
 	{
-		Stream_Free(out, TRUE);
+		Stream_Release(out);
 		return ERROR_INVALID_PARAMETER;
 	}
 
 	if (!channel->Write)
 	{
-		Stream_Free(out, TRUE);
+		Stream_Release(out);
 		return ERROR_INTERNAL_ERROR;
 	}
 
 	urbdrc_dump_message(urbdrc->log, TRUE, TRUE, out);
 	rc = channel->Write(channel, Stream_GetPosition(out), Stream_Buffer(out), NULL);
-	Stream_Free(out, TRUE);
+	Stream_Release(out);
 	return rc;
 }
@@ -64,6 +64,7 @@ typedef struct
 	wLog* log;
 	IWTSListener* listener;
 	BOOL initialized;
+	wStreamPool* pool; /* outgoing messages and URB transfer buffers */
 } URBDRC_PLUGIN;
 
 typedef BOOL (*PREGISTERURBDRCSERVICE)(IWTSPlugin* plugin, IUDEVMAN* udevman);
@@ -217,6 +218,7 @@ FREERDP_API BOOL add_device(IUDEVMAN* idevman, UINT32 flags, BYTE busnum, BYTE d
 FREERDP_API BOOL del_device(IUDEVMAN* idevman, UINT32 flags, BYTE busnum, BYTE devnum,
                             UINT16 idVendor, UINT16 idProduct);
 
+FREERDP_API wStream* urbdrc_stream_new(IWTSPlugin* plugin, size_t size);
 UINT stream_write_and_free(IWTSPlugin* plugin, IWTSVirtualChannel* channel, wStream* s);
 
 #endif /* FREERDP_CHANNEL_URBDRC_CLIENT_MAIN_H */
@@ -372,6 +372,7 @@ BOOL wf_register_graphics(rdpGraphics* graphics)
 	bitmap.Free = wf_Bitmap_Free;
 	bitmap.Paint = wf_Bitmap_Paint;
 	bitmap.SetSurface = wf_Bitmap_SetSurface;
+	bitmap.Compact = NULL;
 	graphics_register_bitmap(graphics, &bitmap);
 	glyph = *graphics->Glyph_Prototype;
 	graphics_register_glyph(graphics, &glyph);
@@ -761,6 +761,7 @@ BOOL xf_register_graphics(rdpGraphics* graphics)
 	bitmap.Free = xf_Bitmap_Free;
 	bitmap.Paint = xf_Bitmap_Paint;
 	bitmap.SetSurface = xf_Bitmap_SetSurface;
+	bitmap.Compact = NULL;
 	graphics_register_bitmap(graphics, &bitmap);
 	glyph.size = sizeof(xfGlyph);
 	glyph.New = xf_Glyph_New;
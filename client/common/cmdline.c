@@ -3099,6 +3099,15 @@ int freerdp_client_settings_parse_command_line_arguments(rdpSettings* settings,
 
 			settings->BitmapCachePersistEnabled = TRUE;
 		}
+		CommandLineSwitchCase(arg, "cache-memory-budget")
+		{
+			ULONGLONG val;
+
+			if (!value_to_uint(arg->Value, &val, 0, UINT32_MAX))
+				return COMMAND_LINE_ERROR_UNEXPECTED_VALUE;
+
+			settings->BitmapCacheMemoryBudget = (UINT32)val;
+		}
 		CommandLineSwitchCase(arg, "offscreen-cache")
 		{
 			settings->OffscreenSupportLevel = (UINT32)enable;
@@ -3138,6 +3147,15 @@ int freerdp_client_settings_parse_command_line_arguments(rdpSettings* settings,
 			settings->FastPathInput = enable;
 			settings->FastPathOutput = enable;
 		}
+		CommandLineSwitchCase(arg, "input-batching")
+		{
+			LONGLONG val;
+
+			if (!value_to_int(arg->Value, &val, 0, 1000))
+				return COMMAND_LINE_ERROR_UNEXPECTED_VALUE;
+
+			settings->FastPathInputBatchLatency = (UINT32)val;
+		}
 		CommandLineSwitchCase(arg, "max-fast-path-size")
 		{
 			LONGLONG val;
@@ -70,6 +70,9 @@ static const COMMAND_LINE_ARGUMENT_A global_cmd_args[] = {
 	  "persistent bitmap cache" },
 	{ "persist-cache-file", COMMAND_LINE_VALUE_REQUIRED, "<filename>", NULL, NULL, -1, NULL,
 	  "persistent bitmap cache file" },
+	{ "cache-memory-budget", COMMAND_LINE_VALUE_REQUIRED, "<MiB>", NULL, NULL, -1, NULL,
+	  "Memory of the bitmap and offscreen caches above which idle bitmaps are kept compressed, "
+	  "0 for no limit" },
 	{ "bpp", COMMAND_LINE_VALUE_REQUIRED, "<depth>", "16", NULL, -1, NULL,
 	  "Session bpp (color depth)" },
 	{ "buildconfig", COMMAND_LINE_VALUE_FLAG | COMMAND_LINE_PRINT_BUILDCONFIG, NULL, NULL, NULL, -1,
@@ -196,6 +199,8 @@ static const COMMAND_LINE_ARGUMENT_A global_cmd_args[] = {
 	  "Print help" },
 	{ "home-drive", COMMAND_LINE_VALUE_BOOL, NULL, BoolValueFalse, NULL, -1, NULL,
 	  "Redirect user home as share" },
+	{ "input-batching", COMMAND_LINE_VALUE_REQUIRED, "<ms>", NULL, NULL, -1, NULL,
+	  "Batch and coalesce fast-path input events for at most <ms> milliseconds" },
 	{ "ipv6", COMMAND_LINE_VALUE_FLAG, NULL, NULL, NULL, -1, "6",
 	  "Prefer IPv6 AAA record over IPv4 A record" },
 #if defined(WITH_JPEG)
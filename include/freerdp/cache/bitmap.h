@@ -27,6 +27,7 @@
 #include <freerdp/cache/persistent.h>
 
 #include <winpr/stream.h>
+#include <winpr/collections.h>
 
 typedef struct
 {
@@ -50,7 +51,16 @@ typedef struct
 
 	/* internal */
 	rdpContext* context;
-	rdpPersistentCache* persistent;
+	rdpPersistentCache* persistent; /* written by persistThread, replaces the file on close */
+	char* persistFile;
+	wMessageQueue* persistQueue;
+	HANDLE persistThread;
+	wHashTable* persistKeys; /* keys already queued, each one is written once */
+	UINT64* persistKeyList;
+	UINT32 persistCount;
+	UINT32 persistMax;
+	rdpPersistentCache* persistLoad; /* the file of the previous session */
+	UINT32** persistIndex; /* per cell entry, 1 + entry in persistLoad advertised for it */
 } rdpBitmapCache;
 
 #ifdef __cplusplus
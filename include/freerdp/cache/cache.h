@@ -34,6 +34,18 @@
 #include <freerdp/cache/offscreen.h>
 #include <freerdp/cache/palette.h>
 
+typedef struct rdp_cache_memory rdpCacheMemory;
+
+/** Memory held by the decoded bitmaps of the bitmap and offscreen caches of all sessions */
+typedef struct
+{
+	UINT64 budget;      /** bytes above which idle bitmaps are compacted, 0 for no limit */
+	UINT64 used;        /** bytes of bitmaps with their pixels present */
+	UINT64 compacted;   /** bytes of compacted bitmaps */
+	UINT64 compactions; /** bitmaps compacted so far */
+	UINT64 restores;    /** compacted bitmaps restored for drawing so far */
+} CACHE_MEMORY_STATS;
+
 struct rdp_cache
 {
 	rdpGlyphCache* glyph;         /* 0 */
@@ -43,6 +55,9 @@ struct rdp_cache
 	rdpOffscreenCache* offscreen; /* 4 */
 	rdpPaletteCache* palette;     /* 5 */
 	rdpNineGridCache* nine_grid;  /* 6 */
+
+	/* internal */
+	rdpCacheMemory* memory;
 };
 
 #ifdef __cplusplus
@@ -53,6 +68,16 @@ extern "C"
 	FREERDP_API rdpCache* cache_new(rdpContext* context);
 	FREERDP_API void cache_free(rdpCache* cache);
 
+	/**
+	 * Sets the process wide memory budget of the bitmap and offscreen caches. Once the bitmaps
+	 * of all sessions exceed it, the least recently used bitmaps of the session adding or using
+	 * one are kept compressed until they are drawn again.
+	 *
+	 * @param budget the budget in bytes, 0 (the default) for no limit
+	 */
+	FREERDP_API void cache_set_memory_budget(UINT64 budget);
+	FREERDP_API void cache_get_memory_stats(CACHE_MEMORY_STATS* stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -84,8 +84,18 @@ extern "C"
 	FREERDP_API int persistent_cache_get_version(rdpPersistentCache* persistent);
 	FREERDP_API int persistent_cache_get_count(rdpPersistentCache* persistent);
 
+	/**
+	 * The keys of all entries of a cache opened for reading, in file order. Reading the keys does
+	 * not touch the bitmap data, use persistent_cache_read_entry_at to load single entries.
+	 *
+	 * @return an array of persistent_cache_get_count keys owned by the cache, NULL if empty
+	 */
+	FREERDP_API const UINT64* persistent_cache_get_keys(rdpPersistentCache* persistent);
+
 	FREERDP_API int persistent_cache_read_entry(rdpPersistentCache* persistent,
 	                                            PERSISTENT_CACHE_ENTRY* entry);
+	FREERDP_API int persistent_cache_read_entry_at(rdpPersistentCache* persistent, int index,
+	                                               PERSISTENT_CACHE_ENTRY* entry);
 	FREERDP_API int persistent_cache_write_entry(rdpPersistentCache* persistent,
 	                                             const PERSISTENT_CACHE_ENTRY* entry);
 
@@ -27,6 +27,7 @@
 #include <freerdp/graphics.h>
 
 #include <winpr/stream.h>
+#include <winpr/collections.h>
 
 typedef struct rdp_pointer_cache rdpPointerCache;
 
@@ -39,6 +40,9 @@ struct rdp_pointer_cache
 
 	/* internal */
 	rdpContext* context;
+	wHashTable* shapes;     /* rdpPointer (by content) -> slot reference count */
+	rdpPointer* unused[16]; /* recently dropped shapes, oldest first */
+	size_t unusedCount;
 };
 
 #ifdef __cplusplus
@@ -52,6 +52,15 @@ extern "C"
 		DRDYNVC_STATE_FAILED = 3
 	};
 
+	/**
+	 * A part of a virtual channel write, see FreeRDP_WTSVirtualChannelWriteGather
+	 */
+	typedef struct
+	{
+		const BYTE* data;
+		size_t length;
+	} WTS_VIRTUAL_CHANNEL_BUFFER;
+
 	typedef BOOL (*psDVCCreationStatusCallback)(void* userdata, UINT32 channelId,
 	                                            INT32 creationStatus);
 
@@ -91,6 +100,14 @@ extern "C"
 
 	FREERDP_API UINT32 WTSChannelGetIdByHandle(HANDLE hChannelHandle);
 
+	/**
+	 * Like WTSVirtualChannelWrite, but the data is gathered from a list of buffers.
+	 * The buffers are copied once, directly into the queued channel chunks.
+	 */
+	FREERDP_API BOOL WINAPI FreeRDP_WTSVirtualChannelWriteGather(
+	    HANDLE hChannelHandle, const WTS_VIRTUAL_CHANNEL_BUFFER* buffers, size_t count,
+	    PULONG pBytesWritten);
+
 #ifdef __cplusplus
 }
 #endif
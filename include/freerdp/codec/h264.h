@@ -47,6 +47,7 @@ typedef struct
 	UINT32 FrameRate;
 	UINT32 QP;
 	UINT32 NumberOfThreads;
+	BOOL AdaptiveLumaOnly; /* AVC444: skip the chroma view during motion, refine it afterwards */
 
 	UINT32 iStride[3];
 	BYTE* pOldYUVData[3];
@@ -67,6 +68,10 @@ typedef struct
 	BOOL firstChromaFrameDone;
 
 	void* lumaData;
+	UINT32 motionFrames;
+	BOOL chromaRefreshPending;
+	RECTANGLE_16 chromaRefreshRect;
+
 	wLog* log;
 } H264_CONTEXT;
 
@@ -56,6 +56,7 @@ typedef RDP_CLIENT_ENTRY_POINTS_V1 RDP_CLIENT_ENTRY_POINTS;
 #include <freerdp/message.h>
 #include <freerdp/autodetect.h>
 #include <freerdp/heartbeat.h>
+#include <freerdp/multitransport.h>
 
 typedef struct stream_dump_context rdpStreamDumpContext;
 
@@ -299,10 +300,10 @@ extern "C"
 		ALIGN64 rdpSettings* settings;     /* 40 owned by rdpRdp */
 		ALIGN64 rdpMetrics* metrics;       /* 41 */
 		ALIGN64 rdpCodecs* codecs;         /* 42 */
-		ALIGN64 rdpAutoDetect* autodetect; /* 43 owned by rdpRdp */
-		UINT64 paddingC1[45 - 44];         /* 44 */
-		ALIGN64 int disconnectUltimatum;   /* 45 */
-		UINT64 paddingC[64 - 46];          /* 46 */
+		ALIGN64 rdpAutoDetect* autodetect;         /* 43 owned by rdpRdp */
+		ALIGN64 rdpMultitransport* multitransport; /* 44 owned by rdpRdp */
+		ALIGN64 int disconnectUltimatum;           /* 45 */
+		UINT64 paddingC[64 - 46];                  /* 46 */
 
 		ALIGN64 rdpStreamDumpContext* dump; /* 64 */
 
@@ -590,6 +591,15 @@ owned by rdpRdp */
 
 	FREERDP_API ULONG freerdp_get_transport_sent(rdpContext* context, BOOL resetCount);
 
+	/** \brief references the received transport buffer that holds \b data
+	 *
+	 *  Only valid from within a receive callback of \b context, e.g. ReceiveChannelData.
+	 *
+	 *  \return the stream, to be released with Stream_Release, or NULL if \b data is not
+	 *  part of a received buffer
+	 */
+	FREERDP_API wStream* freerdp_get_received_stream(rdpContext* context, const BYTE* data);
+
 	FREERDP_API BOOL freerdp_nla_impersonate(rdpContext* context);
 	FREERDP_API BOOL freerdp_nla_revert_to_self(rdpContext* context);
 
@@ -471,6 +471,8 @@ struct gdi_bitmap
 	HGDI_DC hdc;
 	HGDI_BITMAP bitmap;
 	HGDI_BITMAP org_bitmap;
+	BYTE* compact;    /* compressed pixels while compacted by the cache */
+	BOOL compactCopy; /* _p.data is recreated on restore */
 };
 typedef struct gdi_bitmap gdiBitmap;
 
@@ -44,6 +44,7 @@ extern "C"
 	                                   UINT32 width, UINT32 height, UINT32 bpp, UINT32 length,
 	                                   BOOL compressed, UINT32 codec_id);
 	typedef BOOL (*pBitmap_SetSurface)(rdpContext* context, rdpBitmap* bitmap, BOOL primary);
+	typedef BOOL (*pBitmap_Compact)(rdpContext* context, rdpBitmap* bitmap, BOOL compact);
 
 	struct rdp_bitmap
 	{
@@ -53,7 +54,8 @@ extern "C"
 		pBitmap_Paint Paint;           /* 3 */
 		pBitmap_Decompress Decompress; /* 4 */
 		pBitmap_SetSurface SetSurface; /* 5 */
-		UINT32 paddingA[16 - 6];       /* 6 */
+		pBitmap_Compact Compact;       /* 6 */
+		UINT32 paddingA[16 - 8];       /* 8 */
 
 		UINT32 left;              /* 16 */
 		UINT32 top;               /* 17 */
@@ -70,7 +72,9 @@ extern "C"
 
 		BOOL compressed;          /* 32 */
 		BOOL ephemeral;           /* 33 */
-		UINT32 paddingC[64 - 34]; /* 34 */
+		UINT32 compactLength;     /* 34 */
+		UINT64 lastUse;           /* 35 */
+		UINT32 paddingC[64 - 37]; /* 37 */
 	};
 
 	FREERDP_API rdpBitmap* Bitmap_Alloc(rdpContext* context);
@@ -22,6 +22,26 @@
 
 #include <freerdp/api.h>
 
+/** Pipeline stages timed by metrics_stage_add */
+typedef enum
+{
+	METRICS_STAGE_SURFACE_ENCODE,  /* encoding surface data, recorded by the application */
+	METRICS_STAGE_BULK_COMPRESS,   /* bulk_compress */
+	METRICS_STAGE_TRANSPORT_WRITE, /* encrypting and writing a PDU */
+	METRICS_STAGE_TRANSPORT_READ,  /* reading and decrypting a PDU */
+	METRICS_STAGE_PDU_PROCESS,     /* processing a received PDU, includes the stages below */
+	METRICS_STAGE_BULK_DECOMPRESS, /* bulk_decompress */
+	METRICS_STAGE_SURFACE_DECODE,  /* decoding surface bits into the GDI */
+	METRICS_STAGE_COUNT
+} rdpMetricsStage;
+
+typedef struct
+{
+	UINT64 Count;
+	UINT64 TotalNS;
+	UINT64 MaxNS;
+} rdpMetricsStageTime;
+
 struct rdp_metrics
 {
 	rdpContext* context;
@@ -29,6 +49,8 @@ struct rdp_metrics
 	UINT64 TotalCompressedBytes;
 	UINT64 TotalUncompressedBytes;
 	double TotalCompressionRatio;
+
+	rdpMetricsStageTime Stages[METRICS_STAGE_COUNT];
 };
 
 #ifdef __cplusplus
@@ -39,6 +61,14 @@ extern "C"
 	FREERDP_API double metrics_write_bytes(rdpMetrics* metrics, UINT32 UncompressedBytes,
 	                                       UINT32 CompressedBytes);
 
+	/**
+	 * Accounts the time elapsed since startNS to a pipeline stage.
+	 *
+	 * @param startNS a time stamp taken with winpr_GetTickCount64NS when the stage was entered
+	 */
+	FREERDP_API void metrics_stage_add(rdpMetrics* metrics, rdpMetricsStage stage, UINT64 startNS);
+	FREERDP_API const char* metrics_stage_name(rdpMetricsStage stage);
+
 	FREERDP_API rdpMetrics* metrics_new(rdpContext* context);
 	FREERDP_API void metrics_free(rdpMetrics* metrics);
 
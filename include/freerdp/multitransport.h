@@ -0,0 +1,78 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Implementation
+ * Multitransport PDUs
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FREERDP_MULTITRANSPORT_H
+#define FREERDP_MULTITRANSPORT_H
+
+#include <freerdp/types.h>
+
+typedef struct rdp_multitransport rdpMultitransport;
+
+/* Initiate Multitransport Request PDU requestedProtocol */
+#define INITIATE_REQUEST_PROTOCOL_UDPFECR 0x01
+#define INITIATE_REQUEST_PROTOCOL_UDPFECL 0x02
+
+/**
+ * Called on the client for every Initiate Multitransport Request PDU.
+ * A client establishing the side channel keeps the securityCookie for the tunnel create request.
+ * A client not able to do so must answer with freerdp_multitransport_send_response, if the
+ * callback is not set the request is declined with E_ABORT.
+ */
+typedef BOOL (*pMultitransportRequest)(rdpContext* context, UINT32 requestId,
+                                       UINT16 requestedProtocol, const BYTE* securityCookie);
+
+/** Called on the server for every Initiate Multitransport Response PDU */
+typedef BOOL (*pMultitransportResponse)(rdpContext* context, UINT32 requestId, HRESULT hrResponse);
+
+struct rdp_multitransport
+{
+	ALIGN64 rdpContext* context; /* 0 */
+	/* last request sent (server) or received (client) */
+	ALIGN64 UINT32 requestId;         /* 1 */
+	ALIGN64 UINT16 requestedProtocol; /* 2 */
+	ALIGN64 BYTE securityCookie[16];  /* 3 */
+	UINT64 paddingA[16 - 5];          /* 5 */
+
+	ALIGN64 pMultitransportRequest MultitransportRequest;   /* 16 */
+	ALIGN64 pMultitransportResponse MultitransportResponse; /* 17 */
+	UINT64 paddingB[32 - 18];                               /* 18 */
+};
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+	/**
+	 * Sends an Initiate Multitransport Request PDU to the client.
+	 *
+	 * @param securityCookie the 16 byte cookie the client echoes when binding the tunnel, a
+	 * random cookie is generated if NULL
+	 */
+	FREERDP_API BOOL freerdp_multitransport_send_request(freerdp_peer* peer, UINT32 requestId,
+	                                                     UINT16 requestedProtocol,
+	                                                     const BYTE* securityCookie);
+
+	/** Sends an Initiate Multitransport Response PDU to the server */
+	FREERDP_API BOOL freerdp_multitransport_send_response(rdpContext* context, UINT32 requestId,
+	                                                      HRESULT hrResponse);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FREERDP_MULTITRANSPORT_H */
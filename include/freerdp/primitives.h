@@ -142,6 +142,8 @@ typedef pstatus_t (*__RGBToAVC444YUV_t)(const BYTE* pSrc, UINT32 srcFormat, UINT
                                         const prim_size_t* roi);
 typedef pstatus_t (*__andC_32u_t)(const UINT32* pSrc, UINT32 val, UINT32* pDst, INT32 len);
 typedef pstatus_t (*__orC_32u_t)(const UINT32* pSrc, UINT32 val, UINT32* pDst, INT32 len);
+typedef pstatus_t (*__xorC_32u_t)(const UINT32* pSrc, UINT32 val, UINT32* pDst, INT32 len);
+typedef pstatus_t (*__dwtReduceExtrapolateDecode_16s_t)(INT16* pSrcDst, INT16* pTemp);
 typedef pstatus_t (*primitives_uninit_t)(void);
 
 typedef struct
@@ -188,6 +190,10 @@ typedef struct
 	/* flags */
 	DWORD flags;
 	primitives_uninit_t uninit;
+	/* And/or */
+	__xorC_32u_t xorC_32u;
+	/* Wavelet */
+	__dwtReduceExtrapolateDecode_16s_t dwtReduceExtrapolateDecode_16s;
 } primitives_t;
 
 typedef enum
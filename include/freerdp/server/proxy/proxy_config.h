@@ -81,6 +81,7 @@ struct proxy_config
 
 	/* gfx settings */
 	BOOL DecodeGFX;
+	BOOL ForwardRawUpdates;
 
 	/* modules */
 	char** Modules; /* module file names to load */
@@ -51,6 +51,7 @@ typedef struct rdp_shadow_encoder rdpShadowEncoder;
 typedef struct rdp_shadow_capture rdpShadowCapture;
 typedef struct rdp_shadow_subsystem rdpShadowSubsystem;
 typedef struct rdp_shadow_multiclient_event rdpShadowMultiClientEvent;
+typedef struct rdp_shadow_audio_client rdpShadowAudioClient;
 
 typedef struct S_RDP_SHADOW_ENTRY_POINTS RDP_SHADOW_ENTRY_POINTS;
 typedef int (*pfnShadowSubsystemEntry)(RDP_SHADOW_ENTRY_POINTS* pEntryPoints);
@@ -116,6 +117,8 @@ struct rdp_shadow_client
 	RdpsndServerContext* rdpsnd;
 	audin_server_context* audin;
 	RdpgfxServerContext* rdpgfx;
+
+	rdpShadowAudioClient* audio;
 };
 
 struct rdp_shadow_server
@@ -152,6 +155,8 @@ struct rdp_shadow_server
 	char* PrivateKeyFile;
 	CRITICAL_SECTION lock;
 	freerdp_listener* listener;
+	wArrayList* audioEncoders;
+	BOOL h264AdaptiveLumaOnly;
 };
 
 struct rdp_shadow_surface
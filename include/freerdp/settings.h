@@ -125,11 +125,13 @@ typedef enum
 #define RNS_UD_CS_SUPPORT_DYNVC_GFX_PROTOCOL 0x0100
 #define RNS_UD_CS_SUPPORT_DYNAMIC_TIME_ZONE 0x0200
 #define RNS_UD_CS_SUPPORT_HEARTBEAT_PDU 0x0400
+#define RNS_UD_CS_SUPPORT_SKIP_CHANNELJOIN 0x0800
 
 /* Early Capability Flags (Server to Client) */
 #define RNS_UD_SC_EDGE_ACTIONS_SUPPORTED 0x00000001
 #define RNS_UD_SC_DYNAMIC_DST_SUPPORTED 0x00000002
 #define RNS_UD_SC_EDGE_ACTIONS_SUPPORTED_V2 0x00000004
+#define RNS_UD_SC_SKIP_CHANNELJOIN_SUPPORTED 0x00000008
 
 /* Cluster Information Flags */
 #define REDIRECTION_SUPPORTED 0x00000001
@@ -534,6 +536,7 @@ typedef struct
 #define FreeRDP_DesktopOrientation (147)
 #define FreeRDP_DesktopScaleFactor (148)
 #define FreeRDP_DeviceScaleFactor (149)
+#define FreeRDP_SupportSkipChannelJoin (150)
 #define FreeRDP_UseRdpSecurityLayer (192)
 #define FreeRDP_EncryptionMethods (193)
 #define FreeRDP_ExtEncryptionMethods (194)
@@ -807,6 +810,7 @@ typedef struct
 #define FreeRDP_BitmapCacheV2NumCells (2501)
 #define FreeRDP_BitmapCacheV2CellInfo (2502)
 #define FreeRDP_BitmapCachePersistFile (2503)
+#define FreeRDP_BitmapCacheMemoryBudget (2504)
 #define FreeRDP_ColorPointerFlag (2560)
 #define FreeRDP_PointerCacheSize (2561)
 #define FreeRDP_KeyboardRemappingList (2622)
@@ -824,6 +828,7 @@ typedef struct
 #define FreeRDP_HasHorizontalWheel (2634)
 #define FreeRDP_HasExtendedMouseEvent (2635)
 #define FreeRDP_SuspendInput (2636)
+#define FreeRDP_FastPathInputBatchLatency (2637)
 #define FreeRDP_BrushSupportLevel (2688)
 #define FreeRDP_GlyphSupportLevel (2752)
 #define FreeRDP_GlyphCache (2753)
@@ -971,7 +976,8 @@ struct rdp_settings
 	ALIGN64 UINT16 DesktopOrientation;    /* 147 */
 	ALIGN64 UINT32 DesktopScaleFactor;    /* 148 */
 	ALIGN64 UINT32 DeviceScaleFactor;     /* 149 */
-	UINT64 padding0192[192 - 150];        /* 150 */
+	ALIGN64 BOOL SupportSkipChannelJoin;  /* 150 */
+	UINT64 padding0192[192 - 151];        /* 151 */
 
 	/* Client/Server Security Data */
 	ALIGN64 BOOL UseRdpSecurityLayer;       /* 192 */
@@ -1383,7 +1389,8 @@ struct rdp_settings
 	ALIGN64 UINT32 BitmapCacheV2NumCells;                     /* 2501 */
 	ALIGN64 BITMAP_CACHE_V2_CELL_INFO* BitmapCacheV2CellInfo; /* 2502 */
 	ALIGN64 char* BitmapCachePersistFile;                     /* 2503 */
-	UINT64 padding2560[2560 - 2504];                          /* 2504 */
+	ALIGN64 UINT32 BitmapCacheMemoryBudget;                   /* 2504 */
+	UINT64 padding2560[2560 - 2505];                          /* 2505 */
 
 	/* Pointer Capabilities */
 	ALIGN64 BOOL ColorPointerFlag;   /* 2560 */
@@ -1410,8 +1417,15 @@ struct rdp_settings
 	 * If used by an implementation ensure proper state resync after reenabling
 	 * input
 	 */
-	ALIGN64 BOOL SuspendInput;       /* 2636 */
-	UINT64 padding2688[2688 - 2637]; /* 2637 */
+	ALIGN64 BOOL SuspendInput; /* 2636 */
+
+	/** FastPathInputBatchLatency is the maximum time in milliseconds fastpath
+	 * input events are held back to be sent as a single multi event PDU.
+	 * Consecutive pointer motion events are coalesced while held back.
+	 * 0 disables batching.
+	 */
+	ALIGN64 UINT32 FastPathInputBatchLatency; /* 2637 */
+	UINT64 padding2688[2688 - 2638];          /* 2638 */
 
 	/* Brush Capabilities */
 	ALIGN64 UINT32 BrushSupportLevel; /* 2688 */
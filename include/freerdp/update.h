@@ -191,6 +191,10 @@ typedef BOOL (*pSetKeyboardImeStatus)(rdpContext* context, UINT16 imeId, UINT32
                                       UINT32 imeConvMode);
 typedef BOOL (*pServerStatusInfo)(rdpContext* context, UINT32 status);
 
+/* A complete update in fast-path format (decrypted, decompressed and reassembled), the data
+ * is the remaining length of s. Used to relay updates without parsing them. */
+typedef BOOL (*pRawUpdate)(rdpContext* context, BYTE updateCode, wStream* s);
+
 struct rdp_update
 {
 	rdpContext* context;     /* 0 */
@@ -231,7 +235,10 @@ struct rdp_update
 	 * fills BITMAP_DATA struct members: flags, cbCompMainBodySize and cbCompFirstRowSize.
 	 */
 	BOOL autoCalculateBitmapData; /* 71 */
-	UINT32 paddingE[80 - 72];     /* 72 */
+	/* client: if set, every fast-path and slow-path update is passed here instead of being
+	 * parsed. server: sends such an update to the client as is. */
+	pRawUpdate RawUpdate;     /* 72 */
+	UINT32 paddingE[80 - 74]; /* 74 */
 };
 
 #ifdef __cplusplus
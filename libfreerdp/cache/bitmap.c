@@ -23,6 +23,7 @@
 
 #include <winpr/crt.h>
 #include <winpr/assert.h>
+#include <winpr/file.h>
 
 #include <freerdp/freerdp.h>
 #include <freerdp/constants.h>
@@ -36,6 +37,7 @@
 #include "../core/graphics.h"
 
 #include "bitmap.h"
+#include "cache.h"
 
 #define TAG FREERDP_TAG("cache.bitmap")
 
@@ -101,7 +103,6 @@ static BOOL update_gdi_mem3blt(rdpContext* context, MEM3BLT_ORDER* mem3blt)
 static BOOL update_gdi_cache_bitmap(rdpContext* context, const CACHE_BITMAP_ORDER* cacheBitmap)
 {
 	rdpBitmap* bitmap;
-	rdpBitmap* prevBitmap;
 	rdpCache* cache = context->cache;
 	bitmap = Bitmap_Alloc(context);
 
@@ -125,15 +126,12 @@ static BOOL update_gdi_cache_bitmap(rdpContext* context, const CACHE_BITMAP_ORDE
 		return FALSE;
 	}
 
-	prevBitmap = bitmap_cache_get(cache->bitmap, cacheBitmap->cacheId, cacheBitmap->cacheIndex);
-	Bitmap_Free(context, prevBitmap);
 	return bitmap_cache_put(cache->bitmap, cacheBitmap->cacheId, cacheBitmap->cacheIndex, bitmap);
 }
 
 static BOOL update_gdi_cache_bitmap_v2(rdpContext* context, CACHE_BITMAP_V2_ORDER* cacheBitmapV2)
 
 {
-	rdpBitmap* prevBitmap;
 	rdpCache* cache = context->cache;
 	rdpSettings* settings = context->settings;
 	rdpBitmap* bitmap = Bitmap_Alloc(context);
@@ -158,12 +156,9 @@ static BOOL update_gdi_cache_bitmap_v2(rdpContext* context, CACHE_BITMAP_V2_ORDE
 	                        cacheBitmapV2->compressed, RDP_CODEC_ID_NONE))
 		goto fail;
 
-	prevBitmap = bitmap_cache_get(cache->bitmap, cacheBitmapV2->cacheId, cacheBitmapV2->cacheIndex);
-
 	if (!bitmap->New(context, bitmap))
 		goto fail;
 
-	Bitmap_Free(context, prevBitmap);
 	return bitmap_cache_put(cache->bitmap, cacheBitmapV2->cacheId, cacheBitmapV2->cacheIndex,
 	                        bitmap);
 
@@ -175,7 +170,6 @@ fail:
 static BOOL update_gdi_cache_bitmap_v3(rdpContext* context, CACHE_BITMAP_V3_ORDER* cacheBitmapV3)
 {
 	rdpBitmap* bitmap;
-	rdpBitmap* prevBitmap;
 	BOOL compressed = TRUE;
 	rdpCache* cache = context->cache;
 	rdpSettings* settings = context->settings;
@@ -202,8 +196,6 @@ static BOOL update_gdi_cache_bitmap_v3(rdpContext* context, CACHE_BITMAP_V3_ORDE
 	if (!bitmap->New(context, bitmap))
 		goto fail;
 
-	prevBitmap = bitmap_cache_get(cache->bitmap, cacheBitmapV3->cacheId, cacheBitmapV3->cacheIndex);
-	Bitmap_Free(context, prevBitmap);
 	return bitmap_cache_put(cache->bitmap, cacheBitmapV3->cacheId, cacheBitmapV3->cacheIndex,
 	                        bitmap);
 
@@ -212,6 +204,64 @@ fail:
 	return FALSE;
 }
 
+/* Loads the entry of the previous session the persistent key list advertised for a cell entry
+ * the server did not send yet. The entries hold the pixels in the GDI format. */
+static rdpBitmap* bitmap_cache_load(rdpBitmapCache* bitmapCache, UINT32 id, UINT32 index)
+{
+	UINT32 entryIndex;
+	rdpBitmap* bitmap;
+	PERSISTENT_CACHE_ENTRY entry = { 0 };
+	rdpContext* context = bitmapCache->context;
+
+	if (!bitmapCache->persistLoad || !bitmapCache->persistIndex[id])
+		return NULL;
+
+	entryIndex = bitmapCache->persistIndex[id][index];
+
+	if (entryIndex == 0)
+		return NULL;
+
+	bitmapCache->persistIndex[id][index] = 0;
+
+	if (!context->gdi || (FreeRDPGetBytesPerPixel(context->gdi->dstFormat) != 4))
+		return NULL;
+
+	if ((persistent_cache_read_entry_at(bitmapCache->persistLoad, (int)entryIndex - 1, &entry) <
+	     1) ||
+	    (entry.size > 0x4000))
+	{
+		WLog_WARN(TAG, "failed to load persistent bitmap cache entry %" PRIu32, entryIndex - 1);
+		return NULL;
+	}
+
+	bitmap = Bitmap_Alloc(context);
+
+	if (!bitmap)
+		return NULL;
+
+	Bitmap_SetDimensions(bitmap, entry.width, entry.height);
+	bitmap->key64 = entry.key64;
+	bitmap->format = context->gdi->dstFormat;
+	bitmap->length = entry.size;
+	bitmap->data = winpr_aligned_malloc(entry.size, 16);
+
+	if (!bitmap->data)
+		goto fail;
+
+	CopyMemory(bitmap->data, entry.data, entry.size);
+
+	if (!bitmap->New(context, bitmap))
+		goto fail;
+
+	if (!bitmap_cache_put(bitmapCache, id, index, bitmap))
+		goto fail;
+
+	return bitmap;
+fail:
+	Bitmap_Free(context, bitmap);
+	return NULL;
+}
+
 rdpBitmap* bitmap_cache_get(rdpBitmapCache* bitmapCache, UINT32 id, UINT32 index)
 {
 	rdpBitmap* bitmap;
@@ -233,12 +283,261 @@ rdpBitmap* bitmap_cache_get(rdpBitmapCache* bitmapCache, UINT32 id, UINT32 index
 	}
 
 	bitmap = bitmapCache->cells[id].entries[index];
+
+	if (!bitmap)
+		return bitmap_cache_load(bitmapCache, id, index);
+
+	if (!cache_memory_use(bitmapCache->context->cache, bitmap))
+		return NULL;
+
 	return bitmap;
 }
 
+static UINT32 bitmap_cache_key_hash(const void* key)
+{
+	const UINT64 key64 = *(const UINT64*)key;
+	return (UINT32)(key64 ^ (key64 >> 32));
+}
+
+static BOOL bitmap_cache_key_equals(const void* objA, const void* objB)
+{
+	return *(const UINT64*)objA == *(const UINT64*)objB;
+}
+
+static void bitmap_cache_persist_message_free(void* obj)
+{
+	wMessage* message = (wMessage*)obj;
+
+	if (message)
+		free(message->wParam);
+}
+
+/* writes the entries queued by bitmap_cache_persist, keeping file access off the update thread */
+static DWORD WINAPI bitmap_cache_persist_thread(LPVOID arg)
+{
+	wMessage message;
+	rdpBitmapCache* bitmapCache = (rdpBitmapCache*)arg;
+
+	WINPR_ASSERT(bitmapCache);
+
+	while (MessageQueue_Wait(bitmapCache->persistQueue))
+	{
+		PERSISTENT_CACHE_ENTRY* entry;
+
+		if (!MessageQueue_Peek(bitmapCache->persistQueue, &message, TRUE))
+			break;
+
+		if (message.id == WMQ_QUIT)
+			break;
+
+		entry = (PERSISTENT_CACHE_ENTRY*)message.wParam;
+
+		if (bitmapCache->persistent &&
+		    (persistent_cache_write_entry(bitmapCache->persistent, entry) < 1))
+		{
+			WLog_ERR(TAG, "failed to write persistent bitmap cache entry, giving up");
+			persistent_cache_free(bitmapCache->persistent);
+			bitmapCache->persistent = NULL;
+		}
+
+		free(entry);
+	}
+
+	ExitThread(0);
+	return 0;
+}
+
+/* The entries are written to a new file, the previous one is still read by bitmap_cache_load.
+ * It is replaced when the cache is freed. */
+static BOOL bitmap_cache_persist_start(rdpBitmapCache* bitmapCache)
+{
+	size_t length;
+	wObject obj = { 0 };
+	const rdpSettings* settings = bitmapCache->context->settings;
+	const char* file = freerdp_settings_get_string(settings, FreeRDP_BitmapCachePersistFile);
+
+	/* the persistent bitmap cache is saved by the egfx channel for other versions */
+	if (freerdp_settings_get_uint32(settings, FreeRDP_BitmapCacheVersion) != 2)
+		return FALSE;
+
+	length = strlen(file) + 5;
+	bitmapCache->persistFile = calloc(length, sizeof(char));
+	bitmapCache->persistKeyList = calloc(bitmapCache->persistMax, sizeof(UINT64));
+	bitmapCache->persistKeys = HashTable_New(FALSE);
+
+	if (!bitmapCache->persistFile || !bitmapCache->persistKeyList || !bitmapCache->persistKeys)
+		return FALSE;
+
+	if (!HashTable_SetHashFunction(bitmapCache->persistKeys, bitmap_cache_key_hash))
+		return FALSE;
+
+	HashTable_KeyObject(bitmapCache->persistKeys)->fnObjectEquals = bitmap_cache_key_equals;
+	sprintf_s(bitmapCache->persistFile, length, "%s.new", file);
+	bitmapCache->persistent = persistent_cache_new();
+
+	if (!bitmapCache->persistent ||
+	    (persistent_cache_open(bitmapCache->persistent, bitmapCache->persistFile, TRUE, 2) < 1))
+	{
+		WLog_ERR(TAG, "failed to create persistent bitmap cache %s", bitmapCache->persistFile);
+		return FALSE;
+	}
+
+	obj.fnObjectFree = bitmap_cache_persist_message_free;
+	bitmapCache->persistQueue = MessageQueue_New(&obj);
+
+	if (!bitmapCache->persistQueue)
+		return FALSE;
+
+	bitmapCache->persistThread =
+	    CreateThread(NULL, 0, bitmap_cache_persist_thread, bitmapCache, 0, NULL);
+	return bitmapCache->persistThread != NULL;
+}
+
+static void bitmap_cache_persist_stop(rdpBitmapCache* bitmapCache)
+{
+	BOOL replace = FALSE;
+
+	if (bitmapCache->persistThread)
+	{
+		/* only the entries still queued are written, the thread kept up during the session */
+		if (MessageQueue_PostQuit(bitmapCache->persistQueue, 0))
+			WaitForSingleObject(bitmapCache->persistThread, INFINITE);
+
+		CloseHandle(bitmapCache->persistThread);
+		bitmapCache->persistThread = NULL;
+		replace = (bitmapCache->persistent != NULL);
+	}
+
+	MessageQueue_Free(bitmapCache->persistQueue);
+	bitmapCache->persistQueue = NULL;
+	persistent_cache_free(bitmapCache->persistent);
+	bitmapCache->persistent = NULL;
+	persistent_cache_free(bitmapCache->persistLoad);
+	bitmapCache->persistLoad = NULL;
+
+	if (bitmapCache->persistFile)
+	{
+		const char* file = freerdp_settings_get_string(bitmapCache->context->settings,
+		                                               FreeRDP_BitmapCachePersistFile);
+
+		if (!replace || !MoveFileExA(bitmapCache->persistFile, file, MOVEFILE_REPLACE_EXISTING))
+			DeleteFileA(bitmapCache->persistFile);
+
+		free(bitmapCache->persistFile);
+		bitmapCache->persistFile = NULL;
+	}
+
+	HashTable_Free(bitmapCache->persistKeys);
+	bitmapCache->persistKeys = NULL;
+	free(bitmapCache->persistKeyList);
+	bitmapCache->persistKeyList = NULL;
+}
+
+/* Appends a new cache entry to the persistent cache in the background. Every key is written
+ * once, up to the number of entries the cache cells can hold, as the persistent key list can
+ * not advertise more. */
+static void bitmap_cache_persist(rdpBitmapCache* bitmapCache, const rdpBitmap* bitmap)
+{
+	UINT64* key;
+	PERSISTENT_CACHE_ENTRY* entry;
+	const size_t size = 4ull * bitmap->width * bitmap->height;
+
+	if (bitmapCache->persistCount >= bitmapCache->persistMax)
+		return;
+
+	if (!bitmap->key64 || !bitmap->data || (FreeRDPGetBytesPerPixel(bitmap->format) != 4) ||
+	    (size > 0x4000))
+		return;
+
+	if (!bitmapCache->persistQueue && !bitmap_cache_persist_start(bitmapCache))
+	{
+		bitmap_cache_persist_stop(bitmapCache);
+		bitmapCache->persistMax = 0;
+		return;
+	}
+
+	if (HashTable_Contains(bitmapCache->persistKeys, &bitmap->key64))
+		return;
+
+	key = &bitmapCache->persistKeyList[bitmapCache->persistCount];
+	*key = bitmap->key64;
+	entry = (PERSISTENT_CACHE_ENTRY*)calloc(1, sizeof(PERSISTENT_CACHE_ENTRY) + size);
+
+	if (!entry)
+		return;
+
+	entry->key64 = bitmap->key64;
+	entry->width = (UINT16)bitmap->width;
+	entry->height = (UINT16)bitmap->height;
+	entry->size = (UINT32)size;
+	entry->data = (BYTE*)&entry[1];
+	CopyMemory(entry->data, bitmap->data, size);
+
+	if (!HashTable_Insert(bitmapCache->persistKeys, key, key) ||
+	    !MessageQueue_Post(bitmapCache->persistQueue, NULL, 0, entry, NULL))
+	{
+		HashTable_Remove(bitmapCache->persistKeys, key);
+		free(entry);
+		return;
+	}
+
+	bitmapCache->persistCount++;
+}
+
+BOOL bitmap_cache_load_persistent(rdpBitmapCache* bitmapCache, const UINT32* numEntries,
+                                  UINT32 count)
+{
+	UINT32 x;
+	UINT32 entryIndex = 0;
+	const char* file;
+
+	WINPR_ASSERT(numEntries);
+
+	if (!bitmapCache || bitmapCache->persistLoad)
+		return FALSE;
+
+	file = freerdp_settings_get_string(bitmapCache->context->settings,
+	                                   FreeRDP_BitmapCachePersistFile);
+	bitmapCache->persistLoad = persistent_cache_new();
+
+	if (!file || !bitmapCache->persistLoad ||
+	    (persistent_cache_open(bitmapCache->persistLoad, file, FALSE, 0) < 1) ||
+	    (persistent_cache_get_version(bitmapCache->persistLoad) != 2))
+		goto fail;
+
+	for (x = 0; (x < count) && (x < bitmapCache->maxCells); x++)
+	{
+		UINT32 y;
+		const UINT32 number = MIN(numEntries[x], bitmapCache->cells[x].number);
+
+		if (number == 0)
+			continue;
+
+		/* indexed like the cell, up to and including the waiting list entry */
+		bitmapCache->persistIndex[x] = calloc(bitmapCache->cells[x].number + 1, sizeof(UINT32));
+
+		if (!bitmapCache->persistIndex[x])
+			goto fail;
+
+		for (y = 0; y < number; y++)
+			bitmapCache->persistIndex[x][y] = entryIndex + y + 1;
+
+		entryIndex += numEntries[x];
+	}
+
+	return TRUE;
+fail:
+	persistent_cache_free(bitmapCache->persistLoad);
+	bitmapCache->persistLoad = NULL;
+	return FALSE;
+}
+
+/* replaces the previous bitmap at index, which is freed */
 BOOL bitmap_cache_put(rdpBitmapCache* bitmapCache, UINT32 id, UINT32 index, rdpBitmap* bitmap)
 {
-	if (id > bitmapCache->maxCells)
+	rdpBitmap* prevBitmap;
+
+	if (id >= bitmapCache->maxCells)
 	{
 		WLog_ERR(TAG, "put invalid bitmap cell id: %" PRIu32 "", id);
 		return FALSE;
@@ -254,7 +553,43 @@ BOOL bitmap_cache_put(rdpBitmapCache* bitmapCache, UINT32 id, UINT32 index, rdpB
 		return FALSE;
 	}
 
+	prevBitmap = bitmapCache->cells[id].entries[index];
+	cache_memory_remove(prevBitmap);
+	Bitmap_Free(bitmapCache->context, prevBitmap);
+
+	/* the server replaced the entry advertised by the persistent key list */
+	if (bitmapCache->persistIndex[id])
+		bitmapCache->persistIndex[id][index] = 0;
+
+	if (bitmap)
+		bitmap_cache_persist(bitmapCache, bitmap);
+
 	bitmapCache->cells[id].entries[index] = bitmap;
+	cache_memory_add(bitmapCache->context->cache, bitmap);
+	return TRUE;
+}
+
+BOOL bitmap_cache_collect_bitmaps(rdpBitmapCache* bitmapCache, wArrayList* list)
+{
+	UINT32 i;
+	UINT32 j;
+
+	WINPR_ASSERT(list);
+
+	if (!bitmapCache)
+		return TRUE;
+
+	for (i = 0; i < bitmapCache->maxCells; i++)
+	{
+		const BITMAP_V2_CELL* cell = &bitmapCache->cells[i];
+
+		for (j = 0; j < cell->number + 1; j++)
+		{
+			if (cell->entries[j] && !ArrayList_Append(list, cell->entries[j]))
+				return FALSE;
+		}
+	}
+
 	return TRUE;
 }
 
@@ -282,68 +617,6 @@ void bitmap_cache_register_callbacks(rdpUpdate* update)
 	}
 }
 
-static int bitmap_cache_save_persistent(rdpBitmapCache* bitmapCache)
-{
-	int status;
-	UINT32 i, j;
-	UINT32 version;
-	rdpPersistentCache* persistent;
-	rdpContext* context = bitmapCache->context;
-	rdpSettings* settings = context->settings;
-
-	version = settings->BitmapCacheVersion;
-
-	if (version != 2)
-		return 0; /* persistent bitmap cache already saved in egfx channel */
-
-	if (!settings->BitmapCachePersistEnabled)
-		return 0;
-
-	if (!settings->BitmapCachePersistFile)
-		return 0;
-
-	persistent = persistent_cache_new();
-
-	if (!persistent)
-		return -1;
-
-	status = persistent_cache_open(persistent, settings->BitmapCachePersistFile, TRUE, version);
-
-	if (status < 1)
-		goto end;
-
-	for (i = 0; i < bitmapCache->maxCells; i++)
-	{
-		for (j = 0; j < bitmapCache->cells[i].number + 1; j++)
-		{
-			PERSISTENT_CACHE_ENTRY cacheEntry;
-			rdpBitmap* bitmap = bitmapCache->cells[i].entries[j];
-
-			if (!bitmap || !bitmap->key64)
-				continue;
-
-			cacheEntry.key64 = bitmap->key64;
-			cacheEntry.width = bitmap->width;
-			cacheEntry.height = bitmap->height;
-			cacheEntry.size = (UINT32)(bitmap->width * bitmap->height * 4);
-			cacheEntry.flags = 0;
-			cacheEntry.data = bitmap->data;
-
-			if (persistent_cache_write_entry(persistent, &cacheEntry) < 1)
-			{
-				status = -1;
-				goto end;
-			}
-		}
-	}
-
-	status = 1;
-
-end:
-	persistent_cache_free(persistent);
-	return status;
-}
-
 rdpBitmapCache* bitmap_cache_new(rdpContext* context)
 {
 	UINT32 i;
@@ -364,8 +637,9 @@ rdpBitmapCache* bitmap_cache_new(rdpContext* context)
 	    freerdp_settings_get_uint32(settings, FreeRDP_BitmapCacheV2NumCells);
 	bitmapCache->context = context;
 	bitmapCache->cells = (BITMAP_V2_CELL*)calloc(BitmapCacheV2NumCells, sizeof(BITMAP_V2_CELL));
+	bitmapCache->persistIndex = (UINT32**)calloc(BitmapCacheV2NumCells, sizeof(UINT32*));
 
-	if (!bitmapCache->cells)
+	if (!bitmapCache->cells || !bitmapCache->persistIndex)
 		goto fail;
 	bitmapCache->maxCells = BitmapCacheV2NumCells;
 
@@ -381,6 +655,10 @@ rdpBitmapCache* bitmap_cache_new(rdpContext* context)
 		if (!cell->entries)
 			goto fail;
 		cell->number = nr;
+
+		if (freerdp_settings_get_bool(settings, FreeRDP_BitmapCachePersistEnabled) &&
+		    freerdp_settings_get_string(settings, FreeRDP_BitmapCachePersistFile))
+			bitmapCache->persistMax += nr;
 	}
 
 	return bitmapCache;
@@ -395,7 +673,7 @@ void bitmap_cache_free(rdpBitmapCache* bitmapCache)
 	if (!bitmapCache)
 		return;
 
-	bitmap_cache_save_persistent(bitmapCache);
+	bitmap_cache_persist_stop(bitmapCache);
 
 	UINT32 i;
 	for (i = 0; i < bitmapCache->maxCells; i++)
@@ -409,14 +687,21 @@ void bitmap_cache_free(rdpBitmapCache* bitmapCache)
 		for (j = 0; j < cell->number + 1; j++)
 		{
 			rdpBitmap* bitmap = cell->entries[j];
+			cache_memory_remove(bitmap);
 			Bitmap_Free(bitmapCache->context, bitmap);
 		}
 
 		free(bitmapCache->cells[i].entries);
 	}
 
+	if (bitmapCache->persistIndex)
+	{
+		for (i = 0; i < bitmapCache->maxCells; i++)
+			free(bitmapCache->persistIndex[i]);
+	}
+
+	free(bitmapCache->persistIndex);
 	free(bitmapCache->cells);
-	persistent_cache_free(bitmapCache->persistent);
 
 	free(bitmapCache);
 }
@@ -22,6 +22,7 @@
 
 #include <freerdp/api.h>
 #include <freerdp/update.h>
+#include <freerdp/cache/bitmap.h>
 
 FREERDP_LOCAL BITMAP_UPDATE* copy_bitmap_update(rdpContext* context, const BITMAP_UPDATE* pointer);
 FREERDP_LOCAL void free_bitmap_update(rdpContext* context, BITMAP_UPDATE* pointer);
@@ -38,4 +39,9 @@ FREERDP_LOCAL CACHE_BITMAP_V3_ORDER* copy_cache_bitmap_v3_order(rdpContext* cont
                                                                 const CACHE_BITMAP_V3_ORDER* order);
 FREERDP_LOCAL void free_cache_bitmap_v3_order(rdpContext* context, CACHE_BITMAP_V3_ORDER* order);
 
+/* The persistent key list advertised numEntries[x] keys of the persistent cache file for cell x,
+ * in file order. The entries are loaded into these cells when first used. */
+FREERDP_LOCAL BOOL bitmap_cache_load_persistent(rdpBitmapCache* bitmapCache,
+                                                const UINT32* numEntries, UINT32 count);
+
 #endif /* FREERDP_LIB_CACHE_BITMAP_H */
@@ -20,24 +20,381 @@
 #include <freerdp/config.h>
 
 #include <winpr/crt.h>
+#include <winpr/synch.h>
+#include <winpr/assert.h>
 
 #include <winpr/stream.h>
 
+#include <freerdp/log.h>
 #include <freerdp/cache/cache.h>
+#include <freerdp/codec/planar.h>
 
 #include "cache.h"
 
+#define TAG FREERDP_TAG("cache")
+
+struct rdp_cache_memory
+{
+	rdpContext* context;
+	UINT64 clock; /* stamped into rdpBitmap::lastUse */
+	UINT64 stuck; /* bytes held after the last trim that did not reach the target */
+	wArrayList* bitmaps;
+	BITMAP_PLANAR_CONTEXT* planar;
+	UINT32 planarWidth;
+	UINT32 planarHeight;
+};
+
+static INIT_ONCE cache_memory_once = INIT_ONCE_STATIC_INIT;
+static CRITICAL_SECTION cache_memory_lock;
+static CACHE_MEMORY_STATS cache_memory_stats = { 0 };
+
+static BOOL CALLBACK cache_memory_init(PINIT_ONCE once, PVOID param, PVOID* context)
+{
+	WINPR_UNUSED(once);
+	WINPR_UNUSED(param);
+	WINPR_UNUSED(context);
+	return InitializeCriticalSectionAndSpinCount(&cache_memory_lock, 4000);
+}
+
+static void cache_memory_lock_stats(void)
+{
+	InitOnceExecuteOnce(&cache_memory_once, cache_memory_init, NULL, NULL);
+	EnterCriticalSection(&cache_memory_lock);
+}
+
+static void cache_memory_unlock_stats(void)
+{
+	LeaveCriticalSection(&cache_memory_lock);
+}
+
+static UINT64 cache_memory_bitmap_size(const rdpBitmap* bitmap)
+{
+	UINT32 bpp = FreeRDPGetBytesPerPixel(bitmap->format);
+
+	/* offscreen bitmaps are created without a format, they use the one of the GDI */
+	if (bpp == 0)
+		bpp = 4;
+
+	return 1ull * bitmap->width * bitmap->height * bpp;
+}
+
+static void cache_memory_free(rdpCacheMemory* memory)
+{
+	if (!memory)
+		return;
+
+	ArrayList_Free(memory->bitmaps);
+	freerdp_bitmap_planar_context_free(memory->planar);
+	free(memory);
+}
+
+static rdpCacheMemory* cache_memory_new(rdpContext* context)
+{
+	rdpCacheMemory* memory = calloc(1, sizeof(rdpCacheMemory));
+
+	if (!memory)
+		return NULL;
+
+	memory->context = context;
+	memory->bitmaps = ArrayList_New(FALSE);
+
+	if (!memory->bitmaps)
+	{
+		cache_memory_free(memory);
+		return NULL;
+	}
+
+	return memory;
+}
+
+void cache_set_memory_budget(UINT64 budget)
+{
+	cache_memory_lock_stats();
+	cache_memory_stats.budget = budget;
+	cache_memory_unlock_stats();
+}
+
+void cache_get_memory_stats(CACHE_MEMORY_STATS* stats)
+{
+	WINPR_ASSERT(stats);
+
+	cache_memory_lock_stats();
+	*stats = cache_memory_stats;
+	cache_memory_unlock_stats();
+}
+
+static int cache_memory_compare_use(const void* a, const void* b)
+{
+	const rdpBitmap* bitmapA = *(const rdpBitmap* const*)a;
+	const rdpBitmap* bitmapB = *(const rdpBitmap* const*)b;
+
+	if (bitmapA->lastUse < bitmapB->lastUse)
+		return -1;
+
+	return (bitmapA->lastUse > bitmapB->lastUse) ? 1 : 0;
+}
+
+static BOOL cache_memory_can_compact(const rdpCacheMemory* memory)
+{
+	const rdpGraphics* graphics = memory->context->graphics;
+
+	/* the cached bitmaps are created from the prototype */
+	return graphics && graphics->Bitmap_Prototype && graphics->Bitmap_Prototype->Compact;
+}
+
+/* Compacts the least recently used bitmaps of this session until the bitmaps of all sessions
+ * are back to 7/8 of the budget. Other sessions are left alone, their bitmaps may be in use by
+ * another thread. The bitmap used last is kept, it is about to be drawn.
+ * After a trim that did not reach the target, the next one waits for another 1/16 of the
+ * budget to be added instead of scanning all bitmaps again on every add. */
+static void cache_memory_trim(rdpCache* cache)
+{
+	size_t x;
+	size_t count;
+	size_t idle = 0;
+	UINT64 held;
+	UINT64 target;
+	UINT64 budget;
+	rdpBitmap** bitmaps;
+	rdpCacheMemory* memory = cache->memory;
+
+	cache_memory_lock_stats();
+	budget = cache_memory_stats.budget;
+	held = cache_memory_stats.used + cache_memory_stats.compacted;
+	cache_memory_unlock_stats();
+
+	if ((budget == 0) || (held <= budget))
+	{
+		memory->stuck = 0;
+		return;
+	}
+
+	if (!cache_memory_can_compact(memory))
+		return;
+
+	if ((memory->stuck > 0) && (held < memory->stuck + budget / 16))
+		return;
+
+	target = budget - budget / 8;
+	ArrayList_Clear(memory->bitmaps);
+
+	if (!bitmap_cache_collect_bitmaps(cache->bitmap, memory->bitmaps) ||
+	    !offscreen_cache_collect_bitmaps(cache->offscreen, memory->bitmaps))
+		return;
+
+	count = ArrayList_Count(memory->bitmaps);
+	bitmaps = calloc(count + 1, sizeof(rdpBitmap*));
+
+	if (!bitmaps)
+		return;
+
+	for (x = 0; x < count; x++)
+	{
+		rdpBitmap* bitmap = ArrayList_GetItem(memory->bitmaps, x);
+
+		if (bitmap->Compact && (bitmap->compactLength == 0) && (bitmap->lastUse != memory->clock))
+			bitmaps[idle++] = bitmap;
+	}
+
+	qsort(bitmaps, idle, sizeof(rdpBitmap*), cache_memory_compare_use);
+
+	for (x = 0; (x < idle) && (held > target); x++)
+	{
+		rdpBitmap* bitmap = bitmaps[x];
+		const UINT64 size = cache_memory_bitmap_size(bitmap);
+
+		/* does not compress, try the others first next time */
+		if (!bitmap->Compact(memory->context, bitmap, TRUE))
+		{
+			bitmap->lastUse = ++memory->clock;
+			continue;
+		}
+
+		cache_memory_lock_stats();
+		cache_memory_stats.used -= size;
+		cache_memory_stats.compacted += bitmap->compactLength;
+		cache_memory_stats.compactions++;
+		held = cache_memory_stats.used + cache_memory_stats.compacted;
+		cache_memory_unlock_stats();
+	}
+
+	memory->stuck = (held > target) ? held : 0;
+	free(bitmaps);
+}
+
+void cache_memory_add(rdpCache* cache, rdpBitmap* bitmap)
+{
+	if (!bitmap)
+		return;
+
+	cache_memory_lock_stats();
+	cache_memory_stats.used += cache_memory_bitmap_size(bitmap);
+	cache_memory_unlock_stats();
+
+	if (!cache || !cache->memory)
+		return;
+
+	bitmap->lastUse = ++cache->memory->clock;
+	cache_memory_trim(cache);
+}
+
+void cache_memory_remove(rdpBitmap* bitmap)
+{
+	if (!bitmap)
+		return;
+
+	cache_memory_lock_stats();
+
+	if (bitmap->compactLength > 0)
+		cache_memory_stats.compacted -= bitmap->compactLength;
+	else
+		cache_memory_stats.used -= cache_memory_bitmap_size(bitmap);
+
+	cache_memory_unlock_stats();
+}
+
+static BOOL cache_memory_restore(rdpCache* cache, rdpBitmap* bitmap)
+{
+	const UINT32 length = bitmap->compactLength;
+
+	if (length == 0)
+		return TRUE;
+
+	if (!cache || !cache->memory || !bitmap->Compact ||
+	    !bitmap->Compact(cache->memory->context, bitmap, FALSE))
+	{
+		WLog_ERR(TAG, "failed to restore a compacted %" PRIu32 "x%" PRIu32 " bitmap",
+		         bitmap->width, bitmap->height);
+		return FALSE;
+	}
+
+	cache_memory_lock_stats();
+	cache_memory_stats.compacted -= length;
+	cache_memory_stats.used += cache_memory_bitmap_size(bitmap);
+	cache_memory_stats.restores++;
+	cache_memory_unlock_stats();
+	return TRUE;
+}
+
+BOOL cache_memory_use(rdpCache* cache, rdpBitmap* bitmap)
+{
+	BOOL restore;
+
+	if (!bitmap)
+		return FALSE;
+
+	if (cache && cache->memory)
+		bitmap->lastUse = ++cache->memory->clock;
+
+	restore = (bitmap->compactLength > 0);
+
+	if (!cache_memory_restore(cache, bitmap))
+		return FALSE;
+
+	if (restore)
+		cache_memory_trim(cache);
+
+	return TRUE;
+}
+
+static BITMAP_PLANAR_CONTEXT* cache_memory_get_planar(rdpCacheMemory* memory, UINT32 width,
+                                                      UINT32 height)
+{
+	if (memory->planar && (width <= memory->planarWidth) && (height <= memory->planarHeight))
+		return memory->planar;
+
+	width = MAX(width, memory->planarWidth);
+	height = MAX(height, memory->planarHeight);
+
+	if (!memory->planar)
+		memory->planar = freerdp_bitmap_planar_context_new(PLANAR_FORMAT_HEADER_RLE, width, height);
+	else if (!freerdp_bitmap_planar_context_reset(memory->planar, width, height))
+	{
+		freerdp_bitmap_planar_context_free(memory->planar);
+		memory->planar = NULL;
+	}
+
+	if (!memory->planar)
+	{
+		memory->planarWidth = memory->planarHeight = 0;
+		return NULL;
+	}
+
+	memory->planarWidth = width;
+	memory->planarHeight = height;
+	return memory->planar;
+}
+
+BYTE* cache_memory_compact_pixels(rdpCache* cache, const BYTE* data, UINT32 format, UINT32 width,
+                                  UINT32 height, UINT32 stride, UINT32* length)
+{
+	BYTE* compact;
+	BITMAP_PLANAR_CONTEXT* planar;
+
+	WINPR_ASSERT(length);
+
+	if (!cache || !cache->memory || !data || (width == 0) || (height == 0))
+		return NULL;
+
+	planar = cache_memory_get_planar(cache->memory, width, height);
+
+	if (!planar)
+		return NULL;
+
+	*length = 0;
+	compact = freerdp_bitmap_compress_planar(planar, data, format, width, height, stride, NULL,
+	                                         length);
+
+	if (compact && (*length >= 1ull * width * height * FreeRDPGetBytesPerPixel(format)))
+	{
+		free(compact);
+		return NULL;
+	}
+
+	return compact;
+}
+
+BOOL cache_memory_restore_pixels(rdpCache* cache, const BYTE* compact, UINT32 length, BYTE* data,
+                                 UINT32 format, UINT32 width, UINT32 height, UINT32 stride)
+{
+	BITMAP_PLANAR_CONTEXT* planar;
+
+	if (!cache || !cache->memory || !compact || !data)
+		return FALSE;
+
+	planar = cache_memory_get_planar(cache->memory, width, height);
+
+	if (!planar)
+		return FALSE;
+
+	/* the encoder writes the planes bottom up, as on the wire */
+	return planar_decompress(planar, compact, length, width, height, data, format, stride, 0, 0,
+	                         width, height, TRUE);
+}
+
 rdpCache* cache_new(rdpContext* context)
 {
 	rdpCache* cache;
+	UINT32 budget;
 
 	WINPR_ASSERT(context);
 
+	/* the budget is process wide, sessions without one keep the current setting */
+	budget = freerdp_settings_get_uint32(context->settings, FreeRDP_BitmapCacheMemoryBudget);
+
+	if (budget > 0)
+		cache_set_memory_budget(budget * 1024ull * 1024ull);
+
 	cache = (rdpCache*)calloc(1, sizeof(rdpCache));
 
 	if (!cache)
 		return NULL;
 
+	cache->memory = cache_memory_new(context);
+
+	if (!cache->memory)
+		goto error;
+
 	cache->glyph = glyph_cache_new(context);
 
 	if (!cache->glyph)
@@ -90,6 +447,7 @@ void cache_free(rdpCache* cache)
 		offscreen_cache_free(cache->offscreen);
 		palette_cache_free(cache->palette);
 		nine_grid_cache_free(cache->nine_grid);
+		cache_memory_free(cache->memory);
 		free(cache);
 	}
 }
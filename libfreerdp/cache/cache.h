@@ -23,6 +23,9 @@
 #include <freerdp/api.h>
 #include <freerdp/freerdp.h>
 #include <freerdp/pointer.h>
+#include <freerdp/cache/cache.h>
+
+#include <winpr/collections.h>
 
 FREERDP_LOCAL CACHE_COLOR_TABLE_ORDER*
 copy_cache_color_table_order(rdpContext* context, const CACHE_COLOR_TABLE_ORDER* order);
@@ -33,4 +36,22 @@ FREERDP_LOCAL SURFACE_BITS_COMMAND* copy_surface_bits_command(rdpContext* contex
                                                               const SURFACE_BITS_COMMAND* order);
 FREERDP_LOCAL void free_surface_bits_command(rdpContext* context, SURFACE_BITS_COMMAND* order);
 
+/* accounting of bitmaps held by the bitmap and offscreen caches */
+FREERDP_LOCAL void cache_memory_add(rdpCache* cache, rdpBitmap* bitmap);
+FREERDP_LOCAL void cache_memory_remove(rdpBitmap* bitmap);
+FREERDP_LOCAL BOOL cache_memory_use(rdpCache* cache, rdpBitmap* bitmap);
+
+/* append the bitmaps that may be compacted, the current offscreen surface is left out */
+FREERDP_LOCAL BOOL bitmap_cache_collect_bitmaps(rdpBitmapCache* bitmapCache, wArrayList* list);
+FREERDP_LOCAL BOOL offscreen_cache_collect_bitmaps(rdpOffscreenCache* offscreenCache,
+                                                   wArrayList* list);
+
+/* compression of the pixels of compacted bitmaps, for pBitmap_Compact implementations */
+FREERDP_LOCAL BYTE* cache_memory_compact_pixels(rdpCache* cache, const BYTE* data, UINT32 format,
+                                                UINT32 width, UINT32 height, UINT32 stride,
+                                                UINT32* length);
+FREERDP_LOCAL BOOL cache_memory_restore_pixels(rdpCache* cache, const BYTE* compact,
+                                               UINT32 length, BYTE* data, UINT32 format,
+                                               UINT32 width, UINT32 height, UINT32 stride);
+
 #endif /* FREERDP_LIB_CACHE_CACHE_H */
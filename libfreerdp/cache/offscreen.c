@@ -31,6 +31,8 @@
 
 #include "../core/graphics.h"
 
+#include "cache.h"
+
 #define TAG FREERDP_TAG("cache.offscreen")
 
 struct rdp_offscreen_cache
@@ -140,6 +142,9 @@ rdpBitmap* offscreen_cache_get(rdpOffscreenCache* offscreenCache, UINT32 index)
 		return NULL;
 	}
 
+	if (!cache_memory_use(offscreenCache->context->cache, bitmap))
+		return NULL;
+
 	return bitmap;
 }
 
@@ -155,6 +160,7 @@ void offscreen_cache_put(rdpOffscreenCache* offscreenCache, UINT32 index, rdpBit
 
 	offscreen_cache_delete(offscreenCache, index);
 	offscreenCache->entries[index] = bitmap;
+	cache_memory_add(offscreenCache->context->cache, bitmap);
 }
 
 void offscreen_cache_delete(rdpOffscreenCache* offscreenCache, UINT32 index)
@@ -172,11 +178,38 @@ void offscreen_cache_delete(rdpOffscreenCache* offscreenCache, UINT32 index)
 	prevBitmap = offscreenCache->entries[index];
 
 	if (prevBitmap != NULL)
+	{
+		cache_memory_remove(prevBitmap);
 		Bitmap_Free(offscreenCache->context, prevBitmap);
+	}
 
 	offscreenCache->entries[index] = NULL;
 }
 
+BOOL offscreen_cache_collect_bitmaps(rdpOffscreenCache* offscreenCache, wArrayList* list)
+{
+	UINT32 i;
+
+	WINPR_ASSERT(list);
+
+	if (!offscreenCache)
+		return TRUE;
+
+	for (i = 0; i < offscreenCache->maxEntries; i++)
+	{
+		rdpBitmap* bitmap = offscreenCache->entries[i];
+
+		/* the current surface is drawn to without being looked up */
+		if (!bitmap || (i == offscreenCache->currentSurface))
+			continue;
+
+		if (!ArrayList_Append(list, bitmap))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
 void offscreen_cache_register_callbacks(rdpUpdate* update)
 {
 	WINPR_ASSERT(update);
@@ -231,6 +264,7 @@ void offscreen_cache_free(rdpOffscreenCache* offscreenCache)
 			for (i = 0; i < offscreenCache->maxEntries; i++)
 			{
 				rdpBitmap* bitmap = offscreenCache->entries[i];
+				cache_memory_remove(bitmap);
 				Bitmap_Free(offscreenCache->context, bitmap);
 			}
 		}
@@ -39,6 +39,9 @@ struct rdp_persistent_cache
 	char* filename;
 	BYTE* bmpData;
 	UINT32 bmpSize;
+	UINT64* keys;     /* keys of the entries found when opening for read */
+	long* offsets;    /* file offsets of these entries */
+	size_t indexSize; /* allocated index entries */
 };
 
 int persistent_cache_get_version(rdpPersistentCache* persistent)
@@ -51,6 +54,40 @@ int persistent_cache_get_count(rdpPersistentCache* persistent)
 	return persistent->count;
 }
 
+const UINT64* persistent_cache_get_keys(rdpPersistentCache* persistent)
+{
+	return persistent->keys;
+}
+
+static BOOL persistent_cache_index_entry(rdpPersistentCache* persistent, UINT64 key64,
+                                         long offset)
+{
+	const size_t count = (size_t)persistent->count;
+
+	if (count >= persistent->indexSize)
+	{
+		long* offsets;
+		const size_t size = MAX(persistent->indexSize * 2, 256);
+		UINT64* keys = realloc(persistent->keys, size * sizeof(UINT64));
+
+		if (!keys)
+			return FALSE;
+
+		persistent->keys = keys;
+		offsets = realloc(persistent->offsets, size * sizeof(long));
+
+		if (!offsets)
+			return FALSE;
+
+		persistent->offsets = offsets;
+		persistent->indexSize = size;
+	}
+
+	persistent->keys[count] = key64;
+	persistent->offsets[count] = offset;
+	return TRUE;
+}
+
 static int persistent_cache_read_entry_v2(rdpPersistentCache* persistent,
                                           PERSISTENT_CACHE_ENTRY* entry)
 {
@@ -115,6 +152,8 @@ static int persistent_cache_read_v2(rdpPersistentCache* persistent)
 
 	while (1)
 	{
+		const long offset = ftell(persistent->fp);
+
 		if (fread((void*)&entry, 1, sizeof(PERSISTENT_CACHE_ENTRY_V2), persistent->fp) !=
 		    sizeof(PERSISTENT_CACHE_ENTRY_V2))
 			break;
@@ -122,6 +161,9 @@ static int persistent_cache_read_v2(rdpPersistentCache* persistent)
 		if (fseek(persistent->fp, 0x4000, SEEK_CUR) != 0)
 			break;
 
+		if (!persistent_cache_index_entry(persistent, entry.key64, offset))
+			return -1;
+
 		persistent->count++;
 	}
 
@@ -194,6 +236,8 @@ static int persistent_cache_read_v3(rdpPersistentCache* persistent)
 
 	while (1)
 	{
+		const long offset = ftell(persistent->fp);
+
 		if (fread((void*)&entry, 1, sizeof(PERSISTENT_CACHE_ENTRY_V3), persistent->fp) !=
 		    sizeof(PERSISTENT_CACHE_ENTRY_V3))
 			break;
@@ -201,6 +245,9 @@ static int persistent_cache_read_v3(rdpPersistentCache* persistent)
 		if (fseek(persistent->fp, (entry.width * entry.height * 4), SEEK_CUR) != 0)
 			break;
 
+		if (!persistent_cache_index_entry(persistent, entry.key64, offset))
+			return -1;
+
 		persistent->count++;
 	}
 
@@ -217,6 +264,18 @@ int persistent_cache_read_entry(rdpPersistentCache* persistent, PERSISTENT_CACHE
 	return -1;
 }
 
+int persistent_cache_read_entry_at(rdpPersistentCache* persistent, int index,
+                                   PERSISTENT_CACHE_ENTRY* entry)
+{
+	if ((index < 0) || (index >= persistent->count) || !persistent->offsets)
+		return -1;
+
+	if (fseek(persistent->fp, persistent->offsets[index], SEEK_SET) != 0)
+		return -1;
+
+	return persistent_cache_read_entry(persistent, entry);
+}
+
 int persistent_cache_write_entry(rdpPersistentCache* persistent,
                                  const PERSISTENT_CACHE_ENTRY* entry)
 {
@@ -351,6 +410,8 @@ void persistent_cache_free(rdpPersistentCache* persistent)
 	free(persistent->filename);
 
 	free(persistent->bmpData);
+	free(persistent->keys);
+	free(persistent->offsets);
 
 	free(persistent);
 }
@@ -35,6 +35,12 @@
 static BOOL pointer_cache_put(rdpPointerCache* pointer_cache, UINT32 index, rdpPointer* pointer);
 static rdpPointer* pointer_cache_get(rdpPointerCache* pointer_cache, UINT32 index);
 
+typedef struct
+{
+	rdpPointer* pointer;
+	size_t refs;
+} pointerCacheShape;
+
 static void pointer_free(rdpContext* context, rdpPointer* pointer)
 {
 	if (pointer)
@@ -57,6 +63,157 @@ static void pointer_free(rdpContext* context, rdpPointer* pointer)
 	}
 }
 
+/* a pointer that was never handed to pointer->New, only the masks need to go */
+static void pointer_discard(rdpPointer* pointer)
+{
+	if (pointer)
+	{
+		free(pointer->xorMaskData);
+		free(pointer->andMaskData);
+		free(pointer);
+	}
+}
+
+static UINT32 pointer_shape_hash_data(UINT32 hash, const BYTE* data, size_t length)
+{
+	size_t x;
+
+	for (x = 0; x < length; x++)
+		hash = (hash ^ data[x]) * 16777619u;
+
+	return hash;
+}
+
+static UINT32 pointer_shape_hash(const void* key)
+{
+	const rdpPointer* pointer = key;
+	const UINT32 header[] = { pointer->xorBpp,        pointer->xPos,         pointer->yPos,
+		                      pointer->width,         pointer->height,       pointer->lengthAndMask,
+		                      pointer->lengthXorMask };
+	UINT32 hash = 2166136261u;
+
+	WINPR_ASSERT(pointer);
+	hash = pointer_shape_hash_data(hash, (const BYTE*)header, sizeof(header));
+	hash = pointer_shape_hash_data(hash, pointer->andMaskData, pointer->lengthAndMask);
+	return pointer_shape_hash_data(hash, pointer->xorMaskData, pointer->lengthXorMask);
+}
+
+static BOOL pointer_shape_equals(const void* objA, const void* objB)
+{
+	const rdpPointer* a = objA;
+	const rdpPointer* b = objB;
+
+	if (a == b)
+		return TRUE;
+
+	if (!a || !b)
+		return FALSE;
+
+	if ((a->xorBpp != b->xorBpp) || (a->xPos != b->xPos) || (a->yPos != b->yPos) ||
+	    (a->width != b->width) || (a->height != b->height) ||
+	    (a->lengthAndMask != b->lengthAndMask) || (a->lengthXorMask != b->lengthXorMask))
+		return FALSE;
+
+	if ((a->lengthAndMask > 0) && (memcmp(a->andMaskData, b->andMaskData, a->lengthAndMask) != 0))
+		return FALSE;
+
+	return (a->lengthXorMask == 0) ||
+	       (memcmp(a->xorMaskData, b->xorMaskData, a->lengthXorMask) == 0);
+}
+
+/* returns the already converted pointer with the same shape, if there is one */
+static rdpPointer* pointer_cache_find_shape(rdpPointerCache* pointer_cache,
+                                            const rdpPointer* pointer)
+{
+	const pointerCacheShape* shape;
+
+	WINPR_ASSERT(pointer_cache);
+
+	shape = HashTable_GetItemValue(pointer_cache->shapes, pointer);
+	if (!shape)
+		return NULL;
+
+	return shape->pointer;
+}
+
+static void pointer_cache_drop_shape(rdpPointerCache* pointer_cache, rdpPointer* pointer)
+{
+	HashTable_Remove(pointer_cache->shapes, pointer);
+	pointer_free(pointer_cache->context, pointer);
+}
+
+static BOOL pointer_cache_acquire_shape(rdpPointerCache* pointer_cache, rdpPointer* pointer)
+{
+	pointerCacheShape* shape = HashTable_GetItemValue(pointer_cache->shapes, pointer);
+
+	if (!shape)
+	{
+		shape = calloc(1, sizeof(pointerCacheShape));
+		if (!shape)
+			return FALSE;
+
+		shape->pointer = pointer;
+		if (!HashTable_Insert(pointer_cache->shapes, pointer, shape))
+		{
+			free(shape);
+			return FALSE;
+		}
+	}
+
+	WINPR_ASSERT(shape->pointer == pointer);
+
+	/* a shape that is in use again is no longer a candidate for eviction */
+	if (shape->refs == 0)
+	{
+		size_t x;
+
+		for (x = 0; x < pointer_cache->unusedCount; x++)
+		{
+			if (pointer_cache->unused[x] != pointer)
+				continue;
+
+			pointer_cache->unusedCount--;
+			memmove(&pointer_cache->unused[x], &pointer_cache->unused[x + 1],
+			        (pointer_cache->unusedCount - x) * sizeof(rdpPointer*));
+			break;
+		}
+	}
+
+	shape->refs++;
+	return TRUE;
+}
+
+/* Shapes no longer referenced by a slot are kept for a while, servers tend to cycle through a
+ * few cursors in the same slot. */
+static void pointer_cache_release_shape(rdpPointerCache* pointer_cache, rdpPointer* pointer)
+{
+	pointerCacheShape* shape;
+
+	if (!pointer)
+		return;
+
+	shape = HashTable_GetItemValue(pointer_cache->shapes, pointer);
+	if (!shape)
+	{
+		pointer_free(pointer_cache->context, pointer);
+		return;
+	}
+
+	WINPR_ASSERT(shape->refs > 0);
+	if (--shape->refs > 0)
+		return;
+
+	if (pointer_cache->unusedCount == ARRAYSIZE(pointer_cache->unused))
+	{
+		pointer_cache_drop_shape(pointer_cache, pointer_cache->unused[0]);
+		pointer_cache->unusedCount--;
+		memmove(&pointer_cache->unused[0], &pointer_cache->unused[1],
+		        pointer_cache->unusedCount * sizeof(rdpPointer*));
+	}
+
+	pointer_cache->unused[pointer_cache->unusedCount++] = pointer;
+}
+
 static BOOL update_pointer_position(rdpContext* context,
                                     const POINTER_POSITION_UPDATE* pointer_position)
 {
@@ -134,17 +291,48 @@ static BOOL upate_pointer_copy_andxor(rdpPointer* pointer, const BYTE* andMaskDa
 	return TRUE;
 }
 
-static BOOL update_pointer_color(rdpContext* context, const POINTER_COLOR_UPDATE* pointer_color)
+/* Takes ownership of pointer. Identical shapes share one native pointer, so only the first one
+ * is converted by pointer->New. */
+static BOOL update_pointer_cache_and_set(rdpContext* context, UINT32 index, rdpPointer* pointer)
 {
-	rdpPointer* pointer;
+	rdpPointer* shared;
 	rdpCache* cache;
 
 	WINPR_ASSERT(context);
-	WINPR_ASSERT(pointer_color);
+	WINPR_ASSERT(pointer);
 
 	cache = context->cache;
 	WINPR_ASSERT(cache);
 
+	shared = pointer_cache_find_shape(cache->pointer, pointer);
+	if (shared)
+	{
+		pointer_discard(pointer);
+		pointer = shared;
+	}
+	else if (!IFCALLRESULT(TRUE, pointer->New, context, pointer))
+	{
+		pointer_free(context, pointer);
+		return FALSE;
+	}
+
+	if (!pointer_cache_put(cache->pointer, index, pointer))
+	{
+		if (!shared)
+			pointer_free(context, pointer);
+		return FALSE;
+	}
+
+	return IFCALLRESULT(TRUE, pointer->Set, context, pointer);
+}
+
+static BOOL update_pointer_color(rdpContext* context, const POINTER_COLOR_UPDATE* pointer_color)
+{
+	rdpPointer* pointer;
+
+	WINPR_ASSERT(context);
+	WINPR_ASSERT(pointer_color);
+
 	pointer = Pointer_Alloc(context);
 
 	if (pointer == NULL)
@@ -160,32 +348,19 @@ static BOOL update_pointer_color(rdpContext* context, const POINTER_COLOR_UPDATE
 	                               pointer_color->lengthXorMask))
 		goto out_fail;
 
-	if (!IFCALLRESULT(TRUE, pointer->New, context, pointer))
-		goto out_fail;
-
-	if (!pointer_cache_put(cache->pointer, pointer_color->cacheIndex, pointer))
-		goto out_fail;
-
-	if (!IFCALLRESULT(TRUE, pointer->Set, context, pointer))
-		goto out_fail;
-
-	return TRUE;
+	return update_pointer_cache_and_set(context, pointer_color->cacheIndex, pointer);
 out_fail:
-	pointer_free(context, pointer);
+	pointer_discard(pointer);
 	return FALSE;
 }
 
 static BOOL update_pointer_large(rdpContext* context, const POINTER_LARGE_UPDATE* pointer_large)
 {
 	rdpPointer* pointer;
-	rdpCache* cache;
 
 	WINPR_ASSERT(context);
 	WINPR_ASSERT(pointer_large);
 
-	cache = context->cache;
-	WINPR_ASSERT(cache);
-
 	pointer = Pointer_Alloc(context);
 	if (pointer == NULL)
 		return FALSE;
@@ -200,30 +375,19 @@ static BOOL update_pointer_large(rdpContext* context, const POINTER_LARGE_UPDATE
 	                               pointer_large->lengthXorMask))
 		goto out_fail;
 
-	if (!IFCALLRESULT(TRUE, pointer->New, context, pointer))
-		goto out_fail;
-
-	if (!pointer_cache_put(cache->pointer, pointer_large->cacheIndex, pointer))
-		goto out_fail;
-
-	if (!IFCALLRESULT(TRUE, pointer->Set, context, pointer))
-		goto out_fail;
-
-	return TRUE;
+	return update_pointer_cache_and_set(context, pointer_large->cacheIndex, pointer);
 out_fail:
-	pointer_free(context, pointer);
+	pointer_discard(pointer);
 	return FALSE;
 }
 
 static BOOL update_pointer_new(rdpContext* context, const POINTER_NEW_UPDATE* pointer_new)
 {
 	rdpPointer* pointer;
-	rdpCache* cache;
 
 	if (!context || !pointer_new)
 		return FALSE;
 
-	cache = context->cache;
 	pointer = Pointer_Alloc(context);
 
 	if (!pointer)
@@ -239,17 +403,9 @@ static BOOL update_pointer_new(rdpContext* context, const POINTER_NEW_UPDATE* po
 	        pointer_new->colorPtrAttr.xorMaskData, pointer_new->colorPtrAttr.lengthXorMask))
 		goto out_fail;
 
-	if (!IFCALLRESULT(TRUE, pointer->New, context, pointer))
-		goto out_fail;
-
-	if (!pointer_cache_put(cache->pointer, pointer_new->colorPtrAttr.cacheIndex, pointer))
-		goto out_fail;
-
-	if (!IFCALLRESULT(TRUE, pointer->Set, context, pointer))
-		goto out_fail;
-	return TRUE;
+	return update_pointer_cache_and_set(context, pointer_new->colorPtrAttr.cacheIndex, pointer);
 out_fail:
-	pointer_free(context, pointer);
+	pointer_discard(pointer);
 	return FALSE;
 }
 
@@ -301,10 +457,13 @@ BOOL pointer_cache_put(rdpPointerCache* pointer_cache, UINT32 index, rdpPointer*
 		return FALSE;
 	}
 
+	if (!pointer_cache_acquire_shape(pointer_cache, pointer))
+		return FALSE;
+
 	WINPR_ASSERT(pointer_cache->entries);
 	prevPointer = pointer_cache->entries[index];
-	pointer_free(pointer_cache->context, prevPointer);
 	pointer_cache->entries[index] = pointer;
+	pointer_cache_release_shape(pointer_cache, prevPointer);
 	return TRUE;
 }
 
@@ -350,32 +509,46 @@ rdpPointerCache* pointer_cache_new(rdpContext* context)
 	 * matches */
 	pointer_cache->cacheSize = freerdp_settings_get_uint32(settings, FreeRDP_PointerCacheSize) + 1;
 	pointer_cache->entries = (rdpPointer**)calloc(pointer_cache->cacheSize, sizeof(rdpPointer*));
+	pointer_cache->shapes = HashTable_New(FALSE);
+
+	if (!pointer_cache->entries || !pointer_cache->shapes)
+		goto fail;
+
+	if (!HashTable_SetHashFunction(pointer_cache->shapes, pointer_shape_hash))
+		goto fail;
 
-	if (!pointer_cache->entries)
 	{
-		free(pointer_cache);
-		return NULL;
+		wObject* key = HashTable_KeyObject(pointer_cache->shapes);
+		wObject* value = HashTable_ValueObject(pointer_cache->shapes);
+		WINPR_ASSERT(key);
+		WINPR_ASSERT(value);
+		key->fnObjectEquals = pointer_shape_equals;
+		value->fnObjectFree = free;
 	}
 
 	return pointer_cache;
+fail:
+	pointer_cache_free(pointer_cache);
+	return NULL;
 }
 
 void pointer_cache_free(rdpPointerCache* pointer_cache)
 {
 	if (pointer_cache != NULL)
 	{
-		UINT32 i;
-		rdpPointer* pointer;
+		size_t i;
+		size_t count = 0;
+		ULONG_PTR* keys = NULL;
 
-		if (pointer_cache->entries)
-		{
-			for (i = 0; i < pointer_cache->cacheSize; i++)
-			{
-				pointer = pointer_cache->entries[i];
-				pointer_free(pointer_cache->context, pointer);
-			}
-		}
+		if (pointer_cache->shapes)
+			count = HashTable_GetKeys(pointer_cache->shapes, &keys);
+
+		/* every pointer in a slot is a shape, slots may share them */
+		for (i = 0; i < count; i++)
+			pointer_free(pointer_cache->context, (rdpPointer*)keys[i]);
 
+		free(keys);
+		HashTable_Free(pointer_cache->shapes);
 		free(pointer_cache->entries);
 		free(pointer_cache);
 	}
@@ -0,0 +1,265 @@
+#include <stdio.h>
+
+#include <winpr/crt.h>
+#include <winpr/file.h>
+#include <winpr/path.h>
+#include <winpr/sysinfo.h>
+
+#include <freerdp/freerdp.h>
+#include <freerdp/gdi/gdi.h>
+#include <freerdp/cache/cache.h>
+#include <freerdp/cache/persistent.h>
+
+#include "../bitmap.h"
+
+#define TEST_SIZE 16
+#define TEST_BITMAP_BYTES (TEST_SIZE * TEST_SIZE * 4)
+
+static BOOL test_cache_bitmap(rdpContext* context, UINT32 id, UINT32 index, UINT32 key)
+{
+	size_t x;
+	BOOL rc;
+	CACHE_BITMAP_V2_ORDER order = { 0 };
+	BYTE* data = malloc(TEST_BITMAP_BYTES);
+
+	if (!data)
+		return FALSE;
+
+	for (x = 0; x < TEST_BITMAP_BYTES; x += 4)
+	{
+		data[x] = (BYTE)key;
+		data[x + 1] = 0x40;
+		data[x + 2] = 0x80;
+		data[x + 3] = 0xFF;
+	}
+
+	order.cacheId = id;
+	order.cacheIndex = index;
+	order.key1 = key;
+	order.key2 = 0x12345678;
+	order.bitmapBpp = 32;
+	order.bitmapWidth = TEST_SIZE;
+	order.bitmapHeight = TEST_SIZE;
+	order.bitmapLength = TEST_BITMAP_BYTES;
+	order.bitmapDataStream = data;
+	rc = context->update->secondary->CacheBitmapV2(context, &order);
+	free(data);
+	return rc;
+}
+
+static BOOL test_draw_bitmap(rdpContext* context, UINT32 id, UINT32 index, UINT32 key)
+{
+	BYTE r, g, b;
+	UINT32 color;
+	rdpGdi* gdi = context->gdi;
+	MEMBLT_ORDER memblt = { 0 };
+
+	ZeroMemory(gdi->primary_buffer, 1ull * gdi->stride * gdi->height);
+	memblt.cacheId = id;
+	memblt.cacheIndex = index;
+	memblt.nWidth = TEST_SIZE;
+	memblt.nHeight = TEST_SIZE;
+	memblt.bRop = 0xCC; /* SRCCOPY */
+
+	if (!context->update->primary->MemBlt(context, &memblt))
+		return FALSE;
+
+	color = FreeRDPReadColor(&gdi->primary_buffer[4 * gdi->stride + 4 * 4], gdi->dstFormat);
+	FreeRDPSplitColor(color, gdi->dstFormat, &r, &g, &b, NULL, NULL);
+
+	if ((r != 0x80) || (g != 0x40) || (b != (BYTE)key))
+	{
+		fprintf(stderr, "cell %" PRIu32 " entry %" PRIu32 " does not hold bitmap %" PRIu32 "\n",
+		        id, index, key);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/* an entry the server never sent is skipped, nothing is drawn */
+static BOOL test_draw_missing(rdpContext* context, UINT32 id, UINT32 index)
+{
+	rdpGdi* gdi = context->gdi;
+	MEMBLT_ORDER memblt = { 0 };
+
+	memset(gdi->primary_buffer, 0x11, 1ull * gdi->stride * gdi->height);
+	memblt.cacheId = id;
+	memblt.cacheIndex = index;
+	memblt.nWidth = TEST_SIZE;
+	memblt.nHeight = TEST_SIZE;
+	memblt.bRop = 0xCC; /* SRCCOPY */
+
+	if (!context->update->primary->MemBlt(context, &memblt))
+		return FALSE;
+
+	return gdi->primary_buffer[4 * gdi->stride + 4 * 4] == 0x11;
+}
+
+static BOOL test_check_file(const char* file, const UINT32* keys, size_t count)
+{
+	size_t x;
+	BOOL rc = FALSE;
+	const UINT64* keyList;
+	rdpPersistentCache* persistent = persistent_cache_new();
+
+	if (!persistent || (persistent_cache_open(persistent, file, FALSE, 0) < 1))
+		goto fail;
+
+	if (persistent_cache_get_count(persistent) != (int)count)
+	{
+		fprintf(stderr, "expected %" PRIuz " persistent entries, got %d\n", count,
+		        persistent_cache_get_count(persistent));
+		goto fail;
+	}
+
+	keyList = persistent_cache_get_keys(persistent);
+
+	for (x = 0; x < count; x++)
+	{
+		if (keyList[x] != (keys[x] | (0x12345678ull << 32)))
+			goto fail;
+	}
+
+	rc = TRUE;
+fail:
+	persistent_cache_free(persistent);
+	return rc;
+}
+
+static freerdp* test_session_new(const char* file)
+{
+	rdpSettings* settings;
+	freerdp* instance = freerdp_new();
+
+	if (!instance)
+		return NULL;
+
+	if (!freerdp_context_new(instance))
+		goto fail;
+
+	settings = instance->context->settings;
+
+	if (!freerdp_settings_set_uint32(settings, FreeRDP_DesktopWidth, 64) ||
+	    !freerdp_settings_set_uint32(settings, FreeRDP_DesktopHeight, 64) ||
+	    !freerdp_settings_set_uint32(settings, FreeRDP_ColorDepth, 32) ||
+	    !freerdp_settings_set_uint32(settings, FreeRDP_BitmapCacheVersion, 2) ||
+	    !freerdp_settings_set_bool(settings, FreeRDP_BitmapCachePersistEnabled, TRUE) ||
+	    !freerdp_settings_set_string(settings, FreeRDP_BitmapCachePersistFile, file) ||
+	    !gdi_init(instance, PIXEL_FORMAT_BGRX32))
+		goto fail;
+
+	return instance;
+fail:
+	freerdp_context_free(instance);
+	freerdp_free(instance);
+	return NULL;
+}
+
+static void test_session_free(freerdp* instance)
+{
+	if (!instance)
+		return;
+
+	gdi_free(instance);
+	freerdp_context_free(instance);
+	freerdp_free(instance);
+}
+
+/* the entries are written once per key, the cells they were in do not matter */
+static BOOL test_persist(const char* file)
+{
+	const UINT32 keys[] = { 1, 2, 3 };
+	freerdp* instance = test_session_new(file);
+	rdpContext* context;
+
+	if (!instance)
+		return FALSE;
+
+	context = instance->context;
+
+	if (!test_cache_bitmap(context, 0, 0, 1) || !test_cache_bitmap(context, 0, 1, 2) ||
+	    !test_cache_bitmap(context, 0, 0, 1) || !test_cache_bitmap(context, 1, 3, 3) ||
+	    !test_cache_bitmap(context, 2, 5, 2))
+	{
+		test_session_free(instance);
+		return FALSE;
+	}
+
+	/* the file of the previous session is replaced on close */
+	test_session_free(instance);
+	return test_check_file(file, keys, ARRAYSIZE(keys));
+}
+
+/* the entries are loaded into the cells the persistent key list advertised them for */
+static BOOL test_reload(const char* file)
+{
+	BOOL rc = FALSE;
+	const UINT32 numEntries[] = { 2, 1, 0, 0, 0 };
+	const UINT32 keys[] = { 4, 1, 3, 5 };
+	freerdp* instance = test_session_new(file);
+	rdpContext* context;
+
+	if (!instance)
+		return FALSE;
+
+	context = instance->context;
+
+	if (!bitmap_cache_load_persistent(context->cache->bitmap, numEntries, ARRAYSIZE(numEntries)))
+		goto fail;
+
+	/* the server replaced the second advertised entry */
+	if (!test_cache_bitmap(context, 0, 1, 4))
+		goto fail;
+
+	if (!test_draw_bitmap(context, 0, 0, 1) || !test_draw_bitmap(context, 0, 1, 4) ||
+	    !test_draw_bitmap(context, 1, 0, 3))
+		goto fail;
+
+	/* the cell holds more entries than the file advertised for it */
+	if (!test_draw_missing(context, 1, 7) || !test_cache_bitmap(context, 1, 5, 5) ||
+	    !test_draw_bitmap(context, 1, 5, 5))
+		goto fail;
+
+	rc = TRUE;
+fail:
+	test_session_free(instance);
+
+	/* the new entry and the loaded ones are kept for the next session */
+	return rc && test_check_file(file, keys, ARRAYSIZE(keys));
+}
+
+int TestBitmapCachePersist(int argc, char* argv[])
+{
+	int rc = -1;
+	char name[64] = { 0 };
+	char* file = NULL;
+
+	WINPR_UNUSED(argc);
+	WINPR_UNUSED(argv);
+
+	sprintf_s(name, sizeof(name), "TestBitmapCachePersist-%" PRIu32 ".bmc",
+	          GetCurrentProcessId());
+	file = GetKnownSubPath(KNOWN_PATH_TEMP, name);
+
+	if (!file)
+		return -1;
+
+	if (!test_persist(file))
+	{
+		fprintf(stderr, "test_persist failed\n");
+		goto fail;
+	}
+
+	if (!test_reload(file))
+	{
+		fprintf(stderr, "test_reload failed\n");
+		goto fail;
+	}
+
+	rc = 0;
+fail:
+	DeleteFileA(file);
+	free(file);
+	return rc;
+}
@@ -0,0 +1,213 @@
+#include <stdio.h>
+
+#include <winpr/crt.h>
+
+#include <freerdp/freerdp.h>
+#include <freerdp/gdi/gdi.h>
+#include <freerdp/cache/cache.h>
+
+#define TEST_SIZE 64
+#define TEST_BITMAPS 8
+#define TEST_BITMAP_BYTES (TEST_SIZE * TEST_SIZE * 4)
+
+static UINT64 test_held(const CACHE_MEMORY_STATS* stats)
+{
+	return stats->used + stats->compacted;
+}
+
+static BYTE test_color(UINT32 index)
+{
+	return (BYTE)(0x20 + index * 0x10);
+}
+
+/* a solid, well compressible bitmap */
+static BOOL test_cache_bitmap(rdpContext* context, UINT32 index)
+{
+	size_t x;
+	BOOL rc;
+	CACHE_BITMAP_V2_ORDER order = { 0 };
+	BYTE* data = malloc(TEST_BITMAP_BYTES);
+
+	if (!data)
+		return FALSE;
+
+	for (x = 0; x < TEST_BITMAP_BYTES; x += 4)
+	{
+		data[x] = test_color(index);
+		data[x + 1] = 0x40;
+		data[x + 2] = 0x80;
+		data[x + 3] = 0xFF;
+	}
+
+	order.cacheId = 0;
+	order.cacheIndex = index;
+	order.bitmapBpp = 32;
+	order.bitmapWidth = TEST_SIZE;
+	order.bitmapHeight = TEST_SIZE;
+	order.bitmapLength = TEST_BITMAP_BYTES;
+	order.bitmapDataStream = data;
+	rc = context->update->secondary->CacheBitmapV2(context, &order);
+	free(data);
+	return rc;
+}
+
+static BOOL test_draw_bitmap(rdpContext* context, UINT32 index)
+{
+	BYTE r, g, b;
+	UINT32 color;
+	rdpGdi* gdi = context->gdi;
+	MEMBLT_ORDER memblt = { 0 };
+
+	memblt.cacheId = 0;
+	memblt.cacheIndex = index;
+	memblt.nWidth = TEST_SIZE;
+	memblt.nHeight = TEST_SIZE;
+	memblt.bRop = 0xCC; /* SRCCOPY */
+
+	if (!context->update->primary->MemBlt(context, &memblt))
+		return FALSE;
+
+	color = FreeRDPReadColor(&gdi->primary_buffer[10 * gdi->stride + 10 * 4], gdi->dstFormat);
+	FreeRDPSplitColor(color, gdi->dstFormat, &r, &g, &b, NULL, NULL);
+	return (r == 0x80) && (g == 0x40) && (b == test_color(index));
+}
+
+static BOOL test_budget(rdpContext* context)
+{
+	UINT32 x;
+	CACHE_MEMORY_STATS before = { 0 };
+	CACHE_MEMORY_STATS stats = { 0 };
+	UINT64 budget;
+
+	cache_get_memory_stats(&before);
+	budget = test_held(&before) + TEST_BITMAPS * TEST_BITMAP_BYTES / 2;
+	cache_set_memory_budget(budget);
+	cache_get_memory_stats(&stats);
+
+	if (stats.budget != budget)
+		return FALSE;
+
+	for (x = 0; x < TEST_BITMAPS; x++)
+	{
+		if (!test_cache_bitmap(context, x))
+			return FALSE;
+	}
+
+	cache_get_memory_stats(&stats);
+
+	if ((stats.compactions <= before.compactions) || (stats.compacted <= before.compacted))
+	{
+		fprintf(stderr, "no bitmap compacted above the budget\n");
+		return FALSE;
+	}
+
+	if (test_held(&stats) > budget)
+	{
+		fprintf(stderr, "%" PRIu64 " bytes held, above the budget of %" PRIu64 "\n",
+		        test_held(&stats), budget);
+		return FALSE;
+	}
+
+	/* the oldest bitmap was compacted first, drawing restores it */
+	if (!test_draw_bitmap(context, 0))
+	{
+		fprintf(stderr, "compacted bitmap not restored\n");
+		return FALSE;
+	}
+
+	before = stats;
+	cache_get_memory_stats(&stats);
+
+	if (stats.restores != before.restores + 1)
+		return FALSE;
+
+	/* the bitmaps that were not compacted are drawn as they are */
+	if (!test_draw_bitmap(context, TEST_BITMAPS - 1))
+		return FALSE;
+
+	cache_get_memory_stats(&stats);
+	return stats.restores == before.restores + 1;
+}
+
+static BOOL test_no_budget(rdpContext* context)
+{
+	UINT32 x;
+	CACHE_MEMORY_STATS before = { 0 };
+	CACHE_MEMORY_STATS stats = { 0 };
+
+	cache_set_memory_budget(0);
+	cache_get_memory_stats(&before);
+
+	for (x = 0; x < TEST_BITMAPS; x++)
+	{
+		if (!test_cache_bitmap(context, x + TEST_BITMAPS))
+			return FALSE;
+	}
+
+	cache_get_memory_stats(&stats);
+
+	if ((stats.compactions != before.compactions) ||
+	    (stats.used != before.used + TEST_BITMAPS * TEST_BITMAP_BYTES))
+	{
+		fprintf(stderr, "bitmaps compacted without a budget\n");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+int TestCacheMemory(int argc, char* argv[])
+{
+	int rc = -1;
+	rdpContext* context;
+	CACHE_MEMORY_STATS stats = { 0 };
+	freerdp* instance = freerdp_new();
+
+	WINPR_UNUSED(argc);
+	WINPR_UNUSED(argv);
+
+	if (!instance)
+		return -1;
+
+	if (!freerdp_context_new(instance))
+		goto fail;
+
+	context = instance->context;
+
+	if (!freerdp_settings_set_uint32(context->settings, FreeRDP_DesktopWidth, TEST_SIZE) ||
+	    !freerdp_settings_set_uint32(context->settings, FreeRDP_DesktopHeight, TEST_SIZE) ||
+	    !freerdp_settings_set_uint32(context->settings, FreeRDP_ColorDepth, 32) ||
+	    !gdi_init(instance, PIXEL_FORMAT_BGRX32))
+		goto fail;
+
+	if (!test_budget(context))
+	{
+		fprintf(stderr, "test_budget failed\n");
+		goto fail;
+	}
+
+	if (!test_no_budget(context))
+	{
+		fprintf(stderr, "test_no_budget failed\n");
+		goto fail;
+	}
+
+	/* all bitmaps are accounted to this session */
+	gdi_free(instance);
+	cache_get_memory_stats(&stats);
+
+	if ((stats.used != 0) || (stats.compacted != 0))
+	{
+		fprintf(stderr, "%" PRIu64 " bytes still accounted after freeing the cache\n",
+		        test_held(&stats));
+		goto fail;
+	}
+
+	rc = 0;
+fail:
+	cache_set_memory_budget(0);
+	gdi_free(instance);
+	freerdp_context_free(instance);
+	freerdp_free(instance);
+	return rc;
+}
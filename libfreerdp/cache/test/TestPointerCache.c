@@ -0,0 +1,190 @@
+#include <stdio.h>
+
+#include <winpr/crt.h>
+
+#include <freerdp/freerdp.h>
+#include <freerdp/graphics.h>
+#include <freerdp/cache/cache.h>
+#include <freerdp/cache/pointer.h>
+
+static size_t pointerNew = 0;
+static size_t pointerFree = 0;
+static size_t pointerSet = 0;
+
+static BOOL test_pointer_new(rdpContext* context, rdpPointer* pointer)
+{
+	WINPR_UNUSED(context);
+	WINPR_UNUSED(pointer);
+	pointerNew++;
+	return TRUE;
+}
+
+static void test_pointer_free(rdpContext* context, rdpPointer* pointer)
+{
+	WINPR_UNUSED(context);
+	WINPR_UNUSED(pointer);
+	pointerFree++;
+}
+
+static BOOL test_pointer_set(rdpContext* context, rdpPointer* pointer)
+{
+	WINPR_UNUSED(context);
+	WINPR_UNUSED(pointer);
+	pointerSet++;
+	return TRUE;
+}
+
+/* a 2x2 24bpp pointer, seed selects the shape */
+static BOOL test_send_pointer(rdpContext* context, UINT32 index, BYTE seed)
+{
+	BYTE xorMask[2 * 4] = { 0 };
+	BYTE andMask[2 * 2] = { 0 };
+	POINTER_COLOR_UPDATE update = { 0 };
+
+	xorMask[0] = seed;
+	update.cacheIndex = index;
+	update.width = 2;
+	update.height = 2;
+	update.lengthXorMask = sizeof(xorMask);
+	update.xorMaskData = xorMask;
+	update.lengthAndMask = sizeof(andMask);
+	update.andMaskData = andMask;
+	return context->update->pointer->PointerColor(context, &update);
+}
+
+static BOOL test_counts(const char* what, size_t news, size_t frees)
+{
+	if ((pointerNew == news) && (pointerFree == frees))
+		return TRUE;
+
+	fprintf(stderr,
+	        "%s: expected %" PRIuz " new and %" PRIuz " freed pointers, got %" PRIuz
+	        " and %" PRIuz "\n",
+	        what, news, frees, pointerNew, pointerFree);
+	return FALSE;
+}
+
+static BOOL test_shared_shapes(rdpContext* context)
+{
+	const rdpPointerCache* cache = context->cache->pointer;
+
+	/* the same shape in two slots is converted once */
+	if (!test_send_pointer(context, 0, 1) || !test_send_pointer(context, 1, 1))
+		return FALSE;
+
+	if (!test_counts("shared shape", 1, 0) || (cache->entries[0] != cache->entries[1]))
+		return FALSE;
+
+	/* the shape is still referenced by slot 1 */
+	if (!test_send_pointer(context, 0, 2))
+		return FALSE;
+
+	if (!test_counts("replaced shape", 2, 0) || (cache->unusedCount != 0))
+		return FALSE;
+
+	/* the last reference is gone, the shape is kept for reuse */
+	if (!test_send_pointer(context, 1, 2))
+		return FALSE;
+
+	if (!test_counts("unused shape", 2, 0) || (cache->unusedCount != 1))
+		return FALSE;
+
+	if (!test_send_pointer(context, 2, 1))
+		return FALSE;
+
+	if (!test_counts("reused shape", 2, 0) || (cache->unusedCount != 0))
+		return FALSE;
+
+	return pointerSet == 5;
+}
+
+static BOOL test_evict_shapes(rdpContext* context)
+{
+	BYTE x;
+	const rdpPointerCache* cache = context->cache->pointer;
+	const BYTE count = ARRAYSIZE(cache->unused) + 2;
+	const size_t news = pointerNew;
+
+	/* cycle distinct shapes through one slot, all but the last one become unused */
+	for (x = 0; x < count; x++)
+	{
+		if (!test_send_pointer(context, 3, 0x10 + x))
+			return FALSE;
+	}
+
+	if (!test_counts("cycled shapes", news + count, 1) ||
+	    (cache->unusedCount != ARRAYSIZE(cache->unused)))
+		return FALSE;
+
+	/* the second shape is kept, the oldest one was evicted */
+	if (!test_send_pointer(context, 4, 0x11))
+		return FALSE;
+
+	if (!test_counts("kept shape", news + count, 1))
+		return FALSE;
+
+	if (!test_send_pointer(context, 5, 0x10))
+		return FALSE;
+
+	return test_counts("evicted shape", news + count + 1, 1);
+}
+
+int TestPointerCache(int argc, char* argv[])
+{
+	int rc = -1;
+	rdpContext* context;
+	rdpPointer pointer = { 0 };
+	freerdp* instance = freerdp_new();
+
+	WINPR_UNUSED(argc);
+	WINPR_UNUSED(argv);
+
+	if (!instance)
+		return -1;
+
+	if (!freerdp_context_new(instance))
+		goto fail;
+
+	context = instance->context;
+
+	if (!freerdp_settings_set_uint32(context->settings, FreeRDP_PointerCacheSize, 32))
+		goto fail;
+
+	pointer.size = sizeof(rdpPointer);
+	pointer.New = test_pointer_new;
+	pointer.Free = test_pointer_free;
+	pointer.Set = test_pointer_set;
+	graphics_register_pointer(context->graphics, &pointer);
+
+	if (!(context->cache = cache_new(context)))
+		goto fail;
+
+	pointer_cache_register_callbacks(context->update);
+
+	if (!test_shared_shapes(context))
+	{
+		fprintf(stderr, "test_shared_shapes failed\n");
+		goto fail;
+	}
+
+	if (!test_evict_shapes(context))
+	{
+		fprintf(stderr, "test_evict_shapes failed\n");
+		goto fail;
+	}
+
+	cache_free(context->cache);
+	context->cache = NULL;
+
+	if (!test_counts("freed cache", pointerNew, pointerNew))
+		goto fail;
+
+	rc = 0;
+fail:
+	if (instance->context)
+		cache_free(instance->context->cache);
+
+	freerdp_context_free(instance);
+	freerdp_free(instance);
+	return rc;
+}
@@ -0,0 +1,1608 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Implementation
+ * Codec Benchmark
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <freerdp/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <winpr/crt.h>
+#include <winpr/assert.h>
+#include <winpr/file.h>
+#include <winpr/path.h>
+#include <winpr/image.h>
+#include <winpr/stream.h>
+#include <winpr/sysinfo.h>
+
+#include <freerdp/version.h>
+#include <freerdp/settings.h>
+#include <freerdp/primitives.h>
+#include <freerdp/codec/color.h>
+#include <freerdp/codec/region.h>
+#include <freerdp/codec/rfx.h>
+#include <freerdp/codec/nsc.h>
+#include <freerdp/codec/planar.h>
+#include <freerdp/codec/interleaved.h>
+#include <freerdp/codec/clear.h>
+#include <freerdp/codec/progressive.h>
+#include <freerdp/codec/h264.h>
+#include <freerdp/codec/zgfx.h>
+#include <freerdp/codec/bulk.h>
+#include <freerdp/channels/rdpgfx.h>
+#include <freerdp/log.h>
+
+#include "../mppc.h"
+#include "../ncrush.h"
+#include "../xcrush.h"
+#include "../bulk.h"
+#include "../rfx_quantization.h"
+#include "../rfx_dwt.h"
+#include "../nsc_types.h"
+#include "../nsc_encode.h"
+#include "../progressive.h"
+
+#define TAG FREERDP_TAG("codec.bench")
+
+#define BENCH_FORMAT PIXEL_FORMAT_BGRX32
+#define BENCH_TILE_SIZE 64
+#define BENCH_INTERLEAVED_BPP 16
+/* bulk_compress only compresses PDUs smaller than this */
+#define BENCH_BULK_CHUNK_SIZE 16000
+
+typedef enum
+{
+	BENCH_INPUT_FRAME, /* BENCH_FORMAT image, encoded by the bitmap codecs */
+	BENCH_INPUT_DATA,  /* raw PDU payload, compressed by the bulk codecs */
+	BENCH_INPUT_PDU    /* captured encoded PDU, decoded by the codec named by the extension */
+} BENCH_INPUT_TYPE;
+
+typedef struct
+{
+	char* name;
+	BENCH_INPUT_TYPE type;
+	char* codec;
+	UINT32 width;
+	UINT32 height;
+	UINT32 stride;
+	BYTE* data;
+	size_t size;
+} BENCH_INPUT;
+
+typedef void* (*pBenchNew)(BOOL compressor, const BENCH_INPUT* input);
+typedef void (*pBenchFree)(void* context);
+typedef BOOL (*pBenchEncode)(void* context, const BENCH_INPUT* input, wStream* s,
+                             size_t* encodedSize);
+typedef BOOL (*pBenchDecode)(void* context, const BENCH_INPUT* input, const BYTE* data,
+                             size_t length, BYTE* dst);
+
+typedef struct
+{
+	const char* name;
+	BENCH_INPUT_TYPE type;
+	pBenchNew New;
+	pBenchFree Free;
+	pBenchEncode Encode; /* NULL for decoder only codecs fed from BENCH_INPUT_PDU */
+	pBenchDecode Decode;
+} BENCH_CODEC;
+
+typedef struct
+{
+	UINT64* samples; /* nanoseconds per frame */
+	size_t count;
+	UINT64 rawBytes;
+	UINT64 encodedBytes;
+} BENCH_STATS;
+
+typedef struct
+{
+	const char* name;
+	primitive_hints hints;
+	BOOL codecSimd; /* RemoteFX and NSCodec select their own SIMD routines on creation */
+} BENCH_LEVEL;
+
+static const BENCH_LEVEL bench_levels[] = { { "generic", PRIMITIVES_PURE_SOFT, FALSE },
+	                                        { "optimized", PRIMITIVES_ONLY_CPU, TRUE } };
+
+static const BENCH_LEVEL* bench_level = &bench_levels[ARRAYSIZE(bench_levels) - 1];
+
+static UINT64 bench_now(void)
+{
+	return winpr_GetTickCount64NS();
+}
+
+static UINT32 bench_min(UINT32 a, UINT32 b)
+{
+	return (a < b) ? a : b;
+}
+
+static size_t bench_raw_size(const BENCH_INPUT* input)
+{
+	if (input->type == BENCH_INPUT_DATA)
+		return input->size;
+	return 4ull * input->width * input->height;
+}
+
+/* RemoteFX */
+static void bench_rfx_set_level(RFX_CONTEXT* rfx)
+{
+	if (bench_level->codecSimd)
+		return;
+
+	/* undo RFX_INIT_SIMD */
+	rfx->quantization_decode = rfx_quantization_decode;
+	rfx->quantization_encode = rfx_quantization_encode;
+	rfx->dwt_2d_decode = rfx_dwt_2d_decode;
+	rfx->dwt_2d_encode = rfx_dwt_2d_encode;
+}
+
+static void* bench_rfx_new(BOOL compressor, const BENCH_INPUT* input)
+{
+	RFX_CONTEXT* rfx = rfx_context_new(compressor);
+	if (!rfx)
+		return NULL;
+	bench_rfx_set_level(rfx);
+	if (!rfx_context_reset(rfx, input->width, input->height))
+	{
+		rfx_context_free(rfx);
+		return NULL;
+	}
+	rfx_context_set_pixel_format(rfx, BENCH_FORMAT);
+	return rfx;
+}
+
+static void bench_rfx_free(void* context)
+{
+	rfx_context_free(context);
+}
+
+static BOOL bench_rfx_encode(void* context, const BENCH_INPUT* input, wStream* s,
+                             size_t* encodedSize)
+{
+	const RFX_RECT rect = { 0, 0, (UINT16)input->width, (UINT16)input->height };
+
+	if (!rfx_compose_message(context, s, &rect, 1, input->data, input->width, input->height,
+	                         input->stride))
+		return FALSE;
+	*encodedSize = Stream_GetPosition(s);
+	return TRUE;
+}
+
+static BOOL bench_rfx_decode(void* context, const BENCH_INPUT* input, const BYTE* data,
+                             size_t length, BYTE* dst)
+{
+	BOOL rc;
+	REGION16 invalidRegion;
+
+	region16_init(&invalidRegion);
+	rc = rfx_process_message(context, data, (UINT32)length, 0, 0, dst, BENCH_FORMAT,
+	                         input->width * 4, input->height, &invalidRegion);
+	region16_uninit(&invalidRegion);
+	return rc;
+}
+
+/* NSCodec */
+static void* bench_nsc_new(BOOL compressor, const BENCH_INPUT* input)
+{
+	NSC_CONTEXT* nsc = nsc_context_new();
+	if (!nsc)
+		return NULL;
+	/* undo NSC_INIT_SIMD */
+	if (!bench_level->codecSimd)
+		nsc->encode = nsc_encode;
+	if (!nsc_context_reset(nsc, input->width, input->height))
+		goto fail;
+	if (compressor)
+	{
+		if (!nsc_context_set_parameters(nsc, NSC_COLOR_LOSS_LEVEL, 3) ||
+		    !nsc_context_set_parameters(nsc, NSC_ALLOW_SUBSAMPLING, TRUE) ||
+		    !nsc_context_set_parameters(nsc, NSC_DYNAMIC_COLOR_FIDELITY, TRUE) ||
+		    !nsc_context_set_parameters(nsc, NSC_COLOR_FORMAT, BENCH_FORMAT))
+			goto fail;
+	}
+	return nsc;
+fail:
+	nsc_context_free(nsc);
+	return NULL;
+}
+
+static void bench_nsc_free(void* context)
+{
+	nsc_context_free(context);
+}
+
+static BOOL bench_nsc_encode(void* context, const BENCH_INPUT* input, wStream* s,
+                             size_t* encodedSize)
+{
+	if (!nsc_compose_message(context, s, input->data, input->width, input->height, input->stride))
+		return FALSE;
+	*encodedSize = Stream_GetPosition(s);
+	return TRUE;
+}
+
+static BOOL bench_nsc_decode(void* context, const BENCH_INPUT* input, const BYTE* data,
+                             size_t length, BYTE* dst)
+{
+	return nsc_process_message(context, 32, input->width, input->height, data, (UINT32)length,
+	                           dst, BENCH_FORMAT, input->width * 4, 0, 0, input->width,
+	                           input->height, FREERDP_FLIP_NONE);
+}
+
+/* Progressive */
+static void* bench_progressive_new(BOOL compressor, const BENCH_INPUT* input)
+{
+	PROGRESSIVE_CONTEXT* progressive = progressive_context_new(compressor);
+	if (!progressive)
+		return NULL;
+	bench_rfx_set_level(progressive->rfx_context);
+	if (!compressor &&
+	    (progressive_create_surface_context(progressive, 0, input->width, input->height) <= 0))
+	{
+		progressive_context_free(progressive);
+		return NULL;
+	}
+	return progressive;
+}
+
+static void bench_progressive_free(void* context)
+{
+	progressive_context_free(context);
+}
+
+static BOOL bench_progressive_encode(void* context, const BENCH_INPUT* input, wStream* s,
+                                     size_t* encodedSize)
+{
+	int rc;
+	BYTE* data = NULL;
+	UINT32 size = 0;
+	REGION16 region;
+	const RECTANGLE_16 rect = { 0, 0, (UINT16)input->width, (UINT16)input->height };
+
+	region16_init(&region);
+	if (!region16_union_rect(&region, &region, &rect))
+	{
+		region16_uninit(&region);
+		return FALSE;
+	}
+	rc = progressive_compress(context, input->data, input->stride * input->height, BENCH_FORMAT,
+	                          input->width, input->height, input->stride, &region, &data, &size);
+	region16_uninit(&region);
+	if (rc < 0)
+		return FALSE;
+
+	if (!Stream_EnsureRemainingCapacity(s, size))
+		return FALSE;
+	Stream_Write(s, data, size);
+	*encodedSize = size;
+	return TRUE;
+}
+
+static BOOL bench_progressive_decode(void* context, const BENCH_INPUT* input, const BYTE* data,
+                                     size_t length, BYTE* dst)
+{
+	INT32 rc;
+	REGION16 invalidRegion;
+
+	region16_init(&invalidRegion);
+	rc = progressive_decompress(context, data, (UINT32)length, dst, BENCH_FORMAT,
+	                            input->width * 4, 0, 0, &invalidRegion, 0, 0);
+	region16_uninit(&invalidRegion);
+	return rc >= 0;
+}
+
+/* Planar and interleaved are sent as 64x64 bitmap update tiles, stored as [UINT32 length][data] */
+static void* bench_planar_new(BOOL compressor, const BENCH_INPUT* input)
+{
+	BITMAP_PLANAR_CONTEXT* planar;
+	const DWORD flags = compressor ? PLANAR_FORMAT_HEADER_RLE : 0;
+
+	WINPR_UNUSED(input);
+	planar = freerdp_bitmap_planar_context_new(flags, BENCH_TILE_SIZE, BENCH_TILE_SIZE);
+	if (planar)
+		freerdp_planar_topdown_image(planar, TRUE);
+	return planar;
+}
+
+static void bench_planar_free(void* context)
+{
+	freerdp_bitmap_planar_context_free(context);
+}
+
+static BOOL bench_planar_encode(void* context, const BENCH_INPUT* input, wStream* s,
+                                size_t* encodedSize)
+{
+	UINT32 x, y;
+
+	for (y = 0; y < input->height; y += BENCH_TILE_SIZE)
+	{
+		const UINT32 h = bench_min(BENCH_TILE_SIZE, input->height - y);
+
+		for (x = 0; x < input->width; x += BENCH_TILE_SIZE)
+		{
+			const UINT32 w = bench_min(BENCH_TILE_SIZE, input->width - x);
+			const BYTE* src = &input->data[y * input->stride + x * 4];
+			UINT32 size = 0;
+
+			if (!Stream_EnsureRemainingCapacity(s, 4 + BENCH_TILE_SIZE * BENCH_TILE_SIZE * 4 + 16))
+				return FALSE;
+
+			if (!freerdp_bitmap_compress_planar(context, src, BENCH_FORMAT, w, h, input->stride,
+			                                    Stream_Pointer(s) + 4, &size))
+				return FALSE;
+
+			Stream_Write_UINT32(s, size);
+			Stream_Seek(s, size);
+			*encodedSize += size;
+		}
+	}
+	return TRUE;
+}
+
+static BOOL bench_planar_decode(void* context, const BENCH_INPUT* input, const BYTE* data,
+                                size_t length, BYTE* dst)
+{
+	UINT32 x, y;
+	wStream sbuffer = { 0 };
+	wStream* s = Stream_StaticConstInit(&sbuffer, data, length);
+
+	for (y = 0; y < input->height; y += BENCH_TILE_SIZE)
+	{
+		const UINT32 h = bench_min(BENCH_TILE_SIZE, input->height - y);
+
+		for (x = 0; x < input->width; x += BENCH_TILE_SIZE)
+		{
+			const UINT32 w = bench_min(BENCH_TILE_SIZE, input->width - x);
+			UINT32 size;
+
+			if (!Stream_CheckAndLogRequiredLength(TAG, s, 4))
+				return FALSE;
+			Stream_Read_UINT32(s, size);
+			if (!Stream_CheckAndLogRequiredLength(TAG, s, size))
+				return FALSE;
+
+			if (!planar_decompress(context, Stream_Pointer(s), size, w, h, dst, BENCH_FORMAT,
+			                       input->width * 4, x, y, w, h, FALSE))
+				return FALSE;
+			Stream_Seek(s, size);
+		}
+	}
+	return TRUE;
+}
+
+static void* bench_interleaved_new(BOOL compressor, const BENCH_INPUT* input)
+{
+	WINPR_UNUSED(input);
+	return bitmap_interleaved_context_new(compressor);
+}
+
+static void bench_interleaved_free(void* context)
+{
+	bitmap_interleaved_context_free(context);
+}
+
+/* interleaved_compress requires the tile width to be a multiple of 4 */
+static UINT32 bench_interleaved_width(const BENCH_INPUT* input, UINT32 x)
+{
+	return bench_min(BENCH_TILE_SIZE, input->width - x) & ~3u;
+}
+
+static BOOL bench_interleaved_encode(void* context, const BENCH_INPUT* input, wStream* s,
+                                     size_t* encodedSize)
+{
+	UINT32 x, y;
+
+	for (y = 0; y < input->height; y += BENCH_TILE_SIZE)
+	{
+		const UINT32 h = bench_min(BENCH_TILE_SIZE, input->height - y);
+
+		for (x = 0; x < input->width; x += BENCH_TILE_SIZE)
+		{
+			const UINT32 w = bench_interleaved_width(input, x);
+			UINT32 size = BENCH_TILE_SIZE * BENCH_TILE_SIZE * 4;
+
+			if (w == 0)
+				continue;
+
+			if (!Stream_EnsureRemainingCapacity(s, 4ull + size))
+				return FALSE;
+
+			if (!interleaved_compress(context, Stream_Pointer(s) + 4, &size, w, h, input->data,
+			                          BENCH_FORMAT, input->stride, x, y, NULL,
+			                          BENCH_INTERLEAVED_BPP))
+				return FALSE;
+
+			Stream_Write_UINT32(s, size);
+			Stream_Seek(s, size);
+			*encodedSize += size;
+		}
+	}
+	return TRUE;
+}
+
+static BOOL bench_interleaved_decode(void* context, const BENCH_INPUT* input, const BYTE* data,
+                                     size_t length, BYTE* dst)
+{
+	UINT32 x, y;
+	wStream sbuffer = { 0 };
+	wStream* s = Stream_StaticConstInit(&sbuffer, data, length);
+
+	for (y = 0; y < input->height; y += BENCH_TILE_SIZE)
+	{
+		const UINT32 h = bench_min(BENCH_TILE_SIZE, input->height - y);
+
+		for (x = 0; x < input->width; x += BENCH_TILE_SIZE)
+		{
+			const UINT32 w = bench_interleaved_width(input, x);
+			UINT32 size;
+
+			if (w == 0)
+				continue;
+
+			if (!Stream_CheckAndLogRequiredLength(TAG, s, 4))
+				return FALSE;
+			Stream_Read_UINT32(s, size);
+			if (!Stream_CheckAndLogRequiredLength(TAG, s, size))
+				return FALSE;
+
+			if (!interleaved_decompress(context, Stream_Pointer(s), size, w, h,
+			                            BENCH_INTERLEAVED_BPP, dst, BENCH_FORMAT, input->width * 4,
+			                            x, y, w, h, NULL))
+				return FALSE;
+			Stream_Seek(s, size);
+		}
+	}
+	return TRUE;
+}
+
+/* ClearCodec, decoder only */
+static void* bench_clear_new(BOOL compressor, const BENCH_INPUT* input)
+{
+	WINPR_UNUSED(input);
+	return clear_context_new(compressor);
+}
+
+static void bench_clear_free(void* context)
+{
+	clear_context_free(context);
+}
+
+static BOOL bench_clear_decode(void* context, const BENCH_INPUT* input, const BYTE* data,
+                               size_t length, BYTE* dst)
+{
+	return clear_decompress(context, data, (UINT32)length, input->width, input->height, dst,
+	                        BENCH_FORMAT, input->width * 4, 0, 0, input->width, input->height,
+	                        NULL) >= 0;
+}
+
+/* AVC420 and AVC444, only available with a H.264 backend */
+static void* bench_h264_new(BOOL compressor, const BENCH_INPUT* input)
+{
+	H264_CONTEXT* h264 = h264_context_new(compressor);
+	if (!h264)
+		return NULL;
+	if (!h264_context_reset(h264, input->width, input->height))
+	{
+		h264_context_free(h264);
+		return NULL;
+	}
+	return h264;
+}
+
+static void bench_h264_free(void* context)
+{
+	h264_context_free(context);
+}
+
+static RECTANGLE_16 bench_h264_rect(const BENCH_INPUT* input)
+{
+	const RECTANGLE_16 rect = { 0, 0, (UINT16)input->width, (UINT16)input->height };
+	return rect;
+}
+
+static BOOL bench_avc420_encode(void* context, const BENCH_INPUT* input, wStream* s,
+                                size_t* encodedSize)
+{
+	INT32 rc;
+	BYTE* data = NULL;
+	UINT32 size = 0;
+	RDPGFX_H264_METABLOCK meta = { 0 };
+	const RECTANGLE_16 rect = bench_h264_rect(input);
+
+	rc = avc420_compress(context, input->data, BENCH_FORMAT, input->stride, input->width,
+	                     input->height, &rect, &data, &size, &meta);
+	free_h264_metablock(&meta);
+	if (rc < 0)
+		return FALSE;
+
+	/* rc == 0 means no new data */
+	if (rc > 0)
+	{
+		if (!Stream_EnsureRemainingCapacity(s, size))
+			return FALSE;
+		Stream_Write(s, data, size);
+		*encodedSize = size;
+	}
+	return TRUE;
+}
+
+static BOOL bench_avc420_decode(void* context, const BENCH_INPUT* input, const BYTE* data,
+                                size_t length, BYTE* dst)
+{
+	const RECTANGLE_16 rect = bench_h264_rect(input);
+
+	if (length == 0)
+		return TRUE;
+	return avc420_decompress(context, data, (UINT32)length, dst, BENCH_FORMAT, input->width * 4,
+	                         input->width, input->height, &rect, 1) >= 0;
+}
+
+/* stored as [BYTE LC][UINT32 length][luma data][UINT32 length][chroma data] */
+static BOOL bench_avc444_encode(void* context, const BENCH_INPUT* input, wStream* s,
+                                size_t* encodedSize)
+{
+	INT32 rc;
+	BYTE op = 0;
+	BYTE* data = NULL;
+	UINT32 size = 0;
+	BYTE* auxData = NULL;
+	UINT32 auxSize = 0;
+	RDPGFX_H264_METABLOCK meta = { 0 };
+	RDPGFX_H264_METABLOCK auxMeta = { 0 };
+	const RECTANGLE_16 rect = bench_h264_rect(input);
+
+	rc = avc444_compress(context, input->data, BENCH_FORMAT, input->stride, input->width,
+	                     input->height, 1, &rect, &op, &data, &size, &auxData, &auxSize, &meta,
+	                     &auxMeta);
+	free_h264_metablock(&meta);
+	free_h264_metablock(&auxMeta);
+	if (rc < 0)
+		return FALSE;
+
+	if (rc > 0)
+	{
+		if (!data)
+			size = 0;
+		if (!auxData)
+			auxSize = 0;
+		if (!Stream_EnsureRemainingCapacity(s, 9ull + size + auxSize))
+			return FALSE;
+		Stream_Write_UINT8(s, op);
+		Stream_Write_UINT32(s, size);
+		Stream_Write(s, data, size);
+		Stream_Write_UINT32(s, auxSize);
+		Stream_Write(s, auxData, auxSize);
+		*encodedSize = 1ull + size + auxSize;
+	}
+	return TRUE;
+}
+
+static BOOL bench_avc444_decode(void* context, const BENCH_INPUT* input, const BYTE* data,
+                                size_t length, BYTE* dst)
+{
+	BYTE op;
+	UINT32 size, auxSize;
+	const BYTE* lumaData;
+	const BYTE* auxData;
+	wStream sbuffer = { 0 };
+	wStream* s = Stream_StaticConstInit(&sbuffer, data, length);
+	const RECTANGLE_16 rect = bench_h264_rect(input);
+
+	if (length == 0)
+		return TRUE;
+
+	if (!Stream_CheckAndLogRequiredLength(TAG, s, 5))
+		return FALSE;
+	Stream_Read_UINT8(s, op);
+	Stream_Read_UINT32(s, size);
+	if (!Stream_CheckAndLogRequiredLength(TAG, s, 4ull + size))
+		return FALSE;
+	lumaData = Stream_Pointer(s);
+	Stream_Seek(s, size);
+	Stream_Read_UINT32(s, auxSize);
+	if (!Stream_CheckAndLogRequiredLength(TAG, s, auxSize))
+		return FALSE;
+	auxData = Stream_Pointer(s);
+
+	return avc444_decompress(context, op, &rect, size ? 1 : 0, lumaData, size, &rect,
+	                         auxSize ? 1 : 0, auxData, auxSize, dst, BENCH_FORMAT,
+	                         input->width * 4, input->width, input->height,
+	                         RDPGFX_CODECID_AVC444) >= 0;
+}
+
+/* ZGFX */
+static void* bench_zgfx_new(BOOL compressor, const BENCH_INPUT* input)
+{
+	WINPR_UNUSED(input);
+	return zgfx_context_new(compressor);
+}
+
+static void bench_zgfx_free(void* context)
+{
+	zgfx_context_free(context);
+}
+
+static BOOL bench_zgfx_encode(void* context, const BENCH_INPUT* input, wStream* s,
+                              size_t* encodedSize)
+{
+	UINT32 flags = 0;
+
+	if (input->size > UINT32_MAX)
+		return FALSE;
+	if (zgfx_compress_to_stream(context, s, input->data, (UINT32)input->size, &flags) < 0)
+		return FALSE;
+	*encodedSize = Stream_GetPosition(s);
+	return TRUE;
+}
+
+static BOOL bench_zgfx_decode(void* context, const BENCH_INPUT* input, const BYTE* data,
+                              size_t length, BYTE* dst)
+{
+	int rc;
+	BYTE* out = NULL;
+	UINT32 size = 0;
+
+	WINPR_UNUSED(input);
+	WINPR_UNUSED(dst);
+	rc = zgfx_decompress(context, data, (UINT32)length, &out, &size, 0);
+	free(out);
+	return rc >= 0;
+}
+
+/* MPPC, NCRUSH and XCRUSH compress bulk PDUs, stored as [UINT32 flags][UINT32 length][data] */
+typedef struct
+{
+	UINT32 type;
+	MPPC_CONTEXT* mppc;
+	NCRUSH_CONTEXT* ncrush;
+	XCRUSH_CONTEXT* xcrush;
+	BYTE buffer[65536];
+} BENCH_BULK;
+
+static void bench_bulk_free(void* context)
+{
+	BENCH_BULK* bulk = context;
+	if (!bulk)
+		return;
+	mppc_context_free(bulk->mppc);
+	ncrush_context_free(bulk->ncrush);
+	xcrush_context_free(bulk->xcrush);
+	free(bulk);
+}
+
+static BENCH_BULK* bench_bulk_new(UINT32 type, BOOL compressor)
+{
+	BENCH_BULK* bulk = calloc(1, sizeof(BENCH_BULK));
+	if (!bulk)
+		return NULL;
+
+	bulk->type = type;
+	switch (type)
+	{
+		case PACKET_COMPR_TYPE_64K:
+			bulk->mppc = mppc_context_new(type, compressor);
+			break;
+		case PACKET_COMPR_TYPE_RDP6:
+			bulk->ncrush = ncrush_context_new(compressor);
+			break;
+		case PACKET_COMPR_TYPE_RDP61:
+			bulk->xcrush = xcrush_context_new(compressor);
+			break;
+		default:
+			break;
+	}
+
+	if (!bulk->mppc && !bulk->ncrush && !bulk->xcrush)
+	{
+		bench_bulk_free(bulk);
+		return NULL;
+	}
+	return bulk;
+}
+
+static void* bench_mppc_new(BOOL compressor, const BENCH_INPUT* input)
+{
+	WINPR_UNUSED(input);
+	return bench_bulk_new(PACKET_COMPR_TYPE_64K, compressor);
+}
+
+static void* bench_ncrush_new(BOOL compressor, const BENCH_INPUT* input)
+{
+	WINPR_UNUSED(input);
+	return bench_bulk_new(PACKET_COMPR_TYPE_RDP6, compressor);
+}
+
+static void* bench_xcrush_new(BOOL compressor, const BENCH_INPUT* input)
+{
+	WINPR_UNUSED(input);
+	return bench_bulk_new(PACKET_COMPR_TYPE_RDP61, compressor);
+}
+
+static BOOL bench_bulk_encode(void* context, const BENCH_INPUT* input, wStream* s,
+                              size_t* encodedSize)
+{
+	size_t offset;
+	BENCH_BULK* bulk = context;
+
+	for (offset = 0; offset < input->size; offset += BENCH_BULK_CHUNK_SIZE)
+	{
+		int rc = -1;
+		UINT32 flags = 0;
+		const BYTE* data = NULL;
+		UINT32 size = sizeof(bulk->buffer);
+		const size_t remaining = input->size - offset;
+		const UINT32 chunk =
+		    (remaining < BENCH_BULK_CHUNK_SIZE) ? (UINT32)remaining : BENCH_BULK_CHUNK_SIZE;
+		const BYTE* src = &input->data[offset];
+
+		switch (bulk->type)
+		{
+			case PACKET_COMPR_TYPE_64K:
+				rc = mppc_compress(bulk->mppc, src, chunk, bulk->buffer, &data, &size, &flags);
+				break;
+			case PACKET_COMPR_TYPE_RDP6:
+				rc = ncrush_compress(bulk->ncrush, src, chunk, bulk->buffer, &data, &size, &flags);
+				break;
+			case PACKET_COMPR_TYPE_RDP61:
+				rc = xcrush_compress(bulk->xcrush, src, chunk, bulk->buffer, &data, &size, &flags);
+				break;
+			default:
+				break;
+		}
+
+		if (rc < 0)
+			return FALSE;
+
+		/* not compressible, sent as is */
+		if (!(flags & PACKET_COMPRESSED))
+		{
+			data = src;
+			size = chunk;
+		}
+
+		if (!Stream_EnsureRemainingCapacity(s, 8ull + size))
+			return FALSE;
+		Stream_Write_UINT32(s, flags);
+		Stream_Write_UINT32(s, size);
+		Stream_Write(s, data, size);
+		*encodedSize += size;
+	}
+	return TRUE;
+}
+
+static BOOL bench_bulk_decode(void* context, const BENCH_INPUT* input, const BYTE* data,
+                              size_t length, BYTE* dst)
+{
+	BENCH_BULK* bulk = context;
+	wStream sbuffer = { 0 };
+	wStream* s = Stream_StaticConstInit(&sbuffer, data, length);
+
+	WINPR_UNUSED(input);
+	WINPR_UNUSED(dst);
+
+	while (Stream_GetRemainingLength(s) > 0)
+	{
+		int rc = -1;
+		UINT32 flags, size;
+		const BYTE* out = NULL;
+		UINT32 outSize = 0;
+
+		if (!Stream_CheckAndLogRequiredLength(TAG, s, 8))
+			return FALSE;
+		Stream_Read_UINT32(s, flags);
+		Stream_Read_UINT32(s, size);
+		if (!Stream_CheckAndLogRequiredLength(TAG, s, size))
+			return FALSE;
+
+		if (flags & BULK_COMPRESSION_FLAGS_MASK)
+		{
+			switch (bulk->type)
+			{
+				case PACKET_COMPR_TYPE_64K:
+					rc = mppc_decompress(bulk->mppc, Stream_Pointer(s), size, &out, &outSize,
+					                     flags);
+					break;
+				case PACKET_COMPR_TYPE_RDP6:
+					rc = ncrush_decompress(bulk->ncrush, Stream_Pointer(s), size, &out, &outSize,
+					                       flags);
+					break;
+				case PACKET_COMPR_TYPE_RDP61:
+					rc = xcrush_decompress(bulk->xcrush, Stream_Pointer(s), size, &out, &outSize,
+					                       flags);
+					break;
+				default:
+					break;
+			}
+
+			if (rc < 0)
+				return FALSE;
+		}
+		Stream_Seek(s, size);
+	}
+	return TRUE;
+}
+
+static const BENCH_CODEC bench_codecs[] = {
+	{ "rfx", BENCH_INPUT_FRAME, bench_rfx_new, bench_rfx_free, bench_rfx_encode,
+	  bench_rfx_decode },
+	{ "progressive", BENCH_INPUT_FRAME, bench_progressive_new, bench_progressive_free,
+	  bench_progressive_encode, bench_progressive_decode },
+	{ "planar", BENCH_INPUT_FRAME, bench_planar_new, bench_planar_free, bench_planar_encode,
+	  bench_planar_decode },
+	{ "interleaved", BENCH_INPUT_FRAME, bench_interleaved_new, bench_interleaved_free,
+	  bench_interleaved_encode, bench_interleaved_decode },
+	{ "clear", BENCH_INPUT_PDU, bench_clear_new, bench_clear_free, NULL, bench_clear_decode },
+	{ "nsc", BENCH_INPUT_FRAME, bench_nsc_new, bench_nsc_free, bench_nsc_encode,
+	  bench_nsc_decode },
+	{ "avc420", BENCH_INPUT_FRAME, bench_h264_new, bench_h264_free, bench_avc420_encode,
+	  bench_avc420_decode },
+	{ "avc444", BENCH_INPUT_FRAME, bench_h264_new, bench_h264_free, bench_avc444_encode,
+	  bench_avc444_decode },
+	{ "zgfx", BENCH_INPUT_DATA, bench_zgfx_new, bench_zgfx_free, bench_zgfx_encode,
+	  bench_zgfx_decode },
+	{ "mppc", BENCH_INPUT_DATA, bench_mppc_new, bench_bulk_free, bench_bulk_encode,
+	  bench_bulk_decode },
+	{ "ncrush", BENCH_INPUT_DATA, bench_ncrush_new, bench_bulk_free, bench_bulk_encode,
+	  bench_bulk_decode },
+	{ "xcrush", BENCH_INPUT_DATA, bench_xcrush_new, bench_bulk_free, bench_bulk_encode,
+	  bench_bulk_decode }
+};
+
+static BOOL bench_input_matches(const BENCH_CODEC* codec, const BENCH_INPUT* input)
+{
+	switch (codec->type)
+	{
+		case BENCH_INPUT_FRAME:
+			return input->type == BENCH_INPUT_FRAME;
+		case BENCH_INPUT_DATA:
+			/* frames double as uncompressed bitmap update payload */
+			return (input->type == BENCH_INPUT_DATA) || (input->type == BENCH_INPUT_FRAME);
+		case BENCH_INPUT_PDU:
+			return (input->type == BENCH_INPUT_PDU) && (strcmp(input->codec, codec->name) == 0);
+		default:
+			return FALSE;
+	}
+}
+
+static void bench_input_free(BENCH_INPUT* input)
+{
+	if (!input)
+		return;
+	free(input->name);
+	free(input->codec);
+	winpr_aligned_free(input->data);
+	memset(input, 0, sizeof(BENCH_INPUT));
+}
+
+static BOOL bench_input_frame(BENCH_INPUT* input, const char* name, UINT32 width, UINT32 height)
+{
+	input->name = _strdup(name);
+	input->type = BENCH_INPUT_FRAME;
+	input->width = width;
+	input->height = height;
+	input->stride = width * 4;
+	input->size = 1ull * input->stride * height;
+	input->data = winpr_aligned_malloc(input->size, 16);
+	return input->name && input->data;
+}
+
+/* Synthetic frames covering smooth, desktop like and incompressible content */
+static BOOL bench_synthetic_frames(BENCH_INPUT* inputs, size_t* count, UINT32 w, UINT32 h)
+{
+	UINT32 x, y;
+	UINT32 seed = 0x12345678;
+
+	if (!bench_input_frame(&inputs[0], "synthetic-gradient", w, h) ||
+	    !bench_input_frame(&inputs[1], "synthetic-desktop", w, h) ||
+	    !bench_input_frame(&inputs[2], "synthetic-noise", w, h))
+		return FALSE;
+	*count = 3;
+
+	for (y = 0; y < h; y++)
+	{
+		BYTE* gradient = &inputs[0].data[y * inputs[0].stride];
+		BYTE* desktop = &inputs[1].data[y * inputs[1].stride];
+		BYTE* noise = &inputs[2].data[y * inputs[2].stride];
+
+		for (x = 0; x < w; x++)
+		{
+			const BOOL window = (x >= w / 8) && (x < w * 5 / 8) && (y >= h / 8) && (y < h * 3 / 4);
+			UINT32 color;
+
+			color = FreeRDPGetColor(BENCH_FORMAT, (BYTE)(x * 255 / w), (BYTE)(y * 255 / h),
+			                        (BYTE)((x + y) & 0xFF), 0xFF);
+			FreeRDPWriteColor(&gradient[x * 4], BENCH_FORMAT, color);
+
+			seed = seed * 1103515245u + 12345u;
+			if (!window)
+				color = FreeRDPGetColor(BENCH_FORMAT, 0x00, 0x78, 0xD7, 0xFF);
+			else if ((y % 16 < 10) && (x % 320 < 280) && ((seed >> 16) % 3 == 0))
+				color = FreeRDPGetColor(BENCH_FORMAT, 0x20, 0x20, 0x20, 0xFF);
+			else
+				color = FreeRDPGetColor(BENCH_FORMAT, 0xF0, 0xF0, 0xF0, 0xFF);
+			FreeRDPWriteColor(&desktop[x * 4], BENCH_FORMAT, color);
+
+			color = FreeRDPGetColor(BENCH_FORMAT, (BYTE)(seed >> 8), (BYTE)(seed >> 16),
+			                        (BYTE)(seed >> 24), 0xFF);
+			FreeRDPWriteColor(&noise[x * 4], BENCH_FORMAT, color);
+		}
+	}
+	return TRUE;
+}
+
+static BYTE* bench_read_file(const char* path, size_t* size)
+{
+	INT64 length;
+	BYTE* data = NULL;
+	FILE* fp = winpr_fopen(path, "rb");
+
+	if (!fp)
+		return NULL;
+
+	if (_fseeki64(fp, 0, SEEK_END) != 0)
+		goto fail;
+	length = _ftelli64(fp);
+	if ((length <= 0) || (_fseeki64(fp, 0, SEEK_SET) != 0))
+		goto fail;
+
+	data = winpr_aligned_malloc((size_t)length, 16);
+	if (!data)
+		goto fail;
+	if (fread(data, 1, (size_t)length, fp) != (size_t)length)
+	{
+		winpr_aligned_free(data);
+		data = NULL;
+		goto fail;
+	}
+	*size = (size_t)length;
+fail:
+	fclose(fp);
+	return data;
+}
+
+static BOOL bench_load_image(BENCH_INPUT* input, const char* name, const char* path)
+{
+	BOOL rc = FALSE;
+	UINT32 format;
+	wImage* image = winpr_image_new();
+
+	if (!image || (winpr_image_read(image, path) <= 0))
+		goto fail;
+
+	switch (image->bitsPerPixel)
+	{
+		case 32:
+			format = PIXEL_FORMAT_BGRA32;
+			break;
+		case 24:
+			format = PIXEL_FORMAT_BGR24;
+			break;
+		default:
+			WLog_WARN(TAG, "%s: unsupported %" PRIu32 " bpp image", path, image->bitsPerPixel);
+			goto fail;
+	}
+
+	if (!bench_input_frame(input, name, image->width, image->height))
+		goto fail;
+
+	rc = freerdp_image_copy(input->data, BENCH_FORMAT, input->stride, 0, 0, input->width,
+	                        input->height, image->data, format, image->scanline, 0, 0, NULL,
+	                        FREERDP_FLIP_NONE);
+fail:
+	winpr_image_free(image, TRUE);
+	return rc;
+}
+
+/**
+ * Loads a corpus file, the extension selects how it is used:
+ *   .bmp              frame for the bitmap codecs, raw data for the bulk codecs
+ *   .bin              captured PDU payload for the bulk codecs
+ *   .<W>x<H>.<codec>  captured PDU of a decoder only codec, e.g. text.64x24.clear
+ */
+static BOOL bench_load_file(BENCH_INPUT* input, const char* name, const char* path)
+{
+	size_t x;
+	char* dims;
+	const char* ext = strrchr(name, '.');
+
+	if (!ext)
+		return FALSE;
+
+	if (_stricmp(ext, ".bmp") == 0)
+		return bench_load_image(input, name, path);
+
+	if (_stricmp(ext, ".bin") == 0)
+		input->type = BENCH_INPUT_DATA;
+	else
+	{
+		for (x = 0; x < ARRAYSIZE(bench_codecs); x++)
+		{
+			if (!bench_codecs[x].Encode && (_stricmp(&ext[1], bench_codecs[x].name) == 0))
+				break;
+		}
+		if (x == ARRAYSIZE(bench_codecs))
+			return FALSE;
+
+		input->type = BENCH_INPUT_PDU;
+		input->codec = _strdup(bench_codecs[x].name);
+		dims = strchr(name, '.');
+		while (dims && (dims < ext))
+		{
+			if (sscanf(dims, ".%" SCNu32 "x%" SCNu32 ".", &input->width, &input->height) == 2)
+				break;
+			dims = strchr(&dims[1], '.');
+		}
+		if (!input->codec || (input->width == 0) || (input->height == 0) ||
+		    (input->width > UINT16_MAX) || (input->height > UINT16_MAX))
+		{
+			WLog_WARN(TAG, "%s: missing .<width>x<height> in file name", path);
+			bench_input_free(input);
+			return FALSE;
+		}
+		input->stride = input->width * 4;
+	}
+
+	input->name = _strdup(name);
+	input->data = bench_read_file(path, &input->size);
+	if (!input->name || !input->data)
+	{
+		bench_input_free(input);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static int bench_input_compare(const void* a, const void* b)
+{
+	const BENCH_INPUT* ia = a;
+	const BENCH_INPUT* ib = b;
+	return strcmp(ia->name, ib->name);
+}
+
+static BENCH_INPUT* bench_load_corpus(const char* corpus, UINT32 width, UINT32 height,
+                                       size_t* count)
+{
+	HANDLE hFind;
+	WIN32_FIND_DATAA data = { 0 };
+	size_t capacity = 16;
+	char* pattern = NULL;
+	BENCH_INPUT* inputs = calloc(capacity, sizeof(BENCH_INPUT));
+
+	*count = 0;
+	if (!inputs)
+		goto fail;
+
+	if (!corpus)
+	{
+		if (!bench_synthetic_frames(inputs, count, width, height))
+			goto fail;
+		return inputs;
+	}
+
+	pattern = GetCombinedPath(corpus, "*");
+	if (!pattern)
+		goto fail;
+
+	hFind = FindFirstFileA(pattern, &data);
+	if (hFind == INVALID_HANDLE_VALUE)
+	{
+		WLog_ERR(TAG, "failed to open corpus %s", corpus);
+		goto fail;
+	}
+
+	do
+	{
+		char* path;
+
+		if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			continue;
+
+		if (*count == capacity)
+		{
+			BENCH_INPUT* tmp = realloc(inputs, capacity * 2 * sizeof(BENCH_INPUT));
+			if (!tmp)
+				break;
+			memset(&tmp[capacity], 0, capacity * sizeof(BENCH_INPUT));
+			inputs = tmp;
+			capacity *= 2;
+		}
+
+		path = GetCombinedPath(corpus, data.cFileName);
+		if (path && bench_load_file(&inputs[*count], data.cFileName, path))
+			(*count)++;
+		free(path);
+	} while (FindNextFileA(hFind, &data));
+	FindClose(hFind);
+
+	qsort(inputs, *count, sizeof(BENCH_INPUT), bench_input_compare);
+	free(pattern);
+	return inputs;
+
+fail:
+	while (*count > 0)
+		bench_input_free(&inputs[--(*count)]);
+	free(inputs);
+	free(pattern);
+	return NULL;
+}
+
+static int bench_sample_compare(const void* a, const void* b)
+{
+	const UINT64 sa = *(const UINT64*)a;
+	const UINT64 sb = *(const UINT64*)b;
+	return (sa > sb) - (sa < sb);
+}
+
+static void bench_json_string(FILE* fp, const char* str)
+{
+	fputc('"', fp);
+	for (; *str; str++)
+	{
+		if ((*str == '"') || (*str == '\\'))
+			fprintf(fp, "\\%c", *str);
+		else if ((unsigned char)*str < 0x20)
+			fprintf(fp, "\\u%04x", (unsigned char)*str);
+		else
+			fputc(*str, fp);
+	}
+	fputc('"', fp);
+}
+
+/* Sorts the samples, the percentiles are taken with the nearest rank method */
+static void bench_stats_write(FILE* fp, BENCH_STATS* stats)
+{
+	size_t x;
+	UINT64 total = 0;
+	double seconds, p50 = 0.0, p99 = 0.0;
+
+	for (x = 0; x < stats->count; x++)
+		total += stats->samples[x];
+
+	if (stats->count > 0)
+	{
+		qsort(stats->samples, stats->count, sizeof(UINT64), bench_sample_compare);
+		p50 = stats->samples[(stats->count * 50 + 99) / 100 - 1] / 1000.0;
+		p99 = stats->samples[(stats->count * 99 + 99) / 100 - 1] / 1000.0;
+	}
+
+	seconds = total / 1000000000.0;
+	fprintf(fp, "\"frames\": %" PRIuz ", \"seconds\": %.6f, ", stats->count, seconds);
+	fprintf(fp, "\"MBps\": %.3f, \"fps\": %.3f, ",
+	        (seconds > 0.0) ? stats->rawBytes / seconds / 1000000.0 : 0.0,
+	        (seconds > 0.0) ? stats->count / seconds : 0.0);
+	fprintf(fp, "\"bytesPerFrame\": %.1f, \"ratio\": %.3f, ",
+	        (stats->count > 0) ? (double)stats->encodedBytes / stats->count : 0.0,
+	        (stats->encodedBytes > 0) ? (double)stats->rawBytes / stats->encodedBytes : 0.0);
+	fprintf(fp, "\"p50us\": %.3f, \"p99us\": %.3f", p50, p99);
+}
+
+static void bench_stats_add(BENCH_STATS* stats, UINT64 sample, size_t rawBytes,
+                            size_t encodedBytes)
+{
+	stats->samples[stats->count++] = sample;
+	stats->rawBytes += rawBytes;
+	stats->encodedBytes += encodedBytes;
+}
+
+/* Encodes the input once untimed for the reference stream, then times every iteration with a
+ * fresh encoder so history based codecs are measured the same way in every iteration. */
+static int bench_run_encode(const BENCH_CODEC* codec, const BENCH_INPUT* input, size_t iterations,
+                            wStream* reference, size_t* referenceSize, wStream* work,
+                            BENCH_STATS* stats, BENCH_STATS* total)
+{
+	size_t x;
+
+	for (x = 0; x <= iterations; x++)
+	{
+		UINT64 start, end;
+		size_t encodedSize = 0;
+		wStream* s = (x == 0) ? reference : work;
+		void* context = codec->New(TRUE, input);
+
+		if (!context)
+			return (x == 0) ? 0 : -1;
+
+		Stream_SetPosition(s, 0);
+		start = bench_now();
+		if (!codec->Encode(context, input, s, &encodedSize))
+		{
+			codec->Free(context);
+			WLog_ERR(TAG, "%s: encoding %s failed", codec->name, input->name);
+			return -1;
+		}
+		end = bench_now();
+		codec->Free(context);
+
+		if (x == 0)
+			*referenceSize = encodedSize;
+		else
+		{
+			bench_stats_add(stats, end - start, bench_raw_size(input), encodedSize);
+			bench_stats_add(total, end - start, bench_raw_size(input), encodedSize);
+		}
+	}
+	Stream_SealLength(reference);
+	return 1;
+}
+
+/* encodedSize is the payload size without the framing the benchmark adds to length */
+static int bench_run_decode(const BENCH_CODEC* codec, const BENCH_INPUT* input, size_t iterations,
+                            const BYTE* data, size_t length, size_t encodedSize, BYTE* dst,
+                            BENCH_STATS* stats, BENCH_STATS* total)
+{
+	size_t x;
+
+	for (x = 0; x <= iterations; x++)
+	{
+		UINT64 start, end;
+		void* context = codec->New(FALSE, input);
+
+		if (!context)
+			return (x == 0) ? 0 : -1;
+
+		start = bench_now();
+		if (!codec->Decode(context, input, data, length, dst))
+		{
+			codec->Free(context);
+			WLog_ERR(TAG, "%s: decoding %s failed", codec->name, input->name);
+			return -1;
+		}
+		end = bench_now();
+		codec->Free(context);
+
+		if (x > 0)
+		{
+			bench_stats_add(stats, end - start, bench_raw_size(input), encodedSize);
+			bench_stats_add(total, end - start, bench_raw_size(input), encodedSize);
+		}
+	}
+	return 1;
+}
+
+static BOOL bench_stats_init(BENCH_STATS* stats, size_t count)
+{
+	memset(stats, 0, sizeof(BENCH_STATS));
+	stats->samples = calloc(count ? count : 1, sizeof(UINT64));
+	return stats->samples != NULL;
+}
+
+static void bench_write_inputs(FILE* fp, const char* op, const char* const* names,
+                               BENCH_STATS* stats, size_t count, BENCH_STATS* total)
+{
+	size_t x;
+
+	fprintf(fp, "\"%s\": { ", op);
+	bench_stats_write(fp, total);
+	fprintf(fp, ", \"inputs\": [");
+	for (x = 0; x < count; x++)
+	{
+		fprintf(fp, "%s\n            { \"name\": ", (x > 0) ? "," : "");
+		bench_json_string(fp, names[x]);
+		fprintf(fp, ", ");
+		bench_stats_write(fp, &stats[x]);
+		fprintf(fp, " }");
+	}
+	fprintf(fp, " ] }");
+}
+
+static BOOL bench_run_codec(FILE* fp, const BENCH_CODEC* codec, const BENCH_INPUT* inputs,
+                            size_t count, size_t iterations)
+{
+	int rc = 0;
+	size_t x, used = 0;
+	BOOL res = FALSE;
+	BENCH_STATS encodeTotal = { 0 };
+	BENCH_STATS decodeTotal = { 0 };
+	BENCH_STATS* encode = calloc(count ? count : 1, sizeof(BENCH_STATS));
+	BENCH_STATS* decode = calloc(count ? count : 1, sizeof(BENCH_STATS));
+	const char** names = calloc(count ? count : 1, sizeof(char*));
+	wStream* reference = Stream_New(NULL, 4096);
+	wStream* work = Stream_New(NULL, 4096);
+
+	fprintf(fp, "        { \"codec\": \"%s\", ", codec->name);
+	if (!encode || !decode || !names || !reference || !work ||
+	    !bench_stats_init(&encodeTotal, count * iterations) ||
+	    !bench_stats_init(&decodeTotal, count * iterations))
+	{
+		fprintf(fp, "\"failed\": true }");
+		goto fail;
+	}
+
+	for (x = 0; x < count; x++)
+	{
+		BYTE* dst = NULL;
+		const BENCH_INPUT* input = &inputs[x];
+
+		if (!bench_input_matches(codec, input))
+			continue;
+
+		if (input->type != BENCH_INPUT_DATA)
+		{
+			dst = winpr_aligned_malloc(4ull * input->width * input->height, 16);
+			if (dst)
+				memset(dst, 0, 4ull * input->width * input->height);
+		}
+
+		if (!bench_stats_init(&encode[used], iterations) ||
+		    !bench_stats_init(&decode[used], iterations) ||
+		    ((input->type != BENCH_INPUT_DATA) && !dst))
+		{
+			winpr_aligned_free(dst);
+			fprintf(fp, "\"failed\": true }");
+			goto fail;
+		}
+		names[used++] = input->name;
+
+		if (codec->Encode)
+		{
+			size_t encodedSize = 0;
+
+			rc = bench_run_encode(codec, input, iterations, reference, &encodedSize, work,
+			                      &encode[used - 1], &encodeTotal);
+			if (rc > 0)
+				rc = bench_run_decode(codec, input, iterations, Stream_Buffer(reference),
+				                      Stream_Length(reference), encodedSize, dst,
+				                      &decode[used - 1], &decodeTotal);
+		}
+		else
+			rc = bench_run_decode(codec, input, iterations, input->data, input->size,
+			                      input->size, dst, &decode[used - 1], &decodeTotal);
+		winpr_aligned_free(dst);
+
+		/* the codec is not available in this build, e.g. no H.264 backend */
+		if (rc == 0)
+		{
+			fprintf(fp, "\"skipped\": \"not available\" }");
+			res = TRUE;
+			goto fail;
+		}
+		if (rc < 0)
+			break;
+	}
+
+	if (rc < 0)
+		fprintf(fp, "\"failed\": true, ");
+	else if (used == 0)
+	{
+		fprintf(fp, "\"skipped\": \"no input\" }");
+		res = TRUE;
+		goto fail;
+	}
+
+	if (codec->Encode)
+	{
+		fprintf(fp, "\n          ");
+		bench_write_inputs(fp, "encode", names, encode, used, &encodeTotal);
+		fprintf(fp, ",");
+	}
+	fprintf(fp, "\n          ");
+	bench_write_inputs(fp, "decode", names, decode, used, &decodeTotal);
+	fprintf(fp, " }");
+	res = rc >= 0;
+
+fail:
+	if (encode)
+	{
+		for (x = 0; x < count; x++)
+			free(encode[x].samples);
+	}
+	if (decode)
+	{
+		for (x = 0; x < count; x++)
+			free(decode[x].samples);
+	}
+	free(encodeTotal.samples);
+	free(decodeTotal.samples);
+	free(encode);
+	free(decode);
+	free(names);
+	Stream_Free(reference, TRUE);
+	Stream_Free(work, TRUE);
+	return res;
+}
+
+static BOOL bench_codec_selected(const char* selection, const char* name)
+{
+	size_t len;
+	const char* cur = selection;
+
+	if (!selection)
+		return TRUE;
+
+	len = strlen(name);
+	while (cur && *cur)
+	{
+		if ((strncmp(cur, name, len) == 0) && ((cur[len] == ',') || (cur[len] == '\0')))
+			return TRUE;
+		cur = strchr(cur, ',');
+		if (cur)
+			cur++;
+	}
+	return FALSE;
+}
+
+static void bench_write_cpu(FILE* fp)
+{
+	const struct
+	{
+		const char* name;
+		DWORD feature;
+		BOOL ex;
+	} features[] = { { "sse2", PF_SSE2_INSTRUCTIONS_AVAILABLE, FALSE },
+		             { "sse3", PF_SSE3_INSTRUCTIONS_AVAILABLE, FALSE },
+		             { "ssse3", PF_EX_SSSE3, TRUE },
+		             { "sse41", PF_EX_SSE41, TRUE },
+		             { "sse42", PF_EX_SSE42, TRUE },
+		             { "avx2", PF_EX_AVX2, TRUE },
+		             { "neon", PF_ARM_NEON_INSTRUCTIONS_AVAILABLE, FALSE } };
+	size_t x;
+
+	fprintf(fp, "  \"cpu\": { ");
+	for (x = 0; x < ARRAYSIZE(features); x++)
+	{
+		const BOOL present = features[x].ex ? IsProcessorFeaturePresentEx(features[x].feature)
+		                                    : IsProcessorFeaturePresent(features[x].feature);
+		fprintf(fp, "%s\"%s\": %s", (x > 0) ? ", " : "", features[x].name,
+		        present ? "true" : "false");
+	}
+	fprintf(fp, " },\n");
+}
+
+static WINPR_NORETURN(void usage_and_exit(void))
+{
+	size_t x;
+
+	printf("freerdp-codec-bench: codec throughput and latency benchmark\n");
+	printf("Usage: freerdp-codec-bench [-c <corpus directory>] [-n <iterations>] "
+	       "[-s <width>x<height>] [-l <generic,optimized,_all_>] [-b <codec[,codec...]>] "
+	       "[-o <file.json>]\n");
+	printf("Codecs: ");
+	for (x = 0; x < ARRAYSIZE(bench_codecs); x++)
+		printf("%s%s", (x > 0) ? ", " : "", bench_codecs[x].name);
+	printf("\nWithout a corpus synthetic frames of -s size (default 1920x1080) are used.\n");
+	exit(1);
+}
+
+int main(int argc, char* argv[])
+{
+	int rc = 1;
+	int index = 1;
+	size_t x, y, count = 0;
+	BOOL firstLevel = TRUE;
+	unsigned long iterations = 10;
+	UINT32 width = 1920;
+	UINT32 height = 1080;
+	const char* corpus = NULL;
+	const char* level = NULL;
+	const char* selection = NULL;
+	const char* output = NULL;
+	BENCH_INPUT* inputs = NULL;
+	FILE* fp = stdout;
+	primitives_t* prims;
+	errno = 0;
+
+	while (index < argc)
+	{
+		if ((strcmp("-c", argv[index]) == 0) || (strcmp("-n", argv[index]) == 0) ||
+		    (strcmp("-l", argv[index]) == 0) || (strcmp("-b", argv[index]) == 0) ||
+		    (strcmp("-s", argv[index]) == 0) || (strcmp("-o", argv[index]) == 0))
+		{
+			const char* option = argv[index++];
+
+			if (index == argc)
+			{
+				printf("missing argument for %s\n\n", option);
+				usage_and_exit();
+			}
+
+			if (option[1] == 'c')
+				corpus = argv[index];
+			else if (option[1] == 'l')
+				level = argv[index];
+			else if (option[1] == 'b')
+				selection = argv[index];
+			else if (option[1] == 'o')
+				output = argv[index];
+			else if (option[1] == 's')
+			{
+				if ((sscanf(argv[index], "%" SCNu32 "x%" SCNu32, &width, &height) != 2) ||
+				    (width == 0) || (height == 0) || (width > UINT16_MAX) ||
+				    (height > UINT16_MAX))
+				{
+					printf("invalid frame size %s\n\n", argv[index]);
+					usage_and_exit();
+				}
+			}
+			else
+			{
+				iterations = strtoul(argv[index], NULL, 0);
+				if ((iterations == 0) || (iterations > 100000) || (errno != 0))
+				{
+					printf("invalid iteration count %s\n\n", argv[index]);
+					usage_and_exit();
+				}
+			}
+		}
+		else
+			usage_and_exit();
+
+		index++;
+	}
+
+	inputs = bench_load_corpus(corpus, width, height, &count);
+	if (!inputs)
+		goto fail;
+
+	if (output)
+	{
+		fp = winpr_fopen(output, "w");
+		if (!fp)
+		{
+			WLog_ERR(TAG, "failed to open %s", output);
+			goto fail;
+		}
+	}
+
+	/* Codecs keep the primitives_get() pointer, switching the level updates them in place */
+	prims = primitives_get();
+	fprintf(fp, "{\n  \"version\": \"%s\",\n  \"iterations\": %lu,\n", FREERDP_VERSION_FULL,
+	        iterations);
+	bench_write_cpu(fp);
+	fprintf(fp, "  \"levels\": [");
+
+	rc = 0;
+	for (x = 0; x < ARRAYSIZE(bench_levels); x++)
+	{
+		BOOL first = TRUE;
+		const BENCH_LEVEL* cur = &bench_levels[x];
+
+		if (level && (strcmp(level, "all") != 0) && (strcmp(level, cur->name) != 0))
+			continue;
+
+		fprintf(fp, "%s\n    { \"level\": \"%s\", ", firstLevel ? "" : ",", cur->name);
+		firstLevel = FALSE;
+		bench_level = cur;
+		if (!primitives_init(prims, cur->hints))
+		{
+			fprintf(fp, "\"available\": false }");
+			continue;
+		}
+
+		fprintf(fp, "\"available\": true, \"flags\": %" PRIu32 ", \"codecs\": [\n",
+		        primitives_flags(prims));
+		for (y = 0; y < ARRAYSIZE(bench_codecs); y++)
+		{
+			if (!bench_codec_selected(selection, bench_codecs[y].name))
+				continue;
+			if (!first)
+				fprintf(fp, ",\n");
+			first = FALSE;
+			if (!bench_run_codec(fp, &bench_codecs[y], inputs, count, iterations))
+				rc = 1;
+		}
+		fprintf(fp, "\n      ] }");
+	}
+	fprintf(fp, "\n  ]\n}\n");
+
+fail:
+	if (fp && (fp != stdout))
+		fclose(fp);
+	for (x = 0; x < count; x++)
+		bench_input_free(&inputs[x]);
+	free(inputs);
+	return rc;
+}
@@ -18,6 +18,7 @@
  */
 
 #include <winpr/assert.h>
+#include <winpr/sysinfo.h>
 
 #include <freerdp/config.h>
 
@@ -148,6 +149,7 @@ int bulk_decompress(rdpBulk* bulk, const BYTE* pSrcData, UINT32 SrcSize, const B
 {
 	UINT32 type;
 	int status = -1;
+	UINT64 start;
 	rdpMetrics* metrics;
 	UINT32 CompressedBytes;
 	UINT32 UncompressedBytes;
@@ -162,6 +164,7 @@ int bulk_decompress(rdpBulk* bulk, const BYTE* pSrcData, UINT32 SrcSize, const B
 	metrics = bulk->context->metrics;
 	WINPR_ASSERT(metrics);
 
+	start = winpr_GetTickCount64NS();
 	bulk_compression_max_size(bulk);
 	type = flags & BULK_COMPRESSION_TYPE_MASK;
 
@@ -211,6 +214,9 @@ int bulk_decompress(rdpBulk* bulk, const BYTE* pSrcData, UINT32 SrcSize, const B
 
 	if (status >= 0)
 	{
+		if (flags & BULK_COMPRESSION_FLAGS_MASK)
+			metrics_stage_add(metrics, METRICS_STAGE_BULK_DECOMPRESS, start);
+
 		CompressedBytes = SrcSize;
 		UncompressedBytes = *pDstSize;
 		CompressionRatio = metrics_write_bytes(metrics, UncompressedBytes, CompressedBytes);
@@ -240,6 +246,7 @@ int bulk_compress(rdpBulk* bulk, const BYTE* pSrcData, UINT32 SrcSize, const BYT
                   UINT32* pDstSize, UINT32* pFlags)
 {
 	int status = -1;
+	UINT64 start;
 	rdpMetrics* metrics;
 	UINT32 CompressedBytes;
 	UINT32 UncompressedBytes;
@@ -261,6 +268,7 @@ int bulk_compress(rdpBulk* bulk, const BYTE* pSrcData, UINT32 SrcSize, const BYT
 		return 0;
 	}
 
+	start = winpr_GetTickCount64NS();
 	*pDstSize = sizeof(bulk->OutputBuffer);
 	bulk_compression_level(bulk);
 	bulk_compression_max_size(bulk);
@@ -293,6 +301,7 @@ int bulk_compress(rdpBulk* bulk, const BYTE* pSrcData, UINT32 SrcSize, const BYT
 
 	if (status >= 0)
 	{
+		metrics_stage_add(metrics, METRICS_STAGE_BULK_COMPRESS, start);
 		CompressedBytes = *pDstSize;
 		UncompressedBytes = SrcSize;
 		CompressionRatio = metrics_write_bytes(metrics, UncompressedBytes, CompressedBytes);
@@ -35,6 +35,8 @@
 
 #define TAG FREERDP_TAG("codec")
 
+#define AVC444_MOTION_FRAMES 2 /* frames with large luma changes before chroma is skipped */
+
 static BOOL avc444_ensure_buffer(H264_CONTEXT* h264, DWORD nDstHeight);
 
 BOOL avc420_ensure_buffer(H264_CONTEXT* h264, UINT32 stride, UINT32 width, UINT32 height)
@@ -289,6 +291,48 @@ fail:
 	return rc;
 }
 
+static size_t avc444_region_tiles(const RECTANGLE_16* rect)
+{
+	return ((rect->right - rect->left) / 64 + 1) * ((rect->bottom - rect->top) / 64 + 1);
+}
+
+static void avc444_union_rect(RECTANGLE_16* dst, const RECTANGLE_16* rect)
+{
+	dst->left = MIN(dst->left, rect->left);
+	dst->top = MIN(dst->top, rect->top);
+	dst->right = MAX(dst->right, rect->right);
+	dst->bottom = MAX(dst->bottom, rect->bottom);
+}
+
+/**
+ * Adaptive luma only mode: while large parts of the luma view change the chroma view is not
+ * sent. The skipped area is remembered and sent in full once the motion calms down.
+ *
+ * @return TRUE if the chroma view shall be skipped for this frame
+ */
+static BOOL avc444_skip_chroma(H264_CONTEXT* h264, const RECTANGLE_16* region,
+                               const RDPGFX_H264_METABLOCK* meta)
+{
+	if (!h264->AdaptiveLumaOnly || !h264->firstChromaFrameDone)
+		return FALSE;
+
+	if (meta->numRegionRects * 4 >= avc444_region_tiles(region))
+		h264->motionFrames = MIN(h264->motionFrames + 1, AVC444_MOTION_FRAMES);
+	else
+		h264->motionFrames = 0;
+
+	if (h264->motionFrames < AVC444_MOTION_FRAMES)
+		return FALSE;
+
+	if (h264->chromaRefreshPending)
+		avc444_union_rect(&h264->chromaRefreshRect, region);
+	else
+		h264->chromaRefreshRect = *region;
+
+	h264->chromaRefreshPending = TRUE;
+	return TRUE;
+}
+
 INT32 avc444_compress(H264_CONTEXT* h264, const BYTE* pSrcData, DWORD SrcFormat, UINT32 nSrcStep,
                       UINT32 nSrcWidth, UINT32 nSrcHeight, BYTE version, const RECTANGLE_16* region,
                       BYTE* op, BYTE** ppDstData, UINT32* pDstSize, BYTE** ppAuxDstData,
@@ -298,6 +342,9 @@ INT32 avc444_compress(H264_CONTEXT* h264, const BYTE* pSrcData, DWORD SrcFormat,
 	int rc = -1;
 	BYTE* coded;
 	UINT32 codedSize;
+	BOOL skipChroma;
+	BOOL chromaDone;
+	RECTANGLE_16 chromaRect;
 	BYTE** pYUV444Data;
 	BYTE** pOldYUV444Data;
 	BYTE** pYUVData;
@@ -338,8 +385,28 @@ INT32 avc444_compress(H264_CONTEXT* h264, const BYTE* pSrcData, DWORD SrcFormat,
 	if (!detect_changes(h264->firstLumaFrameDone, h264->QP, region, pYUV444Data, pOldYUV444Data,
 	                    h264->iStride, meta))
 		goto fail;
-	if (!detect_changes(h264->firstChromaFrameDone, h264->QP, region, pYUVData, pOldYUVData,
-	                    h264->iStride, auxMeta))
+
+	skipChroma = avc444_skip_chroma(h264, region, meta);
+	chromaDone = h264->firstChromaFrameDone;
+	chromaRect = *region;
+
+	if (skipChroma)
+		WLog_Print(h264->log, WLOG_TRACE, "motion detected, sending luma view only");
+	else if (h264->chromaRefreshPending)
+	{
+		/* refresh the area skipped during motion, the buffers only hold the current region */
+		if (!yuv444_context_encode(h264->yuv, version, pSrcData, nSrcStep, SrcFormat,
+		                           h264->iStride, pYUV444Data, pYUVData,
+		                           &h264->chromaRefreshRect, 1))
+			goto fail;
+
+		avc444_union_rect(&chromaRect, &h264->chromaRefreshRect);
+		h264->chromaRefreshPending = FALSE;
+		chromaDone = FALSE;
+	}
+
+	if (!skipChroma && !detect_changes(chromaDone, h264->QP, &chromaRect, pYUVData, pOldYUVData,
+	                                   h264->iStride, auxMeta))
 		goto fail;
 
 	/* [MS-RDPEGFX] 2.2.4.5 RFX_AVC444_BITMAP_STREAM
@@ -361,6 +428,8 @@ INT32 avc444_compress(H264_CONTEXT* h264, const BYTE* pSrcData, DWORD SrcFormat,
 		goto fail;
 	}
 
+	/* Both views go through the same encoder: the client decodes them with a single decoder
+	 * context, so they have to share one reference frame chain. */
 	if ((*op == 0) || (*op == 1))
 	{
 		const BYTE* pcYUV444Data[3] = { pYUV444Data[0], pYUV444Data[1], pYUV444Data[2] };
@@ -25,6 +25,7 @@
 #include <winpr/crt.h>
 #include <winpr/print.h>
 #include <winpr/bitstream.h>
+#include <winpr/interlocked.h>
 
 #include <freerdp/primitives.h>
 #include <freerdp/codec/color.h>
@@ -628,234 +629,13 @@ int progressive_delete_surface_context(PROGRESSIVE_CONTEXT* progressive, UINT16
 	return 1;
 }
 
-/*
- * Band	    Offset      Dimensions  Size
- *
- * HL1      0           31x33       1023
- * LH1      1023        33x31       1023
- * HH1      2046        31x31       961
- *
- * HL2      3007        16x17       272
- * LH2      3279        17x16       272
- * HH2      3551        16x16       256
- *
- * HL3      3807        8x9         72
- * LH3      3879        9x8         72
- * HH3      3951        8x8         64
- *
- * LL3      4015        9x9         81
- */
-
-static INLINE void progressive_rfx_idwt_x(const INT16* pLowBand, size_t nLowStep,
-                                          const INT16* pHighBand, size_t nHighStep, INT16* pDstBand,
-                                          size_t nDstStep, size_t nLowCount, size_t nHighCount,
-                                          size_t nDstCount)
-{
-	size_t i;
-	INT16 L0;
-	INT16 H0, H1;
-	INT16 X0, X1, X2;
-
-	for (i = 0; i < nDstCount; i++)
-	{
-		size_t j;
-		const INT16* pL = pLowBand;
-		const INT16* pH = pHighBand;
-		INT16* pX = pDstBand;
-		H0 = *pH++;
-		L0 = *pL++;
-		X0 = L0 - H0;
-		X2 = L0 - H0;
-
-		for (j = 0; j < (nHighCount - 1); j++)
-		{
-			H1 = *pH;
-			pH++;
-			L0 = *pL;
-			pL++;
-			X2 = L0 - ((H0 + H1) / 2);
-			X1 = ((X0 + X2) / 2) + (2 * H0);
-			pX[0] = X0;
-			pX[1] = X1;
-			pX += 2;
-			X0 = X2;
-			H0 = H1;
-		}
-
-		if (nLowCount <= (nHighCount + 1))
-		{
-			if (nLowCount <= nHighCount)
-			{
-				pX[0] = X2;
-				pX[1] = X2 + (2 * H0);
-			}
-			else
-			{
-				L0 = *pL;
-				pL++;
-				X0 = L0 - H0;
-				pX[0] = X2;
-				pX[1] = ((X0 + X2) / 2) + (2 * H0);
-				pX[2] = X0;
-			}
-		}
-		else
-		{
-			L0 = *pL;
-			pL++;
-			X0 = L0 - (H0 / 2);
-			pX[0] = X2;
-			pX[1] = ((X0 + X2) / 2) + (2 * H0);
-			pX[2] = X0;
-			L0 = *pL;
-			pL++;
-			pX[3] = (X0 + L0) / 2;
-		}
-
-		pLowBand += nLowStep;
-		pHighBand += nHighStep;
-		pDstBand += nDstStep;
-	}
-}
-
-static INLINE void progressive_rfx_idwt_y(const INT16* pLowBand, size_t nLowStep,
-                                          const INT16* pHighBand, size_t nHighStep, INT16* pDstBand,
-                                          size_t nDstStep, size_t nLowCount, size_t nHighCount,
-                                          size_t nDstCount)
-{
-	size_t i;
-	INT16 L0;
-	INT16 H0, H1;
-	INT16 X0, X1, X2;
-
-	for (i = 0; i < nDstCount; i++)
-	{
-		size_t j;
-		const INT16* pL = pLowBand;
-		const INT16* pH = pHighBand;
-		INT16* pX = pDstBand;
-		H0 = *pH;
-		pH += nHighStep;
-		L0 = *pL;
-		pL += nLowStep;
-		X0 = L0 - H0;
-		X2 = L0 - H0;
-
-		for (j = 0; j < (nHighCount - 1); j++)
-		{
-			H1 = *pH;
-			pH += nHighStep;
-			L0 = *pL;
-			pL += nLowStep;
-			X2 = L0 - ((H0 + H1) / 2);
-			X1 = ((X0 + X2) / 2) + (2 * H0);
-			*pX = X0;
-			pX += nDstStep;
-			*pX = X1;
-			pX += nDstStep;
-			X0 = X2;
-			H0 = H1;
-		}
-
-		if (nLowCount <= (nHighCount + 1))
-		{
-			if (nLowCount <= nHighCount)
-			{
-				*pX = X2;
-				pX += nDstStep;
-				*pX = X2 + (2 * H0);
-			}
-			else
-			{
-				L0 = *pL;
-				X0 = L0 - H0;
-				*pX = X2;
-				pX += nDstStep;
-				*pX = ((X0 + X2) / 2) + (2 * H0);
-				pX += nDstStep;
-				*pX = X0;
-			}
-		}
-		else
-		{
-			L0 = *pL;
-			pL += nLowStep;
-			X0 = L0 - (H0 / 2);
-			*pX = X2;
-			pX += nDstStep;
-			*pX = ((X0 + X2) / 2) + (2 * H0);
-			pX += nDstStep;
-			*pX = X0;
-			pX += nDstStep;
-			L0 = *pL;
-			*pX = (X0 + L0) / 2;
-		}
-
-		pLowBand++;
-		pHighBand++;
-		pDstBand++;
-	}
-}
-
-static INLINE size_t progressive_rfx_get_band_l_count(size_t level)
-{
-	return (64 >> level) + 1;
-}
-
-static INLINE size_t progressive_rfx_get_band_h_count(size_t level)
-{
-	if (level == 1)
-		return (64 >> 1) - 1;
-	else
-		return (64 + (1 << (level - 1))) >> level;
-}
-
-static INLINE void progressive_rfx_dwt_2d_decode_block(INT16* buffer, INT16* temp, size_t level)
-{
-	size_t nDstStepX;
-	size_t nDstStepY;
-	INT16 *HL, *LH;
-	INT16 *HH, *LL;
-	INT16 *L, *H, *LLx;
-
-	const size_t nBandL = progressive_rfx_get_band_l_count(level);
-	const size_t nBandH = progressive_rfx_get_band_h_count(level);
-	size_t offset = 0;
-
-	HL = &buffer[offset];
-	offset += (nBandH * nBandL);
-	LH = &buffer[offset];
-	offset += (nBandL * nBandH);
-	HH = &buffer[offset];
-	offset += (nBandH * nBandH);
-	LL = &buffer[offset];
-	nDstStepX = (nBandL + nBandH);
-	nDstStepY = (nBandL + nBandH);
-	offset = 0;
-	L = &temp[offset];
-	offset += (nBandL * nDstStepX);
-	H = &temp[offset];
-	LLx = &buffer[0];
-
-	/* horizontal (LL + HL -> L) */
-	progressive_rfx_idwt_x(LL, nBandL, HL, nBandH, L, nDstStepX, nBandL, nBandH, nBandL);
-
-	/* horizontal (LH + HH -> H) */
-	progressive_rfx_idwt_x(LH, nBandL, HH, nBandH, H, nDstStepX, nBandL, nBandH, nBandH);
-
-	/* vertical (L + H -> LL) */
-	progressive_rfx_idwt_y(L, nDstStepX, H, nDstStepX, LLx, nDstStepY, nBandL, nBandH,
-	                       nBandL + nBandH);
-}
-
 static INLINE int progressive_rfx_dwt_2d_decode(PROGRESSIVE_CONTEXT* progressive, INT16* buffer,
-                                                INT16* current, BOOL coeffDiff, BOOL extrapolate,
-                                                BOOL reverse)
+                                                INT16* current, INT16* temp, BOOL coeffDiff,
+                                                BOOL extrapolate, BOOL reverse)
 {
 	const primitives_t* prims = primitives_get();
-	INT16* temp;
 
-	if (!progressive || !buffer || !current)
+	if (!progressive || !buffer || !current || !temp)
 		return -1;
 
 	if (coeffDiff)
@@ -865,21 +645,13 @@ static INLINE int progressive_rfx_dwt_2d_decode(PROGRESSIVE_CONTEXT* progressive
 		CopyMemory(buffer, current, 4096 * 2);
 	else
 		CopyMemory(current, buffer, 4096 * 2);
-	temp = (INT16*)BufferPool_Take(progressive->bufferPool, -1); /* DWT buffer */
-	if (!temp)
-		return -2;
 
 	if (!extrapolate)
 	{
 		progressive->rfx_context->dwt_2d_decode(buffer, temp);
 	}
 	else
-	{
-		progressive_rfx_dwt_2d_decode_block(&buffer[3807], temp, 3);
-		progressive_rfx_dwt_2d_decode_block(&buffer[3007], temp, 2);
-		progressive_rfx_dwt_2d_decode_block(&buffer[0], temp, 1);
-	}
-	BufferPool_Return(progressive->bufferPool, temp);
+		prims->dwtReduceExtrapolateDecode_16s(buffer, temp);
 	return 1;
 }
 
@@ -895,8 +667,9 @@ static INLINE void progressive_rfx_decode_block(const primitives_t* prims, INT16
 static INLINE int progressive_rfx_decode_component(PROGRESSIVE_CONTEXT* progressive,
                                                    const RFX_COMPONENT_CODEC_QUANT* shift,
                                                    const BYTE* data, UINT32 length, INT16* buffer,
-                                                   INT16* current, INT16* sign, BOOL coeffDiff,
-                                                   BOOL subbandDiff, BOOL extrapolate)
+                                                   INT16* current, INT16* sign, INT16* temp,
+                                                   BOOL coeffDiff, BOOL subbandDiff,
+                                                   BOOL extrapolate)
 {
 	int status;
 	const primitives_t* prims = primitives_get();
@@ -935,18 +708,18 @@ static INLINE int progressive_rfx_decode_component(PROGRESSIVE_CONTEXT* progress
 		rfx_differential_decode(&buffer[4015], 81);                           /* LL3 */
 		progressive_rfx_decode_block(prims, &buffer[4015], 81, shift->LL3);   /* LL3 */
 	}
-	return progressive_rfx_dwt_2d_decode(progressive, buffer, current, coeffDiff, extrapolate,
-	                                     FALSE);
+	return progressive_rfx_dwt_2d_decode(progressive, buffer, current, temp, coeffDiff,
+	                                     extrapolate, FALSE);
 }
 
 static INLINE int progressive_decompress_tile_first(PROGRESSIVE_CONTEXT* progressive,
                                                     RFX_PROGRESSIVE_TILE* tile,
                                                     PROGRESSIVE_BLOCK_REGION* region,
-                                                    const PROGRESSIVE_BLOCK_CONTEXT* context)
+                                                    const PROGRESSIVE_BLOCK_CONTEXT* context,
+                                                    BYTE* pBuffer, INT16* temp)
 {
 	int rc;
 	BOOL diff, sub, extrapolate;
-	BYTE* pBuffer;
 	INT16* pSign[3];
 	INT16* pSrcDst[3];
 	INT16* pCurrent[3];
@@ -1047,31 +820,28 @@ static INLINE int progressive_decompress_tile_first(PROGRESSIVE_CONTEXT* progres
 	pCurrent[1] = (INT16*)((BYTE*)(&tile->current[((8192 + 32) * 1) + 16])); /* Cb/G buffer */
 	pCurrent[2] = (INT16*)((BYTE*)(&tile->current[((8192 + 32) * 2) + 16])); /* Cr/B buffer */
 
-	pBuffer = (BYTE*)BufferPool_Take(progressive->bufferPool, -1);
 	pSrcDst[0] = (INT16*)((BYTE*)(&pBuffer[((8192 + 32) * 0) + 16])); /* Y/R buffer */
 	pSrcDst[1] = (INT16*)((BYTE*)(&pBuffer[((8192 + 32) * 1) + 16])); /* Cb/G buffer */
 	pSrcDst[2] = (INT16*)((BYTE*)(&pBuffer[((8192 + 32) * 2) + 16])); /* Cr/B buffer */
 
 	rc = progressive_rfx_decode_component(progressive, &shiftY, tile->yData, tile->yLen, pSrcDst[0],
-	                                      pCurrent[0], pSign[0], diff, sub, extrapolate); /* Y */
+	                                      pCurrent[0], pSign[0], temp, diff, sub,
+	                                      extrapolate); /* Y */
 	if (rc < 0)
-		goto fail;
+		return rc;
 	rc = progressive_rfx_decode_component(progressive, &shiftCb, tile->cbData, tile->cbLen,
-	                                      pSrcDst[1], pCurrent[1], pSign[1], diff, sub,
+	                                      pSrcDst[1], pCurrent[1], pSign[1], temp, diff, sub,
 	                                      extrapolate); /* Cb */
 	if (rc < 0)
-		goto fail;
+		return rc;
 	rc = progressive_rfx_decode_component(progressive, &shiftCr, tile->crData, tile->crLen,
-	                                      pSrcDst[2], pCurrent[2], pSign[2], diff, sub,
+	                                      pSrcDst[2], pCurrent[2], pSign[2], temp, diff, sub,
 	                                      extrapolate); /* Cr */
 	if (rc < 0)
-		goto fail;
+		return rc;
 
-	rc = prims->yCbCrToRGB_16s8u_P3AC4R((const INT16* const*)pSrcDst, 64 * 2, tile->data,
-	                                    tile->stride, progressive->format, &roi_64x64);
-fail:
-	BufferPool_Return(progressive->bufferPool, pBuffer);
-	return rc;
+	return prims->yCbCrToRGB_16s8u_P3AC4R((const INT16* const*)pSrcDst, 64 * 2, tile->data,
+	                                      tile->stride, progressive->format, &roi_64x64);
 }
 
 static INLINE INT16 progressive_rfx_srl_read(RFX_PROGRESSIVE_UPGRADE_STATE* state, UINT32 numBits)
@@ -1194,19 +964,20 @@ static INLINE int progressive_rfx_upgrade_block(RFX_PROGRESSIVE_UPGRADE_STATE* s
 {
 	UINT32 index;
 	INT16 input;
+	UINT32 mask;
 	wBitStream* raw;
 
 	if (!numBits)
 		return 1;
 
 	raw = state->raw;
+	mask = ((1 << numBits) - 1);
 
 	if (!state->nonLL)
 	{
 		for (index = 0; index < length; index++)
 		{
-			raw->mask = ((1 << numBits) - 1);
-			input = (INT16)((raw->accumulator >> (32 - numBits)) & raw->mask);
+			input = (INT16)((raw->accumulator >> (32 - numBits)) & mask);
 			BitStream_Shift(raw, numBits);
 			buffer[index] += (input << shift);
 		}
@@ -1219,15 +990,13 @@ static INLINE int progressive_rfx_upgrade_block(RFX_PROGRESSIVE_UPGRADE_STATE* s
 		if (sign[index] > 0)
 		{
 			/* sign > 0, read from raw */
-			raw->mask = ((1 << numBits) - 1);
-			input = (INT16)((raw->accumulator >> (32 - numBits)) & raw->mask);
+			input = (INT16)((raw->accumulator >> (32 - numBits)) & mask);
 			BitStream_Shift(raw, numBits);
 		}
 		else if (sign[index] < 0)
 		{
 			/* sign < 0, read from raw */
-			raw->mask = ((1 << numBits) - 1);
-			input = (INT16)((raw->accumulator >> (32 - numBits)) & raw->mask);
+			input = (INT16)((raw->accumulator >> (32 - numBits)) & mask);
 			BitStream_Shift(raw, numBits);
 			input *= -1;
 		}
@@ -1247,7 +1016,7 @@ static INLINE int progressive_rfx_upgrade_block(RFX_PROGRESSIVE_UPGRADE_STATE* s
 static INLINE int progressive_rfx_upgrade_component(
     PROGRESSIVE_CONTEXT* progressive, const RFX_COMPONENT_CODEC_QUANT* shift,
     const RFX_COMPONENT_CODEC_QUANT* bitPos, const RFX_COMPONENT_CODEC_QUANT* numBits,
-    INT16* buffer, INT16* current, INT16* sign, const BYTE* srlData, UINT32 srlLen,
+    INT16* buffer, INT16* current, INT16* sign, INT16* temp, const BYTE* srlData, UINT32 srlLen,
     const BYTE* rawData, UINT32 rawLen, BOOL coeffDiff, BOOL subbandDiff, BOOL extrapolate)
 {
 	int rc;
@@ -1335,18 +1104,18 @@ static INLINE int progressive_rfx_upgrade_component(
 		return -1;
 	}
 
-	return progressive_rfx_dwt_2d_decode(progressive, buffer, current, coeffDiff, extrapolate,
-	                                     TRUE);
+	return progressive_rfx_dwt_2d_decode(progressive, buffer, current, temp, coeffDiff,
+	                                     extrapolate, TRUE);
 }
 
 static INLINE int progressive_decompress_tile_upgrade(PROGRESSIVE_CONTEXT* progressive,
                                                       RFX_PROGRESSIVE_TILE* tile,
                                                       PROGRESSIVE_BLOCK_REGION* region,
-                                                      const PROGRESSIVE_BLOCK_CONTEXT* context)
+                                                      const PROGRESSIVE_BLOCK_CONTEXT* context,
+                                                      BYTE* pBuffer, INT16* temp)
 {
 	int status;
 	BOOL coeffDiff, sub, extrapolate;
-	BYTE* pBuffer;
 	INT16* pSign[3] = { 0 };
 	INT16* pSrcDst[3] = { 0 };
 	INT16* pCurrent[3] = { 0 };
@@ -1472,40 +1241,39 @@ static INLINE int progressive_decompress_tile_upgrade(PROGRESSIVE_CONTEXT* progr
 	pCurrent[1] = (INT16*)((BYTE*)(&tile->current[((8192 + 32) * 1) + 16])); /* Cb/G buffer */
 	pCurrent[2] = (INT16*)((BYTE*)(&tile->current[((8192 + 32) * 2) + 16])); /* Cr/B buffer */
 
-	pBuffer = (BYTE*)BufferPool_Take(progressive->bufferPool, -1);
 	pSrcDst[0] = (INT16*)((BYTE*)(&pBuffer[((8192 + 32) * 0) + 16])); /* Y/R buffer */
 	pSrcDst[1] = (INT16*)((BYTE*)(&pBuffer[((8192 + 32) * 1) + 16])); /* Cb/G buffer */
 	pSrcDst[2] = (INT16*)((BYTE*)(&pBuffer[((8192 + 32) * 2) + 16])); /* Cr/B buffer */
 
 	status = progressive_rfx_upgrade_component(progressive, &shiftY, quantProgY, &yNumBits,
-	                                           pSrcDst[0], pCurrent[0], pSign[0], tile->ySrlData,
-	                                           tile->ySrlLen, tile->yRawData, tile->yRawLen,
-	                                           coeffDiff, sub, extrapolate); /* Y */
+	                                           pSrcDst[0], pCurrent[0], pSign[0], temp,
+	                                           tile->ySrlData, tile->ySrlLen, tile->yRawData,
+	                                           tile->yRawLen, coeffDiff, sub,
+	                                           extrapolate); /* Y */
 
 	if (status < 0)
-		goto fail;
+		return status;
 
 	status = progressive_rfx_upgrade_component(progressive, &shiftCb, quantProgCb, &cbNumBits,
-	                                           pSrcDst[1], pCurrent[1], pSign[1], tile->cbSrlData,
-	                                           tile->cbSrlLen, tile->cbRawData, tile->cbRawLen,
-	                                           coeffDiff, sub, extrapolate); /* Cb */
+	                                           pSrcDst[1], pCurrent[1], pSign[1], temp,
+	                                           tile->cbSrlData, tile->cbSrlLen, tile->cbRawData,
+	                                           tile->cbRawLen, coeffDiff, sub,
+	                                           extrapolate); /* Cb */
 
 	if (status < 0)
-		goto fail;
+		return status;
 
 	status = progressive_rfx_upgrade_component(progressive, &shiftCr, quantProgCr, &crNumBits,
-	                                           pSrcDst[2], pCurrent[2], pSign[2], tile->crSrlData,
-	                                           tile->crSrlLen, tile->crRawData, tile->crRawLen,
-	                                           coeffDiff, sub, extrapolate); /* Cr */
+	                                           pSrcDst[2], pCurrent[2], pSign[2], temp,
+	                                           tile->crSrlData, tile->crSrlLen, tile->crRawData,
+	                                           tile->crRawLen, coeffDiff, sub,
+	                                           extrapolate); /* Cr */
 
 	if (status < 0)
-		goto fail;
+		return status;
 
-	status = prims->yCbCrToRGB_16s8u_P3AC4R((const INT16* const*)pSrcDst, 64 * 2, tile->data,
-	                                        tile->stride, progressive->format, &roi_64x64);
-fail:
-	BufferPool_Return(progressive->bufferPool, pBuffer);
-	return status;
+	return prims->yCbCrToRGB_16s8u_P3AC4R((const INT16* const*)pSrcDst, 64 * 2, tile->data,
+	                                      tile->stride, progressive->format, &roi_64x64);
 }
 
 static INLINE BOOL progressive_tile_read_upgrade(PROGRESSIVE_CONTEXT* progressive, wStream* s,
@@ -1648,57 +1416,87 @@ static INLINE BOOL progressive_tile_read(PROGRESSIVE_CONTEXT* progressive, BOOL
 	return progressive_surface_tile_replace(surface, region, &tile, FALSE);
 }
 
-typedef struct
+static void progressive_process_tile(PROGRESSIVE_CONTEXT* progressive, RFX_PROGRESSIVE_TILE* tile,
+                                     PROGRESSIVE_BLOCK_REGION* region,
+                                     const PROGRESSIVE_BLOCK_CONTEXT* context, BYTE* pBuffer,
+                                     INT16* temp)
 {
-	PROGRESSIVE_CONTEXT* progressive;
-	PROGRESSIVE_BLOCK_REGION* region;
-	const PROGRESSIVE_BLOCK_CONTEXT* context;
-	RFX_PROGRESSIVE_TILE* tile;
-} PROGRESSIVE_TILE_PROCESS_WORK_PARAM;
-
-static void CALLBACK progressive_process_tiles_tile_work_callback(PTP_CALLBACK_INSTANCE instance,
-                                                                  void* context, PTP_WORK work)
-{
-	PROGRESSIVE_TILE_PROCESS_WORK_PARAM* param = (PROGRESSIVE_TILE_PROCESS_WORK_PARAM*)context;
-
-	WINPR_UNUSED(instance);
-	WINPR_UNUSED(work);
-
-	switch (param->tile->blockType)
+	switch (tile->blockType)
 	{
 		case PROGRESSIVE_WBT_TILE_SIMPLE:
 		case PROGRESSIVE_WBT_TILE_FIRST:
-			progressive_decompress_tile_first(param->progressive, param->tile, param->region,
-			                                  param->context);
+			progressive_decompress_tile_first(progressive, tile, region, context, pBuffer, temp);
 			break;
 
 		case PROGRESSIVE_WBT_TILE_UPGRADE:
-			progressive_decompress_tile_upgrade(param->progressive, param->tile, param->region,
-			                                    param->context);
+			progressive_decompress_tile_upgrade(progressive, tile, region, context, pBuffer, temp);
 			break;
 		default:
-			WLog_Print(param->progressive->log, WLOG_ERROR, "Invalid block type %04 (%s)" PRIx16,
-			           param->tile->blockType,
-			           progressive_get_block_type_string(param->tile->blockType));
+			WLog_Print(progressive->log, WLOG_ERROR, "Invalid block type %04 (%s)" PRIx16,
+			           tile->blockType, progressive_get_block_type_string(tile->blockType));
 			break;
 	}
 }
 
+/**
+ * Each invocation is one worker: it takes its scratch buffers once and then keeps claiming
+ * batches of tiles until the region is done.
+ */
+static void CALLBACK progressive_process_tiles_work_callback(PTP_CALLBACK_INSTANCE instance,
+                                                             void* context, PTP_WORK work)
+{
+	BYTE* pBuffer;
+	INT16* temp;
+	PROGRESSIVE_CONTEXT* progressive = (PROGRESSIVE_CONTEXT*)context;
+	PROGRESSIVE_TILE_JOB* job;
+
+	WINPR_UNUSED(instance);
+	WINPR_UNUSED(work);
+	WINPR_ASSERT(progressive);
+
+	job = &progressive->tileJob;
+	pBuffer = (BYTE*)BufferPool_Take(progressive->bufferPool, -1);
+	temp = (INT16*)BufferPool_Take(progressive->bufferPool, -1); /* DWT buffer */
+
+	if (!pBuffer || !temp)
+	{
+		WLog_Print(progressive->log, WLOG_ERROR, "Failed to allocate tile scratch buffers");
+		InterlockedExchange(&job->failed, 1);
+	}
+	else
+	{
+		LONG batch;
+
+		while ((batch = InterlockedIncrement(&job->nextBatch) - 1) < (LONG)job->numBatches)
+		{
+			const UINT32 first = (UINT32)batch * PROGRESSIVE_TILES_PER_WORK;
+			const UINT32 last = MIN(first + PROGRESSIVE_TILES_PER_WORK, job->region->numTiles);
+			UINT32 index;
+
+			for (index = first; index < last; index++)
+				progressive_process_tile(progressive, job->region->tiles[index], job->region,
+				                         job->context, pBuffer, temp);
+		}
+	}
+
+	if (pBuffer)
+		BufferPool_Return(progressive->bufferPool, pBuffer);
+	if (temp)
+		BufferPool_Return(progressive->bufferPool, temp);
+}
+
 static INLINE int progressive_process_tiles(PROGRESSIVE_CONTEXT* progressive, wStream* s,
                                             PROGRESSIVE_BLOCK_REGION* region,
                                             PROGRESSIVE_SURFACE_CONTEXT* surface,
                                             const PROGRESSIVE_BLOCK_CONTEXT* context)
 {
-	int status = 0;
 	size_t end;
 	const size_t start = Stream_GetPosition(s);
 	UINT16 index;
 	UINT16 blockType;
 	UINT32 blockLen;
 	UINT32 count = 0;
-	PTP_WORK* work_objects = NULL;
-	PROGRESSIVE_TILE_PROCESS_WORK_PARAM* params = NULL;
-	UINT16 close_cnt = 0;
+	PROGRESSIVE_TILE_JOB* job;
 
 	WINPR_ASSERT(progressive);
 	WINPR_ASSERT(region);
@@ -1778,75 +1576,43 @@ static INLINE int progressive_process_tiles(PROGRESSIVE_CONTEXT* progressive, wS
 		return -1044;
 	}
 
-	if (progressive->rfx_context->priv->UseThreads)
-	{
-		work_objects = (PTP_WORK*)calloc(region->numTiles, sizeof(PTP_WORK));
-		if (!work_objects)
-			return -1;
-	}
+	job = &progressive->tileJob;
+	job->region = region;
+	job->context = context;
+	job->numBatches =
+	    (region->numTiles + PROGRESSIVE_TILES_PER_WORK - 1) / PROGRESSIVE_TILES_PER_WORK;
+	job->nextBatch = 0;
+	job->failed = 0;
 
-	params = (PROGRESSIVE_TILE_PROCESS_WORK_PARAM*)calloc(
-	    region->numTiles, sizeof(PROGRESSIVE_TILE_PROCESS_WORK_PARAM));
-	if (!params)
+	if (progressive->rfx_context->priv->UseThreads && (job->numBatches > 1))
 	{
-		free(work_objects);
-		return -1;
-	}
-
-	for (index = 0; index < region->numTiles; index++)
-	{
-		RFX_PROGRESSIVE_TILE* tile = region->tiles[index];
-		PROGRESSIVE_TILE_PROCESS_WORK_PARAM* param = &params[index];
-		param->progressive = progressive;
-		param->region = region;
-		param->context = context;
-		param->tile = tile;
+		RFX_CONTEXT_PRIV* priv = progressive->rfx_context->priv;
+		UINT32 workers = job->numBatches;
 
-		if (progressive->rfx_context->priv->UseThreads)
+		if (!progressive->tileWork)
 		{
-			if (!(work_objects[index] = CreateThreadpoolWork(
-			          progressive_process_tiles_tile_work_callback, (void*)&params[index],
-			          &progressive->rfx_context->priv->ThreadPoolEnv)))
+			progressive->tileWork = CreateThreadpoolWork(progressive_process_tiles_work_callback,
+			                                             progressive, &priv->ThreadPoolEnv);
+
+			if (!progressive->tileWork)
 			{
 				WLog_ERR(TAG, "CreateThreadpoolWork failed.");
-				status = -1;
-				break;
+				return -1;
 			}
-
-			SubmitThreadpoolWork(work_objects[index]);
-			close_cnt = index + 1;
-		}
-		else
-		{
-			progressive_process_tiles_tile_work_callback(0, &params[index], 0);
 		}
 
-		if (status < 0)
-		{
-			WLog_Print(progressive->log, WLOG_ERROR, "Failed to decompress %s at %" PRIu16,
-			           progressive_get_block_type_string(tile->blockType), index);
-			goto fail;
-		}
-	}
+		if ((priv->MinThreadCount > 0) && (workers > priv->MinThreadCount))
+			workers = priv->MinThreadCount;
 
-	if (status < 0)
-		WLog_Print(progressive->log, WLOG_ERROR,
-		           "Failed to create ThreadpoolWork for tile %" PRIu16, index);
+		for (index = 0; index < workers; index++)
+			SubmitThreadpoolWork(progressive->tileWork);
 
-	if (progressive->rfx_context->priv->UseThreads)
-	{
-		for (index = 0; index < close_cnt; index++)
-		{
-			WaitForThreadpoolWorkCallbacks(work_objects[index], FALSE);
-			CloseThreadpoolWork(work_objects[index]);
-		}
+		WaitForThreadpoolWorkCallbacks(progressive->tileWork, FALSE);
 	}
+	else
+		progressive_process_tiles_work_callback(NULL, progressive, NULL);
 
-fail:
-	free(work_objects);
-	free(params);
-
-	if (status < 0)
+	if (job->failed)
 		return -1;
 
 	return (int)(end - start);
@@ -2804,5 +2570,8 @@ void progressive_context_free(PROGRESSIVE_CONTEXT* progressive)
 	BufferPool_Free(progressive->bufferPool);
 	HashTable_Free(progressive->SurfaceContexts);
 
+	if (progressive->tileWork)
+		CloseThreadpoolWork(progressive->tileWork);
+
 	free(progressive);
 }
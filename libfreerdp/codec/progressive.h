@@ -23,6 +23,7 @@
 
 #include <winpr/wlog.h>
 #include <winpr/collections.h>
+#include <winpr/pool.h>
 
 #include <freerdp/codec/rfx.h>
 
@@ -206,6 +207,17 @@ typedef enum
 	FLAG_WBT_REGION = 0x10
 } WBT_STATE_FLAG;
 
+#define PROGRESSIVE_TILES_PER_WORK 4
+
+typedef struct
+{
+	PROGRESSIVE_BLOCK_REGION* region;
+	const PROGRESSIVE_BLOCK_CONTEXT* context;
+	UINT32 numBatches;
+	LONG nextBatch;
+	LONG failed;
+} PROGRESSIVE_TILE_JOB;
+
 struct S_PROGRESSIVE_CONTEXT
 {
 	BOOL Compressor;
@@ -224,6 +236,9 @@ struct S_PROGRESSIVE_CONTEXT
 	wStream* buffer;
 	wStream* rects;
 	RFX_CONTEXT* rfx_context;
+
+	PTP_WORK tileWork; /* persistent worker, submitted once per thread for each region */
+	PROGRESSIVE_TILE_JOB tileJob;
 };
 
 #endif /* INTERNAL_CODEC_PROGRESSIVE_H */
@@ -0,0 +1,155 @@
+#include <stdio.h>
+
+#include <winpr/crt.h>
+
+#include <freerdp/codec/color.h>
+#include <freerdp/codec/h264.h>
+#include <freerdp/channels/rdpgfx.h>
+
+#define TEST_WIDTH 64
+#define TEST_HEIGHT 64
+#define TEST_FRAMES 6
+#define TEST_MAX_ERROR 12 /* mean absolute error per channel */
+
+static void test_fill_frame(BYTE* data, UINT32 stride, UINT32 frame)
+{
+	UINT32 x, y;
+
+	for (y = 0; y < TEST_HEIGHT; y++)
+	{
+		BYTE* line = &data[y * stride];
+
+		for (x = 0; x < TEST_WIDTH; x++)
+		{
+			const BYTE r = (BYTE)((x * 4 + frame * 16) & 0xFF);
+			const BYTE g = (BYTE)((y * 4 + frame * 8) & 0xFF);
+			const BYTE b = (BYTE)(((x + y) * 2 + frame * 24) & 0xFF);
+
+			FreeRDPWriteColor(&line[x * 4], PIXEL_FORMAT_BGRX32,
+			                  FreeRDPGetColor(PIXEL_FORMAT_BGRX32, r, g, b, 0xFF));
+		}
+	}
+}
+
+static BOOL test_compare(const BYTE* src, const BYTE* dst, UINT32 stride, UINT32 frame)
+{
+	UINT32 x, y;
+	UINT64 error[3] = { 0 };
+
+	for (y = 0; y < TEST_HEIGHT; y++)
+	{
+		for (x = 0; x < TEST_WIDTH; x++)
+		{
+			BYTE sr, sg, sb, dr, dg, db;
+			const UINT32 scolor = FreeRDPReadColor(&src[y * stride + x * 4], PIXEL_FORMAT_BGRX32);
+			const UINT32 dcolor = FreeRDPReadColor(&dst[y * stride + x * 4], PIXEL_FORMAT_BGRX32);
+
+			FreeRDPSplitColor(scolor, PIXEL_FORMAT_BGRX32, &sr, &sg, &sb, NULL, NULL);
+			FreeRDPSplitColor(dcolor, PIXEL_FORMAT_BGRX32, &dr, &dg, &db, NULL, NULL);
+			error[0] += (UINT64)abs(sr - dr);
+			error[1] += (UINT64)abs(sg - dg);
+			error[2] += (UINT64)abs(sb - db);
+		}
+	}
+
+	for (x = 0; x < ARRAYSIZE(error); x++)
+	{
+		const UINT64 mean = error[x] / (TEST_WIDTH * TEST_HEIGHT);
+
+		if (mean > TEST_MAX_ERROR)
+		{
+			fprintf(stderr, "frame %" PRIu32 ": mean error %" PRIu64 " in channel %" PRIu32 "\n",
+			        frame, mean, x);
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+/* Encode several AVC444 frames and decode them with a single decoder context, as a client
+ * does. Luma and chroma view have to share one reference chain for the P-frames to decode. */
+int TestFreeRDPCodecH264(int argc, char* argv[])
+{
+	int rc = -1;
+	UINT32 frame;
+	const UINT32 stride = TEST_WIDTH * 4;
+	const RECTANGLE_16 rect = { 0, 0, TEST_WIDTH, TEST_HEIGHT };
+	H264_CONTEXT* encoder = NULL;
+	H264_CONTEXT* decoder = NULL;
+	BYTE* src = calloc(TEST_HEIGHT, stride);
+	BYTE* dst = calloc(TEST_HEIGHT, stride);
+
+	WINPR_UNUSED(argc);
+	WINPR_UNUSED(argv);
+
+	if (!src || !dst)
+		goto fail;
+
+	encoder = h264_context_new(TRUE);
+	decoder = h264_context_new(FALSE);
+
+	if (!encoder || !decoder)
+	{
+		printf("H.264 not available, skipping test\n");
+		rc = 0;
+		goto fail;
+	}
+
+	encoder->RateControlMode = H264_RATECONTROL_CQP;
+	encoder->QP = 10;
+
+	if (!h264_context_reset(encoder, TEST_WIDTH, TEST_HEIGHT) ||
+	    !h264_context_reset(decoder, TEST_WIDTH, TEST_HEIGHT))
+		goto fail;
+
+	for (frame = 0; frame < TEST_FRAMES; frame++)
+	{
+		INT32 status;
+		BYTE op = 0;
+		BYTE* data = NULL;
+		BYTE* auxData = NULL;
+		UINT32 size = 0;
+		UINT32 auxSize = 0;
+		RDPGFX_H264_METABLOCK meta = { 0 };
+		RDPGFX_H264_METABLOCK auxMeta = { 0 };
+
+		test_fill_frame(src, stride, frame);
+
+		status = avc444_compress(encoder, src, PIXEL_FORMAT_BGRX32, stride, TEST_WIDTH,
+		                         TEST_HEIGHT, 1, &rect, &op, &data, &size, &auxData, &auxSize,
+		                         &meta, &auxMeta);
+
+		if (status < 0)
+		{
+			fprintf(stderr, "frame %" PRIu32 ": avc444_compress failed\n", frame);
+			goto fail;
+		}
+
+		if (status > 0)
+			status = avc444_decompress(decoder, op, meta.regionRects, meta.numRegionRects, data,
+			                           size, auxMeta.regionRects, auxMeta.numRegionRects, auxData,
+			                           auxSize, dst, PIXEL_FORMAT_BGRX32, stride, TEST_WIDTH,
+			                           TEST_HEIGHT, RDPGFX_CODECID_AVC444);
+
+		free_h264_metablock(&meta);
+		free_h264_metablock(&auxMeta);
+
+		if (status < 0)
+		{
+			fprintf(stderr, "frame %" PRIu32 ": avc444_decompress failed\n", frame);
+			goto fail;
+		}
+
+		if (!test_compare(src, dst, stride, frame))
+			goto fail;
+	}
+
+	rc = 0;
+fail:
+	h264_context_free(encoder);
+	h264_context_free(decoder);
+	free(src);
+	free(dst);
+	return rc;
+}
@@ -492,6 +492,9 @@ BOOL freerdp_settings_get_bool(const rdpSettings* settings, size_t id)
 		case FreeRDP_SupportSSHAgentChannel:
 			return settings->SupportSSHAgentChannel;
 
+		case FreeRDP_SupportSkipChannelJoin:
+			return settings->SupportSkipChannelJoin;
+
 		case FreeRDP_SupportStatusInfoPdu:
 			return settings->SupportStatusInfoPdu;
 
@@ -1185,6 +1188,10 @@ BOOL freerdp_settings_set_bool(rdpSettings* settings, size_t id, BOOL val)
 			settings->SupportSSHAgentChannel = cnv.c;
 			break;
 
+		case FreeRDP_SupportSkipChannelJoin:
+			settings->SupportSkipChannelJoin = cnv.c;
+			break;
+
 		case FreeRDP_SupportStatusInfoPdu:
 			settings->SupportStatusInfoPdu = cnv.c;
 			break;
@@ -1383,6 +1390,9 @@ UINT32 freerdp_settings_get_uint32(const rdpSettings* settings, size_t id)
 		case FreeRDP_AutoReconnectMaxRetries:
 			return settings->AutoReconnectMaxRetries;
 
+		case FreeRDP_BitmapCacheMemoryBudget:
+			return settings->BitmapCacheMemoryBudget;
+
 		case FreeRDP_BitmapCacheV2NumCells:
 			return settings->BitmapCacheV2NumCells;
 
@@ -1482,6 +1492,9 @@ UINT32 freerdp_settings_get_uint32(const rdpSettings* settings, size_t id)
 		case FreeRDP_ExtEncryptionMethods:
 			return settings->ExtEncryptionMethods;
 
+		case FreeRDP_FastPathInputBatchLatency:
+			return settings->FastPathInputBatchLatency;
+
 		case FreeRDP_Floatbar:
 			return settings->Floatbar;
 
@@ -1761,6 +1774,10 @@ BOOL freerdp_settings_set_uint32(rdpSettings* settings, size_t id, UINT32 val)
 			settings->AutoReconnectMaxRetries = cnv.c;
 			break;
 
+		case FreeRDP_BitmapCacheMemoryBudget:
+			settings->BitmapCacheMemoryBudget = cnv.c;
+			break;
+
 		case FreeRDP_BitmapCacheV2NumCells:
 			settings->BitmapCacheV2NumCells = cnv.c;
 			break;
@@ -1893,6 +1910,10 @@ BOOL freerdp_settings_set_uint32(rdpSettings* settings, size_t id, UINT32 val)
 			settings->ExtEncryptionMethods = cnv.c;
 			break;
 
+		case FreeRDP_FastPathInputBatchLatency:
+			settings->FastPathInputBatchLatency = cnv.c;
+			break;
+
 		case FreeRDP_Floatbar:
 			settings->Floatbar = cnv.c;
 			break;
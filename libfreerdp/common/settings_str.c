@@ -167,6 +167,7 @@ static const struct settings_str_entry settings_map[] = {
 	{ FreeRDP_SupportMonitorLayoutPdu, 0, "FreeRDP_SupportMonitorLayoutPdu" },
 	{ FreeRDP_SupportMultitransport, 0, "FreeRDP_SupportMultitransport" },
 	{ FreeRDP_SupportSSHAgentChannel, 0, "FreeRDP_SupportSSHAgentChannel" },
+	{ FreeRDP_SupportSkipChannelJoin, 0, "FreeRDP_SupportSkipChannelJoin" },
 	{ FreeRDP_SupportStatusInfoPdu, 0, "FreeRDP_SupportStatusInfoPdu" },
 	{ FreeRDP_SupportVideoOptimized, 0, "FreeRDP_SupportVideoOptimized" },
 	{ FreeRDP_SuppressOutput, 0, "FreeRDP_SuppressOutput" },
@@ -194,6 +195,7 @@ static const struct settings_str_entry settings_map[] = {
 	{ FreeRDP_AcceptedCertLength, 3, "FreeRDP_AcceptedCertLength" },
 	{ FreeRDP_AuthenticationLevel, 3, "FreeRDP_AuthenticationLevel" },
 	{ FreeRDP_AutoReconnectMaxRetries, 3, "FreeRDP_AutoReconnectMaxRetries" },
+	{ FreeRDP_BitmapCacheMemoryBudget, 3, "FreeRDP_BitmapCacheMemoryBudget" },
 	{ FreeRDP_BitmapCacheV2NumCells, 3, "FreeRDP_BitmapCacheV2NumCells" },
 	{ FreeRDP_BitmapCacheV3CodecId, 3, "FreeRDP_BitmapCacheV3CodecId" },
 	{ FreeRDP_BitmapCacheVersion, 3, "FreeRDP_BitmapCacheVersion" },
@@ -227,6 +229,7 @@ static const struct settings_str_entry settings_map[] = {
 	{ FreeRDP_EncryptionLevel, 3, "FreeRDP_EncryptionLevel" },
 	{ FreeRDP_EncryptionMethods, 3, "FreeRDP_EncryptionMethods" },
 	{ FreeRDP_ExtEncryptionMethods, 3, "FreeRDP_ExtEncryptionMethods" },
+	{ FreeRDP_FastPathInputBatchLatency, 3, "FreeRDP_FastPathInputBatchLatency" },
 	{ FreeRDP_Floatbar, 3, "FreeRDP_Floatbar" },
 	{ FreeRDP_FrameAcknowledge, 3, "FreeRDP_FrameAcknowledge" },
 	{ FreeRDP_GatewayAcceptedCertLength, 3, "FreeRDP_GatewayAcceptedCertLength" },
@@ -21,8 +21,11 @@
 
 #include <winpr/assert.h>
 
+#include <freerdp/cache/cache.h>
+
 #include "activation.h"
 #include "display.h"
+#include "../cache/bitmap.h"
 
 #define TAG FREERDP_TAG("core.activation")
 
@@ -271,13 +274,12 @@ static BOOL rdp_write_client_persistent_key_list_pdu(wStream* s, RDP_BITMAP_PERS
 
 static UINT32 rdp_load_persistent_key_list(rdpRdp* rdp, UINT64** pKeyList)
 {
-	int index;
 	int count;
 	int status;
 	UINT32 keyCount;
+	const UINT64* keys;
 	UINT64* keyList = NULL;
 	rdpPersistentCache* persistent;
-	PERSISTENT_CACHE_ENTRY cacheEntry;
 	rdpSettings* settings = rdp->settings;
 
 	*pKeyList = NULL;
@@ -299,20 +301,19 @@ static UINT32 rdp_load_persistent_key_list(rdpRdp* rdp, UINT64** pKeyList)
 		goto error;
 
 	count = persistent_cache_get_count(persistent);
+	keys = persistent_cache_get_keys(persistent);
+
+	if ((count < 1) || !keys)
+		goto error;
 
+	/* only the keys are needed, the bitmap data is not read */
 	keyCount = (UINT32)count;
 	keyList = (UINT64*)malloc(keyCount * sizeof(UINT64));
 
 	if (!keyList)
 		goto error;
 
-	for (index = 0; index < count; index++)
-	{
-		if (persistent_cache_read_entry(persistent, &cacheEntry) < 1)
-			continue;
-
-		keyList[index] = cacheEntry.key64;
-	}
+	CopyMemory(keyList, keys, keyCount * sizeof(UINT64));
 
 	*pKeyList = keyList;
 
@@ -398,7 +399,23 @@ BOOL rdp_send_client_persistent_key_list_pdu(rdpRdp* rdp)
 	WINPR_ASSERT(rdp->mcs);
 	free(keyList);
 
-	return rdp_send_data_pdu(rdp, s, DATA_PDU_TYPE_BITMAP_CACHE_PERSISTENT_LIST, rdp->mcs->userId);
+	if (!rdp_send_data_pdu(rdp, s, DATA_PDU_TYPE_BITMAP_CACHE_PERSISTENT_LIST, rdp->mcs->userId))
+		return FALSE;
+
+	/* the server expects the advertised bitmaps in these cache cells */
+	if (info.keyCount > 0)
+	{
+		const UINT32 numEntries[] = { info.numEntriesCache0, info.numEntriesCache1,
+			                          info.numEntriesCache2, info.numEntriesCache3,
+			                          info.numEntriesCache4 };
+		rdpCache* cache = rdp->context->cache;
+
+		if (cache && !bitmap_cache_load_persistent(cache->bitmap, numEntries,
+		                                           ARRAYSIZE(numEntries)))
+			WLog_WARN(TAG, "failed to open the persistent bitmap cache for loading");
+	}
+
+	return TRUE;
 }
 
 BOOL rdp_recv_client_font_list_pdu(wStream* s)
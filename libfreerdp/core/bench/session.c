@@ -0,0 +1,1102 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Implementation
+ * Loopback Session Benchmark
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <freerdp/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <winpr/crt.h>
+#include <winpr/assert.h>
+#include <winpr/file.h>
+#include <winpr/path.h>
+#include <winpr/synch.h>
+#include <winpr/thread.h>
+#include <winpr/stream.h>
+#include <winpr/sysinfo.h>
+#include <winpr/interlocked.h>
+#include <winpr/tools/makecert.h>
+
+#include <freerdp/version.h>
+#include <freerdp/freerdp.h>
+#include <freerdp/listener.h>
+#include <freerdp/peer.h>
+#include <freerdp/metrics.h>
+#include <freerdp/settings.h>
+#include <freerdp/constants.h>
+#include <freerdp/gdi/gdi.h>
+#include <freerdp/codec/color.h>
+#include <freerdp/codec/rfx.h>
+#include <freerdp/codec/nsc.h>
+#include <freerdp/log.h>
+
+#define TAG FREERDP_TAG("core.bench")
+
+#define BENCH_FORMAT PIXEL_FORMAT_BGRX32
+/* every n-th frame of the script scrolls the whole desktop */
+#define BENCH_SCROLL_INTERVAL 8
+#define BENCH_SCROLL_LINES 16
+#define BENCH_WINDOW_STEP 16
+#define BENCH_TITLE_HEIGHT 24
+#define BENCH_TIMEOUT_MS 60000
+/* the first frames are sent while the client still finishes the connection sequence */
+#define BENCH_WARMUP_FRAMES 2
+
+typedef struct
+{
+	const char* name;
+	UINT32 level;
+} BENCH_COMPRESSION;
+
+static const BENCH_COMPRESSION bench_compressions[] = { { "none", UINT32_MAX },
+	                                                    { "8k", PACKET_COMPR_TYPE_8K },
+	                                                    { "64k", PACKET_COMPR_TYPE_64K },
+	                                                    { "rdp6", PACKET_COMPR_TYPE_RDP6 },
+	                                                    { "rdp61", PACKET_COMPR_TYPE_RDP61 } };
+
+/* State shared by the server peer thread and the client */
+typedef struct
+{
+	UINT32 width;
+	UINT32 height;
+	UINT32 frames;
+	UINT32 window;
+	BOOL nsc;
+	const BENCH_COMPRESSION* compression;
+	UINT16 port;
+
+	char* tempPath;
+	char* certificateFile;
+	char* privateKeyFile;
+
+	/* per frame time stamps, taken by the server before encoding and by the client after the
+	 * end of frame marker was processed */
+	UINT64* sent;
+	UINT64* done;
+	LONG framesSent;
+	LONG framesDone;
+
+	HANDLE frameDoneEvent;
+	HANDLE stopEvent;
+	HANDLE peerThread;
+	BOOL failed;
+
+	rdpMetrics serverMetrics;
+	rdpMetrics clientMetrics;
+	/* bytes of the frames after the warmup */
+	UINT64 surfaceBytes;
+	UINT64 bytesSent;
+	UINT64 bytesWarmup;
+} BENCH_SESSION;
+
+typedef struct
+{
+	rdpContext _p;
+
+	BENCH_SESSION* session;
+	RFX_CONTEXT* rfx;
+	NSC_CONTEXT* nsc;
+	wStream* s;
+	BYTE* surface;
+	UINT32 stride;
+	RFX_RECT windowRect;
+	UINT32 scroll;
+	BOOL activated;
+} benchPeerContext;
+
+typedef struct
+{
+	rdpContext _p;
+
+	BENCH_SESSION* session;
+	pSurfaceFrameMarker SurfaceFrameMarker;
+} benchClientContext;
+
+static UINT32 bench_background(UINT32 x, UINT32 y)
+{
+	const BYTE r = (BYTE)(x + y);
+	const BYTE g = (BYTE)(x >> 1);
+	const BYTE b = (BYTE)(y >> 1);
+	return FreeRDPGetColor(BENCH_FORMAT, r, g, b, 0xFF);
+}
+
+/* Draws a text like pattern that changes every frame so the window is never a cache hit */
+static UINT32 bench_window(UINT32 x, UINT32 y, UINT32 frame)
+{
+	if (y < BENCH_TITLE_HEIGHT)
+		return FreeRDPGetColor(BENCH_FORMAT, 0x00, 0x3C, 0x8C, 0xFF);
+
+	if ((((x / 6) + frame) ^ (y / 12)) & 1)
+		return FreeRDPGetColor(BENCH_FORMAT, 0x20, 0x20, 0x20, 0xFF);
+
+	return FreeRDPGetColor(BENCH_FORMAT, 0xF0, 0xF0, 0xF0, 0xFF);
+}
+
+static void bench_draw(benchPeerContext* context, const RFX_RECT* rect, UINT32 frame)
+{
+	UINT32 x, y;
+	const RFX_RECT* win = &context->windowRect;
+
+	for (y = rect->y; y < (UINT32)rect->y + rect->height; y++)
+	{
+		BYTE* line = &context->surface[y * context->stride];
+
+		for (x = rect->x; x < (UINT32)rect->x + rect->width; x++)
+		{
+			UINT32 color;
+
+			if ((x >= win->x) && (x < (UINT32)win->x + win->width) && (y >= win->y) &&
+			    (y < (UINT32)win->y + win->height))
+				color = bench_window(x - win->x, y - win->y, frame);
+			else
+				color = bench_background(x, y + context->scroll);
+
+			FreeRDPWriteColor(&line[x * FreeRDPGetBytesPerPixel(BENCH_FORMAT)], BENCH_FORMAT,
+			                  color);
+		}
+	}
+}
+
+static void bench_rect_union(RFX_RECT* dst, const RFX_RECT* a, const RFX_RECT* b)
+{
+	const UINT32 left = (a->x < b->x) ? a->x : b->x;
+	const UINT32 top = (a->y < b->y) ? a->y : b->y;
+	const UINT32 ra = (UINT32)a->x + a->width;
+	const UINT32 rb = (UINT32)b->x + b->width;
+	const UINT32 ba = (UINT32)a->y + a->height;
+	const UINT32 bb = (UINT32)b->y + b->height;
+
+	dst->x = (UINT16)left;
+	dst->y = (UINT16)top;
+	dst->width = (UINT16)(((ra > rb) ? ra : rb) - left);
+	dst->height = (UINT16)(((ba > bb) ? ba : bb) - top);
+}
+
+/**
+ * Advances the scripted workload by one frame and returns the dirty rectangle:
+ * the first frame paints the whole desktop, every BENCH_SCROLL_INTERVAL frame the desktop
+ * scrolls and in between a window is dragged across it.
+ */
+static void bench_script(benchPeerContext* context, UINT32 frame, RFX_RECT* dirty)
+{
+	const UINT32 width = context->session->width;
+	const UINT32 height = context->session->height;
+	RFX_RECT* win = &context->windowRect;
+
+	if ((frame == 0) || (frame % BENCH_SCROLL_INTERVAL == 0))
+	{
+		if (frame != 0)
+			context->scroll += BENCH_SCROLL_LINES;
+
+		dirty->x = 0;
+		dirty->y = 0;
+		dirty->width = (UINT16)width;
+		dirty->height = (UINT16)height;
+	}
+	else
+	{
+		const RFX_RECT old = *win;
+		const UINT32 rangeX = width - win->width;
+		const UINT32 rangeY = height - win->height;
+
+		win->x = (UINT16)((rangeX > 0) ? (frame * BENCH_WINDOW_STEP) % rangeX : 0);
+		win->y = (UINT16)((rangeY > 0) ? (frame * BENCH_WINDOW_STEP / 2) % rangeY : 0);
+		bench_rect_union(dirty, &old, win);
+	}
+
+	bench_draw(context, dirty, frame);
+}
+
+static BOOL bench_peer_send_frame(freerdp_peer* client)
+{
+	UINT64 start;
+	UINT32 frame;
+	RFX_RECT dirty = { 0 };
+	SURFACE_BITS_COMMAND cmd = { 0 };
+	SURFACE_FRAME_MARKER fm = { 0 };
+	benchPeerContext* context;
+	BENCH_SESSION* session;
+	rdpSettings* settings;
+	rdpUpdate* update;
+	wStream* s;
+
+	WINPR_ASSERT(client);
+	context = (benchPeerContext*)client->context;
+	WINPR_ASSERT(context);
+	session = context->session;
+	WINPR_ASSERT(session);
+	settings = client->context->settings;
+	WINPR_ASSERT(settings);
+	update = client->context->update;
+	WINPR_ASSERT(update);
+
+	frame = (UINT32)session->framesSent;
+	bench_script(context, frame, &dirty);
+
+	if (frame == BENCH_WARMUP_FRAMES)
+		session->bytesWarmup = freerdp_get_transport_sent(client->context, FALSE);
+
+	s = context->s;
+	Stream_SetPosition(s, 0);
+	start = winpr_GetTickCount64NS();
+	session->sent[frame] = start;
+
+	if (session->nsc)
+	{
+		const BYTE* src = &context->surface[dirty.y * context->stride +
+		                                    dirty.x * FreeRDPGetBytesPerPixel(BENCH_FORMAT)];
+
+		if (!nsc_compose_message(context->nsc, s, src, dirty.width, dirty.height,
+		                         context->stride))
+			return FALSE;
+
+		cmd.cmdType = CMDTYPE_SET_SURFACE_BITS;
+		cmd.bmp.codecID = (UINT16)freerdp_settings_get_uint32(settings, FreeRDP_NSCodecId);
+		cmd.destLeft = dirty.x;
+		cmd.destTop = dirty.y;
+		cmd.bmp.width = dirty.width;
+		cmd.bmp.height = dirty.height;
+	}
+	else
+	{
+		/* RemoteFX encodes the tiles of the dirty rectangle relative to the whole surface */
+		if (!rfx_compose_message(context->rfx, s, &dirty, 1, context->surface, session->width,
+		                         session->height, context->stride))
+			return FALSE;
+
+		cmd.cmdType = CMDTYPE_STREAM_SURFACE_BITS;
+		cmd.bmp.codecID = (UINT16)freerdp_settings_get_uint32(settings, FreeRDP_RemoteFxCodecId);
+		cmd.destLeft = 0;
+		cmd.destTop = 0;
+		cmd.bmp.width = (UINT16)session->width;
+		cmd.bmp.height = (UINT16)session->height;
+	}
+
+	metrics_stage_add(client->context->metrics, METRICS_STAGE_SURFACE_ENCODE, start);
+
+	cmd.destRight = cmd.destLeft + cmd.bmp.width;
+	cmd.destBottom = cmd.destTop + cmd.bmp.height;
+	cmd.bmp.bpp = 32;
+	cmd.bmp.bitmapDataLength = (UINT32)Stream_GetPosition(s);
+	cmd.bmp.bitmapData = Stream_Buffer(s);
+	if (frame >= BENCH_WARMUP_FRAMES)
+		session->surfaceBytes += cmd.bmp.bitmapDataLength;
+
+	fm.frameId = frame;
+	fm.frameAction = SURFACECMD_FRAMEACTION_BEGIN;
+	if (!update->SurfaceFrameMarker(update->context, &fm))
+		return FALSE;
+	if (!update->SurfaceBits(update->context, &cmd))
+		return FALSE;
+	fm.frameAction = SURFACECMD_FRAMEACTION_END;
+	if (!update->SurfaceFrameMarker(update->context, &fm))
+		return FALSE;
+
+	InterlockedIncrement(&session->framesSent);
+	return TRUE;
+}
+
+static BOOL bench_peer_context_new(freerdp_peer* client, rdpContext* ctx)
+{
+	benchPeerContext* context = (benchPeerContext*)ctx;
+
+	WINPR_ASSERT(client);
+	WINPR_ASSERT(context);
+
+	context->session = client->ContextExtra;
+
+	if (!(context->rfx = rfx_context_new(TRUE)))
+		return FALSE;
+
+	context->rfx->mode = RLGR3;
+	rfx_context_set_pixel_format(context->rfx, BENCH_FORMAT);
+
+	if (!(context->nsc = nsc_context_new()))
+		return FALSE;
+
+	if (!nsc_context_set_parameters(context->nsc, NSC_COLOR_FORMAT, BENCH_FORMAT))
+		return FALSE;
+
+	if (!(context->s = Stream_New(NULL, 65536)))
+		return FALSE;
+
+	return TRUE;
+}
+
+static void bench_peer_context_free(freerdp_peer* client, rdpContext* ctx)
+{
+	benchPeerContext* context = (benchPeerContext*)ctx;
+
+	WINPR_UNUSED(client);
+
+	if (context)
+	{
+		Stream_Free(context->s, TRUE);
+		winpr_aligned_free(context->surface);
+		rfx_context_free(context->rfx);
+		nsc_context_free(context->nsc);
+	}
+}
+
+static BOOL bench_peer_post_connect(freerdp_peer* client)
+{
+	size_t size;
+	benchPeerContext* context;
+	BENCH_SESSION* session;
+	rdpSettings* settings;
+
+	WINPR_ASSERT(client);
+	context = (benchPeerContext*)client->context;
+	WINPR_ASSERT(context);
+	session = context->session;
+	WINPR_ASSERT(session);
+	settings = client->context->settings;
+	WINPR_ASSERT(settings);
+
+	if (session->nsc ? !freerdp_settings_get_bool(settings, FreeRDP_NSCodec)
+	                 : !freerdp_settings_get_bool(settings, FreeRDP_RemoteFxCodec))
+	{
+		WLog_ERR(TAG, "client did not negotiate %s", session->nsc ? "NSCodec" : "RemoteFX");
+		return FALSE;
+	}
+
+	if ((freerdp_settings_get_uint32(settings, FreeRDP_DesktopWidth) != session->width) ||
+	    (freerdp_settings_get_uint32(settings, FreeRDP_DesktopHeight) != session->height))
+	{
+		WLog_ERR(TAG, "client requested an unexpected desktop size");
+		return FALSE;
+	}
+
+	if (!rfx_context_reset(context->rfx, session->width, session->height))
+		return FALSE;
+
+	context->stride = session->width * FreeRDPGetBytesPerPixel(BENCH_FORMAT);
+	size = 1ull * context->stride * session->height;
+	if (!(context->surface = winpr_aligned_malloc(size, 16)))
+		return FALSE;
+
+	context->windowRect.width = (UINT16)(session->width / 3);
+	context->windowRect.height = (UINT16)(session->height / 3);
+	return TRUE;
+}
+
+static BOOL bench_peer_activate(freerdp_peer* client)
+{
+	benchPeerContext* context;
+
+	WINPR_ASSERT(client);
+	context = (benchPeerContext*)client->context;
+	WINPR_ASSERT(context);
+
+	context->activated = TRUE;
+	return TRUE;
+}
+
+static BOOL bench_peer_setup(freerdp_peer* client, BENCH_SESSION* session)
+{
+	rdpSettings* settings;
+
+	client->ContextSize = sizeof(benchPeerContext);
+	client->ContextNew = bench_peer_context_new;
+	client->ContextFree = bench_peer_context_free;
+	client->ContextExtra = session;
+
+	if (!freerdp_peer_context_new(client))
+		return FALSE;
+
+	settings = client->context->settings;
+	WINPR_ASSERT(settings);
+
+	if (!freerdp_settings_set_string(settings, FreeRDP_CertificateFile,
+	                                 session->certificateFile) ||
+	    !freerdp_settings_set_string(settings, FreeRDP_PrivateKeyFile, session->privateKeyFile) ||
+	    !freerdp_settings_set_bool(settings, FreeRDP_RdpSecurity, FALSE) ||
+	    !freerdp_settings_set_bool(settings, FreeRDP_TlsSecurity, TRUE) ||
+	    !freerdp_settings_set_bool(settings, FreeRDP_NlaSecurity, FALSE) ||
+	    !freerdp_settings_set_bool(settings, FreeRDP_RemoteFxCodec, !session->nsc) ||
+	    !freerdp_settings_set_bool(settings, FreeRDP_NSCodec, session->nsc) ||
+	    !freerdp_settings_set_uint32(settings, FreeRDP_ColorDepth, 32) ||
+	    !freerdp_settings_set_uint32(settings, FreeRDP_MultifragMaxRequestSize, 0xFFFFFF))
+		return FALSE;
+
+	if (session->compression->level != UINT32_MAX)
+	{
+		if (!freerdp_settings_set_bool(settings, FreeRDP_CompressionEnabled, TRUE) ||
+		    !freerdp_settings_set_uint32(settings, FreeRDP_CompressionLevel,
+		                                 session->compression->level))
+			return FALSE;
+	}
+
+	client->PostConnect = bench_peer_post_connect;
+	client->Activate = bench_peer_activate;
+
+	WINPR_ASSERT(client->Initialize);
+	return client->Initialize(client);
+}
+
+static DWORD WINAPI bench_peer_thread(LPVOID arg)
+{
+	HANDLE handles[32] = { 0 };
+	freerdp_peer* client = (freerdp_peer*)arg;
+	BENCH_SESSION* session;
+	benchPeerContext* context;
+
+	WINPR_ASSERT(client);
+	session = client->ContextExtra;
+	WINPR_ASSERT(session);
+
+	if (!bench_peer_setup(client, session))
+	{
+		session->failed = TRUE;
+		goto out;
+	}
+
+	context = (benchPeerContext*)client->context;
+
+	for (;;)
+	{
+		DWORD count, status;
+		DWORD timeout = INFINITE;
+		BOOL send = FALSE;
+
+		WINPR_ASSERT(client->GetEventHandles);
+		count = client->GetEventHandles(client, handles, ARRAYSIZE(handles) - 2);
+		if (count == 0)
+			break;
+
+		handles[count++] = session->frameDoneEvent;
+		handles[count++] = session->stopEvent;
+		ResetEvent(session->frameDoneEvent);
+
+		/* a window of frames in flight keeps the latency from measuring the queueing only */
+		if (context->activated && ((UINT32)session->framesSent < session->frames) &&
+		    ((UINT32)(session->framesSent - session->framesDone) < session->window))
+		{
+			send = TRUE;
+			timeout = 0;
+		}
+
+		status = WaitForMultipleObjects(count, handles, FALSE, timeout);
+		if (status == WAIT_FAILED)
+			break;
+
+		if (WaitForSingleObject(session->stopEvent, 0) == WAIT_OBJECT_0)
+			break;
+
+		WINPR_ASSERT(client->CheckFileDescriptor);
+		if (client->CheckFileDescriptor(client) != TRUE)
+			break;
+
+		if (send && !bench_peer_send_frame(client))
+		{
+			WLog_ERR(TAG, "failed to send frame %" PRId32, session->framesSent);
+			session->failed = TRUE;
+			break;
+		}
+	}
+
+	session->serverMetrics = *client->context->metrics;
+	session->bytesSent =
+	    freerdp_get_transport_sent(client->context, FALSE) - session->bytesWarmup;
+
+	WINPR_ASSERT(client->Disconnect);
+	client->Disconnect(client);
+out:
+	freerdp_peer_context_free(client);
+	freerdp_peer_free(client);
+	return 0;
+}
+
+static BOOL bench_peer_accepted(freerdp_listener* instance, freerdp_peer* client)
+{
+	BENCH_SESSION* session;
+
+	WINPR_ASSERT(instance);
+	WINPR_ASSERT(client);
+
+	session = instance->info;
+	WINPR_ASSERT(session);
+
+	/* a single session is benchmarked, further connections are refused */
+	if (session->peerThread)
+		return FALSE;
+
+	client->ContextExtra = session;
+
+	if (!(session->peerThread = CreateThread(NULL, 0, bench_peer_thread, client, 0, NULL)))
+		return FALSE;
+
+	return TRUE;
+}
+
+static DWORD WINAPI bench_listener_thread(LPVOID arg)
+{
+	HANDLE handles[32] = { 0 };
+	freerdp_listener* instance = (freerdp_listener*)arg;
+	BENCH_SESSION* session;
+
+	WINPR_ASSERT(instance);
+	session = instance->info;
+	WINPR_ASSERT(session);
+
+	for (;;)
+	{
+		DWORD count, status;
+
+		WINPR_ASSERT(instance->GetEventHandles);
+		count = instance->GetEventHandles(instance, handles, ARRAYSIZE(handles) - 1);
+		if (count == 0)
+			break;
+
+		handles[count++] = session->stopEvent;
+		status = WaitForMultipleObjects(count, handles, FALSE, INFINITE);
+
+		if ((status == WAIT_FAILED) ||
+		    (WaitForSingleObject(session->stopEvent, 0) == WAIT_OBJECT_0))
+			break;
+
+		WINPR_ASSERT(instance->CheckFileDescriptor);
+		if (instance->CheckFileDescriptor(instance) != TRUE)
+			break;
+	}
+
+	WINPR_ASSERT(instance->Close);
+	instance->Close(instance);
+	return 0;
+}
+
+static BOOL bench_client_surface_frame_marker(rdpContext* context,
+                                              const SURFACE_FRAME_MARKER* surfaceFrameMarker)
+{
+	benchClientContext* ctx = (benchClientContext*)context;
+	BENCH_SESSION* session;
+
+	WINPR_ASSERT(ctx);
+	WINPR_ASSERT(surfaceFrameMarker);
+	session = ctx->session;
+	WINPR_ASSERT(session);
+
+	if (!IFCALLRESULT(TRUE, ctx->SurfaceFrameMarker, context, surfaceFrameMarker))
+		return FALSE;
+
+	if ((surfaceFrameMarker->frameAction == SURFACECMD_FRAMEACTION_END) &&
+	    (surfaceFrameMarker->frameId < session->frames))
+	{
+		session->done[surfaceFrameMarker->frameId] = winpr_GetTickCount64NS();
+		InterlockedIncrement(&session->framesDone);
+		SetEvent(session->frameDoneEvent);
+	}
+
+	return TRUE;
+}
+
+static BOOL bench_client_begin_paint(rdpContext* context)
+{
+	rdpGdi* gdi;
+
+	WINPR_ASSERT(context);
+	gdi = context->gdi;
+	WINPR_ASSERT(gdi);
+	WINPR_ASSERT(gdi->primary);
+	WINPR_ASSERT(gdi->primary->hdc);
+	WINPR_ASSERT(gdi->primary->hdc->hwnd);
+	WINPR_ASSERT(gdi->primary->hdc->hwnd->invalid);
+
+	gdi->primary->hdc->hwnd->invalid->null = TRUE;
+	return TRUE;
+}
+
+/* Headless, the composed frame stays in the GDI framebuffer */
+static BOOL bench_client_end_paint(rdpContext* context)
+{
+	WINPR_UNUSED(context);
+	return TRUE;
+}
+
+static BOOL bench_client_post_connect(freerdp* instance)
+{
+	benchClientContext* context;
+	rdpUpdate* update;
+
+	WINPR_ASSERT(instance);
+
+	if (!gdi_init(instance, BENCH_FORMAT))
+		return FALSE;
+
+	context = (benchClientContext*)instance->context;
+	WINPR_ASSERT(context);
+	update = instance->context->update;
+	WINPR_ASSERT(update);
+
+	update->BeginPaint = bench_client_begin_paint;
+	update->EndPaint = bench_client_end_paint;
+	context->SurfaceFrameMarker = update->SurfaceFrameMarker;
+	update->SurfaceFrameMarker = bench_client_surface_frame_marker;
+	return TRUE;
+}
+
+static void bench_client_post_disconnect(freerdp* instance)
+{
+	gdi_free(instance);
+}
+
+static BOOL bench_client_settings(rdpSettings* settings, const BENCH_SESSION* session)
+{
+	if (!freerdp_settings_set_string(settings, FreeRDP_ServerHostname, "127.0.0.1") ||
+	    !freerdp_settings_set_uint32(settings, FreeRDP_ServerPort, session->port) ||
+	    !freerdp_settings_set_uint32(settings, FreeRDP_DesktopWidth, session->width) ||
+	    !freerdp_settings_set_uint32(settings, FreeRDP_DesktopHeight, session->height) ||
+	    !freerdp_settings_set_uint32(settings, FreeRDP_ColorDepth, 32) ||
+	    !freerdp_settings_set_bool(settings, FreeRDP_RdpSecurity, FALSE) ||
+	    !freerdp_settings_set_bool(settings, FreeRDP_TlsSecurity, TRUE) ||
+	    !freerdp_settings_set_bool(settings, FreeRDP_NlaSecurity, FALSE) ||
+	    !freerdp_settings_set_bool(settings, FreeRDP_ExtSecurity, FALSE) ||
+	    !freerdp_settings_set_bool(settings, FreeRDP_IgnoreCertificate, TRUE) ||
+	    !freerdp_settings_set_bool(settings, FreeRDP_SoftwareGdi, TRUE) ||
+	    !freerdp_settings_set_bool(settings, FreeRDP_SurfaceCommandsEnabled, TRUE) ||
+	    !freerdp_settings_set_bool(settings, FreeRDP_SurfaceFrameMarkerEnabled, TRUE) ||
+	    !freerdp_settings_set_bool(settings, FreeRDP_RemoteFxCodec, !session->nsc) ||
+	    !freerdp_settings_set_bool(settings, FreeRDP_NSCodec, session->nsc) ||
+	    !freerdp_settings_set_uint32(settings, FreeRDP_MultifragMaxRequestSize, 0xFFFFFF) ||
+	    !freerdp_settings_set_bool(settings, FreeRDP_CompressionEnabled,
+	                               session->compression->level != UINT32_MAX))
+		return FALSE;
+
+	if (session->compression->level != UINT32_MAX)
+		return freerdp_settings_set_uint32(settings, FreeRDP_CompressionLevel,
+		                                   session->compression->level);
+
+	return TRUE;
+}
+
+/* Runs the client on the calling thread until all frames arrived or the session failed */
+static BOOL bench_client_run(BENCH_SESSION* session)
+{
+	BOOL rc = FALSE;
+	UINT64 deadline;
+	freerdp* instance;
+	rdpContext* context;
+
+	if (!(instance = freerdp_new()))
+		return FALSE;
+
+	instance->ContextSize = sizeof(benchClientContext);
+	instance->PostConnect = bench_client_post_connect;
+	instance->PostDisconnect = bench_client_post_disconnect;
+
+	if (!freerdp_context_new(instance))
+	{
+		freerdp_free(instance);
+		return FALSE;
+	}
+
+	context = instance->context;
+	((benchClientContext*)context)->session = session;
+
+	if (!bench_client_settings(context->settings, session))
+		goto out;
+
+	if (!freerdp_connect(instance))
+	{
+		WLog_ERR(TAG, "connection failed: %s",
+		         freerdp_get_last_error_string(freerdp_get_last_error(context)));
+		goto out;
+	}
+
+	deadline = GetTickCount64() + BENCH_TIMEOUT_MS;
+
+	while ((UINT32)session->framesDone < session->frames)
+	{
+		HANDLE handles[64] = { 0 };
+		DWORD count = freerdp_get_event_handles(context, handles, ARRAYSIZE(handles));
+
+		if ((count == 0) || session->failed || (GetTickCount64() > deadline))
+			break;
+
+		if (WaitForMultipleObjects(count, handles, FALSE, 100) == WAIT_FAILED)
+			break;
+
+		if (!freerdp_check_event_handles(context))
+			break;
+	}
+
+	rc = ((UINT32)session->framesDone == session->frames);
+	if (!rc)
+		WLog_ERR(TAG, "received %" PRId32 " of %" PRIu32 " frames", session->framesDone,
+		         session->frames);
+
+	session->clientMetrics = *context->metrics;
+	freerdp_disconnect(instance);
+out:
+	freerdp_context_free(instance);
+	freerdp_free(instance);
+	return rc;
+}
+
+static BOOL bench_create_certificate(BENCH_SESSION* session)
+{
+	BOOL rc = FALSE;
+	char name[64] = { 0 };
+	char* makecert_argv[] = { "makecert", "-rdp", "-live", "-silent", "-y", "1" };
+	MAKECERT_CONTEXT* makecert;
+	char* temp = GetKnownPath(KNOWN_PATH_TEMP);
+
+	if (!temp)
+		return FALSE;
+
+	_snprintf(name, sizeof(name), "freerdp-session-bench-%" PRIu32, GetCurrentProcessId());
+	session->tempPath = GetCombinedPath(temp, name);
+	free(temp);
+
+	if (!session->tempPath || !winpr_PathMakePath(session->tempPath, NULL))
+		return FALSE;
+
+	session->certificateFile = GetCombinedPath(session->tempPath, "bench.crt");
+	session->privateKeyFile = GetCombinedPath(session->tempPath, "bench.key");
+	if (!session->certificateFile || !session->privateKeyFile)
+		return FALSE;
+
+	if (!(makecert = makecert_context_new()))
+		return FALSE;
+
+	if ((makecert_context_process(makecert, ARRAYSIZE(makecert_argv), makecert_argv) < 0) ||
+	    (makecert_context_set_output_file_name(makecert, "bench") != 1) ||
+	    (makecert_context_output_certificate_file(makecert, session->tempPath) != 1) ||
+	    (makecert_context_output_private_key_file(makecert, session->tempPath) != 1))
+		goto out;
+
+	rc = TRUE;
+out:
+	makecert_context_free(makecert);
+	return rc;
+}
+
+static void bench_remove_certificate(BENCH_SESSION* session)
+{
+	if (session->certificateFile)
+		winpr_DeleteFile(session->certificateFile);
+	if (session->privateKeyFile)
+		winpr_DeleteFile(session->privateKeyFile);
+	if (session->tempPath)
+		winpr_RemoveDirectory(session->tempPath);
+
+	free(session->certificateFile);
+	free(session->privateKeyFile);
+	free(session->tempPath);
+}
+
+/* Binds to an unused loopback port, trying a range derived from the process id */
+static BOOL bench_listener_open(freerdp_listener* instance, BENCH_SESSION* session)
+{
+	UINT32 x;
+
+	if (session->port != 0)
+		return instance->Open(instance, "127.0.0.1", session->port);
+
+	for (x = 0; x < 64; x++)
+	{
+		const UINT16 port = (UINT16)(20000 + (GetCurrentProcessId() * 64 + x) % 40000);
+
+		if (instance->Open(instance, "127.0.0.1", port))
+		{
+			session->port = port;
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+static int bench_sample_compare(const void* a, const void* b)
+{
+	const UINT64 sa = *(const UINT64*)a;
+	const UINT64 sb = *(const UINT64*)b;
+	return (sa > sb) - (sa < sb);
+}
+
+static void bench_write_metrics(FILE* fp, const char* name, const rdpMetrics* metrics)
+{
+	size_t x;
+	BOOL first = TRUE;
+
+	fprintf(fp, "  \"%s\": { \"compressionRatio\": %.3f, \"stages\": {", name,
+	        metrics->TotalCompressionRatio);
+
+	for (x = 0; x < METRICS_STAGE_COUNT; x++)
+	{
+		const rdpMetricsStageTime* stage = &metrics->Stages[x];
+
+		if (stage->Count == 0)
+			continue;
+
+		fprintf(fp, "%s\n    \"%s\": { \"count\": %" PRIu64 ", \"totalus\": %.3f, ",
+		        first ? "" : ",", metrics_stage_name((rdpMetricsStage)x), stage->Count,
+		        stage->TotalNS / 1000.0);
+		fprintf(fp, "\"meanus\": %.3f, \"maxus\": %.3f }",
+		        stage->TotalNS / 1000.0 / (double)stage->Count, stage->MaxNS / 1000.0);
+		first = FALSE;
+	}
+
+	fprintf(fp, "\n  } }");
+}
+
+/* Percentiles are taken with the nearest rank method, like freerdp-codec-bench does */
+static BOOL bench_write_report(FILE* fp, BENCH_SESSION* session)
+{
+	UINT32 x;
+	UINT64 total = 0;
+	double seconds;
+	const UINT32 count = session->frames - BENCH_WARMUP_FRAMES;
+	UINT64* latency = calloc(count, sizeof(UINT64));
+
+	if (!latency)
+		return FALSE;
+
+	for (x = 0; x < count; x++)
+	{
+		const UINT32 frame = x + BENCH_WARMUP_FRAMES;
+		latency[x] = session->done[frame] - session->sent[frame];
+		total += latency[x];
+	}
+
+	qsort(latency, count, sizeof(UINT64), bench_sample_compare);
+	seconds = (session->done[session->frames - 1] - session->sent[BENCH_WARMUP_FRAMES]) /
+	          1000000000.0;
+
+	fprintf(fp, "{\n  \"version\": \"%s\",\n", FREERDP_VERSION_FULL);
+	fprintf(fp, "  \"codec\": \"%s\", \"compression\": \"%s\", ", session->nsc ? "nsc" : "rfx",
+	        session->compression->name);
+	fprintf(fp, "\"width\": %" PRIu32 ", \"height\": %" PRIu32 ", ", session->width,
+	        session->height);
+	fprintf(fp, "\"frames\": %" PRIu32 ", \"warmup\": %d, \"window\": %" PRIu32 ",\n",
+	        session->frames, BENCH_WARMUP_FRAMES, session->window);
+	fprintf(fp, "  \"seconds\": %.6f, \"fps\": %.3f, ", seconds,
+	        (seconds > 0.0) ? count / seconds : 0.0);
+	fprintf(fp, "\"bytesSent\": %" PRIu64 ", \"surfaceBytes\": %" PRIu64 ", ",
+	        session->bytesSent, session->surfaceBytes);
+	fprintf(fp, "\"MBps\": %.3f,\n",
+	        (seconds > 0.0) ? session->bytesSent / seconds / 1000000.0 : 0.0);
+	fprintf(fp, "  \"latency\": { \"meanus\": %.3f, \"p50us\": %.3f, \"p90us\": %.3f, ",
+	        total / 1000.0 / count, latency[(count * 50 + 99) / 100 - 1] / 1000.0,
+	        latency[(count * 90 + 99) / 100 - 1] / 1000.0);
+	fprintf(fp, "\"p99us\": %.3f, \"maxus\": %.3f },\n",
+	        latency[(count * 99 + 99) / 100 - 1] / 1000.0, latency[count - 1] / 1000.0);
+	bench_write_metrics(fp, "server", &session->serverMetrics);
+	fprintf(fp, ",\n");
+	bench_write_metrics(fp, "client", &session->clientMetrics);
+	fprintf(fp, "\n}\n");
+
+	free(latency);
+	return TRUE;
+}
+
+static WINPR_NORETURN(void usage_and_exit(void))
+{
+	size_t x;
+
+	printf("freerdp-session-bench: loopback server to client session benchmark\n");
+	printf("Usage: freerdp-session-bench [-n <frames>] [-s <width>x<height>] [-c <rfx|nsc>] "
+	       "[-z <compression>] [-w <frames in flight>] [-p <port>] [-o <file.json>]\n");
+	printf("Compression: ");
+	for (x = 0; x < ARRAYSIZE(bench_compressions); x++)
+		printf("%s%s", (x > 0) ? ", " : "", bench_compressions[x].name);
+	printf("\nDefaults: 300 frames of 1920x1080, rfx, rdp61, 2 frames in flight.\n");
+	exit(1);
+}
+
+int main(int argc, char* argv[])
+{
+	int rc = 1;
+	int index = 1;
+	size_t x;
+	unsigned long value;
+	const char* output = NULL;
+	FILE* fp = stdout;
+	freerdp_listener* listener = NULL;
+	HANDLE listenerThread = NULL;
+	BENCH_SESSION session = { 0 };
+
+	session.width = 1920;
+	session.height = 1080;
+	session.frames = 300;
+	session.window = 2;
+	session.compression = &bench_compressions[4];
+	errno = 0;
+
+	while (index < argc)
+	{
+		const char* option = argv[index++];
+
+		if ((strlen(option) != 2) || (option[0] != '-') || !strchr("nscwzpo", option[1]))
+			usage_and_exit();
+
+		if (index == argc)
+		{
+			printf("missing argument for %s\n\n", option);
+			usage_and_exit();
+		}
+
+		switch (option[1])
+		{
+			case 's':
+				if ((sscanf(argv[index], "%" SCNu32 "x%" SCNu32, &session.width,
+				            &session.height) != 2) ||
+				    (session.width < 64) || (session.height < 64) ||
+				    (session.width > 8192) || (session.height > 8192))
+				{
+					printf("invalid desktop size %s\n\n", argv[index]);
+					usage_and_exit();
+				}
+				break;
+
+			case 'c':
+				if (strcmp(argv[index], "nsc") == 0)
+					session.nsc = TRUE;
+				else if (strcmp(argv[index], "rfx") != 0)
+				{
+					printf("invalid codec %s\n\n", argv[index]);
+					usage_and_exit();
+				}
+				break;
+
+			case 'z':
+				session.compression = NULL;
+				for (x = 0; x < ARRAYSIZE(bench_compressions); x++)
+				{
+					if (strcmp(argv[index], bench_compressions[x].name) == 0)
+						session.compression = &bench_compressions[x];
+				}
+				if (!session.compression)
+				{
+					printf("invalid compression %s\n\n", argv[index]);
+					usage_and_exit();
+				}
+				break;
+
+			case 'o':
+				output = argv[index];
+				break;
+
+			default:
+				value = strtoul(argv[index], NULL, 0);
+				if ((value == 0) || (value > 100000) || (errno != 0) ||
+				    ((option[1] == 'p') && (value > UINT16_MAX)))
+				{
+					printf("invalid value %s for %s\n\n", argv[index], option);
+					usage_and_exit();
+				}
+
+				if (option[1] == 'n')
+				{
+					if (value <= BENCH_WARMUP_FRAMES)
+					{
+						printf("at least %d frames are required\n\n", BENCH_WARMUP_FRAMES + 1);
+						usage_and_exit();
+					}
+
+					session.frames = (UINT32)value;
+				}
+				else if (option[1] == 'w')
+					session.window = (UINT32)value;
+				else
+					session.port = (UINT16)value;
+				break;
+		}
+
+		index++;
+	}
+
+	session.sent = calloc(session.frames, sizeof(UINT64));
+	session.done = calloc(session.frames, sizeof(UINT64));
+	session.frameDoneEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+	session.stopEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+	if (!session.sent || !session.done || !session.frameDoneEvent || !session.stopEvent)
+		goto fail;
+
+	if (!bench_create_certificate(&session))
+	{
+		WLog_ERR(TAG, "failed to create the server certificate");
+		goto fail;
+	}
+
+	if (!(listener = freerdp_listener_new()))
+		goto fail;
+
+	listener->info = &session;
+	listener->PeerAccepted = bench_peer_accepted;
+
+	if (!bench_listener_open(listener, &session))
+	{
+		WLog_ERR(TAG, "failed to listen on 127.0.0.1");
+		goto fail;
+	}
+
+	if (!(listenerThread = CreateThread(NULL, 0, bench_listener_thread, listener, 0, NULL)))
+		goto fail;
+
+	if (!bench_client_run(&session))
+		goto fail;
+
+	/* the peer thread stores the server metrics once it noticed the disconnect */
+	if (session.peerThread)
+		WaitForSingleObject(session.peerThread, INFINITE);
+
+	if (session.failed)
+		goto fail;
+
+	if (output)
+	{
+		fp = winpr_fopen(output, "w");
+		if (!fp)
+		{
+			WLog_ERR(TAG, "failed to open %s", output);
+			goto fail;
+		}
+	}
+
+	if (bench_write_report(fp, &session))
+		rc = 0;
+
+fail:
+	if (fp && (fp != stdout))
+		fclose(fp);
+
+	if (session.stopEvent)
+		SetEvent(session.stopEvent);
+
+	if (session.peerThread)
+	{
+		WaitForSingleObject(session.peerThread, INFINITE);
+		CloseHandle(session.peerThread);
+	}
+
+	if (listenerThread)
+	{
+		WaitForSingleObject(listenerThread, INFINITE);
+		CloseHandle(listenerThread);
+	}
+
+	freerdp_listener_free(listener);
+	bench_remove_certificate(&session);
+	CloseHandle(session.frameDoneEvent);
+	CloseHandle(session.stopEvent);
+	free(session.sent);
+	free(session.done);
+	return rc;
+}
@@ -31,6 +31,7 @@
 #include <winpr/crt.h>
 #include <winpr/crypto.h>
 #include <winpr/ssl.h>
+#include <winpr/sysinfo.h>
 
 #include <freerdp/log.h>
 #include <freerdp/error.h>
@@ -906,104 +907,114 @@ end:
 	return ret;
 }
 
-BOOL rdp_client_connect_mcs_channel_join_confirm(rdpRdp* rdp, wStream* s)
+static BOOL rdp_client_connect_mcs_channels_joined(rdpRdp* rdp)
+{
+	if (!rdp_client_establish_keys(rdp))
+		return FALSE;
+
+	if (!rdp_send_client_info(rdp))
+		return FALSE;
+
+	rdp_client_transition_to_state(rdp, CONNECTION_STATE_LICENSING);
+	return TRUE;
+}
+
+BOOL rdp_client_connect_mcs_attach_user_confirm(rdpRdp* rdp, wStream* s)
 {
 	UINT32 i;
-	UINT16 channelId;
-	BOOL allJoined = TRUE;
 	rdpMcs* mcs = rdp->mcs;
 
-	if (!mcs_recv_channel_join_confirm(mcs, s, &channelId))
+	if (!mcs_recv_attach_user_confirm(mcs, s))
 		return FALSE;
 
-	if (!mcs->userChannelJoined)
+	if (mcs->skipChannelJoin)
 	{
-		if (channelId != mcs->userId)
-			return FALSE;
-
+		WLog_DBG(TAG, "skipping MCS channel join");
 		mcs->userChannelJoined = TRUE;
+		mcs->globalChannelJoined = TRUE;
+		mcs->messageChannelJoined = TRUE;
 
-		if (!mcs_send_channel_join_request(mcs, MCS_GLOBAL_CHANNEL_ID))
-			return FALSE;
+		for (i = 0; i < mcs->channelCount; i++)
+			mcs->channels[i].joined = TRUE;
+
+		rdp_client_transition_to_state(rdp, CONNECTION_STATE_MCS_CHANNEL_JOIN);
+		return rdp_client_connect_mcs_channels_joined(rdp);
 	}
-	else if (!mcs->globalChannelJoined)
-	{
-		if (channelId != MCS_GLOBAL_CHANNEL_ID)
-			return FALSE;
 
-		mcs->globalChannelJoined = TRUE;
+	/* Send all join requests at once instead of one per confirm, the confirms are matched by
+	 * channel id in rdp_client_connect_mcs_channel_join_confirm. */
+	if (!mcs_send_channel_join_request(mcs, mcs->userId))
+		return FALSE;
 
-		if (mcs->messageChannelId != 0)
-		{
-			if (!mcs_send_channel_join_request(mcs, mcs->messageChannelId))
-				return FALSE;
+	if (!mcs_send_channel_join_request(mcs, MCS_GLOBAL_CHANNEL_ID))
+		return FALSE;
 
-			allJoined = FALSE;
-		}
-		else
-		{
-			if (mcs->channelCount > 0)
-			{
-				const rdpMcsChannel* cur = &mcs->channels[0];
-				if (!mcs_send_channel_join_request(mcs, cur->ChannelId))
-					return FALSE;
+	if ((mcs->messageChannelId != 0) &&
+	    !mcs_send_channel_join_request(mcs, mcs->messageChannelId))
+		return FALSE;
 
-				allJoined = FALSE;
-			}
-		}
-	}
-	else if ((mcs->messageChannelId != 0) && !mcs->messageChannelJoined)
+	for (i = 0; i < mcs->channelCount; i++)
 	{
-		if (channelId != mcs->messageChannelId)
+		if (!mcs_send_channel_join_request(mcs, mcs->channels[i].ChannelId))
 			return FALSE;
+	}
 
-		mcs->messageChannelJoined = TRUE;
+	rdp_client_transition_to_state(rdp, CONNECTION_STATE_MCS_CHANNEL_JOIN);
+	return TRUE;
+}
 
-		if (mcs->channelCount > 0)
-		{
-			const rdpMcsChannel* cur = &mcs->channels[0];
-			if (!mcs_send_channel_join_request(mcs, cur->ChannelId))
-				return FALSE;
+BOOL rdp_client_connect_mcs_channel_join_confirm(rdpRdp* rdp, wStream* s)
+{
+	UINT32 i;
+	UINT16 channelId;
+	BOOL allJoined = TRUE;
+	BOOL found = FALSE;
+	rdpMcs* mcs = rdp->mcs;
 
-			allJoined = FALSE;
-		}
+	if (!mcs_recv_channel_join_confirm(mcs, s, &channelId))
+		return FALSE;
+
+	if (!mcs->userChannelJoined && (channelId == mcs->userId))
+	{
+		mcs->userChannelJoined = TRUE;
+		found = TRUE;
 	}
-	else
+	else if (!mcs->globalChannelJoined && (channelId == MCS_GLOBAL_CHANNEL_ID))
 	{
-		for (i = 0; i < mcs->channelCount; i++)
-		{
-			rdpMcsChannel* cur = &mcs->channels[i];
-			if (cur->joined)
-				continue;
+		mcs->globalChannelJoined = TRUE;
+		found = TRUE;
+	}
+	else if ((mcs->messageChannelId != 0) && !mcs->messageChannelJoined &&
+	         (channelId == mcs->messageChannelId))
+	{
+		mcs->messageChannelJoined = TRUE;
+		found = TRUE;
+	}
 
-			if (cur->ChannelId != channelId)
-				return FALSE;
+	for (i = 0; i < mcs->channelCount; i++)
+	{
+		rdpMcsChannel* cur = &mcs->channels[i];
 
+		if (!found && !cur->joined && (cur->ChannelId == channelId))
+		{
 			cur->joined = TRUE;
-			break;
+			found = TRUE;
 		}
 
-		if (i + 1 < mcs->channelCount)
-		{
-			const rdpMcsChannel* cur = &mcs->channels[i + 1];
-			if (!mcs_send_channel_join_request(mcs, cur->ChannelId))
-				return FALSE;
-
+		if (!cur->joined)
 			allJoined = FALSE;
-		}
 	}
 
-	if (mcs->userChannelJoined && mcs->globalChannelJoined && allJoined)
+	if (!found)
 	{
-		if (!rdp_client_establish_keys(rdp))
-			return FALSE;
-
-		if (!rdp_send_client_info(rdp))
-			return FALSE;
-
-		rdp_client_transition_to_state(rdp, CONNECTION_STATE_LICENSING);
+		WLog_ERR(TAG, "unexpected MCS channel join confirm for channel %" PRIu16 "", channelId);
+		return FALSE;
 	}
 
+	if (mcs->userChannelJoined && mcs->globalChannelJoined &&
+	    ((mcs->messageChannelId == 0) || mcs->messageChannelJoined) && allJoined)
+		return rdp_client_connect_mcs_channels_joined(rdp);
+
 	return TRUE;
 }
 
@@ -1358,6 +1369,24 @@ BOOL rdp_server_accept_mcs_attach_user_request(rdpRdp* rdp, wStream* s)
 		return FALSE;
 
 	rdp_server_transition_to_state(rdp, CONNECTION_STATE_MCS_ATTACH_USER);
+
+	if (rdp->mcs->skipChannelJoin)
+	{
+		UINT32 i;
+		rdpMcs* mcs = rdp->mcs;
+
+		/* the client does not send channel join requests, the next PDU is the security exchange
+		 * or the client info */
+		mcs->userChannelJoined = TRUE;
+		mcs->globalChannelJoined = TRUE;
+		mcs->messageChannelJoined = TRUE;
+
+		for (i = 0; i < mcs->channelCount; i++)
+			mcs->channels[i].joined = TRUE;
+
+		rdp_server_transition_to_state(rdp, CONNECTION_STATE_RDP_SECURITY_COMMENCEMENT);
+	}
+
 	return TRUE;
 }
 
@@ -1577,7 +1606,31 @@ CONNECTION_STATE rdp_get_state(const rdpRdp* rdp)
 
 BOOL rdp_set_state(rdpRdp* rdp, CONNECTION_STATE state)
 {
+	const UINT64 now = GetTickCount64();
+
 	WINPR_ASSERT(rdp);
+
+	/* report the time spent in every connection state, the connect is timed from leaving the
+	 * initial state up to the first activation */
+	if (state != rdp->state)
+	{
+		if (rdp->state == CONNECTION_STATE_INITIAL)
+			rdp->connectStartTime = now;
+		else
+			WLog_DBG(TAG, "%s took %" PRIu64 " ms", rdp_state_string(rdp->state),
+			         now - rdp->stateStartTime);
+
+		if ((state == CONNECTION_STATE_ACTIVE) && (rdp->connectStartTime != 0))
+		{
+			WLog_DBG(TAG, "connection established in %" PRIu64 " ms",
+			         now - rdp->connectStartTime);
+			rdp->connectStartTime = 0;
+		}
+		else if (state == CONNECTION_STATE_INITIAL)
+			rdp->connectStartTime = 0;
+	}
+
+	rdp->stateStartTime = now;
 	rdp->state = state;
 	return TRUE;
 }
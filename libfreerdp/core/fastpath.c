@@ -358,6 +358,12 @@ static int fastpath_recv_update(rdpFastPath* fastpath, BYTE updateCode, wStream*
 	          fastpath_update_to_string(updateCode), updateCode, Stream_GetRemainingLength(s));
 #endif
 
+	if (update->RawUpdate)
+	{
+		rc = update->RawUpdate(context, updateCode, s);
+		goto out;
+	}
+
 	defaultReturn = freerdp_settings_get_bool(context->settings, FreeRDP_DeactivateClientDecoding);
 	switch (updateCode)
 	{
@@ -463,6 +469,7 @@ static int fastpath_recv_update(rdpFastPath* fastpath, BYTE updateCode, wStream*
 			break;
 	}
 
+out:
 	Stream_SetPosition(s, 0);
 	if (!rc)
 	{
@@ -315,6 +315,7 @@ BOOL freerdp_check_fds(freerdp* instance)
 DWORD freerdp_get_event_handles(rdpContext* context, HANDLE* events, DWORD count)
 {
 	DWORD nCount = 0;
+	HANDLE batch;
 
 	WINPR_ASSERT(context);
 	WINPR_ASSERT(context->rdp);
@@ -334,6 +335,17 @@ DWORD freerdp_get_event_handles(rdpContext* context, HANDLE* events, DWORD count
 	else
 		return 0;
 
+	/* Latency cap for batched fastpath input, only present if batching is enabled */
+	batch = input_get_batch_event_handle(context->input);
+
+	if (batch)
+	{
+		if (nCount >= count)
+			return 0;
+
+		events[nCount++] = batch;
+	}
+
 	return nCount;
 }
 
@@ -353,6 +365,16 @@ BOOL freerdp_check_event_handles(rdpContext* context)
 		return FALSE;
 	}
 
+	status = input_check_batch(context->input);
+
+	if (!status)
+	{
+		if (freerdp_get_last_error(context) == FREERDP_ERROR_SUCCESS)
+			WLog_ERR(TAG, "input_check_batch() failed - %" PRIi32 "", status);
+
+		return FALSE;
+	}
+
 	status = freerdp_channels_check_fds(context->channels, context->instance);
 
 	if (!status)
@@ -711,6 +733,7 @@ BOOL freerdp_context_new_ex(freerdp* instance, rdpSettings* settings)
 	context->update = rdp->update;
 	context->settings = rdp->settings;
 	context->autodetect = rdp->autodetect;
+	context->multitransport = rdp->multitransport;
 
 	if (!(context->errorDescription = calloc(1, 500)))
 	{
@@ -790,10 +813,11 @@ void freerdp_context_free(freerdp* instance)
 	stream_dump_free(ctx->dump);
 	ctx->dump = NULL;
 
-	ctx->input = NULL;      /* owned by rdpRdp */
-	ctx->update = NULL;     /* owned by rdpRdp */
-	ctx->settings = NULL;   /* owned by rdpRdp */
-	ctx->autodetect = NULL; /* owned by rdpRdp */
+	ctx->input = NULL;          /* owned by rdpRdp */
+	ctx->update = NULL;         /* owned by rdpRdp */
+	ctx->settings = NULL;       /* owned by rdpRdp */
+	ctx->autodetect = NULL;     /* owned by rdpRdp */
+	ctx->multitransport = NULL; /* owned by rdpRdp */
 
 	free(ctx);
 	instance->context = NULL;
@@ -1036,6 +1060,13 @@ ULONG freerdp_get_transport_sent(rdpContext* context, BOOL resetCount)
 	return transport_get_bytes_sent(context->rdp->transport, resetCount);
 }
 
+wStream* freerdp_get_received_stream(rdpContext* context, const BYTE* data)
+{
+	WINPR_ASSERT(context);
+	WINPR_ASSERT(context->rdp);
+	return transport_reference_received(context->rdp->transport, data);
+}
+
 BOOL freerdp_nla_impersonate(rdpContext* context)
 {
 	rdpNla* nla;
@@ -29,6 +29,7 @@
 
 #include <freerdp/log.h>
 #include <freerdp/error.h>
+#include <freerdp/primitives.h>
 #include <freerdp/utils/ringbuffer.h>
 
 #include "rdg.h"
@@ -104,6 +105,14 @@
 #define HTTP_CAPABILITY_UDP_TRANSPORT 0x20
 
 #define WEBSOCKET_MASK_BIT 0x80
+
+/* Read ahead buffer for websocket frames, avoids one TLS read per header byte. */
+#define WEBSOCKET_READ_AHEAD_SIZE 0x10000
+/* Reads at least this large go directly to the TLS BIO if nothing is buffered. */
+#define WEBSOCKET_READ_BYPASS_SIZE 0x1000
+/* Room in front of the data packet payload for the websocket and RDG headers.
+ * Keeps the payload 16 byte aligned for the masking primitive. */
+#define WEBSOCKET_SEND_HEADROOM 32
 #define WEBSOCKET_FIN_BIT 0x80
 
 typedef enum
@@ -137,6 +146,7 @@ typedef struct
 	BYTE lengthAndMaskPosition;
 	WEBSOCKET_STATE state;
 	wStream* responseStreamBuffer;
+	wStream* readBuffer;
 } rdg_http_websocket_context;
 
 typedef enum
@@ -176,6 +186,7 @@ struct rdp_rdg
 	rdpNtlm* ntlm;
 	HttpContext* http;
 	CRITICAL_SECTION writeSection;
+	wStream* sendBuffer; /* websocket data packets, protected by writeSection */
 
 	UUID guid;
 
@@ -372,6 +383,44 @@ static BOOL rdg_write_chunked(BIO* bio, wStream* sPacket)
 	return TRUE;
 }
 
+static void rdg_websocket_mask(BYTE* dst, const BYTE* src, size_t len, const BYTE maskingKey[4])
+{
+	size_t pos = 0;
+
+	/* The 32 bit primitive needs both buffers UINT32 aligned. Mask the head byte wise until
+	 * dst is aligned, src then is as well if both share the same misalignment. */
+	if (((ULONG_PTR)dst & 3) == ((ULONG_PTR)src & 3))
+	{
+		size_t count;
+
+		for (; (pos < len) && (((ULONG_PTR)&dst[pos] & 3) != 0); pos++)
+			dst[pos] = src[pos] ^ maskingKey[pos % 4];
+
+		count = (len - pos) / 4;
+
+		if (count > 0)
+		{
+			size_t x;
+			UINT32 key;
+			BYTE shiftedKey[4];
+			const primitives_t* prims = primitives_get();
+			WINPR_ASSERT(prims);
+			WINPR_ASSERT(count <= INT32_MAX);
+
+			/* the key is used in memory order, so this works independent of endianness */
+			for (x = 0; x < sizeof(shiftedKey); x++)
+				shiftedKey[x] = maskingKey[(pos + x) % 4];
+			memcpy(&key, shiftedKey, sizeof(key));
+
+			prims->xorC_32u((const UINT32*)&src[pos], key, (UINT32*)&dst[pos], (INT32)count);
+			pos += count * 4;
+		}
+	}
+
+	for (; pos < len; pos++)
+		dst[pos] = src[pos] ^ maskingKey[pos % 4];
+}
+
 static BOOL rdg_write_websocket(BIO* bio, wStream* sPacket, WEBSOCKET_OPCODE opcode)
 {
 	size_t len;
@@ -379,9 +428,7 @@ static BOOL rdg_write_websocket(BIO* bio, wStream* sPacket, WEBSOCKET_OPCODE opc
 	int status;
 	wStream* sWS;
 
-	uint32_t maskingKey;
-
-	size_t streamPos;
+	BYTE maskingKey[4];
 
 	len = Stream_Length(sPacket);
 	Stream_SetPosition(sPacket, 0);
@@ -400,7 +447,7 @@ static BOOL rdg_write_websocket(BIO* bio, wStream* sPacket, WEBSOCKET_OPCODE opc
 	if (!sWS)
 		return FALSE;
 
-	winpr_RAND((BYTE*)&maskingKey, 4);
+	winpr_RAND(maskingKey, sizeof(maskingKey));
 
 	Stream_Write_UINT8(sWS, WEBSOCKET_FIN_BIT | opcode);
 	if (len < 126)
@@ -416,25 +463,10 @@ static BOOL rdg_write_websocket(BIO* bio, wStream* sPacket, WEBSOCKET_OPCODE opc
 		Stream_Write_UINT32_BE(sWS, 0); /* payload is limited to INT_MAX */
 		Stream_Write_UINT32_BE(sWS, len);
 	}
-	Stream_Write_UINT32(sWS, maskingKey);
-
-	/* mask as much as possible with 32bit access */
-	for (streamPos = 0; streamPos + 4 <= len; streamPos += 4)
-	{
-		uint32_t data;
-		Stream_Read_UINT32(sPacket, data);
-		Stream_Write_UINT32(sWS, data ^ maskingKey);
-	}
-
-	/* mask the rest byte by byte */
-	for (; streamPos < len; streamPos++)
-	{
-		BYTE data;
-		BYTE* partialMask = ((BYTE*)&maskingKey) + (streamPos % 4);
-		Stream_Read_UINT8(sPacket, data);
-		Stream_Write_UINT8(sWS, data ^ *partialMask);
-	}
+	Stream_Write(sWS, maskingKey, sizeof(maskingKey));
 
+	rdg_websocket_mask(Stream_Pointer(sWS), Stream_Buffer(sPacket), len, maskingKey);
+	Stream_Seek(sWS, len);
 	Stream_SealLength(sWS);
 
 	ERR_clear_error();
@@ -459,6 +491,49 @@ static BOOL rdg_write_packet(rdpRdg* rdg, wStream* sPacket)
 	return rdg_write_chunked(rdg->tlsIn->bio, sPacket);
 }
 
+static int rdg_websocket_buffered_read(BIO* bio, BYTE* pBuffer, size_t size,
+                                       rdg_http_websocket_context* encodingContext)
+{
+	int status;
+	size_t available;
+	wStream* s = encodingContext->readBuffer;
+
+	if (!s)
+	{
+		ERR_clear_error();
+		return BIO_read(bio, pBuffer, size);
+	}
+
+	available = Stream_GetRemainingLength(s);
+
+	if (available == 0)
+	{
+		/* nothing buffered, large payload reads need no extra copy */
+		if (size >= WEBSOCKET_READ_BYPASS_SIZE)
+		{
+			ERR_clear_error();
+			return BIO_read(bio, pBuffer, size);
+		}
+
+		Stream_SetPosition(s, 0);
+		Stream_SetLength(s, 0);
+
+		ERR_clear_error();
+		status = BIO_read(bio, Stream_Buffer(s), Stream_Capacity(s));
+		if (status <= 0)
+			return status;
+
+		Stream_SetLength(s, (size_t)status);
+		available = (size_t)status;
+	}
+
+	if (size > available)
+		size = available;
+
+	Stream_Read(s, pBuffer, size);
+	return (int)size;
+}
+
 static int rdg_websocket_read_data(BIO* bio, BYTE* pBuffer, size_t size,
                                    rdg_http_websocket_context* encodingContext)
 {
@@ -470,10 +545,10 @@ static int rdg_websocket_read_data(BIO* bio, BYTE* pBuffer, size_t size,
 		return 0;
 	}
 
-	ERR_clear_error();
-	status =
-	    BIO_read(bio, pBuffer,
-	             (encodingContext->payloadLength < size ? encodingContext->payloadLength : size));
+	status = rdg_websocket_buffered_read(
+	    bio, pBuffer,
+	    (encodingContext->payloadLength < size ? encodingContext->payloadLength : size),
+	    encodingContext);
 	if (status <= 0)
 		return status;
 
@@ -496,8 +571,11 @@ static int rdg_websocket_read_discard(BIO* bio, rdg_http_websocket_context* enco
 		return 0;
 	}
 
-	ERR_clear_error();
-	status = BIO_read(bio, _dummy, sizeof(_dummy));
+	status = rdg_websocket_buffered_read(
+	    bio, (BYTE*)_dummy,
+	    (encodingContext->payloadLength < sizeof(_dummy) ? encodingContext->payloadLength
+	                                                     : sizeof(_dummy)),
+	    encodingContext);
 	if (status <= 0)
 		return status;
 
@@ -522,8 +600,8 @@ static int rdg_websocket_read_wstream(BIO* bio, wStream* s,
 	if (s == NULL || Stream_GetRemainingCapacity(s) != encodingContext->payloadLength)
 		return -1;
 
-	ERR_clear_error();
-	status = BIO_read(bio, Stream_Pointer(s), encodingContext->payloadLength);
+	status = rdg_websocket_buffered_read(bio, Stream_Pointer(s), encodingContext->payloadLength,
+	                                     encodingContext);
 	if (status <= 0)
 		return status;
 
@@ -692,8 +770,7 @@ static int rdg_websocket_read(BIO* bio, BYTE* pBuffer, size_t size,
 			case WebsocketStateOpcodeAndFin:
 			{
 				BYTE buffer[1];
-				ERR_clear_error();
-				status = BIO_read(bio, (char*)buffer, 1);
+				status = rdg_websocket_buffered_read(bio, buffer, 1, encodingContext);
 				if (status <= 0)
 					return (effectiveDataLen > 0 ? effectiveDataLen : status);
 
@@ -708,8 +785,7 @@ static int rdg_websocket_read(BIO* bio, BYTE* pBuffer, size_t size,
 			{
 				BYTE buffer[1];
 				BYTE len;
-				ERR_clear_error();
-				status = BIO_read(bio, (char*)buffer, 1);
+				status = rdg_websocket_buffered_read(bio, buffer, 1, encodingContext);
 				if (status <= 0)
 					return (effectiveDataLen > 0 ? effectiveDataLen : status);
 
@@ -736,8 +812,7 @@ static int rdg_websocket_read(BIO* bio, BYTE* pBuffer, size_t size,
 				BYTE lenLength = (encodingContext->state == WebsocketStateShortLength ? 2 : 8);
 				while (encodingContext->lengthAndMaskPosition < lenLength)
 				{
-					ERR_clear_error();
-					status = BIO_read(bio, (char*)buffer, 1);
+					status = rdg_websocket_buffered_read(bio, buffer, 1, encodingContext);
 					if (status <= 0)
 						return (effectiveDataLen > 0 ? effectiveDataLen : status);
 
@@ -1789,6 +1864,11 @@ static BOOL rdg_establish_data_connection(rdpRdg* rdg, rdpTls* tls, const char*
 			rdg->transferEncoding.isWebsocketTransport = TRUE;
 			rdg->transferEncoding.context.websocket.state = WebsocketStateOpcodeAndFin;
 			rdg->transferEncoding.context.websocket.responseStreamBuffer = NULL;
+			rdg->transferEncoding.context.websocket.readBuffer =
+			    Stream_New(NULL, WEBSOCKET_READ_AHEAD_SIZE);
+			if (!rdg->transferEncoding.context.websocket.readBuffer)
+				return FALSE;
+			Stream_SetLength(rdg->transferEncoding.context.websocket.readBuffer, 0);
 
 			return TRUE;
 		default:
@@ -1896,38 +1976,39 @@ BOOL rdg_connect(rdpRdg* rdg, DWORD timeout, BOOL* rpcFallback)
 static int rdg_write_websocket_data_packet(rdpRdg* rdg, const BYTE* buf, int isize)
 {
 	size_t payloadSize;
-	size_t fullLen;
+	size_t headerLen;
 	int status;
 	wStream* sWS;
+	BYTE* header;
+	BYTE* payload;
 
-	uint32_t maskingKey;
-	BYTE* maskingKeyByte1 = (BYTE*)&maskingKey;
-	BYTE* maskingKeyByte2 = maskingKeyByte1 + 1;
-	BYTE* maskingKeyByte3 = maskingKeyByte1 + 2;
-	BYTE* maskingKeyByte4 = maskingKeyByte1 + 3;
+	BYTE maskingKey[4];
+	BYTE shiftedKey[4];
 
-	int streamPos;
-
-	winpr_RAND((BYTE*)&maskingKey, 4);
-
-	payloadSize = isize + 10;
 	if ((isize < 0) || (isize > UINT16_MAX))
 		return -1;
 
-	if (payloadSize < 1)
-		return 0;
+	payloadSize = (size_t)isize + 10;
 
 	if (payloadSize < 126)
-		fullLen = payloadSize + 6; /* 2 byte "mini header" + 4 byte masking key */
+		headerLen = 6; /* 2 byte "mini header" + 4 byte masking key */
 	else if (payloadSize < 0x10000)
-		fullLen = payloadSize + 8; /* 2 byte "mini header" + 2 byte length + 4 byte masking key */
+		headerLen = 8; /* 2 byte "mini header" + 2 byte length + 4 byte masking key */
 	else
-		fullLen = payloadSize + 14; /* 2 byte "mini header" + 8 byte length + 4 byte masking key */
+		headerLen = 14; /* 2 byte "mini header" + 8 byte length + 4 byte masking key */
 
-	sWS = Stream_New(NULL, fullLen);
-	if (!sWS)
-		return FALSE;
+	/* The payload is masked directly into the reused send buffer, the RDG and websocket
+	 * headers are written in the headroom in front of it. */
+	sWS = rdg->sendBuffer;
+	if (!Stream_EnsureCapacity(sWS, WEBSOCKET_SEND_HEADROOM + (size_t)isize))
+		return -1;
+
+	payload = Stream_Buffer(sWS) + WEBSOCKET_SEND_HEADROOM;
+	header = payload - 10 - headerLen;
 
+	winpr_RAND(maskingKey, sizeof(maskingKey));
+
+	Stream_SetPosition(sWS, (size_t)(header - Stream_Buffer(sWS)));
 	Stream_Write_UINT8(sWS, WEBSOCKET_FIN_BIT | WebsocketBinaryOpcode);
 	if (payloadSize < 126)
 		Stream_Write_UINT8(sWS, payloadSize | WEBSOCKET_MASK_BIT);
@@ -1943,36 +2024,24 @@ static int rdg_write_websocket_data_packet(rdpRdg* rdg, const BYTE* buf, int isi
 		Stream_Write_UINT32_BE(sWS, 0);
 		Stream_Write_UINT32_BE(sWS, payloadSize);
 	}
-	Stream_Write_UINT32(sWS, maskingKey);
-
-	Stream_Write_UINT16(sWS, PKT_TYPE_DATA ^ (*maskingKeyByte1 | *maskingKeyByte2 << 8)); /* Type */
-	Stream_Write_UINT16(sWS, 0 ^ (*maskingKeyByte3 | *maskingKeyByte4 << 8)); /* Reserved */
-	Stream_Write_UINT32(sWS, (UINT32)payloadSize ^ maskingKey);               /* Packet length */
-	Stream_Write_UINT16(sWS,
-	                    (UINT16)isize ^ (*maskingKeyByte1 | *maskingKeyByte2 << 8)); /* Data size */
-
-	/* masking key is now off by 2 bytes. fix that */
-	maskingKey = (maskingKey & 0xffff) << 16 | (maskingKey >> 16);
+	Stream_Write(sWS, maskingKey, sizeof(maskingKey));
 
-	/* mask as much as possible with 32bit access */
-	for (streamPos = 0; streamPos + 4 <= isize; streamPos += 4)
-	{
-		uint32_t masked = *((const uint32_t*)((const BYTE*)buf + streamPos)) ^ maskingKey;
-		Stream_Write_UINT32(sWS, masked);
-	}
+	Stream_Write_UINT16(sWS, PKT_TYPE_DATA);       /* Type */
+	Stream_Write_UINT16(sWS, 0);                   /* Reserved */
+	Stream_Write_UINT32(sWS, (UINT32)payloadSize); /* Packet length */
+	Stream_Write_UINT16(sWS, (UINT16)isize);       /* Data size */
+	WINPR_ASSERT(Stream_Pointer(sWS) == payload);
 
-	/* mask the rest byte by byte */
-	for (; streamPos < isize; streamPos++)
-	{
-		BYTE* partialMask = (BYTE*)(&maskingKey) + streamPos % 4;
-		BYTE masked = *((const BYTE*)((const BYTE*)buf + streamPos)) ^ *partialMask;
-		Stream_Write_UINT8(sWS, masked);
-	}
+	rdg_websocket_mask(payload - 10, payload - 10, 10, maskingKey);
 
-	Stream_SealLength(sWS);
+	/* masking key is now off by 2 bytes. fix that */
+	shiftedKey[0] = maskingKey[2];
+	shiftedKey[1] = maskingKey[3];
+	shiftedKey[2] = maskingKey[0];
+	shiftedKey[3] = maskingKey[1];
+	rdg_websocket_mask(payload, buf, (size_t)isize, shiftedKey);
 
-	status = tls_write_all(rdg->tlsOut, Stream_Buffer(sWS), Stream_Length(sWS));
-	Stream_Free(sWS, TRUE);
+	status = tls_write_all(rdg->tlsOut, header, (int)(headerLen + payloadSize));
 
 	if (status < 0)
 		return status;
@@ -2347,6 +2416,22 @@ static int rdg_bio_gets(BIO* bio, char* str, int size)
 	return -2;
 }
 
+/* bytes already read from the TLS layer into the websocket read buffer */
+static size_t rdg_websocket_buffered(rdpRdg* rdg)
+{
+	wStream* s;
+
+	if (!rdg->transferEncoding.isWebsocketTransport)
+		return 0;
+
+	s = rdg->transferEncoding.context.websocket.readBuffer;
+
+	if (!s)
+		return 0;
+
+	return Stream_GetRemainingLength(s);
+}
+
 static long rdg_bio_ctrl(BIO* in_bio, int cmd, long arg1, void* arg2)
 {
 	long status = -1;
@@ -2365,10 +2450,24 @@ static long rdg_bio_ctrl(BIO* in_bio, int cmd, long arg1, void* arg2)
 	{
 		status = 1;
 	}
+	else if (cmd == BIO_CTRL_PENDING)
+	{
+		const size_t buffered = rdg_websocket_buffered(rdg);
+
+		if (buffered > 0)
+			status = (long)buffered;
+		else
+			status = BIO_pending(tlsOut->bio);
+	}
 	else if (cmd == BIO_C_READ_BLOCKED)
 	{
 		BIO* cbio = tlsOut->bio;
-		status = BIO_read_blocked(cbio);
+
+		/* the socket is not readable for data already in the read buffer */
+		if (rdg_websocket_buffered(rdg) > 0)
+			status = 0;
+		else
+			status = BIO_read_blocked(cbio);
 	}
 	else if (cmd == BIO_C_WRITE_BLOCKED)
 	{
@@ -2384,7 +2483,9 @@ static long rdg_bio_ctrl(BIO* in_bio, int cmd, long arg1, void* arg2)
 		int timeout = (int)arg1;
 		BIO* cbio = tlsOut->bio;
 
-		if (BIO_read_blocked(cbio))
+		if (rdg_websocket_buffered(rdg) > 0)
+			status = 1;
+		else if (BIO_read_blocked(cbio))
 			return BIO_wait_read(cbio, timeout);
 		else if (BIO_write_blocked(cbio))
 			return BIO_wait_write(cbio, timeout);
@@ -2556,6 +2657,11 @@ rdpRdg* rdg_new(rdpContext* context)
 		BIO_set_data(rdg->frontBio, rdg);
 		InitializeCriticalSection(&rdg->writeSection);
 
+		rdg->sendBuffer = Stream_New(NULL, WEBSOCKET_SEND_HEADROOM + UINT16_MAX);
+
+		if (!rdg->sendBuffer)
+			goto rdg_alloc_error;
+
 		rdg->transferEncoding.httpTransferEncoding = TransferEncodingIdentity;
 		rdg->transferEncoding.isWebsocketTransport = FALSE;
 	}
@@ -2585,8 +2691,11 @@ void rdg_free(rdpRdg* rdg)
 	{
 		if (rdg->transferEncoding.context.websocket.responseStreamBuffer != NULL)
 			Stream_Free(rdg->transferEncoding.context.websocket.responseStreamBuffer, TRUE);
+		Stream_Free(rdg->transferEncoding.context.websocket.readBuffer, TRUE);
 	}
 
+	Stream_Free(rdg->sendBuffer, TRUE);
+
 	free(rdg);
 }
 
@@ -541,6 +541,8 @@ static int rpc_out_channel_init(rdpRpc* rpc, RpcOutChannel* outChannel)
 	outChannel->ReceiveWindow = rpc->ReceiveWindow;
 	outChannel->ReceiveWindowSize = rpc->ReceiveWindow;
 	outChannel->AvailableWindowAdvertised = rpc->ReceiveWindow;
+	outChannel->FlowControlAckThreshold = rpc->ReceiveWindow / 2;
+	outChannel->LastFlowControlAck = 0;
 
 	if (rpc_channel_rpch_init(rpc->client, &outChannel->common, "RPC_OUT_DATA") < 0)
 		return -1;
@@ -674,6 +674,8 @@ typedef struct
 	UINT32 ReceiverAvailableWindow;
 	UINT32 BytesReceived;
 	UINT32 AvailableWindowAdvertised;
+	UINT32 FlowControlAckThreshold;
+	UINT64 LastFlowControlAck;
 } RpcOutChannel;
 
 /* Client Virtual Connection */
@@ -25,6 +25,7 @@
 #include <winpr/assert.h>
 #include <winpr/print.h>
 #include <winpr/synch.h>
+#include <winpr/sysinfo.h>
 #include <winpr/thread.h>
 #include <winpr/stream.h>
 
@@ -42,6 +43,9 @@
 
 #define TAG FREERDP_TAG("core.gateway.rpc")
 
+/* Send the FlowControlAck early enough to cover this much data at the measured rate */
+#define RPC_FLOW_CONTROL_ACK_LEAD_MS 20
+
 static void rpc_pdu_reset(RPC_PDU* pdu)
 {
 	pdu->Type = 0;
@@ -82,16 +86,21 @@ static void rpc_pdu_free(RPC_PDU* pdu)
 static int rpc_client_receive_pipe_write(RpcClient* client, const BYTE* buffer, size_t length)
 {
 	int status = 0;
+	BOOL wasEmpty;
 
 	if (!client || !buffer)
 		return -1;
 
 	EnterCriticalSection(&(client->PipeLock));
 
+	wasEmpty = ringbuffer_used(&(client->ReceivePipe)) == 0;
+
 	if (ringbuffer_write(&(client->ReceivePipe), buffer, length))
 		status += (int)length;
 
-	if (ringbuffer_used(&(client->ReceivePipe)) > 0)
+	/* The event is set while the pipe holds data, only signal the empty to non empty
+	 * transition instead of every fragment. */
+	if (wasEmpty && (ringbuffer_used(&(client->ReceivePipe)) > 0))
 		SetEvent(client->PipeEvent);
 
 	LeaveCriticalSection(&(client->PipeLock));
@@ -120,7 +129,7 @@ int rpc_client_receive_pipe_read(RpcClient* client, BYTE* buffer, size_t length)
 	if (status > 0)
 		ringbuffer_commit_read_bytes(&(client->ReceivePipe), status);
 
-	if (ringbuffer_used(&(client->ReceivePipe)) < 1)
+	if ((status > 0) && (ringbuffer_used(&(client->ReceivePipe)) < 1))
 		ResetEvent(client->PipeEvent);
 
 	LeaveCriticalSection(&(client->PipeLock));
@@ -303,6 +312,40 @@ static int rpc_client_recv_pdu(rdpRpc* rpc, RPC_PDU* pdu)
 	return status;
 }
 
+/**
+ * Adapt the FlowControlAck threshold to the measured receive rate.
+ * Fast links get the ack earlier so the server does not stall on an exhausted window,
+ * slow links ack later and send fewer RTS PDUs.
+ */
+static void rpc_client_update_flow_control_threshold(RpcOutChannel* outChannel)
+{
+	UINT64 now;
+	UINT64 elapsed;
+	UINT64 threshold;
+	UINT32 consumed;
+	const UINT32 minThreshold = outChannel->ReceiveWindow / 4;
+	const UINT32 maxThreshold = outChannel->ReceiveWindow / 4 * 3;
+
+	now = GetTickCount64();
+	elapsed = now - outChannel->LastFlowControlAck;
+	consumed = outChannel->AvailableWindowAdvertised - outChannel->ReceiverAvailableWindow;
+
+	if (outChannel->LastFlowControlAck == 0)
+		threshold = outChannel->FlowControlAckThreshold;
+	else if (elapsed == 0)
+		threshold = maxThreshold;
+	else
+		threshold = consumed * RPC_FLOW_CONTROL_ACK_LEAD_MS / elapsed;
+
+	if (threshold < minThreshold)
+		threshold = minThreshold;
+	if (threshold > maxThreshold)
+		threshold = maxThreshold;
+
+	outChannel->FlowControlAckThreshold = (UINT32)threshold;
+	outChannel->LastFlowControlAck = now;
+}
+
 static int rpc_client_recv_fragment(rdpRpc* rpc, wStream* fragment)
 {
 	int rc = -1;
@@ -327,13 +370,15 @@ static int rpc_client_recv_fragment(rdpRpc* rpc, wStream* fragment)
 
 	if (header.common.ptype == PTYPE_RESPONSE)
 	{
-		rpc->VirtualConnection->DefaultOutChannel->BytesReceived += header.common.frag_length;
-		rpc->VirtualConnection->DefaultOutChannel->ReceiverAvailableWindow -=
-		    header.common.frag_length;
+		RpcOutChannel* outChannel = rpc->VirtualConnection->DefaultOutChannel;
+
+		outChannel->BytesReceived += header.common.frag_length;
+		outChannel->ReceiverAvailableWindow -= header.common.frag_length;
 
-		if (rpc->VirtualConnection->DefaultOutChannel->ReceiverAvailableWindow <
-		    (rpc->ReceiveWindow / 2))
+		if (outChannel->ReceiverAvailableWindow < outChannel->FlowControlAckThreshold)
 		{
+			rpc_client_update_flow_control_threshold(outChannel);
+
 			if (!rts_send_flow_control_ack_pdu(rpc))
 				goto fail;
 		}
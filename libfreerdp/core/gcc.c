@@ -641,13 +641,11 @@ BOOL gcc_read_server_data_blocks(wStream* s, rdpMcs* mcs, UINT16 length)
 
 BOOL gcc_write_server_data_blocks(wStream* s, rdpMcs* mcs)
 {
-	return gcc_write_server_core_data(s, mcs) &&          /* serverCoreData */
-	       gcc_write_server_network_data(s, mcs) &&       /* serverNetworkData */
-	       gcc_write_server_security_data(s, mcs) &&      /* serverSecurityData */
-	       gcc_write_server_message_channel_data(s, mcs); /* serverMessageChannelData */
-	/* TODO: Send these GCC data blocks only when the client sent them */
-	// gcc_write_server_multitransport_channel_data(s, settings); /* serverMultitransportChannelData
-	// */
+	return gcc_write_server_core_data(s, mcs) &&            /* serverCoreData */
+	       gcc_write_server_network_data(s, mcs) &&         /* serverNetworkData */
+	       gcc_write_server_security_data(s, mcs) &&        /* serverSecurityData */
+	       gcc_write_server_message_channel_data(s, mcs) && /* serverMessageChannelData */
+	       gcc_write_server_multitransport_channel_data(s, mcs); /* serverMultitransportData */
 }
 
 BOOL gcc_read_user_data_header(wStream* s, UINT16* type, UINT16* length)
@@ -939,6 +937,9 @@ BOOL gcc_read_client_core_data(wStream* s, rdpMcs* mcs, UINT16 blockLength)
 		settings->SupportStatusInfoPdu =
 		    (earlyCapabilityFlags & RNS_UD_CS_SUPPORT_STATUSINFO_PDU) ? TRUE : FALSE;
 
+	mcs->skipChannelJoin = settings->SupportSkipChannelJoin &&
+	                       (earlyCapabilityFlags & RNS_UD_CS_SUPPORT_SKIP_CHANNELJOIN);
+
 	if (!(earlyCapabilityFlags & RNS_UD_CS_VALID_CONNECTION_TYPE))
 		connectionType = 0;
 
@@ -1042,6 +1043,10 @@ BOOL gcc_write_client_core_data(wStream* s, rdpMcs* mcs)
 
 	if (settings->SupportStatusInfoPdu)
 		earlyCapabilityFlags |= RNS_UD_CS_SUPPORT_STATUSINFO_PDU;
+
+	if (settings->SupportSkipChannelJoin)
+		earlyCapabilityFlags |= RNS_UD_CS_SUPPORT_SKIP_CHANNELJOIN;
+
 	if (!Stream_EnsureRemainingCapacity(s, 6))
 		return FALSE;
 
@@ -1076,7 +1081,7 @@ BOOL gcc_read_server_core_data(wStream* s, rdpMcs* mcs)
 {
 	UINT32 serverVersion;
 	UINT32 clientRequestedProtocols;
-	UINT32 earlyCapabilityFlags;
+	UINT32 earlyCapabilityFlags = 0;
 	rdpContext* context;
 	rdpSettings* settings;
 
@@ -1105,6 +1110,8 @@ BOOL gcc_read_server_core_data(wStream* s, rdpMcs* mcs)
 		Stream_Read_UINT32(s, earlyCapabilityFlags); /* earlyCapabilityFlags */
 	}
 
+	mcs->skipChannelJoin = settings->SupportSkipChannelJoin &&
+	                       (earlyCapabilityFlags & RNS_UD_SC_SKIP_CHANNELJOIN_SUPPORTED);
 	return TRUE;
 }
 
@@ -1129,6 +1136,9 @@ BOOL gcc_write_server_core_data(wStream* s, const rdpMcs* mcs)
 	if (settings->SupportDynamicTimeZone)
 		earlyCapabilityFlags |= RNS_UD_SC_DYNAMIC_DST_SUPPORTED;
 
+	if (settings->SupportSkipChannelJoin)
+		earlyCapabilityFlags |= RNS_UD_SC_SKIP_CHANNELJOIN_SUPPORTED;
+
 	Stream_Write_UINT32(s, settings->RdpVersion);         /* version (4 bytes) */
 	Stream_Write_UINT32(s, settings->RequestedProtocols); /* clientRequestedProtocols (4 bytes) */
 	Stream_Write_UINT32(s, earlyCapabilityFlags);         /* earlyCapabilityFlags (4 bytes) */
@@ -2179,11 +2189,26 @@ BOOL gcc_write_server_message_channel_data(wStream* s, const rdpMcs* mcs)
 BOOL gcc_read_client_multitransport_channel_data(wStream* s, rdpMcs* mcs, UINT16 blockLength)
 {
 	UINT32 flags;
+	rdpContext* context;
+	rdpSettings* settings;
+
+	WINPR_ASSERT(s);
+	WINPR_ASSERT(mcs);
+
+	context = transport_get_context(mcs->transport);
+	WINPR_ASSERT(context);
+
+	settings = context->settings;
+	WINPR_ASSERT(settings);
 
 	if (blockLength < 4)
 		return FALSE;
 
 	Stream_Read_UINT32(s, flags);
+
+	/* only offer the transports both sides support */
+	settings->MultitransportFlags &= flags;
+	mcs->clientMultitransport = TRUE;
 	return TRUE;
 }
 
@@ -2227,9 +2252,25 @@ BOOL gcc_read_server_multitransport_channel_data(wStream* s, rdpMcs* mcs)
 
 BOOL gcc_write_server_multitransport_channel_data(wStream* s, const rdpMcs* mcs)
 {
-	UINT32 flags = 0;
+	rdpContext* context;
+	const rdpSettings* settings;
+
+	WINPR_ASSERT(s);
+	WINPR_ASSERT(mcs);
+
+	context = transport_get_context(mcs->transport);
+	WINPR_ASSERT(context);
+
+	settings = context->settings;
+	WINPR_ASSERT(settings);
+
+	/* only answer a client block, the multitransport PDUs are sent on the message channel */
+	if (!mcs->clientMultitransport || !settings->SupportMultitransport ||
+	    (settings->MultitransportFlags == 0) || (mcs->messageChannelId == 0))
+		return TRUE;
+
 	if (!gcc_write_user_data_header(s, SC_MULTITRANSPORT, 8))
 		return FALSE;
-	Stream_Write_UINT32(s, flags); /* flags (4 bytes) */
+	Stream_Write_UINT32(s, settings->MultitransportFlags); /* flags (4 bytes) */
 	return TRUE;
 }
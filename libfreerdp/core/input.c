@@ -21,6 +21,7 @@
 
 #include <winpr/crt.h>
 #include <winpr/assert.h>
+#include <winpr/sysinfo.h>
 
 #include <freerdp/input.h>
 #include <freerdp/log.h>
@@ -302,36 +303,129 @@ static BOOL input_send_keyboard_pause_event(rdpInput* input)
 	                                 RDP_SCANCODE_CODE(RDP_SCANCODE_NUMLOCK));
 }
 
-static BOOL input_send_fastpath_synchronize_event(rdpInput* input, UINT32 flags)
+static BOOL input_send_fastpath_event_pdu(rdpRdp* rdp, const FASTPATH_INPUT_EVENT* events,
+                                          size_t count)
 {
+	size_t x;
 	wStream* s;
+
+	WINPR_ASSERT(rdp);
+	WINPR_ASSERT(events);
+	WINPR_ASSERT(count > 0);
+
+	s = fastpath_input_pdu_init_header(rdp->fastpath);
+
+	if (!s)
+		return FALSE;
+
+	for (x = 0; x < count; x++)
+	{
+		const FASTPATH_INPUT_EVENT* event = &events[x];
+
+		WINPR_ASSERT(Stream_GetRemainingCapacity(s) >= 1ull + event->length);
+		Stream_Write_UINT8(s, event->header); /* eventHeader (1 byte) */
+		Stream_Write(s, event->data, event->length);
+	}
+
+	return fastpath_send_multiple_input_pdu(rdp->fastpath, s, count);
+}
+
+static BOOL input_flush_batch(rdp_input_internal* in)
+{
+	BOOL rc = TRUE;
 	rdpRdp* rdp;
 
-	WINPR_ASSERT(input);
-	WINPR_ASSERT(input->context);
+	WINPR_ASSERT(in);
 
-	rdp = input->context->rdp;
+	if (in->batchCount == 0)
+		return TRUE;
+
+	rdp = in->common.context->rdp;
 	WINPR_ASSERT(rdp);
 
-	if (!input_ensure_client_running(input))
-		return FALSE;
+	/* The session is going away, nobody is interested in the pending input anymore */
+	if (!freerdp_shall_disconnect_context(in->common.context))
+		rc = input_send_fastpath_event_pdu(rdp, in->batch, in->batchCount);
 
-	/* The FastPath Synchronization eventFlags has identical values as SlowPath */
-	s = fastpath_input_pdu_init(rdp->fastpath, (BYTE)flags, FASTPATH_INPUT_EVENT_SYNC);
+	in->batchCount = 0;
+	in->batchDeadline = 0;
+	return rc;
+}
 
-	if (!s)
-		return FALSE;
+static BOOL input_batch_enabled(rdp_input_internal* in)
+{
+	WINPR_ASSERT(in);
+	return in->batchTimer != NULL;
+}
+
+static BOOL input_queue_fastpath_events(rdp_input_internal* in, const FASTPATH_INPUT_EVENT* events,
+                                        size_t count)
+{
+	BOOL rc = TRUE;
+	size_t x;
+	UINT64 now;
+
+	WINPR_ASSERT(in);
+	WINPR_ASSERT(events);
+
+	EnterCriticalSection(&in->batchLock);
+
+	now = GetTickCount64();
+
+	for (x = 0; x < count; x++)
+	{
+		const FASTPATH_INPUT_EVENT* event = &events[x];
+
+		/* Pointer motion is coalesced with a directly preceding motion event, the last
+		 * position wins. Button transitions are never merged so their order is kept. */
+		if (event->motion && (in->batchCount > 0) && in->batch[in->batchCount - 1].motion)
+		{
+			in->batch[in->batchCount - 1] = *event;
+			continue;
+		}
+
+		if (in->batchCount >= ARRAYSIZE(in->batch))
+		{
+			if (!input_flush_batch(in))
+			{
+				rc = FALSE;
+				goto out;
+			}
+		}
+
+		if (in->batchCount == 0)
+		{
+			const UINT32 latency = freerdp_settings_get_uint32(in->common.context->settings,
+			                                                   FreeRDP_FastPathInputBatchLatency);
+			LARGE_INTEGER due;
+
+			due.QuadPart = -10000LL * latency; /* relative, 100ns units */
+			in->batchDeadline = now + latency;
+
+			if (!SetWaitableTimer(in->batchTimer, &due, 0, NULL, NULL, FALSE))
+			{
+				rc = FALSE;
+				goto out;
+			}
+		}
+
+		in->batch[in->batchCount++] = *event;
+	}
+
+	if ((in->batchCount >= ARRAYSIZE(in->batch)) || (now >= in->batchDeadline))
+		rc = input_flush_batch(in);
 
-	return fastpath_send_input_pdu(rdp->fastpath, s);
+out:
+	LeaveCriticalSection(&in->batchLock);
+	return rc;
 }
 
-static BOOL input_send_fastpath_keyboard_event(rdpInput* input, UINT16 flags, UINT8 code)
+static BOOL input_send_fastpath_events(rdpInput* input, const FASTPATH_INPUT_EVENT* events,
+                                       size_t count)
 {
-	wStream* s;
-	BYTE eventFlags = 0;
 	rdpRdp* rdp;
+	rdp_input_internal* in = input_cast(input);
 
-	WINPR_ASSERT(input);
 	WINPR_ASSERT(input->context);
 
 	rdp = input->context->rdp;
@@ -340,35 +434,77 @@ static BOOL input_send_fastpath_keyboard_event(rdpInput* input, UINT16 flags, UI
 	if (!input_ensure_client_running(input))
 		return FALSE;
 
+	if (input_batch_enabled(in))
+		return input_queue_fastpath_events(in, events, count);
+
+	return input_send_fastpath_event_pdu(rdp, events, count);
+}
+
+static wStream* input_fastpath_event_init(FASTPATH_INPUT_EVENT* event, wStream* buffer,
+                                          BYTE eventFlags, BYTE eventCode)
+{
+	WINPR_ASSERT(event);
+
+	event->header = eventFlags | (eventCode << 5);
+	event->length = 0;
+	event->motion = FALSE;
+	return Stream_StaticInit(buffer, event->data, sizeof(event->data));
+}
+
+static void input_fastpath_event_seal(FASTPATH_INPUT_EVENT* event, wStream* s)
+{
+	WINPR_ASSERT(event);
+	WINPR_ASSERT(s);
+	WINPR_ASSERT(Stream_GetPosition(s) <= sizeof(event->data));
+
+	event->length = (BYTE)Stream_GetPosition(s);
+}
+
+static BOOL input_send_fastpath_synchronize_event(rdpInput* input, UINT32 flags)
+{
+	wStream buffer;
+	FASTPATH_INPUT_EVENT event;
+	wStream* s;
+
+	WINPR_ASSERT(input);
+
+	/* The FastPath Synchronization eventFlags has identical values as SlowPath */
+	s = input_fastpath_event_init(&event, &buffer, (BYTE)flags, FASTPATH_INPUT_EVENT_SYNC);
+	input_fastpath_event_seal(&event, s);
+	return input_send_fastpath_events(input, &event, 1);
+}
+
+static BOOL input_send_fastpath_keyboard_event(rdpInput* input, UINT16 flags, UINT8 code)
+{
+	wStream buffer;
+	FASTPATH_INPUT_EVENT event;
+	wStream* s;
+	BYTE eventFlags = 0;
+
+	WINPR_ASSERT(input);
+
 	eventFlags |= (flags & KBD_FLAGS_RELEASE) ? FASTPATH_INPUT_KBDFLAGS_RELEASE : 0;
 	eventFlags |= (flags & KBD_FLAGS_EXTENDED) ? FASTPATH_INPUT_KBDFLAGS_EXTENDED : 0;
 	eventFlags |= (flags & KBD_FLAGS_EXTENDED1) ? FASTPATH_INPUT_KBDFLAGS_PREFIX_E1 : 0;
-	s = fastpath_input_pdu_init(rdp->fastpath, eventFlags, FASTPATH_INPUT_EVENT_SCANCODE);
-
-	if (!s)
-		return FALSE;
+	s = input_fastpath_event_init(&event, &buffer, eventFlags, FASTPATH_INPUT_EVENT_SCANCODE);
 
 	WINPR_ASSERT(code <= UINT8_MAX);
 	Stream_Write_UINT8(s, (UINT8)code); /* keyCode (1 byte) */
-	return fastpath_send_input_pdu(rdp->fastpath, s);
+	input_fastpath_event_seal(&event, s);
+	return input_send_fastpath_events(input, &event, 1);
 }
 
 static BOOL input_send_fastpath_unicode_keyboard_event(rdpInput* input, UINT16 flags, UINT16 code)
 {
+	wStream buffer;
+	FASTPATH_INPUT_EVENT event;
 	wStream* s;
 	BYTE eventFlags = 0;
-	rdpRdp* rdp;
 
 	WINPR_ASSERT(input);
 	WINPR_ASSERT(input->context);
 	WINPR_ASSERT(input->context->settings);
 
-	rdp = input->context->rdp;
-	WINPR_ASSERT(rdp);
-
-	if (!input_ensure_client_running(input))
-		return FALSE;
-
 	if (!freerdp_settings_get_bool(input->context->settings, FreeRDP_UnicodeInput))
 	{
 		WLog_WARN(TAG, "Unicode input not supported by server.");
@@ -376,30 +512,23 @@ static BOOL input_send_fastpath_unicode_keyboard_event(rdpInput* input, UINT16 f
 	}
 
 	eventFlags |= (flags & KBD_FLAGS_RELEASE) ? FASTPATH_INPUT_KBDFLAGS_RELEASE : 0;
-	s = fastpath_input_pdu_init(rdp->fastpath, eventFlags, FASTPATH_INPUT_EVENT_UNICODE);
-
-	if (!s)
-		return FALSE;
+	s = input_fastpath_event_init(&event, &buffer, eventFlags, FASTPATH_INPUT_EVENT_UNICODE);
 
 	Stream_Write_UINT16(s, code); /* unicodeCode (2 bytes) */
-	return fastpath_send_input_pdu(rdp->fastpath, s);
+	input_fastpath_event_seal(&event, s);
+	return input_send_fastpath_events(input, &event, 1);
 }
 
 static BOOL input_send_fastpath_mouse_event(rdpInput* input, UINT16 flags, UINT16 x, UINT16 y)
 {
+	wStream buffer;
+	FASTPATH_INPUT_EVENT event;
 	wStream* s;
-	rdpRdp* rdp;
 
 	WINPR_ASSERT(input);
 	WINPR_ASSERT(input->context);
 	WINPR_ASSERT(input->context->settings);
 
-	rdp = input->context->rdp;
-	WINPR_ASSERT(rdp);
-
-	if (!input_ensure_client_running(input))
-		return FALSE;
-
 	if (!freerdp_settings_get_bool(input->context->settings, FreeRDP_HasHorizontalWheel))
 	{
 		if (flags & PTR_FLAGS_HWHEEL)
@@ -412,30 +541,24 @@ static BOOL input_send_fastpath_mouse_event(rdpInput* input, UINT16 flags, UINT1
 		}
 	}
 
-	s = fastpath_input_pdu_init(rdp->fastpath, 0, FASTPATH_INPUT_EVENT_MOUSE);
-
-	if (!s)
-		return FALSE;
+	s = input_fastpath_event_init(&event, &buffer, 0, FASTPATH_INPUT_EVENT_MOUSE);
 
 	input_write_mouse_event(s, flags, x, y);
-	return fastpath_send_input_pdu(rdp->fastpath, s);
+	input_fastpath_event_seal(&event, s);
+	event.motion = (flags == PTR_FLAGS_MOVE);
+	return input_send_fastpath_events(input, &event, 1);
 }
 
 static BOOL input_send_fastpath_extended_mouse_event(rdpInput* input, UINT16 flags, UINT16 x,
                                                      UINT16 y)
 {
+	wStream buffer;
+	FASTPATH_INPUT_EVENT event;
 	wStream* s;
-	rdpRdp* rdp;
 
 	WINPR_ASSERT(input);
 	WINPR_ASSERT(input->context);
 
-	rdp = input->context->rdp;
-	WINPR_ASSERT(rdp);
-
-	if (!input_ensure_client_running(input))
-		return FALSE;
-
 	if (!freerdp_settings_get_bool(input->context->settings, FreeRDP_HasExtendedMouseEvent))
 	{
 		WLog_WARN(TAG,
@@ -445,47 +568,33 @@ static BOOL input_send_fastpath_extended_mouse_event(rdpInput* input, UINT16 fla
 		return TRUE;
 	}
 
-	s = fastpath_input_pdu_init(rdp->fastpath, 0, FASTPATH_INPUT_EVENT_MOUSEX);
-
-	if (!s)
-		return FALSE;
+	s = input_fastpath_event_init(&event, &buffer, 0, FASTPATH_INPUT_EVENT_MOUSEX);
 
 	input_write_extended_mouse_event(s, flags, x, y);
-	return fastpath_send_input_pdu(rdp->fastpath, s);
+	input_fastpath_event_seal(&event, s);
+	return input_send_fastpath_events(input, &event, 1);
 }
 
 static BOOL input_send_fastpath_focus_in_event(rdpInput* input, UINT16 toggleStates)
 {
+	wStream buffer;
+	FASTPATH_INPUT_EVENT events[3];
 	wStream* s;
-	BYTE eventFlags = 0;
-	rdpRdp* rdp;
 
 	WINPR_ASSERT(input);
-	WINPR_ASSERT(input->context);
-
-	rdp = input->context->rdp;
-	WINPR_ASSERT(rdp);
-
-	if (!input_ensure_client_running(input))
-		return FALSE;
-
-	s = fastpath_input_pdu_init_header(rdp->fastpath);
-
-	if (!s)
-		return FALSE;
 
 	/* send a tab up like mstsc.exe */
-	eventFlags = FASTPATH_INPUT_KBDFLAGS_RELEASE | FASTPATH_INPUT_EVENT_SCANCODE << 5;
-	Stream_Write_UINT8(s, eventFlags); /* Key Release event (1 byte) */
-	Stream_Write_UINT8(s, 0x0f);       /* keyCode (1 byte) */
+	s = input_fastpath_event_init(&events[0], &buffer, FASTPATH_INPUT_KBDFLAGS_RELEASE,
+	                              FASTPATH_INPUT_EVENT_SCANCODE);
+	Stream_Write_UINT8(s, 0x0f); /* keyCode (1 byte) */
+	input_fastpath_event_seal(&events[0], s);
 	/* send the toggle key states */
-	eventFlags = (toggleStates & 0x1F) | FASTPATH_INPUT_EVENT_SYNC << 5;
-	Stream_Write_UINT8(s, eventFlags); /* toggle state (1 byte) */
+	s = input_fastpath_event_init(&events[1], &buffer, (toggleStates & 0x1F),
+	                              FASTPATH_INPUT_EVENT_SYNC);
+	input_fastpath_event_seal(&events[1], s);
 	/* send another tab up like mstsc.exe */
-	eventFlags = FASTPATH_INPUT_KBDFLAGS_RELEASE | FASTPATH_INPUT_EVENT_SCANCODE << 5;
-	Stream_Write_UINT8(s, eventFlags); /* Key Release event (1 byte) */
-	Stream_Write_UINT8(s, 0x0f);       /* keyCode (1 byte) */
-	return fastpath_send_multiple_input_pdu(rdp->fastpath, s, 3);
+	events[2] = events[0];
+	return input_send_fastpath_events(input, events, ARRAYSIZE(events));
 }
 
 static BOOL input_send_fastpath_keyboard_pause_event(rdpInput* input)
@@ -494,38 +603,33 @@ static BOOL input_send_fastpath_keyboard_pause_event(rdpInput* input)
 	 * and pause-up sent nothing.  However, reverse engineering mstsc shows
 	 * it sending the following sequence:
 	 */
+	wStream buffer;
+	FASTPATH_INPUT_EVENT events[4];
 	wStream* s;
-	const BYTE keyDownEvent = FASTPATH_INPUT_EVENT_SCANCODE << 5;
-	const BYTE keyUpEvent = (FASTPATH_INPUT_EVENT_SCANCODE << 5) | FASTPATH_INPUT_KBDFLAGS_RELEASE;
-	rdpRdp* rdp;
 
 	WINPR_ASSERT(input);
-	WINPR_ASSERT(input->context);
-
-	rdp = input->context->rdp;
-	WINPR_ASSERT(rdp);
-
-	if (!input_ensure_client_running(input))
-		return FALSE;
-
-	s = fastpath_input_pdu_init_header(rdp->fastpath);
-
-	if (!s)
-		return FALSE;
 
 	/* Control down (0x1D) */
-	Stream_Write_UINT8(s, keyDownEvent | FASTPATH_INPUT_KBDFLAGS_PREFIX_E1);
+	s = input_fastpath_event_init(&events[0], &buffer, FASTPATH_INPUT_KBDFLAGS_PREFIX_E1,
+	                              FASTPATH_INPUT_EVENT_SCANCODE);
 	Stream_Write_UINT8(s, RDP_SCANCODE_CODE(RDP_SCANCODE_LCONTROL));
+	input_fastpath_event_seal(&events[0], s);
 	/* Numlock down (0x45) */
-	Stream_Write_UINT8(s, keyDownEvent);
+	s = input_fastpath_event_init(&events[1], &buffer, 0, FASTPATH_INPUT_EVENT_SCANCODE);
 	Stream_Write_UINT8(s, RDP_SCANCODE_CODE(RDP_SCANCODE_NUMLOCK));
+	input_fastpath_event_seal(&events[1], s);
 	/* Control up (0x1D) */
-	Stream_Write_UINT8(s, keyUpEvent | FASTPATH_INPUT_KBDFLAGS_PREFIX_E1);
+	s = input_fastpath_event_init(&events[2], &buffer,
+	                              FASTPATH_INPUT_KBDFLAGS_RELEASE | FASTPATH_INPUT_KBDFLAGS_PREFIX_E1,
+	                              FASTPATH_INPUT_EVENT_SCANCODE);
 	Stream_Write_UINT8(s, RDP_SCANCODE_CODE(RDP_SCANCODE_LCONTROL));
-	/* Numlock down (0x45) */
-	Stream_Write_UINT8(s, keyUpEvent);
+	input_fastpath_event_seal(&events[2], s);
+	/* Numlock up (0x45) */
+	s = input_fastpath_event_init(&events[3], &buffer, FASTPATH_INPUT_KBDFLAGS_RELEASE,
+	                              FASTPATH_INPUT_EVENT_SCANCODE);
 	Stream_Write_UINT8(s, RDP_SCANCODE_CODE(RDP_SCANCODE_NUMLOCK));
-	return fastpath_send_multiple_input_pdu(rdp->fastpath, s, 4);
+	input_fastpath_event_seal(&events[3], s);
+	return input_send_fastpath_events(input, events, ARRAYSIZE(events));
 }
 
 static BOOL input_recv_sync_event(rdpInput* input, wStream* s)
@@ -722,6 +826,87 @@ BOOL input_recv(rdpInput* input, wStream* s)
 	return TRUE;
 }
 
+static BOOL input_batch_reset(rdp_input_internal* in)
+{
+	rdpSettings* settings;
+	BOOL enable;
+
+	WINPR_ASSERT(in);
+
+	settings = in->common.context->settings;
+	WINPR_ASSERT(settings);
+
+	enable = freerdp_settings_get_bool(settings, FreeRDP_FastPathInput) &&
+	         (freerdp_settings_get_uint32(settings, FreeRDP_FastPathInputBatchLatency) > 0);
+
+	EnterCriticalSection(&in->batchLock);
+
+	/* Events batched before a deactivation-reactivation sequence are stale */
+	in->batchCount = 0;
+	in->batchDeadline = 0;
+
+	if (enable && !in->batchTimer)
+		in->batchTimer = CreateWaitableTimerA(NULL, FALSE, NULL);
+	else if (!enable && in->batchTimer)
+	{
+		CloseHandle(in->batchTimer);
+		in->batchTimer = NULL;
+	}
+
+	LeaveCriticalSection(&in->batchLock);
+
+	if (enable && !in->batchTimer)
+	{
+		WLog_ERR(TAG, "failed to create input batching timer");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+HANDLE input_get_batch_event_handle(rdpInput* input)
+{
+	if (!input)
+		return NULL;
+
+	return input_cast(input)->batchTimer;
+}
+
+BOOL input_check_batch(rdpInput* input)
+{
+	BOOL rc = TRUE;
+	rdp_input_internal* in;
+
+	if (!input)
+		return FALSE;
+
+	in = input_cast(input);
+
+	if (!input_batch_enabled(in))
+		return TRUE;
+
+	EnterCriticalSection(&in->batchLock);
+
+	if (in->batchCount > 0)
+	{
+		const UINT64 now = GetTickCount64();
+
+		if (now >= in->batchDeadline)
+			rc = input_flush_batch(in);
+		else
+		{
+			/* Woken up early, make sure the timer fires again for the pending events */
+			LARGE_INTEGER due;
+
+			due.QuadPart = -10000LL * (LONGLONG)(in->batchDeadline - now);
+			rc = SetWaitableTimer(in->batchTimer, &due, 0, NULL, NULL, FALSE);
+		}
+	}
+
+	LeaveCriticalSection(&in->batchLock);
+	return rc;
+}
+
 BOOL input_register_client_callbacks(rdpInput* input)
 {
 	rdpSettings* settings;
@@ -734,6 +919,9 @@ BOOL input_register_client_callbacks(rdpInput* input)
 	if (!settings)
 		return FALSE;
 
+	if (!input_batch_reset(input_cast(input)))
+		return FALSE;
+
 	if (freerdp_settings_get_bool(settings, FreeRDP_FastPathInput))
 	{
 		input->SynchronizeEvent = input_send_fastpath_synchronize_event;
@@ -877,6 +1065,13 @@ rdpInput* input_new(rdpRdp* rdp)
 		return NULL;
 	}
 
+	if (!InitializeCriticalSectionAndSpinCount(&input->batchLock, 4000))
+	{
+		MessageQueue_Free(input->queue);
+		free(input);
+		return NULL;
+	}
+
 	return &input->common;
 }
 
@@ -887,6 +1082,11 @@ void input_free(rdpInput* input)
 		rdp_input_internal* in = input_cast(input);
 
 		MessageQueue_Free(in->queue);
+
+		if (in->batchTimer)
+			CloseHandle(in->batchTimer);
+
+		DeleteCriticalSection(&in->batchLock);
 		free(in);
 	}
 }
@@ -29,6 +29,17 @@
 #include <freerdp/api.h>
 
 #include <winpr/stream.h>
+#include <winpr/synch.h>
+
+#define FASTPATH_INPUT_MAX_EVENTS 15
+
+typedef struct
+{
+	BYTE header;  /* eventHeader */
+	BYTE length;  /* number of valid bytes in data */
+	BYTE data[6]; /* largest fastpath input event payload is 6 bytes */
+	BOOL motion;  /* pure pointer motion, may be coalesced */
+} FASTPATH_INPUT_EVENT;
 
 typedef struct
 {
@@ -37,6 +48,12 @@ typedef struct
 
 	rdpInputProxy* proxy;
 	wMessageQueue* queue;
+
+	CRITICAL_SECTION batchLock;
+	HANDLE batchTimer;
+	UINT64 batchDeadline;
+	size_t batchCount;
+	FASTPATH_INPUT_EVENT batch[FASTPATH_INPUT_MAX_EVENTS];
 } rdp_input_internal;
 
 static INLINE rdp_input_internal* input_cast(rdpInput* input)
@@ -54,6 +71,8 @@ static INLINE rdp_input_internal* input_cast(rdpInput* input)
 FREERDP_LOCAL BOOL input_recv(rdpInput* input, wStream* s);
 
 FREERDP_LOCAL int input_process_events(rdpInput* input);
+FREERDP_LOCAL HANDLE input_get_batch_event_handle(rdpInput* input);
+FREERDP_LOCAL BOOL input_check_batch(rdpInput* input);
 FREERDP_LOCAL BOOL input_register_client_callbacks(rdpInput* input);
 
 FREERDP_LOCAL rdpInput* input_new(rdpRdp* rdp);
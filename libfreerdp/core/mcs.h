@@ -146,6 +146,8 @@ struct rdp_mcs
 	BOOL userChannelJoined;
 	BOOL globalChannelJoined;
 	BOOL messageChannelJoined;
+	BOOL skipChannelJoin;      /* both sides announced RNS_UD_*_SKIP_CHANNELJOIN */
+	BOOL clientMultitransport; /* the client sent a TS_UD_CS_MULTITRANSPORT block */
 
 	UINT32 channelCount;
 	UINT32 channelMaxCount;
@@ -19,6 +19,9 @@
 
 #include <freerdp/config.h>
 
+#include <winpr/sysinfo.h>
+#include <winpr/interlocked.h>
+
 #include "rdp.h"
 
 double metrics_write_bytes(rdpMetrics* metrics, UINT32 UncompressedBytes, UINT32 CompressedBytes)
@@ -37,6 +40,47 @@ double metrics_write_bytes(rdpMetrics* metrics, UINT32 UncompressedBytes, UINT32
 	return CompressionRatio;
 }
 
+void metrics_stage_add(rdpMetrics* metrics, rdpMetricsStage stage, UINT64 startNS)
+{
+	rdpMetricsStageTime* time;
+	UINT64 elapsed;
+	const UINT64 now = winpr_GetTickCount64NS();
+
+	if (!metrics || (stage >= METRICS_STAGE_COUNT))
+		return;
+
+	elapsed = (now > startNS) ? now - startNS : 0;
+	time = &metrics->Stages[stage];
+
+	/* stages may be entered from more than one thread, e.g. transport writes from channels */
+	winpr_InterlockedExchangeAdd64((LONGLONG volatile*)&time->Count, 1);
+	winpr_InterlockedExchangeAdd64((LONGLONG volatile*)&time->TotalNS, (LONGLONG)elapsed);
+	winpr_InterlockedMax64((LONGLONG volatile*)&time->MaxNS, (LONGLONG)elapsed);
+}
+
+const char* metrics_stage_name(rdpMetricsStage stage)
+{
+	switch (stage)
+	{
+		case METRICS_STAGE_SURFACE_ENCODE:
+			return "surfaceEncode";
+		case METRICS_STAGE_BULK_COMPRESS:
+			return "bulkCompress";
+		case METRICS_STAGE_TRANSPORT_WRITE:
+			return "transportWrite";
+		case METRICS_STAGE_TRANSPORT_READ:
+			return "transportRead";
+		case METRICS_STAGE_PDU_PROCESS:
+			return "pduProcess";
+		case METRICS_STAGE_BULK_DECOMPRESS:
+			return "bulkDecompress";
+		case METRICS_STAGE_SURFACE_DECODE:
+			return "surfaceDecode";
+		default:
+			return "unknown";
+	}
+}
+
 rdpMetrics* metrics_new(rdpContext* context)
 {
 	rdpMetrics* metrics;
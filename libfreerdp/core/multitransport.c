@@ -19,33 +19,181 @@
 
 #include <freerdp/config.h>
 
+#include <winpr/assert.h>
+#include <winpr/crypto.h>
+
 #include "multitransport.h"
 
 #include <freerdp/log.h>
 
 #define TAG FREERDP_TAG("core.multitransport")
 
-int rdp_recv_multitransport_packet(rdpRdp* rdp, wStream* s)
+int rdp_recv_multitransport_request_packet(rdpRdp* rdp, wStream* s)
 {
-	UINT32 requestId;
-	UINT16 requestedProtocol;
-	UINT16 reserved;
-	BYTE securityCookie[16];
+	BOOL rc;
+	rdpMultitransport* multitransport;
+
+	WINPR_ASSERT(rdp);
+	WINPR_ASSERT(s);
+
+	multitransport = rdp->multitransport;
+	WINPR_ASSERT(multitransport);
 
 	if (!Stream_CheckAndLogRequiredLength(TAG, s, 24))
 		return -1;
 
-	Stream_Read_UINT32(s, requestId);         /* requestId (4 bytes) */
-	Stream_Read_UINT16(s, requestedProtocol); /* requestedProtocol (2 bytes) */
-	Stream_Read_UINT16(s, reserved);          /* reserved (2 bytes) */
-	Stream_Read(s, securityCookie, 16);       /* securityCookie (16 bytes) */
+	Stream_Read_UINT32(s, multitransport->requestId);         /* requestId (4 bytes) */
+	Stream_Read_UINT16(s, multitransport->requestedProtocol); /* requestedProtocol (2 bytes) */
+	Stream_Seek_UINT16(s);                                    /* reserved (2 bytes) */
+	Stream_Read(s, multitransport->securityCookie, 16);       /* securityCookie (16 bytes) */
+
+	WLog_DBG(TAG,
+	         "received Initiate Multitransport Request PDU -> requestId=%" PRIu32
+	         ", requestedProtocol=0x%04" PRIx16 "",
+	         multitransport->requestId, multitransport->requestedProtocol);
+
+	/* Without a transport for the side channel decline right away, the server would otherwise
+	 * keep waiting for the UDP connection before it continues over TCP. */
+	if (!multitransport->MultitransportRequest)
+		rc = freerdp_multitransport_send_response(rdp->context, multitransport->requestId,
+		                                          E_ABORT);
+	else
+		rc = multitransport->MultitransportRequest(rdp->context, multitransport->requestId,
+		                                           multitransport->requestedProtocol,
+		                                           multitransport->securityCookie);
+
+	if (!rc)
+	{
+		WLog_ERR(TAG, "failed to handle Initiate Multitransport Request PDU");
+		return -1;
+	}
 
 	return 0;
 }
 
-rdpMultitransport* multitransport_new(void)
+int rdp_recv_multitransport_response_packet(rdpRdp* rdp, wStream* s)
+{
+	UINT32 requestId;
+	HRESULT hrResponse;
+	BOOL rc;
+	rdpMultitransport* multitransport;
+
+	WINPR_ASSERT(rdp);
+	WINPR_ASSERT(s);
+
+	multitransport = rdp->multitransport;
+	WINPR_ASSERT(multitransport);
+
+	if (!Stream_CheckAndLogRequiredLength(TAG, s, 8))
+		return -1;
+
+	Stream_Read_UINT32(s, requestId); /* requestId (4 bytes) */
+	Stream_Read_INT32(s, hrResponse); /* hrResponse (4 bytes) */
+
+	WLog_DBG(TAG,
+	         "received Initiate Multitransport Response PDU -> requestId=%" PRIu32
+	         ", hrResponse=0x%08" PRIx32 "",
+	         requestId, (UINT32)hrResponse);
+
+	if (requestId != multitransport->requestId)
+		WLog_WARN(TAG, "response to unknown multitransport request %" PRIu32 "", requestId);
+
+	rc = IFCALLRESULT(TRUE, multitransport->MultitransportResponse, rdp->context, requestId,
+	                  hrResponse);
+
+	if (!rc)
+	{
+		WLog_ERR(TAG, "multitransport->MultitransportResponse callback failed!");
+		return -1;
+	}
+
+	return 0;
+}
+
+BOOL freerdp_multitransport_send_request(freerdp_peer* peer, UINT32 requestId,
+                                         UINT16 requestedProtocol, const BYTE* securityCookie)
+{
+	wStream* s;
+	rdpRdp* rdp;
+	rdpMultitransport* multitransport;
+
+	WINPR_ASSERT(peer);
+	WINPR_ASSERT(peer->context);
+
+	rdp = peer->context->rdp;
+	WINPR_ASSERT(rdp);
+
+	multitransport = rdp->multitransport;
+	WINPR_ASSERT(multitransport);
+
+	if (rdp->mcs->messageChannelId == 0)
+	{
+		WLog_ERR(TAG, "client did not announce a message channel");
+		return FALSE;
+	}
+
+	/* remember the request, the tunnel create request of the side channel has to match it */
+	multitransport->requestId = requestId;
+	multitransport->requestedProtocol = requestedProtocol;
+
+	if (securityCookie)
+		CopyMemory(multitransport->securityCookie, securityCookie, 16);
+	else if (winpr_RAND(multitransport->securityCookie, 16) < 0)
+		return FALSE;
+
+	s = rdp_message_channel_pdu_init(rdp);
+
+	if (!s)
+		return FALSE;
+
+	Stream_Write_UINT32(s, requestId);                   /* requestId (4 bytes) */
+	Stream_Write_UINT16(s, requestedProtocol);           /* requestedProtocol (2 bytes) */
+	Stream_Write_UINT16(s, 0);                           /* reserved (2 bytes) */
+	Stream_Write(s, multitransport->securityCookie, 16); /* securityCookie (16 bytes) */
+
+	WLog_DBG(TAG,
+	         "sending Initiate Multitransport Request PDU -> requestId=%" PRIu32
+	         ", requestedProtocol=0x%04" PRIx16 "",
+	         requestId, requestedProtocol);
+
+	return rdp_send_message_channel_pdu(rdp, s, SEC_TRANSPORT_REQ);
+}
+
+BOOL freerdp_multitransport_send_response(rdpContext* context, UINT32 requestId,
+                                          HRESULT hrResponse)
 {
-	return (rdpMultitransport*)calloc(1, sizeof(rdpMultitransport));
+	wStream* s;
+	rdpRdp* rdp;
+
+	WINPR_ASSERT(context);
+
+	rdp = context->rdp;
+	WINPR_ASSERT(rdp);
+
+	s = rdp_message_channel_pdu_init(rdp);
+
+	if (!s)
+		return FALSE;
+
+	Stream_Write_UINT32(s, requestId); /* requestId (4 bytes) */
+	Stream_Write_INT32(s, hrResponse); /* hrResponse (4 bytes) */
+
+	WLog_DBG(TAG,
+	         "sending Initiate Multitransport Response PDU -> requestId=%" PRIu32
+	         ", hrResponse=0x%08" PRIx32 "",
+	         requestId, (UINT32)hrResponse);
+
+	return rdp_send_message_channel_pdu(rdp, s, SEC_TRANSPORT_RSP);
+}
+
+rdpMultitransport* multitransport_new(rdpContext* context)
+{
+	rdpMultitransport* multitransport = (rdpMultitransport*)calloc(1, sizeof(rdpMultitransport));
+
+	if (multitransport)
+		multitransport->context = context;
+
+	return multitransport;
 }
 
 void multitransport_free(rdpMultitransport* multitransport)
@@ -20,23 +20,18 @@
 #ifndef FREERDP_LIB_CORE_MULTITRANSPORT_H
 #define FREERDP_LIB_CORE_MULTITRANSPORT_H
 
-typedef struct rdp_multitransport rdpMultitransport;
-
 #include "rdp.h"
 
+#include <freerdp/multitransport.h>
 #include <freerdp/freerdp.h>
 #include <freerdp/api.h>
 
 #include <winpr/stream.h>
 
-struct rdp_multitransport
-{
-	UINT32 placeholder;
-};
-
-FREERDP_LOCAL int rdp_recv_multitransport_packet(rdpRdp* rdp, wStream* s);
+FREERDP_LOCAL int rdp_recv_multitransport_request_packet(rdpRdp* rdp, wStream* s);
+FREERDP_LOCAL int rdp_recv_multitransport_response_packet(rdpRdp* rdp, wStream* s);
 
-FREERDP_LOCAL rdpMultitransport* multitransport_new(void);
+FREERDP_LOCAL rdpMultitransport* multitransport_new(rdpContext* context);
 FREERDP_LOCAL void multitransport_free(rdpMultitransport* multitransport);
 
 #endif /* FREERDP_LIB_CORE_MULTITRANSPORT_H */
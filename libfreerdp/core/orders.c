@@ -1158,16 +1158,288 @@ static INLINE BOOL FIELD_SKIP_BUFFER16(wStream* s, UINT32 TARGET_LEN)
 
 	return TRUE;
 }
+
+/* Fixed size fields of primary drawing orders. An order type describes its fields in a table,
+ * the size of all fields present is known from the field flags before any of them is read. */
+typedef enum
+{
+	PRIMARY_FIELD_COORD,
+	PRIMARY_FIELD_BYTE,
+	PRIMARY_FIELD_UINT16,
+	PRIMARY_FIELD_INT16,
+	PRIMARY_FIELD_UINT32,
+	PRIMARY_FIELD_COLOR,
+	PRIMARY_FIELD_COLOR_BYTE,
+	PRIMARY_FIELD_KIND_COUNT
+} PRIMARY_FIELD_KIND;
+
+typedef struct
+{
+	BYTE kind;
+	BYTE shift;
+	size_t offset;
+} PRIMARY_ORDER_FIELD;
+
+#define PRIMARY_FIELD(kind, type, member) { kind, 0, offsetof(type, member) }
+#define PRIMARY_FIELD_COLOR_PART(shift, type, member) \
+	{ PRIMARY_FIELD_COLOR_BYTE, shift, offsetof(type, member) }
+
+/* size of each field kind, with absolute and with delta coordinates */
+static const BYTE primary_field_size[2][PRIMARY_FIELD_KIND_COUNT] = { { 2, 1, 2, 2, 4, 3, 1 },
+	                                                                  { 1, 1, 2, 2, 4, 3, 1 } };
+
+/* reads the fields first to first + count - 1 of a primary drawing order */
+static BOOL update_read_primary_fields(wStream* s, const ORDER_INFO* orderInfo,
+                                       const PRIMARY_ORDER_FIELD* fields, size_t count,
+                                       BYTE first, void* order)
+{
+	size_t x;
+	size_t length = 0;
+	BYTE* base = order;
+	const BYTE* sizes;
+	const UINT32 present = (orderInfo->fieldFlags >> (first - 1)) & ((1UL << count) - 1UL);
+
+	WINPR_ASSERT(count < 32);
+
+	sizes = primary_field_size[orderInfo->deltaCoordinates ? 1 : 0];
+
+	for (x = 0; x < count; x++)
+	{
+		if (present & (1UL << x))
+			length += sizes[fields[x].kind];
+	}
+
+	if (!Stream_CheckAndLogRequiredLength(TAG, s, length))
+		return FALSE;
+
+	for (x = 0; x < count; x++)
+	{
+		INT8 lsi8;
+		INT16 lsi16;
+		BYTE byte;
+		const PRIMARY_ORDER_FIELD* field = &fields[x];
+		UINT32* target = (UINT32*)&base[field->offset];
+
+		if (!(present & (1UL << x)))
+			continue;
+
+		switch (field->kind)
+		{
+			case PRIMARY_FIELD_COORD:
+				if (orderInfo->deltaCoordinates)
+				{
+					Stream_Read_INT8(s, lsi8);
+					*(INT32*)target += lsi8;
+				}
+				else
+				{
+					Stream_Read_INT16(s, lsi16);
+					*(INT32*)target = lsi16;
+				}
+				break;
+
+			case PRIMARY_FIELD_BYTE:
+				Stream_Read_UINT8(s, *target);
+				break;
+
+			case PRIMARY_FIELD_UINT16:
+				Stream_Read_UINT16(s, *target);
+				break;
+
+			case PRIMARY_FIELD_INT16:
+				Stream_Read_INT16(s, *(INT32*)target);
+				break;
+
+			case PRIMARY_FIELD_UINT32:
+				Stream_Read_UINT32(s, *target);
+				break;
+
+			case PRIMARY_FIELD_COLOR:
+				Stream_Read_UINT8(s, byte);
+				*target = (UINT32)byte;
+				Stream_Read_UINT8(s, byte);
+				*target |= ((UINT32)byte << 8);
+				Stream_Read_UINT8(s, byte);
+				*target |= ((UINT32)byte << 16);
+				break;
+
+			case PRIMARY_FIELD_COLOR_BYTE:
+				Stream_Read_UINT8(s, byte);
+				*target = (*target & ~(0xFFUL << field->shift)) | ((UINT32)byte << field->shift);
+				break;
+
+			default:
+				return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+static const PRIMARY_ORDER_FIELD dstblt_fields[] = {
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, DSTBLT_ORDER, nLeftRect),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, DSTBLT_ORDER, nTopRect),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, DSTBLT_ORDER, nWidth),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, DSTBLT_ORDER, nHeight),
+	PRIMARY_FIELD(PRIMARY_FIELD_BYTE, DSTBLT_ORDER, bRop)
+};
+
+static const PRIMARY_ORDER_FIELD patblt_fields[] = {
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, PATBLT_ORDER, nLeftRect),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, PATBLT_ORDER, nTopRect),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, PATBLT_ORDER, nWidth),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, PATBLT_ORDER, nHeight),
+	PRIMARY_FIELD(PRIMARY_FIELD_BYTE, PATBLT_ORDER, bRop),
+	PRIMARY_FIELD(PRIMARY_FIELD_COLOR, PATBLT_ORDER, backColor),
+	PRIMARY_FIELD(PRIMARY_FIELD_COLOR, PATBLT_ORDER, foreColor)
+};
+
+static const PRIMARY_ORDER_FIELD scrblt_fields[] = {
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, SCRBLT_ORDER, nLeftRect),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, SCRBLT_ORDER, nTopRect),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, SCRBLT_ORDER, nWidth),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, SCRBLT_ORDER, nHeight),
+	PRIMARY_FIELD(PRIMARY_FIELD_BYTE, SCRBLT_ORDER, bRop),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, SCRBLT_ORDER, nXSrc),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, SCRBLT_ORDER, nYSrc)
+};
+
+static const PRIMARY_ORDER_FIELD opaque_rect_fields[] = {
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, OPAQUE_RECT_ORDER, nLeftRect),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, OPAQUE_RECT_ORDER, nTopRect),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, OPAQUE_RECT_ORDER, nWidth),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, OPAQUE_RECT_ORDER, nHeight),
+	PRIMARY_FIELD_COLOR_PART(0, OPAQUE_RECT_ORDER, color),
+	PRIMARY_FIELD_COLOR_PART(8, OPAQUE_RECT_ORDER, color),
+	PRIMARY_FIELD_COLOR_PART(16, OPAQUE_RECT_ORDER, color)
+};
+
+static const PRIMARY_ORDER_FIELD draw_nine_grid_fields[] = {
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, DRAW_NINE_GRID_ORDER, srcLeft),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, DRAW_NINE_GRID_ORDER, srcTop),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, DRAW_NINE_GRID_ORDER, srcRight),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, DRAW_NINE_GRID_ORDER, srcBottom),
+	PRIMARY_FIELD(PRIMARY_FIELD_UINT16, DRAW_NINE_GRID_ORDER, bitmapId)
+};
+
+static const PRIMARY_ORDER_FIELD multi_dstblt_fields[] = {
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, MULTI_DSTBLT_ORDER, nLeftRect),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, MULTI_DSTBLT_ORDER, nTopRect),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, MULTI_DSTBLT_ORDER, nWidth),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, MULTI_DSTBLT_ORDER, nHeight),
+	PRIMARY_FIELD(PRIMARY_FIELD_BYTE, MULTI_DSTBLT_ORDER, bRop),
+	PRIMARY_FIELD(PRIMARY_FIELD_BYTE, MULTI_DSTBLT_ORDER, numRectangles)
+};
+
+static const PRIMARY_ORDER_FIELD multi_patblt_fields[] = {
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, MULTI_PATBLT_ORDER, nLeftRect),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, MULTI_PATBLT_ORDER, nTopRect),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, MULTI_PATBLT_ORDER, nWidth),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, MULTI_PATBLT_ORDER, nHeight),
+	PRIMARY_FIELD(PRIMARY_FIELD_BYTE, MULTI_PATBLT_ORDER, bRop),
+	PRIMARY_FIELD(PRIMARY_FIELD_COLOR, MULTI_PATBLT_ORDER, backColor),
+	PRIMARY_FIELD(PRIMARY_FIELD_COLOR, MULTI_PATBLT_ORDER, foreColor)
+};
+
+static const PRIMARY_ORDER_FIELD multi_scrblt_fields[] = {
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, MULTI_SCRBLT_ORDER, nLeftRect),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, MULTI_SCRBLT_ORDER, nTopRect),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, MULTI_SCRBLT_ORDER, nWidth),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, MULTI_SCRBLT_ORDER, nHeight),
+	PRIMARY_FIELD(PRIMARY_FIELD_BYTE, MULTI_SCRBLT_ORDER, bRop),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, MULTI_SCRBLT_ORDER, nXSrc),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, MULTI_SCRBLT_ORDER, nYSrc),
+	PRIMARY_FIELD(PRIMARY_FIELD_BYTE, MULTI_SCRBLT_ORDER, numRectangles)
+};
+
+static const PRIMARY_ORDER_FIELD multi_opaque_rect_fields[] = {
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, MULTI_OPAQUE_RECT_ORDER, nLeftRect),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, MULTI_OPAQUE_RECT_ORDER, nTopRect),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, MULTI_OPAQUE_RECT_ORDER, nWidth),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, MULTI_OPAQUE_RECT_ORDER, nHeight),
+	PRIMARY_FIELD_COLOR_PART(0, MULTI_OPAQUE_RECT_ORDER, color),
+	PRIMARY_FIELD_COLOR_PART(8, MULTI_OPAQUE_RECT_ORDER, color),
+	PRIMARY_FIELD_COLOR_PART(16, MULTI_OPAQUE_RECT_ORDER, color),
+	PRIMARY_FIELD(PRIMARY_FIELD_BYTE, MULTI_OPAQUE_RECT_ORDER, numRectangles)
+};
+
+static const PRIMARY_ORDER_FIELD line_to_fields[] = {
+	PRIMARY_FIELD(PRIMARY_FIELD_UINT16, LINE_TO_ORDER, backMode),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, LINE_TO_ORDER, nXStart),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, LINE_TO_ORDER, nYStart),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, LINE_TO_ORDER, nXEnd),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, LINE_TO_ORDER, nYEnd),
+	PRIMARY_FIELD(PRIMARY_FIELD_COLOR, LINE_TO_ORDER, backColor),
+	PRIMARY_FIELD(PRIMARY_FIELD_BYTE, LINE_TO_ORDER, bRop2),
+	PRIMARY_FIELD(PRIMARY_FIELD_BYTE, LINE_TO_ORDER, penStyle),
+	PRIMARY_FIELD(PRIMARY_FIELD_BYTE, LINE_TO_ORDER, penWidth),
+	PRIMARY_FIELD(PRIMARY_FIELD_COLOR, LINE_TO_ORDER, penColor)
+};
+
+static const PRIMARY_ORDER_FIELD memblt_fields[] = {
+	PRIMARY_FIELD(PRIMARY_FIELD_UINT16, MEMBLT_ORDER, cacheId),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, MEMBLT_ORDER, nLeftRect),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, MEMBLT_ORDER, nTopRect),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, MEMBLT_ORDER, nWidth),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, MEMBLT_ORDER, nHeight),
+	PRIMARY_FIELD(PRIMARY_FIELD_BYTE, MEMBLT_ORDER, bRop),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, MEMBLT_ORDER, nXSrc),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, MEMBLT_ORDER, nYSrc),
+	PRIMARY_FIELD(PRIMARY_FIELD_UINT16, MEMBLT_ORDER, cacheIndex)
+};
+
+static const PRIMARY_ORDER_FIELD mem3blt_fields[] = {
+	PRIMARY_FIELD(PRIMARY_FIELD_UINT16, MEM3BLT_ORDER, cacheId),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, MEM3BLT_ORDER, nLeftRect),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, MEM3BLT_ORDER, nTopRect),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, MEM3BLT_ORDER, nWidth),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, MEM3BLT_ORDER, nHeight),
+	PRIMARY_FIELD(PRIMARY_FIELD_BYTE, MEM3BLT_ORDER, bRop),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, MEM3BLT_ORDER, nXSrc),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, MEM3BLT_ORDER, nYSrc),
+	PRIMARY_FIELD(PRIMARY_FIELD_COLOR, MEM3BLT_ORDER, backColor),
+	PRIMARY_FIELD(PRIMARY_FIELD_COLOR, MEM3BLT_ORDER, foreColor)
+};
+
+static const PRIMARY_ORDER_FIELD mem3blt_index_fields[] = { PRIMARY_FIELD(
+	PRIMARY_FIELD_UINT16, MEM3BLT_ORDER, cacheIndex) };
+
+static const PRIMARY_ORDER_FIELD save_bitmap_fields[] = {
+	PRIMARY_FIELD(PRIMARY_FIELD_UINT32, SAVE_BITMAP_ORDER, savedBitmapPosition),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, SAVE_BITMAP_ORDER, nLeftRect),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, SAVE_BITMAP_ORDER, nTopRect),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, SAVE_BITMAP_ORDER, nRightRect),
+	PRIMARY_FIELD(PRIMARY_FIELD_COORD, SAVE_BITMAP_ORDER, nBottomRect),
+	PRIMARY_FIELD(PRIMARY_FIELD_BYTE, SAVE_BITMAP_ORDER, operation)
+};
+
+static const PRIMARY_ORDER_FIELD glyph_index_fields[] = {
+	PRIMARY_FIELD(PRIMARY_FIELD_BYTE, GLYPH_INDEX_ORDER, cacheId),
+	PRIMARY_FIELD(PRIMARY_FIELD_BYTE, GLYPH_INDEX_ORDER, flAccel),
+	PRIMARY_FIELD(PRIMARY_FIELD_BYTE, GLYPH_INDEX_ORDER, ulCharInc),
+	PRIMARY_FIELD(PRIMARY_FIELD_BYTE, GLYPH_INDEX_ORDER, fOpRedundant),
+	PRIMARY_FIELD(PRIMARY_FIELD_COLOR, GLYPH_INDEX_ORDER, backColor),
+	PRIMARY_FIELD(PRIMARY_FIELD_COLOR, GLYPH_INDEX_ORDER, foreColor),
+	PRIMARY_FIELD(PRIMARY_FIELD_INT16, GLYPH_INDEX_ORDER, bkLeft),
+	PRIMARY_FIELD(PRIMARY_FIELD_INT16, GLYPH_INDEX_ORDER, bkTop),
+	PRIMARY_FIELD(PRIMARY_FIELD_INT16, GLYPH_INDEX_ORDER, bkRight),
+	PRIMARY_FIELD(PRIMARY_FIELD_INT16, GLYPH_INDEX_ORDER, bkBottom),
+	PRIMARY_FIELD(PRIMARY_FIELD_INT16, GLYPH_INDEX_ORDER, opLeft),
+	PRIMARY_FIELD(PRIMARY_FIELD_INT16, GLYPH_INDEX_ORDER, opTop),
+	PRIMARY_FIELD(PRIMARY_FIELD_INT16, GLYPH_INDEX_ORDER, opRight),
+	PRIMARY_FIELD(PRIMARY_FIELD_INT16, GLYPH_INDEX_ORDER, opBottom)
+};
+
+static const PRIMARY_ORDER_FIELD glyph_index_position_fields[] = {
+	PRIMARY_FIELD(PRIMARY_FIELD_INT16, GLYPH_INDEX_ORDER, x),
+	PRIMARY_FIELD(PRIMARY_FIELD_INT16, GLYPH_INDEX_ORDER, y)
+};
+
 /* Primary Drawing Orders */
 static BOOL update_read_dstblt_order(wStream* s, const ORDER_INFO* orderInfo, DSTBLT_ORDER* dstblt)
 {
-	if (read_order_field_coord(orderInfo, s, 1, &dstblt->nLeftRect, FALSE) &&
-	    read_order_field_coord(orderInfo, s, 2, &dstblt->nTopRect, FALSE) &&
-	    read_order_field_coord(orderInfo, s, 3, &dstblt->nWidth, FALSE) &&
-	    read_order_field_coord(orderInfo, s, 4, &dstblt->nHeight, FALSE) &&
-	    read_order_field_byte(orderInfo, s, 5, &dstblt->bRop, TRUE))
-		return TRUE;
-	return FALSE;
+	return update_read_primary_fields(s, orderInfo, dstblt_fields, ARRAYSIZE(dstblt_fields), 1,
+	                                  dstblt);
 }
 
 size_t update_approximate_dstblt_order(ORDER_INFO* orderInfo, const DSTBLT_ORDER* dstblt)
@@ -1198,13 +1470,8 @@ BOOL update_write_dstblt_order(wStream* s, ORDER_INFO* orderInfo, const DSTBLT_O
 
 static BOOL update_read_patblt_order(wStream* s, const ORDER_INFO* orderInfo, PATBLT_ORDER* patblt)
 {
-	if (read_order_field_coord(orderInfo, s, 1, &patblt->nLeftRect, FALSE) &&
-	    read_order_field_coord(orderInfo, s, 2, &patblt->nTopRect, FALSE) &&
-	    read_order_field_coord(orderInfo, s, 3, &patblt->nWidth, FALSE) &&
-	    read_order_field_coord(orderInfo, s, 4, &patblt->nHeight, FALSE) &&
-	    read_order_field_byte(orderInfo, s, 5, &patblt->bRop, TRUE) &&
-	    read_order_field_color(orderInfo, s, 6, &patblt->backColor, TRUE) &&
-	    read_order_field_color(orderInfo, s, 7, &patblt->foreColor, TRUE) &&
+	if (update_read_primary_fields(s, orderInfo, patblt_fields, ARRAYSIZE(patblt_fields), 1,
+	                               patblt) &&
 	    update_read_brush(s, &patblt->brush, orderInfo->fieldFlags >> 7))
 		return TRUE;
 	return FALSE;
@@ -1248,15 +1515,8 @@ BOOL update_write_patblt_order(wStream* s, ORDER_INFO* orderInfo, PATBLT_ORDER*
 
 static BOOL update_read_scrblt_order(wStream* s, const ORDER_INFO* orderInfo, SCRBLT_ORDER* scrblt)
 {
-	if (read_order_field_coord(orderInfo, s, 1, &scrblt->nLeftRect, FALSE) &&
-	    read_order_field_coord(orderInfo, s, 2, &scrblt->nTopRect, FALSE) &&
-	    read_order_field_coord(orderInfo, s, 3, &scrblt->nWidth, FALSE) &&
-	    read_order_field_coord(orderInfo, s, 4, &scrblt->nHeight, FALSE) &&
-	    read_order_field_byte(orderInfo, s, 5, &scrblt->bRop, TRUE) &&
-	    read_order_field_coord(orderInfo, s, 6, &scrblt->nXSrc, FALSE) &&
-	    read_order_field_coord(orderInfo, s, 7, &scrblt->nYSrc, FALSE))
-		return TRUE;
-	return FALSE;
+	return update_read_primary_fields(s, orderInfo, scrblt_fields, ARRAYSIZE(scrblt_fields), 1,
+	                                  scrblt);
 }
 
 size_t update_approximate_scrblt_order(ORDER_INFO* orderInfo, const SCRBLT_ORDER* scrblt)
@@ -1291,41 +1551,8 @@ BOOL update_write_scrblt_order(wStream* s, ORDER_INFO* orderInfo, const SCRBLT_O
 static BOOL update_read_opaque_rect_order(wStream* s, const ORDER_INFO* orderInfo,
                                           OPAQUE_RECT_ORDER* opaque_rect)
 {
-	BYTE byte;
-	if (!read_order_field_coord(orderInfo, s, 1, &opaque_rect->nLeftRect, FALSE) ||
-	    !read_order_field_coord(orderInfo, s, 2, &opaque_rect->nTopRect, FALSE) ||
-	    !read_order_field_coord(orderInfo, s, 3, &opaque_rect->nWidth, FALSE) ||
-	    !read_order_field_coord(orderInfo, s, 4, &opaque_rect->nHeight, FALSE))
-		return FALSE;
-
-	if ((orderInfo->fieldFlags & ORDER_FIELD_05) != 0)
-	{
-		if (!Stream_CheckAndLogRequiredLength(TAG, s, 1))
-			return FALSE;
-
-		Stream_Read_UINT8(s, byte);
-		opaque_rect->color = (opaque_rect->color & 0x00FFFF00) | ((UINT32)byte);
-	}
-
-	if ((orderInfo->fieldFlags & ORDER_FIELD_06) != 0)
-	{
-		if (!Stream_CheckAndLogRequiredLength(TAG, s, 1))
-			return FALSE;
-
-		Stream_Read_UINT8(s, byte);
-		opaque_rect->color = (opaque_rect->color & 0x00FF00FF) | ((UINT32)byte << 8);
-	}
-
-	if ((orderInfo->fieldFlags & ORDER_FIELD_07) != 0)
-	{
-		if (!Stream_CheckAndLogRequiredLength(TAG, s, 1))
-			return FALSE;
-
-		Stream_Read_UINT8(s, byte);
-		opaque_rect->color = (opaque_rect->color & 0x0000FFFF) | ((UINT32)byte << 16);
-	}
-
-	return TRUE;
+	return update_read_primary_fields(s, orderInfo, opaque_rect_fields,
+	                                  ARRAYSIZE(opaque_rect_fields), 1, opaque_rect);
 }
 
 size_t update_approximate_opaque_rect_order(ORDER_INFO* orderInfo,
@@ -1370,24 +1597,15 @@ BOOL update_write_opaque_rect_order(wStream* s, ORDER_INFO* orderInfo,
 static BOOL update_read_draw_nine_grid_order(wStream* s, const ORDER_INFO* orderInfo,
                                              DRAW_NINE_GRID_ORDER* draw_nine_grid)
 {
-	if (read_order_field_coord(orderInfo, s, 1, &draw_nine_grid->srcLeft, FALSE) &&
-	    read_order_field_coord(orderInfo, s, 2, &draw_nine_grid->srcTop, FALSE) &&
-	    read_order_field_coord(orderInfo, s, 3, &draw_nine_grid->srcRight, FALSE) &&
-	    read_order_field_coord(orderInfo, s, 4, &draw_nine_grid->srcBottom, FALSE) &&
-	    read_order_field_uint16(orderInfo, s, 5, &draw_nine_grid->bitmapId, FALSE))
-		return TRUE;
-	return FALSE;
+	return update_read_primary_fields(s, orderInfo, draw_nine_grid_fields,
+	                                  ARRAYSIZE(draw_nine_grid_fields), 1, draw_nine_grid);
 }
 
 static BOOL update_read_multi_dstblt_order(wStream* s, const ORDER_INFO* orderInfo,
                                            MULTI_DSTBLT_ORDER* multi_dstblt)
 {
-	if (!read_order_field_coord(orderInfo, s, 1, &multi_dstblt->nLeftRect, FALSE) ||
-	    !read_order_field_coord(orderInfo, s, 2, &multi_dstblt->nTopRect, FALSE) ||
-	    !read_order_field_coord(orderInfo, s, 3, &multi_dstblt->nWidth, FALSE) ||
-	    !read_order_field_coord(orderInfo, s, 4, &multi_dstblt->nHeight, FALSE) ||
-	    !read_order_field_byte(orderInfo, s, 5, &multi_dstblt->bRop, TRUE) ||
-	    !read_order_field_byte(orderInfo, s, 6, &multi_dstblt->numRectangles, TRUE))
+	if (!update_read_primary_fields(s, orderInfo, multi_dstblt_fields,
+	                                ARRAYSIZE(multi_dstblt_fields), 1, multi_dstblt))
 		return FALSE;
 
 	if ((orderInfo->fieldFlags & ORDER_FIELD_07) != 0)
@@ -1405,13 +1623,8 @@ static BOOL update_read_multi_dstblt_order(wStream* s, const ORDER_INFO* orderIn
 static BOOL update_read_multi_patblt_order(wStream* s, const ORDER_INFO* orderInfo,
                                            MULTI_PATBLT_ORDER* multi_patblt)
 {
-	if (!read_order_field_coord(orderInfo, s, 1, &multi_patblt->nLeftRect, FALSE) ||
-	    !read_order_field_coord(orderInfo, s, 2, &multi_patblt->nTopRect, FALSE) ||
-	    !read_order_field_coord(orderInfo, s, 3, &multi_patblt->nWidth, FALSE) ||
-	    !read_order_field_coord(orderInfo, s, 4, &multi_patblt->nHeight, FALSE) ||
-	    !read_order_field_byte(orderInfo, s, 5, &multi_patblt->bRop, TRUE) ||
-	    !read_order_field_color(orderInfo, s, 6, &multi_patblt->backColor, TRUE) ||
-	    !read_order_field_color(orderInfo, s, 7, &multi_patblt->foreColor, TRUE))
+	if (!update_read_primary_fields(s, orderInfo, multi_patblt_fields,
+	                                ARRAYSIZE(multi_patblt_fields), 1, multi_patblt))
 		return FALSE;
 
 	if (!update_read_brush(s, &multi_patblt->brush, orderInfo->fieldFlags >> 7))
@@ -1437,14 +1650,8 @@ static BOOL update_read_multi_patblt_order(wStream* s, const ORDER_INFO* orderIn
 static BOOL update_read_multi_scrblt_order(wStream* s, const ORDER_INFO* orderInfo,
                                            MULTI_SCRBLT_ORDER* multi_scrblt)
 {
-	if (!read_order_field_coord(orderInfo, s, 1, &multi_scrblt->nLeftRect, FALSE) ||
-	    !read_order_field_coord(orderInfo, s, 2, &multi_scrblt->nTopRect, FALSE) ||
-	    !read_order_field_coord(orderInfo, s, 3, &multi_scrblt->nWidth, FALSE) ||
-	    !read_order_field_coord(orderInfo, s, 4, &multi_scrblt->nHeight, FALSE) ||
-	    !read_order_field_byte(orderInfo, s, 5, &multi_scrblt->bRop, TRUE) ||
-	    !read_order_field_coord(orderInfo, s, 6, &multi_scrblt->nXSrc, FALSE) ||
-	    !read_order_field_coord(orderInfo, s, 7, &multi_scrblt->nYSrc, FALSE) ||
-	    !read_order_field_byte(orderInfo, s, 8, &multi_scrblt->numRectangles, TRUE))
+	if (!update_read_primary_fields(s, orderInfo, multi_scrblt_fields,
+	                                ARRAYSIZE(multi_scrblt_fields), 1, multi_scrblt))
 		return FALSE;
 
 	if ((orderInfo->fieldFlags & ORDER_FIELD_09) != 0)
@@ -1462,41 +1669,8 @@ static BOOL update_read_multi_scrblt_order(wStream* s, const ORDER_INFO* orderIn
 static BOOL update_read_multi_opaque_rect_order(wStream* s, const ORDER_INFO* orderInfo,
                                                 MULTI_OPAQUE_RECT_ORDER* multi_opaque_rect)
 {
-	BYTE byte;
-	if (!read_order_field_coord(orderInfo, s, 1, &multi_opaque_rect->nLeftRect, FALSE) ||
-	    !read_order_field_coord(orderInfo, s, 2, &multi_opaque_rect->nTopRect, FALSE) ||
-	    !read_order_field_coord(orderInfo, s, 3, &multi_opaque_rect->nWidth, FALSE) ||
-	    !read_order_field_coord(orderInfo, s, 4, &multi_opaque_rect->nHeight, FALSE))
-		return FALSE;
-
-	if ((orderInfo->fieldFlags & ORDER_FIELD_05) != 0)
-	{
-		if (!Stream_CheckAndLogRequiredLength(TAG, s, 1))
-			return FALSE;
-
-		Stream_Read_UINT8(s, byte);
-		multi_opaque_rect->color = (multi_opaque_rect->color & 0x00FFFF00) | ((UINT32)byte);
-	}
-
-	if ((orderInfo->fieldFlags & ORDER_FIELD_06) != 0)
-	{
-		if (!Stream_CheckAndLogRequiredLength(TAG, s, 1))
-			return FALSE;
-
-		Stream_Read_UINT8(s, byte);
-		multi_opaque_rect->color = (multi_opaque_rect->color & 0x00FF00FF) | ((UINT32)byte << 8);
-	}
-
-	if ((orderInfo->fieldFlags & ORDER_FIELD_07) != 0)
-	{
-		if (!Stream_CheckAndLogRequiredLength(TAG, s, 1))
-			return FALSE;
-
-		Stream_Read_UINT8(s, byte);
-		multi_opaque_rect->color = (multi_opaque_rect->color & 0x0000FFFF) | ((UINT32)byte << 16);
-	}
-
-	if (!read_order_field_byte(orderInfo, s, 8, &multi_opaque_rect->numRectangles, TRUE))
+	if (!update_read_primary_fields(s, orderInfo, multi_opaque_rect_fields,
+	                                ARRAYSIZE(multi_opaque_rect_fields), 1, multi_opaque_rect))
 		return FALSE;
 
 	if ((orderInfo->fieldFlags & ORDER_FIELD_09) != 0)
@@ -1538,18 +1712,8 @@ static BOOL update_read_multi_draw_nine_grid_order(wStream* s, const ORDER_INFO*
 static BOOL update_read_line_to_order(wStream* s, const ORDER_INFO* orderInfo,
                                       LINE_TO_ORDER* line_to)
 {
-	if (read_order_field_uint16(orderInfo, s, 1, &line_to->backMode, TRUE) &&
-	    read_order_field_coord(orderInfo, s, 2, &line_to->nXStart, FALSE) &&
-	    read_order_field_coord(orderInfo, s, 3, &line_to->nYStart, FALSE) &&
-	    read_order_field_coord(orderInfo, s, 4, &line_to->nXEnd, FALSE) &&
-	    read_order_field_coord(orderInfo, s, 5, &line_to->nYEnd, FALSE) &&
-	    read_order_field_color(orderInfo, s, 6, &line_to->backColor, TRUE) &&
-	    read_order_field_byte(orderInfo, s, 7, &line_to->bRop2, TRUE) &&
-	    read_order_field_byte(orderInfo, s, 8, &line_to->penStyle, TRUE) &&
-	    read_order_field_byte(orderInfo, s, 9, &line_to->penWidth, TRUE) &&
-	    read_order_field_color(orderInfo, s, 10, &line_to->penColor, TRUE))
-		return TRUE;
-	return FALSE;
+	return update_read_primary_fields(s, orderInfo, line_to_fields, ARRAYSIZE(line_to_fields), 1,
+	                                  line_to);
 }
 
 size_t update_approximate_line_to_order(ORDER_INFO* orderInfo, const LINE_TO_ORDER* line_to)
@@ -1634,15 +1798,8 @@ static BOOL update_read_memblt_order(wStream* s, const ORDER_INFO* orderInfo, ME
 	if (!s || !orderInfo || !memblt)
 		return FALSE;
 
-	if (!read_order_field_uint16(orderInfo, s, 1, &memblt->cacheId, TRUE) ||
-	    !read_order_field_coord(orderInfo, s, 2, &memblt->nLeftRect, FALSE) ||
-	    !read_order_field_coord(orderInfo, s, 3, &memblt->nTopRect, FALSE) ||
-	    !read_order_field_coord(orderInfo, s, 4, &memblt->nWidth, FALSE) ||
-	    !read_order_field_coord(orderInfo, s, 5, &memblt->nHeight, FALSE) ||
-	    !read_order_field_byte(orderInfo, s, 6, &memblt->bRop, TRUE) ||
-	    !read_order_field_coord(orderInfo, s, 7, &memblt->nXSrc, FALSE) ||
-	    !read_order_field_coord(orderInfo, s, 8, &memblt->nYSrc, FALSE) ||
-	    !read_order_field_uint16(orderInfo, s, 9, &memblt->cacheIndex, TRUE))
+	if (!update_read_primary_fields(s, orderInfo, memblt_fields, ARRAYSIZE(memblt_fields), 1,
+	                                memblt))
 		return FALSE;
 	memblt->colorIndex = (memblt->cacheId >> 8);
 	memblt->cacheId = (memblt->cacheId & 0xFF);
@@ -1688,20 +1845,13 @@ BOOL update_write_memblt_order(wStream* s, ORDER_INFO* orderInfo, const MEMBLT_O
 static BOOL update_read_mem3blt_order(wStream* s, const ORDER_INFO* orderInfo,
                                       MEM3BLT_ORDER* mem3blt)
 {
-	if (!read_order_field_uint16(orderInfo, s, 1, &mem3blt->cacheId, TRUE) ||
-	    !read_order_field_coord(orderInfo, s, 2, &mem3blt->nLeftRect, FALSE) ||
-	    !read_order_field_coord(orderInfo, s, 3, &mem3blt->nTopRect, FALSE) ||
-	    !read_order_field_coord(orderInfo, s, 4, &mem3blt->nWidth, FALSE) ||
-	    !read_order_field_coord(orderInfo, s, 5, &mem3blt->nHeight, FALSE) ||
-	    !read_order_field_byte(orderInfo, s, 6, &mem3blt->bRop, TRUE) ||
-	    !read_order_field_coord(orderInfo, s, 7, &mem3blt->nXSrc, FALSE) ||
-	    !read_order_field_coord(orderInfo, s, 8, &mem3blt->nYSrc, FALSE) ||
-	    !read_order_field_color(orderInfo, s, 9, &mem3blt->backColor, TRUE) ||
-	    !read_order_field_color(orderInfo, s, 10, &mem3blt->foreColor, TRUE))
+	if (!update_read_primary_fields(s, orderInfo, mem3blt_fields, ARRAYSIZE(mem3blt_fields), 1,
+	                                mem3blt))
 		return FALSE;
 
 	if (!update_read_brush(s, &mem3blt->brush, orderInfo->fieldFlags >> 10) ||
-	    !read_order_field_uint16(orderInfo, s, 16, &mem3blt->cacheIndex, TRUE))
+	    !update_read_primary_fields(s, orderInfo, mem3blt_index_fields,
+	                                ARRAYSIZE(mem3blt_index_fields), 16, mem3blt))
 		return FALSE;
 	mem3blt->colorIndex = (mem3blt->cacheId >> 8);
 	mem3blt->cacheId = (mem3blt->cacheId & 0xFF);
@@ -1711,35 +1861,17 @@ static BOOL update_read_mem3blt_order(wStream* s, const ORDER_INFO* orderInfo,
 static BOOL update_read_save_bitmap_order(wStream* s, const ORDER_INFO* orderInfo,
                                           SAVE_BITMAP_ORDER* save_bitmap)
 {
-	if (read_order_field_uint32(orderInfo, s, 1, &save_bitmap->savedBitmapPosition, TRUE) &&
-	    read_order_field_coord(orderInfo, s, 2, &save_bitmap->nLeftRect, FALSE) &&
-	    read_order_field_coord(orderInfo, s, 3, &save_bitmap->nTopRect, FALSE) &&
-	    read_order_field_coord(orderInfo, s, 4, &save_bitmap->nRightRect, FALSE) &&
-	    read_order_field_coord(orderInfo, s, 5, &save_bitmap->nBottomRect, FALSE) &&
-	    read_order_field_byte(orderInfo, s, 6, &save_bitmap->operation, TRUE))
-		return TRUE;
-	return FALSE;
+	return update_read_primary_fields(s, orderInfo, save_bitmap_fields,
+	                                  ARRAYSIZE(save_bitmap_fields), 1, save_bitmap);
 }
 static BOOL update_read_glyph_index_order(wStream* s, const ORDER_INFO* orderInfo,
                                           GLYPH_INDEX_ORDER* glyph_index)
 {
-	if (!read_order_field_byte(orderInfo, s, 1, &glyph_index->cacheId, TRUE) ||
-	    !read_order_field_byte(orderInfo, s, 2, &glyph_index->flAccel, TRUE) ||
-	    !read_order_field_byte(orderInfo, s, 3, &glyph_index->ulCharInc, TRUE) ||
-	    !read_order_field_byte(orderInfo, s, 4, &glyph_index->fOpRedundant, TRUE) ||
-	    !read_order_field_color(orderInfo, s, 5, &glyph_index->backColor, TRUE) ||
-	    !read_order_field_color(orderInfo, s, 6, &glyph_index->foreColor, TRUE) ||
-	    !read_order_field_int16(orderInfo, s, 7, &glyph_index->bkLeft, TRUE) ||
-	    !read_order_field_int16(orderInfo, s, 8, &glyph_index->bkTop, TRUE) ||
-	    !read_order_field_int16(orderInfo, s, 9, &glyph_index->bkRight, TRUE) ||
-	    !read_order_field_int16(orderInfo, s, 10, &glyph_index->bkBottom, TRUE) ||
-	    !read_order_field_int16(orderInfo, s, 11, &glyph_index->opLeft, TRUE) ||
-	    !read_order_field_int16(orderInfo, s, 12, &glyph_index->opTop, TRUE) ||
-	    !read_order_field_int16(orderInfo, s, 13, &glyph_index->opRight, TRUE) ||
-	    !read_order_field_int16(orderInfo, s, 14, &glyph_index->opBottom, TRUE) ||
+	if (!update_read_primary_fields(s, orderInfo, glyph_index_fields,
+	                                ARRAYSIZE(glyph_index_fields), 1, glyph_index) ||
 	    !update_read_brush(s, &glyph_index->brush, orderInfo->fieldFlags >> 14) ||
-	    !read_order_field_int16(orderInfo, s, 20, &glyph_index->x, TRUE) ||
-	    !read_order_field_int16(orderInfo, s, 21, &glyph_index->y, TRUE))
+	    !update_read_primary_fields(s, orderInfo, glyph_index_position_fields,
+	                                ARRAYSIZE(glyph_index_position_fields), 20, glyph_index))
 		return FALSE;
 
 	if ((orderInfo->fieldFlags & ORDER_FIELD_22) != 0)
@@ -1165,6 +1165,7 @@ BOOL freerdp_peer_context_new_ex(freerdp_peer* client, const rdpSettings* settin
 	context->update = rdp->update;
 	context->settings = rdp->settings;
 	context->autodetect = rdp->autodetect;
+	context->multitransport = rdp->multitransport;
 	update_register_server_callbacks(rdp->update);
 	autodetect_register_server_callbacks(rdp->autodetect);
 
@@ -1197,7 +1197,13 @@ int rdp_recv_message_channel_pdu(rdpRdp* rdp, wStream* s, UINT16 securityFlags)
 	if (securityFlags & SEC_TRANSPORT_REQ)
 	{
 		/* Initiate Multitransport Request PDU */
-		return rdp_recv_multitransport_packet(rdp, s);
+		return rdp_recv_multitransport_request_packet(rdp, s);
+	}
+
+	if (securityFlags & SEC_TRANSPORT_RSP)
+	{
+		/* Initiate Multitransport Response PDU */
+		return rdp_recv_multitransport_response_packet(rdp, s);
 	}
 
 	return -1;
@@ -1696,19 +1702,15 @@ int rdp_recv_callback(rdpTransport* transport, wStream* s, void* extra)
 			break;
 
 		case CONNECTION_STATE_MCS_ATTACH_USER:
-			if (!mcs_recv_attach_user_confirm(rdp->mcs, s))
-			{
-				WLog_ERR(TAG, "mcs_recv_attach_user_confirm failure");
-				return -1;
-			}
-
-			if (!mcs_send_channel_join_request(rdp->mcs, rdp->mcs->userId))
+			if (!rdp_client_connect_mcs_attach_user_confirm(rdp, s))
 			{
-				WLog_ERR(TAG, "mcs_send_channel_join_request failure");
-				return -1;
+				WLog_ERR(TAG,
+				         "%s: %s - "
+				         "rdp_client_connect_mcs_attach_user_confirm() fail",
+				         __FUNCTION__, rdp_get_state_string(rdp));
+				status = -1;
 			}
 
-			rdp_client_transition_to_state(rdp, CONNECTION_STATE_MCS_CHANNEL_JOIN);
 			break;
 
 		case CONNECTION_STATE_MCS_CHANNEL_JOIN:
@@ -1971,7 +1973,7 @@ rdpRdp* rdp_new(rdpContext* context)
 	if (!rdp->heartbeat)
 		goto fail;
 
-	rdp->multitransport = multitransport_new();
+	rdp->multitransport = multitransport_new(rdp->context);
 
 	if (!rdp->multitransport)
 		goto fail;
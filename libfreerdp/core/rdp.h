@@ -152,6 +152,8 @@ typedef enum
 struct rdp_rdp
 {
 	CONNECTION_STATE state;
+	UINT64 stateStartTime;   /* GetTickCount64 when state was entered */
+	UINT64 connectStartTime; /* GetTickCount64 when the connect began, 0 once active */
 	rdpContext* context;
 	rdpNla* nla;
 	rdpMcs* mcs;
@@ -1503,27 +1503,63 @@ BOOL WINAPI FreeRDP_WTSVirtualChannelRead(HANDLE hChannelHandle, ULONG TimeOut,
 	return TRUE;
 }
 
-BOOL WINAPI FreeRDP_WTSVirtualChannelWrite(HANDLE hChannelHandle, PCHAR Buffer, ULONG Length,
-                                           PULONG pBytesWritten)
+/* Copy the next length bytes of a buffer list to dst and advance the cursor. */
+static void wts_buffers_read(const WTS_VIRTUAL_CHANNEL_BUFFER** pBuffer, size_t* pOffset, BYTE* dst,
+                             size_t length)
+{
+	const WTS_VIRTUAL_CHANNEL_BUFFER* buffer = *pBuffer;
+	size_t offset = *pOffset;
+
+	while (length > 0)
+	{
+		const size_t count = MIN(length, buffer->length - offset);
+		CopyMemory(dst, &buffer->data[offset], count);
+		dst += count;
+		length -= count;
+		offset += count;
+
+		if (offset == buffer->length)
+		{
+			buffer++;
+			offset = 0;
+		}
+	}
+
+	*pBuffer = buffer;
+	*pOffset = offset;
+}
+
+BOOL WINAPI FreeRDP_WTSVirtualChannelWriteGather(HANDLE hChannelHandle,
+                                                 const WTS_VIRTUAL_CHANNEL_BUFFER* buffers,
+                                                 size_t count, PULONG pBytesWritten)
 {
 	wStream* s;
 	int cbLen;
 	int cbChId;
 	int first;
+	size_t index;
+	size_t offset = 0;
 	BYTE* buffer;
 	UINT32 length;
 	UINT32 written;
 	UINT32 totalWritten = 0;
+	UINT64 Length = 0;
 	rdpPeerChannel* channel = (rdpPeerChannel*)hChannelHandle;
 	BOOL ret = TRUE;
 
-	if (!channel)
+	if (!channel || (!buffers && (count > 0)))
+		return FALSE;
+
+	for (index = 0; index < count; index++)
+		Length += buffers[index].length;
+
+	if (Length > UINT32_MAX)
 		return FALSE;
 
 	WINPR_ASSERT(channel->vcm);
 	if (channel->channelType == RDP_PEER_CHANNEL_TYPE_SVC)
 	{
-		length = Length;
+		length = (UINT32)Length;
 		buffer = (BYTE*)malloc(length);
 
 		if (!buffer)
@@ -1532,8 +1568,8 @@ BOOL WINAPI FreeRDP_WTSVirtualChannelWrite(HANDLE hChannelHandle, PCHAR Buffer,
 			return FALSE;
 		}
 
-		CopyMemory(buffer, Buffer, length);
-		totalWritten = Length;
+		wts_buffers_read(&buffers, &offset, buffer, length);
+		totalWritten = length;
 		ret = wts_queue_send_item(channel, buffer, length);
 	}
 	else if (!channel->vcm->drdynvc_channel || (channel->vcm->drdynvc_state != DRDYNVC_STATE_READY))
@@ -1567,7 +1603,7 @@ BOOL WINAPI FreeRDP_WTSVirtualChannelWrite(HANDLE hChannelHandle, PCHAR Buffer,
 
 			if (first && (Length > (UINT32)Stream_GetRemainingLength(s)))
 			{
-				cbLen = wts_write_variable_uint(s, Length);
+				cbLen = wts_write_variable_uint(s, (UINT32)Length);
 				buffer[0] = (DATA_FIRST_PDU << 4) | (cbLen << 2) | cbChId;
 			}
 			else
@@ -1579,13 +1615,14 @@ BOOL WINAPI FreeRDP_WTSVirtualChannelWrite(HANDLE hChannelHandle, PCHAR Buffer,
 			written = Stream_GetRemainingLength(s);
 
 			if (written > Length)
-				written = Length;
+				written = (UINT32)Length;
 
-			Stream_Write(s, Buffer, written);
+			/* the chunk is the only copy of the data until it is sent */
+			wts_buffers_read(&buffers, &offset, Stream_Pointer(s), written);
+			Stream_Seek(s, written);
 			length = Stream_GetPosition(s);
 			Stream_Free(s, FALSE);
 			Length -= written;
-			Buffer += written;
 			totalWritten += written;
 			ret = wts_queue_send_item(channel->vcm->drdynvc_channel, buffer, length);
 		}
@@ -1597,6 +1634,15 @@ BOOL WINAPI FreeRDP_WTSVirtualChannelWrite(HANDLE hChannelHandle, PCHAR Buffer,
 	return ret;
 }
 
+BOOL WINAPI FreeRDP_WTSVirtualChannelWrite(HANDLE hChannelHandle, PCHAR Buffer, ULONG Length,
+                                           PULONG pBytesWritten)
+{
+	WTS_VIRTUAL_CHANNEL_BUFFER buffer;
+	buffer.data = (const BYTE*)Buffer;
+	buffer.length = Length;
+	return FreeRDP_WTSVirtualChannelWriteGather(hChannelHandle, &buffer, 1, pBytesWritten);
+}
+
 BOOL WINAPI FreeRDP_WTSVirtualChannelPurgeInput(HANDLE hChannelHandle)
 {
 	return TRUE;
@@ -345,6 +345,7 @@ rdpSettings* freerdp_settings_new(DWORD flags)
 	            RAIL_LEVEL_HIDE_MINIMIZED_APPS_SUPPORTED | RAIL_LEVEL_WINDOW_CLOAKING_SUPPORTED |
 	            RAIL_LEVEL_HANDSHAKE_EX_SUPPORTED) ||
 	    !freerdp_settings_set_bool(settings, FreeRDP_SupportHeartbeatPdu, TRUE) ||
+	    !freerdp_settings_set_bool(settings, FreeRDP_SupportSkipChannelJoin, TRUE) ||
 	    !freerdp_settings_set_bool(settings, FreeRDP_ServerMode,
 	                               (flags & FREERDP_SETTINGS_SERVER_MODE) ? TRUE : FALSE) ||
 	    !freerdp_settings_set_bool(settings, FreeRDP_WaitForOutputBufferFlush, TRUE) ||
@@ -0,0 +1,271 @@
+#include <stdio.h>
+
+#include <winpr/crt.h>
+#include <winpr/synch.h>
+#include <winpr/stream.h>
+
+#include <freerdp/freerdp.h>
+
+#include "../rdp.h"
+#include "../input.h"
+#include "../fastpath.h"
+#include "../connection.h"
+
+#include "helpers.h"
+
+static BOOL test_read_event_header(wStream* s, BYTE eventCode, BYTE eventFlags)
+{
+	BYTE header;
+
+	if (Stream_GetRemainingLength(s) < 1)
+		return FALSE;
+
+	Stream_Read_UINT8(s, header);
+
+	if ((header >> 5) != eventCode)
+	{
+		fprintf(stderr, "expected event code %" PRIu8 ", got %" PRIu8 "\n", eventCode,
+		        header >> 5);
+		return FALSE;
+	}
+
+	return (header & 0x1F) == eventFlags;
+}
+
+static BOOL test_read_mouse_event(wStream* s, UINT16 flags, UINT16 x, UINT16 y)
+{
+	UINT16 rflags, rx, ry;
+
+	if (!test_read_event_header(s, FASTPATH_INPUT_EVENT_MOUSE, 0))
+		return FALSE;
+
+	if (Stream_GetRemainingLength(s) < 6)
+		return FALSE;
+
+	Stream_Read_UINT16(s, rflags);
+	Stream_Read_UINT16(s, rx);
+	Stream_Read_UINT16(s, ry);
+
+	if ((rflags != flags) || (rx != x) || (ry != y))
+	{
+		fprintf(stderr,
+		        "expected mouse event 0x%04" PRIx16 " %" PRIu16 "x%" PRIu16 ", got 0x%04" PRIx16
+		        " %" PRIu16 "x%" PRIu16 "\n",
+		        flags, x, y, rflags, rx, ry);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static BOOL test_read_scancode_event(wStream* s, BYTE code)
+{
+	BYTE rcode;
+
+	if (!test_read_event_header(s, FASTPATH_INPUT_EVENT_SCANCODE, 0))
+		return FALSE;
+
+	if (Stream_GetRemainingLength(s) < 1)
+		return FALSE;
+
+	Stream_Read_UINT8(s, rcode);
+	return rcode == code;
+}
+
+static wStream* test_read_pdu(size_t numberEvents)
+{
+	BYTE header;
+	UINT16 length;
+	wStream* s = test_written_get(test_written_count() - 1);
+
+	if (!s || (Stream_GetRemainingLength(s) < 3))
+		return NULL;
+
+	Stream_Read_UINT8(s, header);
+	Stream_Read_UINT16_BE(s, length);
+
+	if ((header & 0x03) != FASTPATH_INPUT_ACTION_FASTPATH)
+		return NULL;
+
+	if (((header >> 2) & 0x0F) != numberEvents)
+	{
+		fprintf(stderr, "expected %" PRIuz " events, got %" PRIu8 "\n", numberEvents,
+		        (BYTE)((header >> 2) & 0x0F));
+		return NULL;
+	}
+
+	if ((length & 0x7FFF) != Stream_Length(s))
+		return NULL;
+
+	return s;
+}
+
+static BOOL test_batch_full(rdpInput* input)
+{
+	size_t x;
+	wStream* s;
+
+	test_written_clear();
+
+	/* 4 events after coalescing: move, button down, move, button up */
+	for (x = 1; x <= 5; x++)
+	{
+		if (!freerdp_input_send_mouse_event(input, PTR_FLAGS_MOVE, (UINT16)x, 10))
+			return FALSE;
+	}
+
+	if (!freerdp_input_send_mouse_event(input, PTR_FLAGS_DOWN | PTR_FLAGS_BUTTON1, 5, 10))
+		return FALSE;
+
+	for (x = 6; x <= 8; x++)
+	{
+		if (!freerdp_input_send_mouse_event(input, PTR_FLAGS_MOVE, (UINT16)x, 20))
+			return FALSE;
+	}
+
+	if (!freerdp_input_send_mouse_event(input, PTR_FLAGS_BUTTON1, 8, 20))
+		return FALSE;
+
+	/* 11 more events fill the batch to FASTPATH_INPUT_MAX_EVENTS */
+	for (x = 0; x < 10; x++)
+	{
+		if (test_written_count() != 0)
+		{
+			fprintf(stderr, "batch sent before it was full\n");
+			return FALSE;
+		}
+
+		if (!freerdp_input_send_keyboard_event(input, 0, (UINT8)(0x10 + x)))
+			return FALSE;
+	}
+
+	if (test_written_count() != 0)
+	{
+		fprintf(stderr, "batch sent before it was full\n");
+		return FALSE;
+	}
+
+	if (!freerdp_input_send_keyboard_event(input, 0, 0x1A))
+		return FALSE;
+
+	if (test_written_count() != 1)
+	{
+		fprintf(stderr, "expected a single PDU for a full batch, got %" PRIuz "\n",
+		        test_written_count());
+		return FALSE;
+	}
+
+	s = test_read_pdu(FASTPATH_INPUT_MAX_EVENTS);
+
+	if (!s)
+		return FALSE;
+
+	if (!test_read_mouse_event(s, PTR_FLAGS_MOVE, 5, 10) ||
+	    !test_read_mouse_event(s, PTR_FLAGS_DOWN | PTR_FLAGS_BUTTON1, 5, 10) ||
+	    !test_read_mouse_event(s, PTR_FLAGS_MOVE, 8, 20) ||
+	    !test_read_mouse_event(s, PTR_FLAGS_BUTTON1, 8, 20))
+		return FALSE;
+
+	for (x = 0; x < 11; x++)
+	{
+		if (!test_read_scancode_event(s, (BYTE)(0x10 + x)))
+			return FALSE;
+	}
+
+	return Stream_GetRemainingLength(s) == 0;
+}
+
+static BOOL test_batch_latency(rdpContext* context)
+{
+	wStream* s;
+	HANDLE timer;
+	rdpInput* input = context->input;
+
+	test_written_clear();
+
+	if (!freerdp_settings_set_uint32(context->settings, FreeRDP_FastPathInputBatchLatency, 20))
+		return FALSE;
+
+	if (!freerdp_input_send_mouse_event(input, PTR_FLAGS_MOVE, 100, 200) ||
+	    !freerdp_input_send_mouse_event(input, PTR_FLAGS_MOVE, 101, 201))
+		return FALSE;
+
+	if (test_written_count() != 0)
+	{
+		fprintf(stderr, "batch sent before the latency expired\n");
+		return FALSE;
+	}
+
+	timer = input_get_batch_event_handle(input);
+
+	if (!timer || (WaitForSingleObject(timer, 5000) != WAIT_OBJECT_0))
+	{
+		fprintf(stderr, "batch timer did not fire\n");
+		return FALSE;
+	}
+
+	/* The timer may fire a little early, input_check_batch re-arms it in that case */
+	while (test_written_count() == 0)
+	{
+		if (!input_check_batch(input))
+			return FALSE;
+
+		if (test_written_count() == 0)
+			Sleep(1);
+	}
+
+	if (test_written_count() != 1)
+		return FALSE;
+
+	s = test_read_pdu(1);
+
+	if (!s)
+		return FALSE;
+
+	if (!test_read_mouse_event(s, PTR_FLAGS_MOVE, 101, 201))
+		return FALSE;
+
+	return Stream_GetRemainingLength(s) == 0;
+}
+
+int TestInputBatch(int argc, char* argv[])
+{
+	int rc = -1;
+	rdpContext* context;
+	freerdp* instance = test_instance_new(FALSE);
+
+	WINPR_UNUSED(argc);
+	WINPR_UNUSED(argv);
+
+	if (!instance)
+		return -1;
+
+	context = instance->context;
+
+	if (!freerdp_settings_set_bool(context->settings, FreeRDP_FastPathInput, TRUE) ||
+	    !freerdp_settings_set_uint32(context->settings, FreeRDP_FastPathInputBatchLatency, 10000))
+		goto fail;
+
+	if (!input_register_client_callbacks(context->input))
+		goto fail;
+
+	rdp_client_transition_to_state(context->rdp, CONNECTION_STATE_ACTIVE);
+
+	if (!test_batch_full(context->input))
+	{
+		fprintf(stderr, "test_batch_full failed\n");
+		goto fail;
+	}
+
+	if (!test_batch_latency(context))
+	{
+		fprintf(stderr, "test_batch_latency failed\n");
+		goto fail;
+	}
+
+	rc = 0;
+fail:
+	test_written_clear();
+	test_instance_free(instance);
+	return rc;
+}
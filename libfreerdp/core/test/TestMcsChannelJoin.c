@@ -0,0 +1,214 @@
+#include <stdio.h>
+
+#include <winpr/crt.h>
+#include <winpr/stream.h>
+
+#include <freerdp/freerdp.h>
+
+#include "../rdp.h"
+#include "../mcs.h"
+#include "../connection.h"
+
+#include "helpers.h"
+
+#define TEST_MESSAGE_CHANNEL 1010
+#define TEST_STATIC_CHANNEL 1011
+#define TEST_STATIC_CHANNELS 3
+
+/* a client that negotiated a message channel and a few static channels */
+static freerdp* test_client_new(BOOL skipChannelJoin)
+{
+	UINT32 x;
+	rdpMcs* mcs;
+	freerdp* client = test_instance_new(FALSE);
+
+	if (!client)
+		return NULL;
+
+	mcs = client->context->rdp->mcs;
+	mcs->skipChannelJoin = skipChannelJoin;
+	mcs->messageChannelId = TEST_MESSAGE_CHANNEL;
+	mcs->channelCount = TEST_STATIC_CHANNELS;
+
+	for (x = 0; x < mcs->channelCount; x++)
+		mcs->channels[x].ChannelId = (UINT16)(TEST_STATIC_CHANNEL + x);
+
+	return client;
+}
+
+static BOOL test_state(rdpRdp* rdp, CONNECTION_STATE state)
+{
+	if (rdp_get_state(rdp) == state)
+		return TRUE;
+
+	fprintf(stderr, "unexpected connection state %s\n", rdp_get_state_string(rdp));
+	return FALSE;
+}
+
+/* the server confirms the attach user request, the client continues the sequence */
+static BOOL test_attach_user(rdpRdp* server, rdpRdp* client)
+{
+	BOOL rc;
+	wStream* s;
+
+	test_written_clear();
+
+	if (!mcs_send_attach_user_confirm(server->mcs) || (test_written_count() != 1))
+		return FALSE;
+
+	s = test_written_pop();
+
+	rc = rdp_client_connect_mcs_attach_user_confirm(client, s);
+	Stream_Free(s, TRUE);
+	return rc && (client->mcs->userId == server->mcs->userId);
+}
+
+static BOOL test_join_confirm(rdpRdp* server, rdpRdp* client, UINT16 channelId)
+{
+	BOOL rc;
+	wStream* s;
+	const size_t count = test_written_count();
+
+	if (!mcs_send_channel_join_confirm(server->mcs, channelId) ||
+	    (test_written_count() != count + 1))
+		return FALSE;
+
+	s = test_written_pop();
+	rc = rdp_client_connect_mcs_channel_join_confirm(client, s);
+	Stream_Free(s, TRUE);
+	return rc;
+}
+
+static BOOL test_skip_join(rdpRdp* server)
+{
+	UINT32 x;
+	BOOL rc = FALSE;
+	freerdp* instance = test_client_new(TRUE);
+	rdpRdp* client;
+
+	if (!instance)
+		return FALSE;
+
+	client = instance->context->rdp;
+
+	if (!test_attach_user(server, client))
+		goto fail;
+
+	/* no join request, the client info follows the attach user confirm */
+	if ((test_written_count() != 1) || !test_state(client, CONNECTION_STATE_LICENSING))
+		goto fail;
+
+	if (!client->mcs->userChannelJoined || !client->mcs->globalChannelJoined ||
+	    !client->mcs->messageChannelJoined)
+		goto fail;
+
+	for (x = 0; x < client->mcs->channelCount; x++)
+	{
+		if (!client->mcs->channels[x].joined)
+			goto fail;
+	}
+
+	rc = TRUE;
+fail:
+	test_written_clear();
+	test_instance_free(instance);
+	return rc;
+}
+
+static BOOL test_join(rdpRdp* server)
+{
+	size_t x;
+	BOOL rc = FALSE;
+	UINT16 channels[3 + TEST_STATIC_CHANNELS] = { 0 };
+	freerdp* instance = test_client_new(FALSE);
+	rdpRdp* client;
+
+	if (!instance)
+		return FALSE;
+
+	client = instance->context->rdp;
+
+	if (!test_attach_user(server, client))
+		goto fail;
+
+	/* all join requests are sent at once */
+	if ((test_written_count() != ARRAYSIZE(channels)) ||
+	    !test_state(client, CONNECTION_STATE_MCS_CHANNEL_JOIN))
+		goto fail;
+
+	for (x = 0; x < ARRAYSIZE(channels); x++)
+	{
+		if (!mcs_recv_channel_join_request(server->mcs, test_written_get(x), &channels[x]))
+			goto fail;
+	}
+
+	if ((channels[0] != client->mcs->userId) || (channels[1] != MCS_GLOBAL_CHANNEL_ID) ||
+	    (channels[2] != TEST_MESSAGE_CHANNEL))
+		goto fail;
+
+	for (x = 0; x < TEST_STATIC_CHANNELS; x++)
+	{
+		if (channels[3 + x] != TEST_STATIC_CHANNEL + x)
+			goto fail;
+	}
+
+	test_written_clear();
+
+	/* the confirms are matched by channel id, not by the order of the requests */
+	for (x = ARRAYSIZE(channels); x > 1; x--)
+	{
+		if (!test_join_confirm(server, client, channels[x - 1]) ||
+		    !test_state(client, CONNECTION_STATE_MCS_CHANNEL_JOIN) || (test_written_count() != 0))
+			goto fail;
+	}
+
+	/* a second confirm for a joined channel is rejected */
+	if (test_join_confirm(server, client, channels[1]))
+	{
+		fprintf(stderr, "duplicate channel join confirm accepted\n");
+		goto fail;
+	}
+
+	/* the last confirm sends the client info */
+	if (!test_join_confirm(server, client, channels[0]) || (test_written_count() != 1) ||
+	    !test_state(client, CONNECTION_STATE_LICENSING))
+		goto fail;
+
+	rc = TRUE;
+fail:
+	test_written_clear();
+	test_instance_free(instance);
+	return rc;
+}
+
+int TestMcsChannelJoin(int argc, char* argv[])
+{
+	int rc = -1;
+	freerdp* server;
+
+	WINPR_UNUSED(argc);
+	WINPR_UNUSED(argv);
+
+	server = test_instance_new(TRUE);
+
+	if (!server)
+		goto fail;
+
+	if (!test_skip_join(server->context->rdp))
+	{
+		fprintf(stderr, "test_skip_join failed\n");
+		goto fail;
+	}
+
+	if (!test_join(server->context->rdp))
+	{
+		fprintf(stderr, "test_join failed\n");
+		goto fail;
+	}
+
+	rc = 0;
+fail:
+	test_written_clear();
+	test_instance_free(server);
+	return rc;
+}
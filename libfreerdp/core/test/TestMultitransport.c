@@ -0,0 +1,281 @@
+#include <stdio.h>
+
+#include <winpr/crt.h>
+#include <winpr/stream.h>
+
+#include <freerdp/freerdp.h>
+#include <freerdp/peer.h>
+#include <freerdp/multitransport.h>
+
+#include "../rdp.h"
+#include "../gcc.h"
+#include "../mcs.h"
+
+#include "helpers.h"
+
+#define TEST_MESSAGE_CHANNEL 1007
+
+static UINT32 requestId = 0;
+static UINT16 requestedProtocol = 0;
+static BYTE securityCookie[16] = { 0 };
+static HRESULT hrResponse = S_OK;
+static size_t callbacks = 0;
+
+static BOOL test_request(rdpContext* context, UINT32 id, UINT16 protocol, const BYTE* cookie)
+{
+	WINPR_UNUSED(context);
+	requestId = id;
+	requestedProtocol = protocol;
+	memcpy(securityCookie, cookie, sizeof(securityCookie));
+	callbacks++;
+	return TRUE;
+}
+
+static BOOL test_response(rdpContext* context, UINT32 id, HRESULT hr)
+{
+	WINPR_UNUSED(context);
+	requestId = id;
+	hrResponse = hr;
+	callbacks++;
+	return TRUE;
+}
+
+/* both sides share the message channel */
+static freerdp* test_peer_new(BOOL server)
+{
+	freerdp* instance = test_instance_new(server);
+
+	if (!instance)
+		return NULL;
+
+	instance->context->rdp->mcs->userId = MCS_BASE_CHANNEL_ID + 1;
+	instance->context->rdp->mcs->messageChannelId = TEST_MESSAGE_CHANNEL;
+	return instance;
+}
+
+/* hand the last written PDU to the other side */
+static BOOL test_receive(rdpContext* context, UINT16 expectedFlags)
+{
+	UINT16 length;
+	UINT16 channelId;
+	UINT16 securityFlags;
+	BOOL rc = FALSE;
+	wStream* s = test_written_pop();
+
+	test_written_clear();
+
+	if (!s)
+		return FALSE;
+
+	if (!rdp_read_header(context->rdp, s, &length, &channelId) ||
+	    !rdp_read_security_header(s, &securityFlags, &length))
+		goto fail;
+
+	if ((channelId != TEST_MESSAGE_CHANNEL) || (securityFlags != expectedFlags))
+	{
+		fprintf(stderr, "PDU on channel %" PRIu16 " with flags 0x%04" PRIx16 "\n", channelId,
+		        securityFlags);
+		goto fail;
+	}
+
+	rc = rdp_recv_message_channel_pdu(context->rdp, s, securityFlags) == 0;
+fail:
+	Stream_Free(s, TRUE);
+	return rc;
+}
+
+/* the request is written, parsed and declined by a client without a transport */
+static BOOL test_request_declined(rdpContext* server, rdpContext* client)
+{
+	freerdp_peer peer = { 0 };
+	const BYTE cookie[16] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+		                      0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10 };
+
+	peer.context = server;
+	server->multitransport->MultitransportResponse = test_response;
+
+	if (!freerdp_multitransport_send_request(&peer, 23, INITIATE_REQUEST_PROTOCOL_UDPFECR,
+	                                         cookie))
+		return FALSE;
+
+	if (!test_receive(client, SEC_TRANSPORT_REQ))
+		return FALSE;
+
+	if ((client->multitransport->requestId != 23) ||
+	    (client->multitransport->requestedProtocol != INITIATE_REQUEST_PROTOCOL_UDPFECR) ||
+	    (memcmp(client->multitransport->securityCookie, cookie, sizeof(cookie)) != 0))
+	{
+		fprintf(stderr, "request not parsed\n");
+		return FALSE;
+	}
+
+	/* the client answered at once */
+	callbacks = 0;
+
+	if (!test_receive(server, SEC_TRANSPORT_RSP))
+		return FALSE;
+
+	return (callbacks == 1) && (requestId == 23) && (hrResponse == E_ABORT);
+}
+
+/* a client with a transport gets the request and answers itself */
+static BOOL test_request_accepted(rdpContext* server, rdpContext* client)
+{
+	const BYTE empty[16] = { 0 };
+	freerdp_peer peer = { 0 };
+
+	peer.context = server;
+	client->multitransport->MultitransportRequest = test_request;
+	callbacks = 0;
+
+	/* a random cookie is generated */
+	if (!freerdp_multitransport_send_request(&peer, 42, INITIATE_REQUEST_PROTOCOL_UDPFECL, NULL))
+		return FALSE;
+
+	if (!test_receive(client, SEC_TRANSPORT_REQ))
+		return FALSE;
+
+	if ((callbacks != 1) || (requestId != 42) ||
+	    (requestedProtocol != INITIATE_REQUEST_PROTOCOL_UDPFECL) ||
+	    (memcmp(securityCookie, server->multitransport->securityCookie, 16) != 0) ||
+	    (memcmp(securityCookie, empty, sizeof(empty)) == 0))
+	{
+		fprintf(stderr, "request not handed to the callback\n");
+		return FALSE;
+	}
+
+	if (!freerdp_multitransport_send_response(client, 42, S_OK))
+		return FALSE;
+
+	callbacks = 0;
+
+	if (!test_receive(server, SEC_TRANSPORT_RSP))
+		return FALSE;
+
+	return (callbacks == 1) && (requestId == 42) && (hrResponse == S_OK);
+}
+
+static BOOL test_short_pdus(rdpContext* server, rdpContext* client)
+{
+	const BYTE request[23] = { 0 };
+	const BYTE response[7] = { 0 };
+	wStream buffer;
+	wStream* s;
+
+	s = Stream_StaticConstInit(&buffer, request, sizeof(request));
+
+	if (rdp_recv_message_channel_pdu(client->rdp, s, SEC_TRANSPORT_REQ) >= 0)
+		return FALSE;
+
+	s = Stream_StaticConstInit(&buffer, response, sizeof(response));
+	return rdp_recv_message_channel_pdu(server->rdp, s, SEC_TRANSPORT_RSP) < 0;
+}
+
+static BOOL test_has_server_block(rdpContext* server)
+{
+	BOOL found = FALSE;
+	wStream* s = Stream_New(NULL, 1024);
+
+	if (!s)
+		return FALSE;
+
+	if (gcc_write_server_data_blocks(s, server->rdp->mcs))
+	{
+		Stream_SealLength(s);
+		Stream_SetPosition(s, 0);
+
+		while (Stream_GetRemainingLength(s) >= 4)
+		{
+			UINT16 type;
+			UINT16 length;
+
+			Stream_Read_UINT16(s, type);
+			Stream_Read_UINT16(s, length);
+
+			if (type == SC_MULTITRANSPORT)
+				found = TRUE;
+
+			if ((length < 4) || !Stream_SafeSeek(s, length - 4U))
+				break;
+		}
+	}
+
+	Stream_Free(s, TRUE);
+	return found;
+}
+
+/* the server data block only answers the one of the client */
+static BOOL test_server_data(rdpContext* server)
+{
+	rdpMcs* mcs = server->rdp->mcs;
+
+	if (!freerdp_settings_set_bool(server->settings, FreeRDP_SupportMultitransport, TRUE) ||
+	    !freerdp_settings_set_uint32(server->settings, FreeRDP_MultitransportFlags,
+	                                 TRANSPORT_TYPE_UDP_FECR))
+		return FALSE;
+
+	mcs->clientMultitransport = FALSE;
+
+	if (test_has_server_block(server))
+	{
+		fprintf(stderr, "server multitransport data sent without a client block\n");
+		return FALSE;
+	}
+
+	mcs->clientMultitransport = TRUE;
+
+	if (!test_has_server_block(server))
+	{
+		fprintf(stderr, "server multitransport data not sent\n");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+int TestMultitransport(int argc, char* argv[])
+{
+	int rc = -1;
+	freerdp* server;
+	freerdp* client;
+
+	WINPR_UNUSED(argc);
+	WINPR_UNUSED(argv);
+
+	server = test_peer_new(TRUE);
+	client = test_peer_new(FALSE);
+
+	if (!server || !client)
+		goto fail;
+
+	if (!test_request_declined(server->context, client->context))
+	{
+		fprintf(stderr, "test_request_declined failed\n");
+		goto fail;
+	}
+
+	if (!test_request_accepted(server->context, client->context))
+	{
+		fprintf(stderr, "test_request_accepted failed\n");
+		goto fail;
+	}
+
+	if (!test_short_pdus(server->context, client->context))
+	{
+		fprintf(stderr, "test_short_pdus failed\n");
+		goto fail;
+	}
+
+	if (!test_server_data(server->context))
+	{
+		fprintf(stderr, "test_server_data failed\n");
+		goto fail;
+	}
+
+	rc = 0;
+fail:
+	test_written_clear();
+	test_instance_free(server);
+	test_instance_free(client);
+	return rc;
+}
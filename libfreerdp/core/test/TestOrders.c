@@ -0,0 +1,325 @@
+#include <stdio.h>
+
+#include <winpr/crt.h>
+#include <winpr/stream.h>
+#include <winpr/sysinfo.h>
+
+#include <freerdp/freerdp.h>
+
+#include "../orders.h"
+
+#define TEST_ORDER_REPLAYS 2000
+
+typedef struct
+{
+	size_t count;
+	OPAQUE_RECT_ORDER opaque_rect;
+	MEMBLT_ORDER memblt;
+	SCRBLT_ORDER scrblt;
+	LINE_TO_ORDER line_to;
+	GLYPH_INDEX_ORDER glyph_index;
+} test_orders;
+
+static test_orders decoded = { 0 };
+
+static BOOL test_opaque_rect(rdpContext* context, const OPAQUE_RECT_ORDER* order)
+{
+	WINPR_UNUSED(context);
+	decoded.opaque_rect = *order;
+	decoded.count++;
+	return TRUE;
+}
+
+static BOOL test_memblt(rdpContext* context, MEMBLT_ORDER* order)
+{
+	WINPR_UNUSED(context);
+	decoded.memblt = *order;
+	decoded.count++;
+	return TRUE;
+}
+
+static BOOL test_scrblt(rdpContext* context, const SCRBLT_ORDER* order)
+{
+	WINPR_UNUSED(context);
+	decoded.scrblt = *order;
+	decoded.count++;
+	return TRUE;
+}
+
+static BOOL test_line_to(rdpContext* context, const LINE_TO_ORDER* order)
+{
+	WINPR_UNUSED(context);
+	decoded.line_to = *order;
+	decoded.count++;
+	return TRUE;
+}
+
+static BOOL test_glyph_index(rdpContext* context, GLYPH_INDEX_ORDER* order)
+{
+	WINPR_UNUSED(context);
+	decoded.glyph_index = *order;
+	decoded.count++;
+	return TRUE;
+}
+
+static BOOL test_write_header(wStream* s, const ORDER_INFO* orderInfo, BYTE controlFlags)
+{
+	BOOL valid = FALSE;
+	const BYTE fieldBytes = get_primary_drawing_order_field_bytes(orderInfo->orderType, &valid);
+
+	if (!valid || !Stream_EnsureRemainingCapacity(s, 2 + fieldBytes))
+		return FALSE;
+
+	Stream_Write_UINT8(s, controlFlags);
+
+	if (controlFlags & ORDER_TYPE_CHANGE)
+		Stream_Write_UINT8(s, orderInfo->orderType);
+
+	return update_write_field_flags(s, orderInfo->fieldFlags, controlFlags, fieldBytes);
+}
+
+/* writes one primary order with all fields present, as a server would */
+static BOOL test_write_order(wStream* s, wStream* body, UINT32 orderType, const void* order)
+{
+	BOOL rc = FALSE;
+	ORDER_INFO orderInfo = { 0 };
+
+	orderInfo.orderType = orderType;
+	Stream_SetPosition(body, 0);
+
+	switch (orderType)
+	{
+		case ORDER_TYPE_OPAQUE_RECT:
+			rc = update_write_opaque_rect_order(body, &orderInfo, order);
+			break;
+		case ORDER_TYPE_MEMBLT:
+			rc = update_write_memblt_order(body, &orderInfo, order);
+			break;
+		case ORDER_TYPE_SCRBLT:
+			rc = update_write_scrblt_order(body, &orderInfo, order);
+			break;
+		case ORDER_TYPE_LINE_TO:
+			rc = update_write_line_to_order(body, &orderInfo, order);
+			break;
+		case ORDER_TYPE_GLYPH_INDEX:
+		{
+			GLYPH_INDEX_ORDER copy = *(const GLYPH_INDEX_ORDER*)order;
+			rc = update_write_glyph_index_order(body, &orderInfo, &copy);
+		}
+		break;
+		default:
+			break;
+	}
+
+	if (!rc || !test_write_header(s, &orderInfo, ORDER_STANDARD | ORDER_TYPE_CHANGE))
+		return FALSE;
+
+	if (!Stream_EnsureRemainingCapacity(s, Stream_GetPosition(body)))
+		return FALSE;
+
+	Stream_Write(s, Stream_Buffer(body), Stream_GetPosition(body));
+	return TRUE;
+}
+
+/* an opaque rect that only moves left by a delta and changes the blue color byte */
+static BOOL test_write_delta_order(wStream* s)
+{
+	ORDER_INFO orderInfo = { 0 };
+
+	orderInfo.orderType = ORDER_TYPE_OPAQUE_RECT;
+	orderInfo.fieldFlags = ORDER_FIELD_01 | ORDER_FIELD_07;
+
+	if (!test_write_header(s, &orderInfo, ORDER_STANDARD | ORDER_DELTA_COORDINATES) ||
+	    !Stream_EnsureRemainingCapacity(s, 2))
+		return FALSE;
+
+	Stream_Write_UINT8(s, 0xF9); /* -7 */
+	Stream_Write_UINT8(s, 0x5A);
+	return TRUE;
+}
+
+static BOOL test_replay(rdpUpdate* update, wStream* s, size_t orders)
+{
+	Stream_SetPosition(s, 0);
+	decoded.count = 0;
+
+	while (Stream_GetRemainingLength(s) > 0)
+	{
+		if (!update_recv_order(update, s))
+			return FALSE;
+	}
+
+	return decoded.count == orders;
+}
+
+static BOOL test_decoded(const OPAQUE_RECT_ORDER* opaque_rect, const MEMBLT_ORDER* memblt,
+                         const SCRBLT_ORDER* scrblt, const LINE_TO_ORDER* line_to,
+                         const GLYPH_INDEX_ORDER* glyph_index)
+{
+	const OPAQUE_RECT_ORDER* o = &decoded.opaque_rect;
+	const MEMBLT_ORDER* m = &decoded.memblt;
+	const SCRBLT_ORDER* r = &decoded.scrblt;
+	const LINE_TO_ORDER* l = &decoded.line_to;
+	const GLYPH_INDEX_ORDER* g = &decoded.glyph_index;
+
+	/* the last opaque rect is the delta order */
+	if ((o->nLeftRect != opaque_rect->nLeftRect - 7) || (o->nTopRect != opaque_rect->nTopRect) ||
+	    (o->nWidth != opaque_rect->nWidth) || (o->nHeight != opaque_rect->nHeight) ||
+	    (o->color != ((opaque_rect->color & 0x00FFFF) | 0x5A0000)))
+		return FALSE;
+
+	if ((m->cacheId != memblt->cacheId) || (m->colorIndex != memblt->colorIndex) ||
+	    (m->nLeftRect != memblt->nLeftRect) || (m->nTopRect != memblt->nTopRect) ||
+	    (m->nWidth != memblt->nWidth) || (m->nHeight != memblt->nHeight) ||
+	    (m->bRop != memblt->bRop) || (m->nXSrc != memblt->nXSrc) ||
+	    (m->nYSrc != memblt->nYSrc) || (m->cacheIndex != memblt->cacheIndex))
+		return FALSE;
+
+	if ((r->nLeftRect != scrblt->nLeftRect) || (r->nTopRect != scrblt->nTopRect) ||
+	    (r->nWidth != scrblt->nWidth) || (r->nHeight != scrblt->nHeight) ||
+	    (r->bRop != scrblt->bRop) || (r->nXSrc != scrblt->nXSrc) || (r->nYSrc != scrblt->nYSrc))
+		return FALSE;
+
+	if ((l->backMode != line_to->backMode) || (l->nXStart != line_to->nXStart) ||
+	    (l->nYStart != line_to->nYStart) || (l->nXEnd != line_to->nXEnd) ||
+	    (l->nYEnd != line_to->nYEnd) || (l->backColor != line_to->backColor) ||
+	    (l->bRop2 != line_to->bRop2) || (l->penStyle != line_to->penStyle) ||
+	    (l->penWidth != line_to->penWidth) || (l->penColor != line_to->penColor))
+		return FALSE;
+
+	if ((g->cacheId != glyph_index->cacheId) || (g->flAccel != glyph_index->flAccel) ||
+	    (g->ulCharInc != glyph_index->ulCharInc) || (g->backColor != glyph_index->backColor) ||
+	    (g->foreColor != glyph_index->foreColor) || (g->bkLeft != glyph_index->bkLeft) ||
+	    (g->bkBottom != glyph_index->bkBottom) || (g->opRight != glyph_index->opRight) ||
+	    (g->x != glyph_index->x) || (g->y != glyph_index->y) ||
+	    (g->cbData != glyph_index->cbData) ||
+	    (memcmp(g->data, glyph_index->data, glyph_index->cbData) != 0))
+		return FALSE;
+
+	return TRUE;
+}
+
+int TestOrders(int argc, char* argv[])
+{
+	int rc = -1;
+	size_t x;
+	size_t orders = 0;
+	UINT64 start;
+	UINT64 duration;
+	freerdp* instance = NULL;
+	rdpSettings* settings;
+	rdpPrimaryUpdate* primary;
+	BYTE* OrderSupport;
+	wStream* s = Stream_New(NULL, 4096);
+	wStream* body = Stream_New(NULL, 1024);
+	OPAQUE_RECT_ORDER opaque_rect = { 10, -20, 300, 40, 0x123456 };
+	MEMBLT_ORDER memblt = { 0 };
+	SCRBLT_ORDER scrblt = { 5, 6, 700, 800, 0xCC, -3, 1023 };
+	LINE_TO_ORDER line_to = { 1, -5, 12, 640, 480, 0xABCDEF, 0x0D, 0, 1, 0x010203 };
+	GLYPH_INDEX_ORDER glyph_index = { 0 };
+
+	WINPR_UNUSED(argc);
+	WINPR_UNUSED(argv);
+
+	memblt.cacheId = 2;
+	memblt.colorIndex = 1;
+	memblt.nLeftRect = 64;
+	memblt.nTopRect = -64;
+	memblt.nWidth = 64;
+	memblt.nHeight = 32;
+	memblt.bRop = 0xCC;
+	memblt.nXSrc = 3;
+	memblt.nYSrc = 4;
+	memblt.cacheIndex = 0x1234;
+
+	glyph_index.cacheId = 7;
+	glyph_index.flAccel = 3;
+	glyph_index.ulCharInc = 0;
+	glyph_index.backColor = 0xFFFFFF;
+	glyph_index.foreColor = 0x102030;
+	glyph_index.bkLeft = 1;
+	glyph_index.bkTop = 2;
+	glyph_index.bkRight = 300;
+	glyph_index.bkBottom = 20;
+	glyph_index.opRight = -1;
+	glyph_index.x = 4;
+	glyph_index.y = 18;
+	glyph_index.cbData = 6;
+	memcpy(glyph_index.data, "\x01\x00\x02\x08\x03\x08", 6);
+
+	if (!s || !body)
+		goto fail;
+
+	instance = freerdp_new();
+
+	if (!instance || !freerdp_context_new(instance))
+		goto fail;
+
+	settings = instance->context->settings;
+	OrderSupport = freerdp_settings_get_pointer_writable(settings, FreeRDP_OrderSupport);
+	OrderSupport[NEG_OPAQUE_RECT_INDEX] = TRUE;
+	OrderSupport[NEG_SCRBLT_INDEX] = TRUE;
+	OrderSupport[NEG_MEMBLT_INDEX] = TRUE;
+	OrderSupport[NEG_LINETO_INDEX] = TRUE;
+	OrderSupport[NEG_GLYPH_INDEX_INDEX] = TRUE;
+
+	primary = instance->context->update->primary;
+	primary->OpaqueRect = test_opaque_rect;
+	primary->MemBlt = test_memblt;
+	primary->ScrBlt = test_scrblt;
+	primary->LineTo = test_line_to;
+	primary->GlyphIndex = test_glyph_index;
+
+	/* a recording of a typical text and blit heavy screen update */
+	for (x = 0; x < 16; x++)
+	{
+		if (!test_write_order(s, body, ORDER_TYPE_OPAQUE_RECT, &opaque_rect) ||
+		    !test_write_order(s, body, ORDER_TYPE_GLYPH_INDEX, &glyph_index) ||
+		    !test_write_order(s, body, ORDER_TYPE_GLYPH_INDEX, &glyph_index) ||
+		    !test_write_order(s, body, ORDER_TYPE_MEMBLT, &memblt) ||
+		    !test_write_order(s, body, ORDER_TYPE_SCRBLT, &scrblt) ||
+		    !test_write_order(s, body, ORDER_TYPE_LINE_TO, &line_to))
+			goto fail;
+
+		orders += 6;
+	}
+
+	if (!test_write_order(s, body, ORDER_TYPE_OPAQUE_RECT, &opaque_rect) ||
+	    !test_write_delta_order(s))
+		goto fail;
+
+	orders += 2;
+	Stream_SealLength(s);
+
+	if (!test_replay(instance->context->update, s, orders))
+	{
+		fprintf(stderr, "replaying the recorded orders failed\n");
+		goto fail;
+	}
+
+	if (!test_decoded(&opaque_rect, &memblt, &scrblt, &line_to, &glyph_index))
+	{
+		fprintf(stderr, "decoded orders do not match the recorded ones\n");
+		goto fail;
+	}
+
+	start = GetTickCount64();
+
+	for (x = 0; x < TEST_ORDER_REPLAYS; x++)
+	{
+		if (!test_replay(instance->context->update, s, orders))
+			goto fail;
+	}
+
+	duration = GetTickCount64() - start;
+	printf("replayed %" PRIuz " orders (%" PRIuz " bytes) %d times in %" PRIu64 " ms\n", orders,
+	       Stream_Length(s), TEST_ORDER_REPLAYS, duration);
+	rc = 0;
+fail:
+	if (instance)
+		freerdp_context_free(instance);
+	freerdp_free(instance);
+	Stream_Free(s, TRUE);
+	Stream_Free(body, TRUE);
+	return rc;
+}
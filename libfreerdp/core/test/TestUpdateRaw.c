@@ -0,0 +1,209 @@
+#include <stdio.h>
+
+#include <winpr/crt.h>
+#include <winpr/stream.h>
+
+#include <freerdp/freerdp.h>
+#include <freerdp/pointer.h>
+
+#include "../update.h"
+#include "../fastpath.h"
+
+static BYTE rawCode = 0xFF;
+static BYTE raw[64];
+static size_t rawLength = 0;
+static size_t rawCount = 0;
+
+static BOOL test_raw_update(rdpContext* context, BYTE updateCode, wStream* s)
+{
+	WINPR_UNUSED(context);
+
+	if (Stream_GetRemainingLength(s) > sizeof(raw))
+		return FALSE;
+
+	rawCode = updateCode;
+	rawLength = Stream_GetRemainingLength(s);
+	memcpy(raw, Stream_Pointer(s), rawLength);
+	rawCount++;
+	return TRUE;
+}
+
+static BOOL test_paint(rdpContext* context)
+{
+	WINPR_UNUSED(context);
+	return TRUE;
+}
+
+static BOOL test_relayed(BYTE updateCode, const BYTE* data, size_t length)
+{
+	if (rawCount != 1)
+	{
+		fprintf(stderr, "expected a single relayed update, got %" PRIuz "\n", rawCount);
+		return FALSE;
+	}
+
+	if (rawCode != updateCode)
+	{
+		fprintf(stderr, "expected fast-path update code %" PRIu8 ", got %" PRIu8 "\n", updateCode,
+		        rawCode);
+		return FALSE;
+	}
+
+	if ((rawLength != length) || (memcmp(raw, data, length) != 0))
+	{
+		fprintf(stderr, "fast-path update data for code %" PRIu8 " differs\n", updateCode);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static BOOL test_update(rdpUpdate* update, const BYTE* pdu, size_t length, BYTE updateCode,
+                        const BYTE* expected, size_t expectedLength)
+{
+	wStream buffer;
+	BYTE data[64];
+	wStream* s;
+
+	/* the orders header is rewritten in place */
+	memcpy(data, pdu, length);
+	s = Stream_StaticInit(&buffer, data, length);
+	rawCount = 0;
+
+	if (!update_recv(update, s))
+		return FALSE;
+
+	if (!expected)
+		return rawCount == 0;
+
+	return test_relayed(updateCode, expected, expectedLength);
+}
+
+static BOOL test_pointer(rdpUpdate* update, const BYTE* pdu, size_t length, BYTE updateCode,
+                         const BYTE* expected, size_t expectedLength)
+{
+	wStream buffer;
+	wStream* s = Stream_StaticConstInit(&buffer, pdu, length);
+
+	rawCount = 0;
+
+	if (!update_recv_pointer(update, s))
+		return FALSE;
+
+	if (!expected)
+		return rawCount == 0;
+
+	return test_relayed(updateCode, expected, expectedLength);
+}
+
+static BOOL test_raw_updates(rdpUpdate* update)
+{
+	/* updateType, pad2OctetsA, numberOrders, pad2OctetsB, orders */
+	const BYTE orders[] = { 0x00, 0x00, 0xAA, 0xAA, 0x02, 0x00, 0xBB, 0xBB, 0x11, 0x22, 0x33 };
+	/* numberOrders, orders */
+	const BYTE fastpathOrders[] = { 0x02, 0x00, 0x11, 0x22, 0x33 };
+	/* updateType, numberRectangles, rectangles */
+	const BYTE bitmap[] = { 0x01, 0x00, 0x01, 0x00, 0x44, 0x55 };
+	/* updateType, pad2Octets */
+	const BYTE synchronize[] = { 0x03, 0x00, 0x00, 0x00 };
+	const BYTE unknown[] = { 0x7F, 0x00, 0x01, 0x02 };
+
+	if (!test_update(update, orders, sizeof(orders), FASTPATH_UPDATETYPE_ORDERS, fastpathOrders,
+	                 sizeof(fastpathOrders)))
+	{
+		fprintf(stderr, "orders update not relayed\n");
+		return FALSE;
+	}
+
+	/* the fast-path bitmap update data contains the updateType */
+	if (!test_update(update, bitmap, sizeof(bitmap), FASTPATH_UPDATETYPE_BITMAP, bitmap,
+	                 sizeof(bitmap)))
+	{
+		fprintf(stderr, "bitmap update not relayed\n");
+		return FALSE;
+	}
+
+	if (!test_update(update, synchronize, sizeof(synchronize), FASTPATH_UPDATETYPE_SYNCHRONIZE,
+	                 &synchronize[2], 2))
+	{
+		fprintf(stderr, "synchronize update not relayed\n");
+		return FALSE;
+	}
+
+	if (!test_update(update, unknown, sizeof(unknown), 0, NULL, 0))
+	{
+		fprintf(stderr, "unknown update relayed\n");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static BOOL test_raw_pointers(rdpUpdate* update)
+{
+	/* messageType, pad2Octets, systemPointerType */
+	const BYTE systemNull[] = { 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+	const BYTE systemDefault[] = { 0x01, 0x00, 0x00, 0x00, 0x00, 0x7F, 0x00, 0x00 };
+	/* messageType, pad2Octets, cacheIndex */
+	const BYTE cached[] = { 0x07, 0x00, 0x00, 0x00, 0x05, 0x00 };
+	const BYTE unknown[] = { 0x42, 0x00, 0x00, 0x00, 0x05, 0x00 };
+
+	/* the system pointer type is a part of the fast-path update code */
+	if (!test_pointer(update, systemNull, sizeof(systemNull), FASTPATH_UPDATETYPE_PTR_NULL,
+	                  systemNull, 0))
+	{
+		fprintf(stderr, "null system pointer not relayed\n");
+		return FALSE;
+	}
+
+	if (!test_pointer(update, systemDefault, sizeof(systemDefault),
+	                  FASTPATH_UPDATETYPE_PTR_DEFAULT, systemDefault, 0))
+	{
+		fprintf(stderr, "default system pointer not relayed\n");
+		return FALSE;
+	}
+
+	if (!test_pointer(update, cached, sizeof(cached), FASTPATH_UPDATETYPE_CACHED, &cached[4], 2))
+	{
+		fprintf(stderr, "cached pointer not relayed\n");
+		return FALSE;
+	}
+
+	if (!test_pointer(update, unknown, sizeof(unknown), 0, NULL, 0))
+	{
+		fprintf(stderr, "unknown pointer message relayed\n");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+int TestUpdateRaw(int argc, char* argv[])
+{
+	int rc = -1;
+	rdpUpdate* update;
+	freerdp* instance = freerdp_new();
+
+	WINPR_UNUSED(argc);
+	WINPR_UNUSED(argv);
+
+	if (!instance)
+		return -1;
+
+	if (!freerdp_context_new(instance))
+		goto fail;
+
+	update = instance->context->update;
+	update->RawUpdate = test_raw_update;
+	update->BeginPaint = test_paint;
+	update->EndPaint = test_paint;
+
+	if (!test_raw_updates(update) || !test_raw_pointers(update))
+		goto fail;
+
+	rc = 0;
+fail:
+	freerdp_context_free(instance);
+	freerdp_free(instance);
+	return rc;
+}
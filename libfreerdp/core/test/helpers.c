@@ -0,0 +1,119 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Implementation
+ * Core Library Tests
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <winpr/crt.h>
+
+#include <freerdp/transport_io.h>
+
+#include "helpers.h"
+
+#define TEST_MAX_PDUS 16
+
+static wStream* written[TEST_MAX_PDUS] = { 0 };
+static size_t writtenCount = 0;
+
+static int test_write_pdu(rdpTransport* transport, wStream* s)
+{
+	const size_t length = Stream_GetPosition(s);
+	wStream* copy;
+
+	WINPR_UNUSED(transport);
+
+	if (writtenCount >= ARRAYSIZE(written))
+		return -1;
+
+	copy = Stream_New(NULL, length);
+
+	if (!copy)
+		return -1;
+
+	Stream_Write(copy, Stream_Buffer(s), length);
+	Stream_SealLength(copy);
+	Stream_SetPosition(copy, 0);
+	written[writtenCount++] = copy;
+	return (int)length;
+}
+
+size_t test_written_count(void)
+{
+	return writtenCount;
+}
+
+wStream* test_written_get(size_t index)
+{
+	if (index >= writtenCount)
+		return NULL;
+
+	Stream_SetPosition(written[index], 0);
+	return written[index];
+}
+
+wStream* test_written_pop(void)
+{
+	if (writtenCount == 0)
+		return NULL;
+
+	return written[--writtenCount];
+}
+
+void test_written_clear(void)
+{
+	size_t x;
+
+	for (x = 0; x < writtenCount; x++)
+		Stream_Free(written[x], TRUE);
+
+	writtenCount = 0;
+}
+
+freerdp* test_instance_new(BOOL server)
+{
+	rdpTransportIo io;
+	rdpContext* context;
+	freerdp* instance = freerdp_new();
+
+	if (!instance)
+		return NULL;
+
+	if (!freerdp_context_new(instance))
+		goto fail;
+
+	context = instance->context;
+
+	if (!freerdp_settings_set_bool(context->settings, FreeRDP_ServerMode, server))
+		goto fail;
+
+	io = *freerdp_get_io_callbacks(context);
+	io.WritePdu = test_write_pdu;
+
+	if (!freerdp_set_io_callbacks(context, &io))
+		goto fail;
+
+	return instance;
+fail:
+	test_instance_free(instance);
+	return NULL;
+}
+
+void test_instance_free(freerdp* instance)
+{
+	if (!instance)
+		return;
+
+	freerdp_context_free(instance);
+	freerdp_free(instance);
+}
@@ -0,0 +1,37 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Implementation
+ * Core Library Tests
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CORE_TEST_HELPERS_H
+#define CORE_TEST_HELPERS_H
+
+#include <winpr/stream.h>
+
+#include <freerdp/freerdp.h>
+
+/* An instance without a connection, the PDUs it writes are recorded instead of sent */
+freerdp* test_instance_new(BOOL server);
+void test_instance_free(freerdp* instance);
+
+/* The PDUs written by all test instances, oldest first */
+size_t test_written_count(void);
+wStream* test_written_get(size_t index);
+
+/* Removes the last PDU written, to be freed with Stream_Free */
+wStream* test_written_pop(void);
+void test_written_clear(void);
+
+#endif /* CORE_TEST_HELPERS_H */
@@ -156,6 +156,7 @@ static const size_t bool_list_indices[] = {
 	FreeRDP_SupportMonitorLayoutPdu,
 	FreeRDP_SupportMultitransport,
 	FreeRDP_SupportSSHAgentChannel,
+	FreeRDP_SupportSkipChannelJoin,
 	FreeRDP_SupportStatusInfoPdu,
 	FreeRDP_SupportVideoOptimized,
 	FreeRDP_SuppressOutput,
@@ -191,6 +192,7 @@ static const size_t uint32_list_indices[] = {
 	FreeRDP_AcceptedCertLength,
 	FreeRDP_AuthenticationLevel,
 	FreeRDP_AutoReconnectMaxRetries,
+	FreeRDP_BitmapCacheMemoryBudget,
 	FreeRDP_BitmapCacheV2NumCells,
 	FreeRDP_BitmapCacheV3CodecId,
 	FreeRDP_BitmapCacheVersion,
@@ -224,6 +226,7 @@ static const size_t uint32_list_indices[] = {
 	FreeRDP_EncryptionLevel,
 	FreeRDP_EncryptionMethods,
 	FreeRDP_ExtEncryptionMethods,
+	FreeRDP_FastPathInputBatchLatency,
 	FreeRDP_Floatbar,
 	FreeRDP_FrameAcknowledge,
 	FreeRDP_GatewayAcceptedCertLength,
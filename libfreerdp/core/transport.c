@@ -27,6 +27,7 @@
 #include <winpr/stream.h>
 #include <winpr/winsock.h>
 #include <winpr/crypto.h>
+#include <winpr/sysinfo.h>
 
 #include <freerdp/log.h>
 #include <freerdp/error.h>
@@ -56,6 +57,7 @@
 #define TAG FREERDP_TAG("core.transport")
 
 #define BUFFER_SIZE 16384
+#define TRANSPORT_READ_AHEAD_SIZE (256 * 1024)
 
 struct rdp_transport
 {
@@ -81,6 +83,11 @@ struct rdp_transport
 	BOOL haveMoreBytesToRead;
 	wLog* log;
 	rdpTransportIo io;
+	BYTE* readAhead;
+	size_t readAheadOffset;
+	size_t readAheadLength;
+	UINT64 bioReads;
+	UINT64 pdusRead;
 };
 
 static void transport_ssl_cb(SSL* ssl, int where, int ret)
@@ -560,6 +567,20 @@ static void transport_bio_error_log(rdpTransport* transport, LPCSTR biofunc, BIO
 	}
 }
 
+/**
+ * Once the TLS layer is established reads are served from a large buffer so that the header
+ * and body of a PDU, and any following PDUs, come out of a single BIO_read. Before that the
+ * connection sequence hands the socket over to the TLS handshake, so nothing may be read ahead.
+ */
+static BOOL transport_read_ahead_enabled(const rdpTransport* transport)
+{
+	if (!transport->readAhead)
+		return FALSE;
+
+	return (transport->layer == TRANSPORT_LAYER_TLS) ||
+	       (transport->layer == TRANSPORT_LAYER_TSG_TLS);
+}
+
 static SSIZE_T transport_read_layer(rdpTransport* transport, BYTE* data, size_t bytes)
 {
 	SSIZE_T read = 0;
@@ -585,8 +606,31 @@ static SSIZE_T transport_read_layer(rdpTransport* transport, BYTE* data, size_t
 	{
 		const SSIZE_T tr = (SSIZE_T)bytes - read;
 		int r = (int)((tr > INT_MAX) ? INT_MAX : tr);
+		BYTE* dst = data + read;
+		BOOL ahead = FALSE;
+
+		if (transport->readAheadOffset < transport->readAheadLength)
+		{
+			const size_t avail = transport->readAheadLength - transport->readAheadOffset;
+			const size_t copy = MIN(avail, (size_t)tr);
+
+			CopyMemory(dst, &transport->readAhead[transport->readAheadOffset], copy);
+			transport->readAheadOffset += copy;
+			read += (SSIZE_T)copy;
+			continue;
+		}
+
+		/* large reads go straight to the caller, there is nothing to gain from a copy */
+		if (transport_read_ahead_enabled(transport) && ((size_t)tr < TRANSPORT_READ_AHEAD_SIZE))
+		{
+			dst = transport->readAhead;
+			r = TRANSPORT_READ_AHEAD_SIZE;
+			ahead = TRUE;
+		}
+
 		ERR_clear_error();
-		int status = BIO_read(transport->frontBio, data + read, r);
+		int status = BIO_read(transport->frontBio, dst, r);
+		transport->bioReads++;
 
 		if (freerdp_shall_disconnect_context(context))
 			return -1;
@@ -624,10 +668,17 @@ static SSIZE_T transport_read_layer(rdpTransport* transport, BYTE* data, size_t
 		}
 
 #ifdef HAVE_VALGRIND_MEMCHECK_H
-		VALGRIND_MAKE_MEM_DEFINED(data + read, bytes - read);
+		VALGRIND_MAKE_MEM_DEFINED(dst, status);
 #endif
-		read += status;
 		rdp->inBytes += status;
+
+		if (ahead)
+		{
+			transport->readAheadOffset = 0;
+			transport->readAheadLength = (size_t)status;
+		}
+		else
+			read += status;
 	}
 
 	return read;
@@ -854,6 +905,8 @@ static int transport_default_read_pdu(rdpTransport* transport, wStream* s)
 	if (Stream_GetPosition(s) >= pduLength)
 		WLog_Packet(transport->log, WLOG_TRACE, Stream_Buffer(s), pduLength, WLOG_PACKET_INBOUND);
 
+	transport->pdusRead++;
+
 	Stream_SealLength(s);
 	Stream_SetPosition(s, 0);
 	return Stream_Length(s);
@@ -861,10 +914,23 @@ static int transport_default_read_pdu(rdpTransport* transport, wStream* s)
 
 int transport_write(rdpTransport* transport, wStream* s)
 {
+	int status;
+	UINT64 start;
+
 	if (!transport)
 		return -1;
 
-	return IFCALLRESULT(-1, transport->io.WritePdu, transport, s);
+	start = winpr_GetTickCount64NS();
+	status = IFCALLRESULT(-1, transport->io.WritePdu, transport, s);
+
+	if (status >= 0)
+	{
+		rdpContext* context = transport_get_context(transport);
+		WINPR_ASSERT(context);
+		metrics_stage_add(context->metrics, METRICS_STAGE_TRANSPORT_WRITE, start);
+	}
+
+	return status;
 }
 
 static int transport_default_write(rdpTransport* transport, wStream* s)
@@ -1099,6 +1165,7 @@ int transport_check_fds(rdpTransport* transport)
 	int status;
 	int recv_status;
 	wStream* received;
+	UINT64 start;
 	UINT64 now = GetTickCount64();
 	UINT64 dueDate = 0;
 	rdpContext* context = transport_get_context(transport);
@@ -1138,6 +1205,8 @@ int transport_check_fds(rdpTransport* transport)
 		 * Note that transport->ReceiveBuffer is replaced after each iteration
 		 * of this loop with a fresh stream instance from a pool.
 		 */
+		start = winpr_GetTickCount64NS();
+
 		if ((status = transport_read_pdu(transport, transport->ReceiveBuffer)) <= 0)
 		{
 			if (status < 0)
@@ -1147,6 +1216,8 @@ int transport_check_fds(rdpTransport* transport)
 			return status;
 		}
 
+		metrics_stage_add(context->metrics, METRICS_STAGE_TRANSPORT_READ, start);
+
 		received = transport->ReceiveBuffer;
 
 		if (!(transport->ReceiveBuffer = StreamPool_Take(transport->ReceivePool, 0)))
@@ -1159,12 +1230,22 @@ int transport_check_fds(rdpTransport* transport)
 		 * 	 1: redirection
 		 */
 		WINPR_ASSERT(transport->ReceiveCallback);
+		start = winpr_GetTickCount64NS();
 		recv_status = transport->ReceiveCallback(transport, received, transport->ReceiveExtra);
+		metrics_stage_add(context->metrics, METRICS_STAGE_PDU_PROCESS, start);
 		Stream_Release(received);
 
 		/* session redirection or activation */
 		if (recv_status == 1 || recv_status == 2)
 		{
+			/* The socket is not signaled for data already buffered, wake up the caller */
+			if ((transport->readAheadOffset < transport->readAheadLength) ||
+			    (BIO_pending(transport->frontBio) > 0))
+			{
+				SetEvent(transport->rereadEvent);
+				transport->haveMoreBytesToRead = TRUE;
+			}
+
 			return recv_status;
 		}
 
@@ -1251,6 +1332,8 @@ static BOOL transport_default_disconnect(rdpTransport* transport)
 
 	transport->frontBio = NULL;
 	transport->layer = TRANSPORT_LAYER_TCP;
+	transport->readAheadOffset = 0;
+	transport->readAheadLength = 0;
 	return status;
 }
 
@@ -1289,6 +1372,11 @@ rdpTransport* transport_new(rdpContext* context)
 	if (!transport->ReceiveBuffer)
 		goto fail;
 
+	transport->readAhead = malloc(TRANSPORT_READ_AHEAD_SIZE);
+
+	if (!transport->readAhead)
+		goto fail;
+
 	transport->connectedEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
 
 	if (!transport->connectedEvent || transport->connectedEvent == INVALID_HANDLE_VALUE)
@@ -1323,6 +1411,10 @@ void transport_free(rdpTransport* transport)
 
 	transport_disconnect(transport);
 
+	if (transport->log)
+		WLog_Print(transport->log, WLOG_DEBUG, "%" PRIu64 " BIO reads for %" PRIu64 " PDUs",
+		           transport->bioReads, transport->pdusRead);
+
 	if (transport->ReceiveBuffer)
 		Stream_Release(transport->ReceiveBuffer);
 
@@ -1332,6 +1424,7 @@ void transport_free(rdpTransport* transport)
 	CloseHandle(transport->rereadEvent);
 	DeleteCriticalSection(&(transport->ReadLock));
 	DeleteCriticalSection(&(transport->WriteLock));
+	free(transport->readAhead);
 	free(transport);
 }
 
@@ -1412,6 +1505,30 @@ wStream* transport_take_from_pool(rdpTransport* transport, size_t size)
 	return StreamPool_Take(transport->ReceivePool, size);
 }
 
+wStream* transport_reference_received(rdpTransport* transport, const BYTE* data)
+{
+	wStream* s;
+	union
+	{
+		const BYTE* cpv;
+		BYTE* pv;
+	} cnv;
+
+	WINPR_ASSERT(transport);
+
+	if (!data)
+		return NULL;
+
+	/* the stream is in use by the caller, it can not be returned to the pool meanwhile */
+	cnv.cpv = data;
+	s = StreamPool_Find(transport->ReceivePool, cnv.pv);
+
+	if (s)
+		Stream_AddRef(s);
+
+	return s;
+}
+
 ULONG transport_get_bytes_sent(rdpTransport* transport, BOOL resetCount)
 {
 	ULONG rc;
@@ -99,6 +99,7 @@ FREERDP_LOCAL BOOL transport_set_tsg(rdpTransport* transport, rdpTsg* tsg);
 FREERDP_LOCAL rdpTsg* transport_get_tsg(rdpTransport* transport);
 
 FREERDP_LOCAL wStream* transport_take_from_pool(rdpTransport* transport, size_t size);
+FREERDP_LOCAL wStream* transport_reference_received(rdpTransport* transport, const BYTE* data);
 
 FREERDP_LOCAL ULONG transport_get_bytes_sent(rdpTransport* transport, BOOL resetCount);
 
@@ -662,6 +662,52 @@ fail:
 	return NULL;
 }
 
+/* Relay a slow-path pointer update as fast-path update, it only differs in the header. */
+static BOOL update_recv_raw_pointer(rdpUpdate* update, UINT16 messageType, wStream* s)
+{
+	BYTE updateCode;
+	UINT32 systemPointerType;
+
+	switch (messageType)
+	{
+		case PTR_MSG_TYPE_POSITION:
+			updateCode = FASTPATH_UPDATETYPE_PTR_POSITION;
+			break;
+
+		case PTR_MSG_TYPE_SYSTEM:
+			if (!Stream_CheckAndLogRequiredLength(TAG, s, 4))
+				return FALSE;
+
+			Stream_Read_UINT32(s, systemPointerType); /* systemPointerType (4 bytes) */
+			updateCode = (systemPointerType == SYSPTR_NULL) ? FASTPATH_UPDATETYPE_PTR_NULL
+			                                                : FASTPATH_UPDATETYPE_PTR_DEFAULT;
+			break;
+
+		case PTR_MSG_TYPE_COLOR:
+			updateCode = FASTPATH_UPDATETYPE_COLOR;
+			break;
+
+		case PTR_MSG_TYPE_POINTER_LARGE:
+			updateCode = FASTPATH_UPDATETYPE_LARGE_POINTER;
+			break;
+
+		case PTR_MSG_TYPE_POINTER:
+			updateCode = FASTPATH_UPDATETYPE_POINTER;
+			break;
+
+		case PTR_MSG_TYPE_CACHED:
+			updateCode = FASTPATH_UPDATETYPE_CACHED;
+			break;
+
+		default:
+			WLog_WARN(TAG, "unknown pointer message type 0x%04" PRIx16 ", not relayed",
+			          messageType);
+			return TRUE;
+	}
+
+	return update->RawUpdate(update->context, updateCode, s);
+}
+
 BOOL update_recv_pointer(rdpUpdate* update, wStream* s)
 {
 	BOOL rc = FALSE;
@@ -675,6 +721,9 @@ BOOL update_recv_pointer(rdpUpdate* update, wStream* s)
 	Stream_Read_UINT16(s, messageType); /* messageType (2 bytes) */
 	Stream_Seek_UINT16(s);              /* pad2Octets (2 bytes) */
 
+	if (update->RawUpdate)
+		return update_recv_raw_pointer(update, messageType, s);
+
 	switch (messageType)
 	{
 		case PTR_MSG_TYPE_POSITION:
@@ -756,6 +805,51 @@ BOOL update_recv_pointer(rdpUpdate* update, wStream* s)
 	return rc;
 }
 
+/* Relay a slow-path update as fast-path update. The fast-path header is a part of the slow-path
+ * one or rewritten in place, the update data is not touched. */
+static BOOL update_recv_raw_update(rdpUpdate* update, UINT16 updateType, wStream* s)
+{
+	BYTE updateCode;
+
+	switch (updateType)
+	{
+		case UPDATE_TYPE_ORDERS:
+		{
+			BYTE* header;
+
+			/* pad2OctetsA (2 bytes), numberOrders (2 bytes), pad2OctetsB (2 bytes) */
+			if (!Stream_CheckAndLogRequiredLength(TAG, s, 6))
+				return FALSE;
+
+			header = Stream_Pointer(s);
+			header[4] = header[2];
+			header[5] = header[3];
+			Stream_Seek(s, 4);
+			updateCode = FASTPATH_UPDATETYPE_ORDERS;
+		}
+		break;
+
+		case UPDATE_TYPE_BITMAP:
+		case UPDATE_TYPE_PALETTE:
+			/* the fast-path update data starts with the updateType as well */
+			Stream_Rewind(s, 2);
+			updateCode = (updateType == UPDATE_TYPE_BITMAP) ? FASTPATH_UPDATETYPE_BITMAP
+			                                                : FASTPATH_UPDATETYPE_PALETTE;
+			break;
+
+		case UPDATE_TYPE_SYNCHRONIZE:
+			updateCode = FASTPATH_UPDATETYPE_SYNCHRONIZE;
+			break;
+
+		default:
+			WLog_WARN(TAG, "unknown update type %s [%" PRIu16 "], not relayed",
+			          update_type_to_string(updateType), updateType);
+			return TRUE;
+	}
+
+	return update->RawUpdate(update->context, updateCode, s);
+}
+
 BOOL update_recv(rdpUpdate* update, wStream* s)
 {
 	BOOL rc = FALSE;
@@ -772,6 +866,12 @@ BOOL update_recv(rdpUpdate* update, wStream* s)
 	if (!update_begin_paint(update))
 		goto fail;
 
+	if (update->RawUpdate)
+	{
+		rc = update_recv_raw_update(update, updateType, s);
+		goto fail;
+	}
+
 	switch (updateType)
 	{
 		case UPDATE_TYPE_ORDERS:
@@ -1340,6 +1440,24 @@ static BOOL update_send_synchronize(rdpContext* context)
 	return ret;
 }
 
+static BOOL update_send_raw_update(rdpContext* context, BYTE updateCode, wStream* s)
+{
+	wStream sbuffer = { 0 };
+	wStream* data;
+	rdpRdp* rdp;
+	const size_t length = Stream_GetRemainingLength(s);
+
+	WINPR_ASSERT(context);
+	rdp = context->rdp;
+	WINPR_ASSERT(rdp);
+
+	/* batched orders go first to keep the order of the updates */
+	update_force_flush(context);
+	data = Stream_StaticConstInit(&sbuffer, Stream_Pointer(s), length);
+	Stream_Seek(data, length);
+	return fastpath_send_update_pdu(rdp->fastpath, updateCode, data, FALSE);
+}
+
 static BOOL update_send_desktop_resize(rdpContext* context)
 {
 	return rdp_server_reactivate(context->rdp);
@@ -2965,6 +3083,7 @@ void update_register_server_callbacks(rdpUpdate* update)
 	update->SetKeyboardImeStatus = update_send_set_keyboard_ime_status;
 	update->SaveSessionInfo = rdp_send_save_session_info;
 	update->ServerStatusInfo = rdp_send_server_status_info;
+	update->RawUpdate = update_send_raw_update;
 	update->primary->DstBlt = update_send_dstblt;
 	update->primary->PatBlt = update_send_patblt;
 	update->primary->ScrBlt = update_send_scrblt;
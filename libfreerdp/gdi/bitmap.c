@@ -342,6 +342,416 @@ static INLINE BOOL BitBlt_write(HGDI_DC hdcDest, HGDI_DC hdcSrc, INT32 nXDest, I
 	return FreeRDPWriteColor(dstp, hdcDest->format, dstColor);
 }
 
+/* Raster operations are applied to chunks of a row. Each ROP string is compiled to its
+ * ROP3 truth table, the common ones are dispatched to dedicated row kernels, everything
+ * else to a table driven one. The kernels work on native pixel words of 32bpp surfaces. */
+#define BITBLT_CHUNK_SIZE 256
+
+typedef void (*BitBlt_row_fn)(UINT32* dst, const UINT32* src, const UINT32* pat, size_t count,
+                              BYTE rop3);
+
+typedef struct
+{
+	BYTE rop3;
+	BOOL constant;
+	UINT32 color;
+	BitBlt_row_fn fkt;
+} BITBLT_ROP;
+
+static void rop_row_P(UINT32* dst, const UINT32* src, const UINT32* pat, size_t count, BYTE rop3)
+{
+	WINPR_UNUSED(src);
+	WINPR_UNUSED(rop3);
+	memcpy(dst, pat, count * sizeof(UINT32));
+}
+
+static void rop_row_Dn(UINT32* dst, const UINT32* src, const UINT32* pat, size_t count, BYTE rop3)
+{
+	size_t x;
+	WINPR_UNUSED(src);
+	WINPR_UNUSED(pat);
+	WINPR_UNUSED(rop3);
+
+	for (x = 0; x < count; x++)
+		dst[x] = ~dst[x];
+}
+
+static void rop_row_Sn(UINT32* dst, const UINT32* src, const UINT32* pat, size_t count, BYTE rop3)
+{
+	size_t x;
+	WINPR_UNUSED(pat);
+	WINPR_UNUSED(rop3);
+
+	for (x = 0; x < count; x++)
+		dst[x] = ~src[x];
+}
+
+static void rop_row_DPx(UINT32* dst, const UINT32* src, const UINT32* pat, size_t count, BYTE rop3)
+{
+	size_t x;
+	WINPR_UNUSED(src);
+	WINPR_UNUSED(rop3);
+
+	for (x = 0; x < count; x++)
+		dst[x] ^= pat[x];
+}
+
+static void rop_row_DSx(UINT32* dst, const UINT32* src, const UINT32* pat, size_t count, BYTE rop3)
+{
+	size_t x;
+	WINPR_UNUSED(pat);
+	WINPR_UNUSED(rop3);
+
+	for (x = 0; x < count; x++)
+		dst[x] ^= src[x];
+}
+
+static void rop_row_DSa(UINT32* dst, const UINT32* src, const UINT32* pat, size_t count, BYTE rop3)
+{
+	size_t x;
+	WINPR_UNUSED(pat);
+	WINPR_UNUSED(rop3);
+
+	for (x = 0; x < count; x++)
+		dst[x] &= src[x];
+}
+
+static void rop_row_DSo(UINT32* dst, const UINT32* src, const UINT32* pat, size_t count, BYTE rop3)
+{
+	size_t x;
+	WINPR_UNUSED(pat);
+	WINPR_UNUSED(rop3);
+
+	for (x = 0; x < count; x++)
+		dst[x] |= src[x];
+}
+
+static void rop_row_DSno(UINT32* dst, const UINT32* src, const UINT32* pat, size_t count,
+                         BYTE rop3)
+{
+	size_t x;
+	WINPR_UNUSED(pat);
+	WINPR_UNUSED(rop3);
+
+	for (x = 0; x < count; x++)
+		dst[x] |= ~src[x];
+}
+
+static void rop_row_PSa(UINT32* dst, const UINT32* src, const UINT32* pat, size_t count, BYTE rop3)
+{
+	size_t x;
+	WINPR_UNUSED(rop3);
+
+	for (x = 0; x < count; x++)
+		dst[x] = pat[x] & src[x];
+}
+
+/* S ? P : D, used for glyphs */
+static void rop_row_DSPDxax(UINT32* dst, const UINT32* src, const UINT32* pat, size_t count,
+                            BYTE rop3)
+{
+	size_t x;
+	WINPR_UNUSED(rop3);
+
+	for (x = 0; x < count; x++)
+		dst[x] = ((dst[x] ^ pat[x]) & src[x]) ^ dst[x];
+}
+
+/* S ? D : P */
+static void rop_row_PSDPxax(UINT32* dst, const UINT32* src, const UINT32* pat, size_t count,
+                            BYTE rop3)
+{
+	size_t x;
+	WINPR_UNUSED(rop3);
+
+	for (x = 0; x < count; x++)
+		dst[x] = ((dst[x] ^ pat[x]) & src[x]) ^ pat[x];
+}
+
+/* Bit i of the truth table is the result for P = bit 2, S = bit 1 and D = bit 0 of i */
+static void rop_row_table(UINT32* dst, const UINT32* src, const UINT32* pat, size_t count,
+                          BYTE rop3)
+{
+	size_t x;
+
+	for (x = 0; x < count; x++)
+	{
+		size_t i;
+		const UINT32 P = pat[x];
+		const UINT32 S = src[x];
+		const UINT32 D = dst[x];
+		UINT32 result = 0;
+
+		for (i = 0; i < 8; i++)
+		{
+			if (rop3 & (1 << i))
+				result |= ((i & 4) ? P : ~P) & ((i & 2) ? S : ~S) & ((i & 1) ? D : ~D);
+		}
+
+		dst[x] = result;
+	}
+}
+
+static BOOL BitBlt_compile_rop(const char* rop, UINT32 format, BITBLT_ROP* compiled)
+{
+	BYTE stack[10] = { 0 };
+	UINT32 stackp = 0;
+	const char* iter = rop;
+
+	if (!rop || !compiled)
+		return FALSE;
+
+	/* constants carry the alpha channel of the format, handle them as a fill */
+	if (strcmp(rop, "0") == 0)
+	{
+		compiled->rop3 = 0x00;
+		compiled->constant = TRUE;
+		compiled->color = FreeRDPGetColor(format, 0, 0, 0, 0xFF);
+		compiled->fkt = rop_row_P;
+		return TRUE;
+	}
+
+	if (strcmp(rop, "1") == 0)
+	{
+		compiled->rop3 = 0xFF;
+		compiled->constant = TRUE;
+		compiled->color = FreeRDPGetColor(format, 0xFF, 0xFF, 0xFF, 0xFF);
+		compiled->fkt = rop_row_P;
+		return TRUE;
+	}
+
+	/* evaluate the ROP string on the truth table operands */
+	while (*iter != '\0')
+	{
+		switch (*iter++)
+		{
+			case 'D':
+				if (stackp >= ARRAYSIZE(stack))
+					return FALSE;
+				stack[stackp++] = 0xAA;
+				break;
+
+			case 'S':
+				if (stackp >= ARRAYSIZE(stack))
+					return FALSE;
+				stack[stackp++] = 0xCC;
+				break;
+
+			case 'P':
+				if (stackp >= ARRAYSIZE(stack))
+					return FALSE;
+				stack[stackp++] = 0xF0;
+				break;
+
+			case 'x':
+				if (stackp < 2)
+					return FALSE;
+				stackp--;
+				stack[stackp - 1] ^= stack[stackp];
+				break;
+
+			case 'a':
+				if (stackp < 2)
+					return FALSE;
+				stackp--;
+				stack[stackp - 1] &= stack[stackp];
+				break;
+
+			case 'o':
+				if (stackp < 2)
+					return FALSE;
+				stackp--;
+				stack[stackp - 1] |= stack[stackp];
+				break;
+
+			case 'n':
+				if (stackp < 1)
+					return FALSE;
+				stack[stackp - 1] = ~stack[stackp - 1];
+				break;
+
+			default:
+				return FALSE;
+		}
+	}
+
+	if (stackp != 1)
+		return FALSE;
+
+	compiled->rop3 = stack[0];
+	compiled->constant = FALSE;
+	compiled->color = 0;
+
+	switch (compiled->rop3)
+	{
+		case 0xF0: /* PATCOPY */
+			compiled->fkt = rop_row_P;
+			break;
+
+		case 0x55: /* DSTINVERT */
+			compiled->fkt = rop_row_Dn;
+			break;
+
+		case 0x33: /* NOTSRCCOPY */
+			compiled->fkt = rop_row_Sn;
+			break;
+
+		case 0x5A: /* PATINVERT */
+			compiled->fkt = rop_row_DPx;
+			break;
+
+		case 0x66: /* SRCINVERT */
+			compiled->fkt = rop_row_DSx;
+			break;
+
+		case 0x88: /* SRCAND */
+			compiled->fkt = rop_row_DSa;
+			break;
+
+		case 0xEE: /* SRCPAINT */
+			compiled->fkt = rop_row_DSo;
+			break;
+
+		case 0xBB: /* MERGEPAINT */
+			compiled->fkt = rop_row_DSno;
+			break;
+
+		case 0xC0: /* MERGECOPY */
+			compiled->fkt = rop_row_PSa;
+			break;
+
+		case 0xE2: /* DSPDxax */
+			compiled->fkt = rop_row_DSPDxax;
+			break;
+
+		case 0xB8: /* PSDPxax */
+			compiled->fkt = rop_row_PSDPxax;
+			break;
+
+		default:
+			compiled->fkt = rop_row_table;
+			break;
+	}
+
+	return TRUE;
+}
+
+static INLINE UINT32 BitBlt_native_color(UINT32 format, UINT32 color)
+{
+	UINT32 native = 0;
+	FreeRDPWriteColor((BYTE*)&native, format, color);
+	return native;
+}
+
+static BOOL BitBlt_process_rows(HGDI_DC hdcDest, INT32 nXDest, INT32 nYDest, INT32 nWidth,
+                                INT32 nHeight, HGDI_DC hdcSrc, INT32 nXSrc, INT32 nYSrc,
+                                BOOL useSrc, BOOL usePat, UINT32 style,
+                                const BITBLT_ROP* compiled, const gdiPalette* palette)
+{
+	INT32 i;
+	UINT32 srcChunk[BITBLT_CHUNK_SIZE] = { 0 };
+	UINT32 patChunk[BITBLT_CHUNK_SIZE] = { 0 };
+	const HGDI_BITMAP hDstBmp = (HGDI_BITMAP)hdcDest->selectedObject;
+	const HGDI_BITMAP hSrcBmp = useSrc ? (HGDI_BITMAP)hdcSrc->selectedObject : NULL;
+	UINT32 srcKeep = 0xFFFFFFFF;
+	UINT32 srcSet = 0;
+	BOOL directSrc;
+	const BOOL sameFormat = useSrc && (hdcSrc->format == hdcDest->format) &&
+	                        (hdcDest->format != PIXEL_FORMAT_BGRX32_DEPTH30) &&
+	                        (hdcDest->format != PIXEL_FORMAT_RGBX32_DEPTH30);
+	const BOOL reverseX = nXDest > nXSrc;
+	const BOOL reverseY = nYDest > nYSrc;
+	const INT32 nChunks = (nWidth + BITBLT_CHUNK_SIZE - 1) / BITBLT_CHUNK_SIZE;
+	const BOOL patternRows = usePat && (style != GDI_BS_SOLID);
+
+	/* color conversion rewrites the unused alpha byte, even between identical formats */
+	if (sameFormat && !FreeRDPColorHasAlpha(hdcDest->format))
+	{
+		const UINT32 black =
+		    BitBlt_native_color(hdcDest->format, FreeRDPGetColor(hdcDest->format, 0, 0, 0, 0xFF));
+		const UINT32 white = BitBlt_native_color(
+		    hdcDest->format, FreeRDPGetColor(hdcDest->format, 0xFF, 0xFF, 0xFF, 0xFF));
+		srcKeep = black ^ white;
+		srcSet = black & ~srcKeep;
+	}
+
+	directSrc = sameFormat && (srcKeep == 0xFFFFFFFF) && (hSrcBmp != hDstBmp);
+
+	if (compiled->constant || (usePat && (style == GDI_BS_SOLID)))
+	{
+		const UINT32 color = compiled->constant ? compiled->color : hdcDest->brush->color;
+		const UINT32 native = BitBlt_native_color(hdcDest->format, color);
+
+		for (i = 0; i < BITBLT_CHUNK_SIZE; i++)
+			patChunk[i] = native;
+	}
+
+	for (i = 0; i < nHeight; i++)
+	{
+		INT32 c;
+		const INT32 y = reverseY ? nHeight - 1 - i : i;
+
+		for (c = 0; c < nChunks; c++)
+		{
+			INT32 k;
+			const INT32 x = (reverseX ? nChunks - 1 - c : c) * BITBLT_CHUNK_SIZE;
+			const INT32 count = MIN(BITBLT_CHUNK_SIZE, nWidth - x);
+			const UINT32* src = srcChunk;
+			UINT32* dst = (UINT32*)gdi_get_bitmap_pointer(hdcDest, nXDest + x, nYDest + y);
+
+			if (!dst)
+				return FALSE;
+
+			if (useSrc)
+			{
+				const BYTE* srcp = gdi_get_bitmap_pointer(hdcSrc, nXSrc + x, nYSrc + y);
+
+				if (!srcp)
+					return FALSE;
+
+				if (directSrc)
+					src = (const UINT32*)srcp;
+				else if (sameFormat)
+				{
+					for (k = 0; k < count; k++)
+						srcChunk[k] = (((const UINT32*)srcp)[k] & srcKeep) | srcSet;
+				}
+				else
+				{
+					const size_t srcBpp = FreeRDPGetBytesPerPixel(hdcSrc->format);
+
+					for (k = 0; k < count; k++)
+					{
+						UINT32 color = FreeRDPReadColor(&srcp[k * srcBpp], hdcSrc->format);
+						color = FreeRDPConvertColor(color, hdcSrc->format, hdcDest->format,
+						                            palette);
+						srcChunk[k] = BitBlt_native_color(hdcDest->format, color);
+					}
+				}
+			}
+
+			if (patternRows)
+			{
+				const INT32 period = MIN((INT32)hdcDest->brush->pattern->width, count);
+
+				for (k = 0; k < period; k++)
+				{
+					const BYTE* patp = gdi_get_brush_pointer(hdcDest, nXDest + x + k, nYDest + y);
+					const UINT32 color = FreeRDPReadColor(patp, hdcDest->format);
+					patChunk[k] = BitBlt_native_color(hdcDest->format, color);
+				}
+
+				for (; k < count; k++)
+					patChunk[k] = patChunk[k - period];
+			}
+
+			compiled->fkt(dst, src, patChunk, (size_t)count, compiled->rop3);
+		}
+	}
+
+	return TRUE;
+}
+
 static BOOL adjust_src_coordinates(HGDI_DC hdcSrc, INT32 nWidth, INT32 nHeight, INT32* px,
                                    INT32* py)
 {
@@ -455,6 +865,7 @@ static BOOL BitBlt_process(HGDI_DC hdcDest, INT32 nXDest, INT32 nYDest, INT32 nW
 	UINT32 style = 0;
 	BOOL useSrc = FALSE;
 	BOOL usePat = FALSE;
+	BITBLT_ROP compiled = { 0 };
 	const char* iter = rop;
 
 	while (*iter != '\0')
@@ -506,6 +917,11 @@ static BOOL BitBlt_process(HGDI_DC hdcDest, INT32 nXDest, INT32 nYDest, INT32 nW
 		}
 	}
 
+	if ((FreeRDPGetBytesPerPixel(hdcDest->format) == 4) &&
+	    BitBlt_compile_rop(rop, hdcDest->format, &compiled))
+		return BitBlt_process_rows(hdcDest, nXDest, nYDest, nWidth, nHeight, hdcSrc, nXSrc, nYSrc,
+		                           useSrc, usePat, style, &compiled, palette);
+
 	if ((nXDest > nXSrc) && (nYDest > nYSrc))
 	{
 		for (y = nHeight - 1; y >= 0; y--)
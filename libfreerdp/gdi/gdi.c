@@ -26,6 +26,7 @@
 
 #include <winpr/crt.h>
 #include <winpr/assert.h>
+#include <winpr/sysinfo.h>
 
 #include <freerdp/api.h>
 #include <freerdp/log.h>
@@ -42,6 +43,7 @@
 #include "clipping.h"
 #include "brush.h"
 #include "line.h"
+#include "glyph.h"
 #include "gdi.h"
 #include "../core/graphics.h"
 #include "../core/update.h"
@@ -1010,6 +1012,7 @@ static BOOL gdi_surface_bits(rdpContext* context, const SURFACE_BITS_COMMAND* cm
 	RECTANGLE_16 cmdRect;
 	UINT32 i, nbRects;
 	const RECTANGLE_16* rects;
+	const UINT64 start = winpr_GetTickCount64NS();
 
 	if (!context || !cmd)
 		return FALSE;
@@ -1103,6 +1106,7 @@ static BOOL gdi_surface_bits(rdpContext* context, const SURFACE_BITS_COMMAND* cm
 	}
 
 	result = TRUE;
+	metrics_stage_add(context->metrics, METRICS_STAGE_SURFACE_DECODE, start);
 out:
 	region16_uninit(&region);
 	return result;
@@ -1291,7 +1295,7 @@ BOOL gdi_init_ex(freerdp* instance, UINT32 format, UINT32 stride, BYTE* buffer,
 
 	const UINT32 ColorDepth = freerdp_settings_get_uint32(context->settings, FreeRDP_ColorDepth);
 	SrcFormat = gdi_get_pixel_format(ColorDepth);
-	gdi = (rdpGdi*)calloc(1, sizeof(rdpGdi));
+	gdi = (rdpGdi*)calloc(1, sizeof(rdp_gdi_internal));
 
 	if (!gdi)
 		goto fail;
@@ -1317,6 +1321,9 @@ BOOL gdi_init_ex(freerdp* instance, UINT32 format, UINT32 stride, BYTE* buffer,
 
 	gdi->hdc->format = gdi->dstFormat;
 
+	if (!(((rdp_gdi_internal*)gdi)->glyphAtlas = gdi_glyph_atlas_new()))
+		goto fail;
+
 	if (!gdi_init_primary(gdi, stride, gdi->dstFormat, buffer, pfree, FALSE))
 		goto fail;
 
@@ -1354,6 +1361,7 @@ void gdi_free(freerdp* instance)
 	{
 		gdi_bitmap_free_ex(gdi->primary);
 		gdi_DeleteDC(gdi->hdc);
+		gdi_glyph_atlas_free(gdi_get_glyph_atlas(gdi));
 		free(gdi);
 	}
 
@@ -0,0 +1,504 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Implementation
+ * GDI Glyph Atlas
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <freerdp/config.h>
+
+#include <winpr/crt.h>
+#include <winpr/assert.h>
+
+#include <freerdp/log.h>
+#include <freerdp/graphics.h>
+#include <freerdp/codec/color.h>
+#include <freerdp/gdi/region.h>
+
+#include "clipping.h"
+#include "glyph.h"
+
+#define TAG FREERDP_TAG("gdi.glyph")
+
+/**
+ * Glyphs are stored as 8bit masks (0x00 or 0xFF per pixel) in atlas pages.
+ * A page is filled with shelves, rows of glyphs of about the same height.
+ * Space of a shelf is reused once all of its glyphs are gone, a page is reset
+ * when it is empty. Glyphs larger than a page get a page of their own.
+ *
+ * Text runs are collected between gdi_glyph_run_begin and gdi_glyph_run_end
+ * and blended into the destination in a single pass.
+ */
+#define GDI_GLYPH_PAGE_WIDTH 256
+#define GDI_GLYPH_PAGE_HEIGHT 128
+#define GDI_GLYPH_SHELF_SLACK 4
+
+typedef struct
+{
+	UINT32 y;
+	UINT32 x;
+	UINT32 height;
+	UINT32 used;
+} gdiGlyphShelf;
+
+struct gdi_glyph_page
+{
+	gdiGlyphAtlas* atlas;
+	BYTE* data;
+	UINT32 width;
+	UINT32 height;
+	UINT32 nextY;
+	UINT32 used;
+	size_t nShelves;
+	gdiGlyphShelf shelves[GDI_GLYPH_PAGE_HEIGHT];
+};
+
+typedef struct
+{
+	const BYTE* mask;
+	UINT32 maskStep;
+	INT32 x;
+	INT32 y;
+	INT32 w;
+	INT32 h;
+} gdiGlyphRunEntry;
+
+struct gdi_glyph_atlas
+{
+	gdiGlyphPage** pages;
+	size_t nPages;
+
+	HGDI_DC hdc;
+	gdiGlyphRunEntry* entries;
+	size_t nEntries;
+	size_t maxEntries;
+	INT32 left;
+	INT32 top;
+	INT32 right;
+	INT32 bottom;
+};
+
+static void gdi_glyph_page_free(gdiGlyphPage* page)
+{
+	if (!page)
+		return;
+
+	winpr_aligned_free(page->data);
+	free(page);
+}
+
+static gdiGlyphPage* gdi_glyph_page_new(gdiGlyphAtlas* atlas, UINT32 width, UINT32 height)
+{
+	gdiGlyphPage* page = calloc(1, sizeof(gdiGlyphPage));
+
+	if (!page)
+		return NULL;
+
+	page->atlas = atlas;
+	page->width = width;
+	page->height = height;
+	page->data = winpr_aligned_malloc(1ull * width * height, 16);
+
+	if (!page->data)
+	{
+		gdi_glyph_page_free(page);
+		return NULL;
+	}
+
+	return page;
+}
+
+static BOOL gdi_glyph_page_alloc(gdiGlyphPage* page, UINT32 cx, UINT32 cy, size_t* pShelf,
+                                 UINT32* px, UINT32* py)
+{
+	size_t i;
+	gdiGlyphShelf* shelf;
+
+	for (i = 0; i < page->nShelves; i++)
+	{
+		shelf = &page->shelves[i];
+
+		if ((shelf->height < cy) || (shelf->height - cy > GDI_GLYPH_SHELF_SLACK))
+			continue;
+
+		if (page->width - shelf->x < cx)
+			continue;
+
+		goto out;
+	}
+
+	if ((page->nShelves >= ARRAYSIZE(page->shelves)) || (page->height - page->nextY < cy) ||
+	    (page->width < cx))
+		return FALSE;
+
+	i = page->nShelves++;
+	shelf = &page->shelves[i];
+	shelf->y = page->nextY;
+	shelf->x = 0;
+	shelf->height = cy;
+	shelf->used = 0;
+	page->nextY += cy;
+out:
+	*pShelf = i;
+	*px = shelf->x;
+	*py = shelf->y;
+	shelf->x += cx;
+	shelf->used++;
+	page->used++;
+	return TRUE;
+}
+
+gdiGlyphAtlas* gdi_glyph_atlas_new(void)
+{
+	return calloc(1, sizeof(gdiGlyphAtlas));
+}
+
+void gdi_glyph_atlas_free(gdiGlyphAtlas* atlas)
+{
+	size_t i;
+
+	if (!atlas)
+		return;
+
+	/* pages still in use by glyphs are released with their last glyph */
+	for (i = 0; i < atlas->nPages; i++)
+	{
+		gdiGlyphPage* page = atlas->pages[i];
+		page->atlas = NULL;
+
+		if (page->used == 0)
+			gdi_glyph_page_free(page);
+	}
+
+	free(atlas->pages);
+	free(atlas->entries);
+	free(atlas);
+}
+
+BOOL gdi_glyph_atlas_add(gdiGlyphAtlas* atlas, gdi_glyph_internal* glyph, UINT32 cx, UINT32 cy,
+                         const BYTE* aj)
+{
+	size_t i;
+	size_t shelf = 0;
+	UINT32 x = 0;
+	UINT32 y = 0;
+	UINT32 line;
+	gdiGlyphPage* page = NULL;
+	const UINT32 scanline = (cx + 7) / 8;
+
+	if (!atlas || !glyph || (!aj && (cx > 0) && (cy > 0)))
+		return FALSE;
+
+	glyph->page = NULL;
+	glyph->mask = NULL;
+	glyph->maskStep = 0;
+
+	if ((cx == 0) || (cy == 0))
+		return TRUE;
+
+	for (i = 0; i < atlas->nPages; i++)
+	{
+		if (gdi_glyph_page_alloc(atlas->pages[i], cx, cy, &shelf, &x, &y))
+		{
+			page = atlas->pages[i];
+			break;
+		}
+	}
+
+	if (!page)
+	{
+		gdiGlyphPage** pages =
+		    realloc(atlas->pages, (atlas->nPages + 1) * sizeof(gdiGlyphPage*));
+
+		if (!pages)
+			return FALSE;
+
+		atlas->pages = pages;
+		page = gdi_glyph_page_new(atlas, MAX(GDI_GLYPH_PAGE_WIDTH, cx),
+		                          MAX(GDI_GLYPH_PAGE_HEIGHT, cy));
+
+		if (!page)
+			return FALSE;
+
+		atlas->pages[atlas->nPages++] = page;
+
+		if (!gdi_glyph_page_alloc(page, cx, cy, &shelf, &x, &y))
+			return FALSE;
+	}
+
+	glyph->page = page;
+	glyph->shelf = shelf;
+	glyph->maskStep = page->width;
+	glyph->mask = &page->data[1ull * y * page->width + x];
+
+	for (line = 0; line < cy; line++)
+	{
+		UINT32 col;
+		const BYTE* src = &aj[1ull * line * scanline];
+		BYTE* dst = &page->data[1ull * (y + line) * page->width + x];
+
+		for (col = 0; col < cx; col++)
+			dst[col] = (src[col / 8] & (0x80 >> (col % 8))) ? 0xFF : 0x00;
+	}
+
+	return TRUE;
+}
+
+void gdi_glyph_atlas_remove(gdi_glyph_internal* glyph)
+{
+	gdiGlyphPage* page;
+	gdiGlyphShelf* shelf;
+
+	if (!glyph || !glyph->page)
+		return;
+
+	page = glyph->page;
+	shelf = &page->shelves[glyph->shelf];
+	glyph->page = NULL;
+	glyph->mask = NULL;
+
+	WINPR_ASSERT(shelf->used > 0);
+	WINPR_ASSERT(page->used > 0);
+	shelf->used--;
+	page->used--;
+
+	if (shelf->used == 0)
+		shelf->x = 0;
+
+	if (page->used == 0)
+	{
+		if (!page->atlas)
+			gdi_glyph_page_free(page);
+		else
+		{
+			page->nShelves = 0;
+			page->nextY = 0;
+		}
+	}
+}
+
+BOOL gdi_glyph_run_begin(gdiGlyphAtlas* atlas, HGDI_DC hdc)
+{
+	if (!atlas || !hdc)
+		return FALSE;
+
+	/* a run aborted by an error is drawn before starting the next one */
+	if (atlas->hdc && !gdi_glyph_run_end(atlas))
+		return FALSE;
+
+	atlas->hdc = hdc;
+	atlas->nEntries = 0;
+	atlas->left = INT32_MAX;
+	atlas->top = INT32_MAX;
+	atlas->right = INT32_MIN;
+	atlas->bottom = INT32_MIN;
+	return TRUE;
+}
+
+BOOL gdi_glyph_run_active(const gdiGlyphAtlas* atlas)
+{
+	return atlas && atlas->hdc;
+}
+
+BOOL gdi_glyph_run_add(gdiGlyphAtlas* atlas, const gdi_glyph_internal* glyph, INT32 x, INT32 y,
+                       INT32 w, INT32 h, INT32 sx, INT32 sy)
+{
+	HGDI_BITMAP hBmp;
+	gdiGlyphRunEntry* entry;
+	const rdpGlyph* base = (const rdpGlyph*)&glyph->common;
+
+	if (!atlas || !glyph)
+		return FALSE;
+
+	if (!atlas->hdc)
+	{
+		WLog_ERR(TAG, "glyph drawn outside of a glyph run");
+		return FALSE;
+	}
+
+	if (!gdi_ClipCoords(atlas->hdc, &x, &y, &w, &h, &sx, &sy))
+		return TRUE;
+
+	hBmp = (HGDI_BITMAP)atlas->hdc->selectedObject;
+
+	if (!hBmp)
+		return FALSE;
+
+	/* same clamping as gdi_BitBlt applies to destination and source */
+	if (x < 0)
+	{
+		sx -= x;
+		w += x;
+		x = 0;
+	}
+
+	if (y < 0)
+	{
+		sy -= y;
+		h += y;
+		y = 0;
+	}
+
+	if (x + w > hBmp->width)
+		w = hBmp->width - x;
+
+	if (y + h > hBmp->height)
+		h = hBmp->height - y;
+
+	if ((w <= 0) || (h <= 0))
+		return TRUE;
+
+	if (sx < 0)
+		sx = 0;
+
+	if (sy < 0)
+		sy = 0;
+
+	if (sx + w > (INT64)base->cx)
+		sx = (INT32)base->cx - w;
+
+	if (sy + h > (INT64)base->cy)
+		sy = (INT32)base->cy - h;
+
+	if ((sx < 0) || (sy < 0) || !glyph->mask)
+		return FALSE;
+
+	if (atlas->nEntries >= atlas->maxEntries)
+	{
+		const size_t maxEntries = MAX(64, atlas->maxEntries * 2);
+		gdiGlyphRunEntry* entries = realloc(atlas->entries, maxEntries * sizeof(gdiGlyphRunEntry));
+
+		if (!entries)
+			return FALSE;
+
+		atlas->entries = entries;
+		atlas->maxEntries = maxEntries;
+	}
+
+	entry = &atlas->entries[atlas->nEntries++];
+	entry->mask = &glyph->mask[1ull * sy * glyph->maskStep + sx];
+	entry->maskStep = glyph->maskStep;
+	entry->x = x;
+	entry->y = y;
+	entry->w = w;
+	entry->h = h;
+	atlas->left = MIN(atlas->left, x);
+	atlas->top = MIN(atlas->top, y);
+	atlas->right = MAX(atlas->right, x + w);
+	atlas->bottom = MAX(atlas->bottom, y + h);
+	return TRUE;
+}
+
+/* Set mask pixels take the color bits of the foreground, like the S ? P : D glyph ROP */
+static void gdi_glyph_blend_32(BYTE* pDst, UINT32 nDstStep, const BYTE* pMask, UINT32 nMaskStep,
+                               INT32 nWidth, INT32 nHeight, UINT32 color, UINT32 bits)
+{
+	INT32 x, y;
+
+	for (y = 0; y < nHeight; y++)
+	{
+		UINT32* dst = (UINT32*)&pDst[1ull * y * nDstStep];
+		const BYTE* mask = &pMask[1ull * y * nMaskStep];
+
+		for (x = 0; x < nWidth; x++)
+		{
+			const UINT32 m = (0u - (UINT32)(mask[x] >> 7)) & bits;
+			dst[x] = (dst[x] & ~m) | (color & m);
+		}
+	}
+}
+
+static void gdi_glyph_blend(BYTE* pDst, UINT32 nDstStep, UINT32 format, const BYTE* pMask,
+                            UINT32 nMaskStep, INT32 nWidth, INT32 nHeight, UINT32 color,
+                            UINT32 bits)
+{
+	INT32 x, y;
+	const size_t bpp = FreeRDPGetBytesPerPixel(format);
+
+	for (y = 0; y < nHeight; y++)
+	{
+		BYTE* dst = &pDst[1ull * y * nDstStep];
+		const BYTE* mask = &pMask[1ull * y * nMaskStep];
+
+		for (x = 0; x < nWidth; x++)
+		{
+			if (mask[x])
+			{
+				const UINT32 dstColor = FreeRDPReadColor(&dst[x * bpp], format);
+				FreeRDPWriteColor(&dst[x * bpp], format, (color & bits) | (dstColor & ~bits));
+			}
+		}
+	}
+}
+
+BOOL gdi_glyph_run_end(gdiGlyphAtlas* atlas)
+{
+	size_t i;
+	BOOL rc = TRUE;
+	HGDI_DC hdc;
+	HGDI_BITMAP hBmp;
+	UINT32 bpp;
+	UINT32 color;
+	UINT32 bits;
+
+	if (!atlas)
+		return FALSE;
+
+	hdc = atlas->hdc;
+	atlas->hdc = NULL;
+
+	if (!hdc || (atlas->nEntries == 0))
+		return TRUE;
+
+	hBmp = (HGDI_BITMAP)hdc->selectedObject;
+
+	if (!hBmp)
+		return FALSE;
+
+	bpp = FreeRDPGetBytesPerPixel(hdc->format);
+	color = hdc->textColor;
+	bits = FreeRDPGetColor(hdc->format, 0xFF, 0xFF, 0xFF, 0xFF);
+
+	if (bpp == 4)
+	{
+		UINT32 nativeColor = 0;
+		UINT32 nativeBits = 0;
+		FreeRDPWriteColor((BYTE*)&nativeColor, hdc->format, color);
+		FreeRDPWriteColor((BYTE*)&nativeBits, hdc->format, bits);
+
+		for (i = 0; i < atlas->nEntries; i++)
+		{
+			const gdiGlyphRunEntry* entry = &atlas->entries[i];
+			BYTE* dst = &hBmp->data[1ull * entry->y * hBmp->scanline + 4ull * entry->x];
+			gdi_glyph_blend_32(dst, hBmp->scanline, entry->mask, entry->maskStep, entry->w,
+			                   entry->h, nativeColor, nativeBits);
+		}
+	}
+	else
+	{
+		for (i = 0; i < atlas->nEntries; i++)
+		{
+			const gdiGlyphRunEntry* entry = &atlas->entries[i];
+			BYTE* dst = &hBmp->data[1ull * entry->y * hBmp->scanline + 1ull * bpp * entry->x];
+			gdi_glyph_blend(dst, hBmp->scanline, hdc->format, entry->mask, entry->maskStep,
+			                entry->w, entry->h, color, bits);
+		}
+	}
+
+	if (!gdi_InvalidateRegion(hdc, atlas->left, atlas->top, atlas->right - atlas->left,
+	                          atlas->bottom - atlas->top))
+		rc = FALSE;
+
+	atlas->nEntries = 0;
+	return rc;
+}
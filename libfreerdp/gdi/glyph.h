@@ -0,0 +1,76 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Implementation
+ * GDI Glyph Atlas
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FREERDP_LIB_GDI_GLYPH_H
+#define FREERDP_LIB_GDI_GLYPH_H
+
+#include <winpr/assert.h>
+
+#include <freerdp/api.h>
+#include <freerdp/gdi/gdi.h>
+
+typedef struct gdi_glyph_page gdiGlyphPage;
+typedef struct gdi_glyph_atlas gdiGlyphAtlas;
+
+/* The GDI glyph prototype allocates this, the public gdiGlyph members stay unused */
+typedef struct
+{
+	gdiGlyph common;
+
+	gdiGlyphPage* page; /* atlas page holding the mask */
+	size_t shelf;
+	const BYTE* mask; /* one byte per pixel, 0x00 or 0xFF */
+	UINT32 maskStep;
+} gdi_glyph_internal;
+
+/* The GDI allocated by gdi_init_ex, owning the glyph atlas */
+typedef struct
+{
+	rdpGdi common;
+
+	gdiGlyphAtlas* glyphAtlas;
+} rdp_gdi_internal;
+
+static INLINE gdiGlyphAtlas* gdi_get_glyph_atlas(rdpGdi* gdi)
+{
+	WINPR_ASSERT(gdi);
+	return ((rdp_gdi_internal*)gdi)->glyphAtlas;
+}
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+	FREERDP_LOCAL gdiGlyphAtlas* gdi_glyph_atlas_new(void);
+	FREERDP_LOCAL void gdi_glyph_atlas_free(gdiGlyphAtlas* atlas);
+
+	FREERDP_LOCAL BOOL gdi_glyph_atlas_add(gdiGlyphAtlas* atlas, gdi_glyph_internal* glyph,
+	                                       UINT32 cx, UINT32 cy, const BYTE* aj);
+	FREERDP_LOCAL void gdi_glyph_atlas_remove(gdi_glyph_internal* glyph);
+
+	FREERDP_LOCAL BOOL gdi_glyph_run_begin(gdiGlyphAtlas* atlas, HGDI_DC hdc);
+	FREERDP_LOCAL BOOL gdi_glyph_run_active(const gdiGlyphAtlas* atlas);
+	FREERDP_LOCAL BOOL gdi_glyph_run_add(gdiGlyphAtlas* atlas, const gdi_glyph_internal* glyph,
+	                                     INT32 x, INT32 y, INT32 w, INT32 h, INT32 sx, INT32 sy);
+	FREERDP_LOCAL BOOL gdi_glyph_run_end(gdiGlyphAtlas* atlas);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FREERDP_LIB_GDI_GLYPH_H */
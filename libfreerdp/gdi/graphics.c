@@ -33,6 +33,8 @@
 #include "drawing.h"
 #include "brush.h"
 #include "graphics.h"
+#include "glyph.h"
+#include "../cache/cache.h"
 
 #define TAG FREERDP_TAG("gdi")
 /* Bitmap Class */
@@ -113,11 +115,92 @@ static void gdi_Bitmap_Free(rdpContext* context, rdpBitmap* bitmap)
 		gdi_DeleteObject((HGDIOBJECT)gdi_bitmap->bitmap);
 		gdi_DeleteDC(gdi_bitmap->hdc);
 		winpr_aligned_free(bitmap->data);
+		free(gdi_bitmap->compact);
 	}
 
 	free(bitmap);
 }
 
+/* Only the compressed pixels are kept while compacted, the decoded copy in bitmap->data is
+ * dropped as well and recreated on restore. */
+static BOOL gdi_Bitmap_Compact(rdpContext* context, rdpBitmap* bitmap, BOOL compact)
+{
+	BYTE* data;
+	size_t size;
+	gdiBitmap* gdi_bitmap = (gdiBitmap*)bitmap;
+	HGDI_BITMAP hBitmap;
+
+	WINPR_ASSERT(context);
+	WINPR_ASSERT(gdi_bitmap);
+
+	hBitmap = gdi_bitmap->bitmap;
+
+	if (!hBitmap)
+		return FALSE;
+
+	size = 1ull * hBitmap->scanline * hBitmap->height;
+
+	if (compact)
+	{
+		UINT32 length = 0;
+
+		if (!hBitmap->data || (hBitmap->free != winpr_aligned_free) || gdi_bitmap->compact)
+			return FALSE;
+
+		if (bitmap->data && (bitmap->length != size))
+			return FALSE;
+
+		data = cache_memory_compact_pixels(context->cache, hBitmap->data, hBitmap->format,
+		                                   hBitmap->width, hBitmap->height, hBitmap->scanline,
+		                                   &length);
+
+		if (!data)
+			return FALSE;
+
+		gdi_bitmap->compact = data;
+		gdi_bitmap->compactCopy = (bitmap->data != NULL);
+		bitmap->compactLength = length;
+		winpr_aligned_free(hBitmap->data);
+		hBitmap->data = NULL;
+		winpr_aligned_free(bitmap->data);
+		bitmap->data = NULL;
+		return TRUE;
+	}
+
+	if (!gdi_bitmap->compact)
+		return FALSE;
+
+	data = winpr_aligned_malloc(size, 16);
+
+	if (!data)
+		return FALSE;
+
+	if (!cache_memory_restore_pixels(context->cache, gdi_bitmap->compact, bitmap->compactLength,
+	                                 data, hBitmap->format, hBitmap->width, hBitmap->height,
+	                                 hBitmap->scanline))
+		goto fail;
+
+	if (gdi_bitmap->compactCopy)
+	{
+		bitmap->data = winpr_aligned_malloc(size, 16);
+
+		if (!bitmap->data)
+			goto fail;
+
+		memcpy(bitmap->data, data, size);
+	}
+
+	hBitmap->data = data;
+	free(gdi_bitmap->compact);
+	gdi_bitmap->compact = NULL;
+	gdi_bitmap->compactCopy = FALSE;
+	bitmap->compactLength = 0;
+	return TRUE;
+fail:
+	winpr_aligned_free(data);
+	return FALSE;
+}
+
 static BOOL gdi_Bitmap_Paint(rdpContext* context, rdpBitmap* bitmap)
 {
 	gdiBitmap* gdi_bitmap = (gdiBitmap*)bitmap;
@@ -248,51 +331,27 @@ static BOOL gdi_Bitmap_SetSurface(rdpContext* context, rdpBitmap* bitmap, BOOL p
 /* Glyph Class */
 static BOOL gdi_Glyph_New(rdpContext* context, rdpGlyph* glyph)
 {
-	BYTE* data;
-	gdiGlyph* gdi_glyph;
+	gdi_glyph_internal* gdi_glyph;
 
-	if (!context || !glyph)
+	if (!context || !context->gdi || !glyph)
 		return FALSE;
 
-	gdi_glyph = (gdiGlyph*)glyph;
-	gdi_glyph->hdc = gdi_GetDC();
-
-	if (!gdi_glyph->hdc)
-		return FALSE;
-
-	gdi_glyph->hdc->format = PIXEL_FORMAT_MONO;
-	data = freerdp_glyph_convert(glyph->cx, glyph->cy, glyph->aj);
-
-	if (!data)
-	{
-		gdi_DeleteDC(gdi_glyph->hdc);
+	if (glyph->cb < 1ull * ((glyph->cx + 7) / 8) * glyph->cy)
 		return FALSE;
-	}
-
-	gdi_glyph->bitmap = gdi_CreateBitmap(glyph->cx, glyph->cy, PIXEL_FORMAT_MONO, data);
 
-	if (!gdi_glyph->bitmap)
-	{
-		gdi_DeleteDC(gdi_glyph->hdc);
-		winpr_aligned_free(data);
-		return FALSE;
-	}
-
-	gdi_SelectObject(gdi_glyph->hdc, (HGDIOBJECT)gdi_glyph->bitmap);
-	gdi_glyph->org_bitmap = NULL;
-	return TRUE;
+	gdi_glyph = (gdi_glyph_internal*)glyph;
+	return gdi_glyph_atlas_add(gdi_get_glyph_atlas(context->gdi), gdi_glyph, glyph->cx, glyph->cy,
+	                           glyph->aj);
 }
 
 static void gdi_Glyph_Free(rdpContext* context, rdpGlyph* glyph)
 {
-	gdiGlyph* gdi_glyph;
-	gdi_glyph = (gdiGlyph*)glyph;
+	gdi_glyph_internal* gdi_glyph;
+	gdi_glyph = (gdi_glyph_internal*)glyph;
 
 	if (gdi_glyph)
 	{
-		gdi_SelectObject(gdi_glyph->hdc, (HGDIOBJECT)gdi_glyph->org_bitmap);
-		gdi_DeleteObject((HGDIOBJECT)gdi_glyph->bitmap);
-		gdi_DeleteDC(gdi_glyph->hdc);
+		gdi_glyph_atlas_remove(gdi_glyph);
 		free(glyph->aj);
 		free(glyph);
 	}
@@ -301,55 +360,32 @@ static void gdi_Glyph_Free(rdpContext* context, rdpGlyph* glyph)
 static BOOL gdi_Glyph_Draw(rdpContext* context, const rdpGlyph* glyph, INT32 x, INT32 y, INT32 w,
                            INT32 h, INT32 sx, INT32 sy, BOOL fOpRedundant)
 {
-	const gdiGlyph* gdi_glyph;
+	const gdi_glyph_internal* gdi_glyph;
+	gdiGlyphAtlas* atlas;
 	rdpGdi* gdi;
-	HGDI_BRUSH brush;
-	BOOL rc = FALSE;
 
-	if (!context || !glyph)
+	WINPR_UNUSED(fOpRedundant);
+
+	if (!context || !context->gdi || !glyph)
 		return FALSE;
 
 	gdi = context->gdi;
-	gdi_glyph = (const gdiGlyph*)glyph;
-
-	if (!fOpRedundant && 0)
-	{
-		GDI_RECT rect = { 0 };
-
-		if (x > 0)
-			rect.left = x;
-
-		if (y > 0)
-			rect.top = y;
-
-		if (x + w > 0)
-			rect.right = x + w - 1;
+	gdi_glyph = (const gdi_glyph_internal*)glyph;
+	atlas = gdi_get_glyph_atlas(gdi);
 
-		if (y + h > 0)
-			rect.bottom = y + h - 1;
-
-		if ((rect.left < rect.right) && (rect.top < rect.bottom))
-		{
-			brush = gdi_CreateSolidBrush(gdi->drawing->hdc->bkColor);
-
-			if (!brush)
-				return FALSE;
+	if (!gdi->drawing || !gdi->drawing->hdc)
+		return FALSE;
 
-			gdi_FillRect(gdi->drawing->hdc, &rect, brush);
-			gdi_DeleteObject((HGDIOBJECT)brush);
-		}
+	/* glyphs are collected and blended when the text run ends, a glyph drawn outside of
+	 * Glyph_BeginDraw/Glyph_EndDraw is a run of its own */
+	if (!gdi_glyph_run_active(atlas))
+	{
+		return gdi_glyph_run_begin(atlas, gdi->drawing->hdc) &&
+		       gdi_glyph_run_add(atlas, gdi_glyph, x, y, w, h, sx, sy) &&
+		       gdi_glyph_run_end(atlas);
 	}
 
-	brush = gdi_CreateSolidBrush(gdi->drawing->hdc->textColor);
-
-	if (!brush)
-		return FALSE;
-
-	gdi_SelectObject(gdi->drawing->hdc, (HGDIOBJECT)brush);
-	rc = gdi_BitBlt(gdi->drawing->hdc, x, y, w, h, gdi_glyph->hdc, sx, sy, GDI_GLYPH_ORDER,
-	                &context->gdi->palette);
-	gdi_DeleteObject((HGDIOBJECT)brush);
-	return rc;
+	return gdi_glyph_run_add(atlas, gdi_glyph, x, y, w, h, sx, sy);
 }
 
 static BOOL gdi_Glyph_SetBounds(rdpContext* context, INT32 x, INT32 y, INT32 width, INT32 height)
@@ -415,15 +451,17 @@ static BOOL gdi_Glyph_BeginDraw(rdpContext* context, INT32 x, INT32 y, INT32 wid
 			gdi_DeleteObject((HGDIOBJECT)brush);
 		}
 
-		return gdi_SetNullClipRgn(gdi->drawing->hdc);
+		if (!gdi_SetNullClipRgn(gdi->drawing->hdc))
+			return FALSE;
 	}
 
-	return TRUE;
+	return gdi_glyph_run_begin(gdi_get_glyph_atlas(gdi), gdi->drawing->hdc);
 }
 
 static BOOL gdi_Glyph_EndDraw(rdpContext* context, INT32 x, INT32 y, INT32 width, INT32 height,
                               UINT32 bgcolor, UINT32 fgcolor)
 {
+	BOOL rc;
 	rdpGdi* gdi;
 
 	if (!context || !context->gdi)
@@ -434,14 +472,15 @@ static BOOL gdi_Glyph_EndDraw(rdpContext* context, INT32 x, INT32 y, INT32 width
 	if (!gdi->drawing || !gdi->drawing->hdc)
 		return FALSE;
 
+	rc = gdi_glyph_run_end(gdi_get_glyph_atlas(gdi));
 	gdi_SetNullClipRgn(gdi->drawing->hdc);
-	return TRUE;
+	return rc;
 }
 
 /* Graphics Module */
 BOOL gdi_register_graphics(rdpGraphics* graphics)
 {
-	rdpBitmap bitmap;
+	rdpBitmap bitmap = { 0 };
 	rdpGlyph glyph;
 	bitmap.size = sizeof(gdiBitmap);
 	bitmap.New = gdi_Bitmap_New;
@@ -449,8 +488,9 @@ BOOL gdi_register_graphics(rdpGraphics* graphics)
 	bitmap.Paint = gdi_Bitmap_Paint;
 	bitmap.Decompress = gdi_Bitmap_Decompress;
 	bitmap.SetSurface = gdi_Bitmap_SetSurface;
+	bitmap.Compact = gdi_Bitmap_Compact;
 	graphics_register_bitmap(graphics, &bitmap);
-	glyph.size = sizeof(gdiGlyph);
+	glyph.size = sizeof(gdi_glyph_internal);
 	glyph.New = gdi_Glyph_New;
 	glyph.Free = gdi_Glyph_Free;
 	glyph.Draw = gdi_Glyph_Draw;
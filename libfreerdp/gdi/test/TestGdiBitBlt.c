@@ -7,6 +7,7 @@
 #include <freerdp/gdi/bitmap.h>
 
 #include <winpr/crt.h>
+#include <winpr/crypto.h>
 
 #include "line.h"
 #include "brush.h"
@@ -535,6 +536,202 @@ fail:
 	return TRUE; // rc;
 }
 
+/* Per pixel reference for the raster operation engine, evaluates the ROP string directly. */
+static UINT32 test_eval_rop(const char* rop, UINT32 src, UINT32 dst, UINT32 pat, UINT32 format)
+{
+	UINT32 stack[10] = { 0 };
+	UINT32 stackp = 0;
+
+	while (*rop != '\0')
+	{
+		switch (*rop++)
+		{
+			case '0':
+				stack[stackp++] = FreeRDPGetColor(format, 0, 0, 0, 0xFF);
+				break;
+
+			case '1':
+				stack[stackp++] = FreeRDPGetColor(format, 0xFF, 0xFF, 0xFF, 0xFF);
+				break;
+
+			case 'D':
+				stack[stackp++] = dst;
+				break;
+
+			case 'S':
+				stack[stackp++] = src;
+				break;
+
+			case 'P':
+				stack[stackp++] = pat;
+				break;
+
+			case 'x':
+				stackp--;
+				stack[stackp - 1] ^= stack[stackp];
+				break;
+
+			case 'a':
+				stackp--;
+				stack[stackp - 1] &= stack[stackp];
+				break;
+
+			case 'o':
+				stackp--;
+				stack[stackp - 1] |= stack[stackp];
+				break;
+
+			case 'n':
+				stack[stackp - 1] = ~stack[stackp - 1];
+				break;
+
+			default:
+				break;
+		}
+	}
+
+	return stack[0];
+}
+
+static BOOL test_rop_engine(HGDI_DC hdcDst, HGDI_DC hdcSrc, HGDI_BITMAP hBmpPattern, UINT32 rop,
+                            const gdiPalette* hPalette)
+{
+	BOOL rc = FALSE;
+	UINT32 x, y;
+	const UINT32 nXDst = 3;
+	const UINT32 nYDst = 1;
+	const UINT32 nXSrc = 5;
+	const UINT32 nYSrc = 2;
+	HGDI_BITMAP hBmpDst = (HGDI_BITMAP)hdcDst->selectedObject;
+	HGDI_BITMAP hBmpSrc = (HGDI_BITMAP)hdcSrc->selectedObject;
+	const UINT32 nWidth = hBmpDst->width - nXDst - 2;
+	const UINT32 nHeight = hBmpDst->height - nYDst - 1;
+	const size_t size = 1ull * hBmpDst->scanline * hBmpDst->height;
+	const char* str = gdi_rop_to_string(rop);
+	BYTE* expected = malloc(size);
+
+	if (!expected)
+		return FALSE;
+
+	winpr_RAND(hBmpDst->data, size);
+	winpr_RAND(hBmpSrc->data, 1ull * hBmpSrc->scanline * hBmpSrc->height);
+	memcpy(expected, hBmpDst->data, size);
+
+	for (y = 0; y < nHeight; y++)
+	{
+		for (x = 0; x < nWidth; x++)
+		{
+			const size_t dstBpp = FreeRDPGetBytesPerPixel(hdcDst->format);
+			const size_t srcBpp = FreeRDPGetBytesPerPixel(hdcSrc->format);
+			BYTE* dstp = &expected[(nYDst + y) * hBmpDst->scanline + (nXDst + x) * dstBpp];
+			const BYTE* srcp =
+			    &hBmpSrc->data[(nYSrc + y) * hBmpSrc->scanline + (nXSrc + x) * srcBpp];
+			UINT32 src = FreeRDPReadColor(srcp, hdcSrc->format);
+			UINT32 pat = hdcDst->brush->color;
+
+			if (hBmpPattern)
+			{
+				const UINT32 px = (nXDst + x) % hBmpPattern->width;
+				const UINT32 py = (nYDst + y) % hBmpPattern->height;
+				pat = FreeRDPReadColor(
+				    &hBmpPattern->data[py * hBmpPattern->scanline + px * dstBpp], hdcDst->format);
+			}
+
+			src = FreeRDPConvertColor(src, hdcSrc->format, hdcDst->format, hPalette);
+			FreeRDPWriteColor(dstp, hdcDst->format,
+			                  test_eval_rop(str, src, FreeRDPReadColor(dstp, hdcDst->format), pat,
+			                                hdcDst->format));
+		}
+	}
+
+	if (!gdi_BitBlt(hdcDst, nXDst, nYDst, nWidth, nHeight, hdcSrc, nXSrc, nYSrc, rop, hPalette))
+		goto fail;
+
+	if (memcmp(hBmpDst->data, expected, size) != 0)
+	{
+		fprintf(stderr, "%s: %s mismatch for %s -> %s\n", __FUNCTION__, str,
+		        FreeRDPGetColorFormatName(hdcSrc->format),
+		        FreeRDPGetColorFormatName(hdcDst->format));
+		goto fail;
+	}
+
+	rc = TRUE;
+fail:
+	free(expected);
+	return rc;
+}
+
+static BOOL test_gdi_BitBlt_rop_engine(UINT32 SrcFormat, UINT32 DstFormat)
+{
+	BOOL rc = FALSE;
+	size_t x, y;
+	HGDI_DC hdcSrc = NULL;
+	HGDI_DC hdcDst = NULL;
+	HGDI_BITMAP hBmpSrc = NULL;
+	HGDI_BITMAP hBmpDst = NULL;
+	HGDI_BITMAP hBmpPattern = NULL;
+	HGDI_BRUSH solid = NULL;
+	HGDI_BRUSH pattern = NULL;
+	gdiPalette g = { 0 };
+	const UINT32 rops[] = { GDI_SPna,      GDI_BLACKNESS, GDI_WHITENESS, GDI_SRCAND,
+		                    GDI_SRCPAINT,  GDI_SRCINVERT, GDI_SRCERASE,  GDI_NOTSRCCOPY,
+		                    GDI_DSTINVERT, GDI_MERGECOPY, GDI_MERGEPAINT, GDI_PATCOPY,
+		                    GDI_PATPAINT,  GDI_PATINVERT, GDI_DSPDxax,   GDI_PSDPxax,
+		                    GDI_PDSona,    GDI_DPSDonox,  GDI_SPDSxax,   GDI_GLYPH_ORDER };
+
+	g.format = DstFormat;
+
+	for (x = 0; x < 256; x++)
+		g.palette[x] = FreeRDPGetColor(DstFormat, x, x, x, 0xFF);
+
+	if (!(hdcSrc = gdi_GetDC()) || !(hdcDst = gdi_GetDC()))
+		goto fail;
+
+	hdcSrc->format = SrcFormat;
+	hdcDst->format = DstFormat;
+
+	/* wider than one chunk of the row engine */
+	if (!(hBmpSrc = gdi_CreateCompatibleBitmap(hdcSrc, 300, 6)))
+		goto fail;
+
+	if (!(hBmpDst = gdi_CreateCompatibleBitmap(hdcDst, 300, 6)))
+		goto fail;
+
+	if (!(hBmpPattern = gdi_CreateCompatibleBitmap(hdcDst, 8, 8)))
+		goto fail;
+
+	winpr_RAND(hBmpPattern->data, 1ull * hBmpPattern->scanline * hBmpPattern->height);
+	gdi_SelectObject(hdcSrc, (HGDIOBJECT)hBmpSrc);
+	gdi_SelectObject(hdcDst, (HGDIOBJECT)hBmpDst);
+
+	if (!(solid = gdi_CreateSolidBrush(0x123456)) ||
+	    !(pattern = gdi_CreatePatternBrush(hBmpPattern)))
+		goto fail;
+
+	for (y = 0; y < 2; y++)
+	{
+		gdi_SelectObject(hdcDst, (HGDIOBJECT)(y == 0 ? solid : pattern));
+
+		for (x = 0; x < ARRAYSIZE(rops); x++)
+		{
+			if (!test_rop_engine(hdcDst, hdcSrc, (y == 0) ? NULL : hBmpPattern, rops[x], &g))
+				goto fail;
+		}
+	}
+
+	rc = TRUE;
+fail:
+	gdi_SelectObject(hdcDst, NULL);
+	gdi_DeleteObject((HGDIOBJECT)solid);
+	gdi_DeleteObject((HGDIOBJECT)pattern);
+	gdi_DeleteObject((HGDIOBJECT)hBmpPattern);
+	gdi_DeleteObject((HGDIOBJECT)hBmpSrc);
+	gdi_DeleteObject((HGDIOBJECT)hBmpDst);
+	gdi_DeleteDC(hdcSrc);
+	gdi_DeleteDC(hdcDst);
+	return rc;
+}
+
 int TestGdiBitBlt(int argc, char* argv[])
 {
 	int rc = 0;
@@ -564,5 +761,18 @@ int TestGdiBitBlt(int argc, char* argv[])
 		}
 	}
 
+	for (x = 0; x < listSize; x++)
+	{
+		for (y = 0; y < listSize; y++)
+		{
+			if ((FreeRDPGetBytesPerPixel(formatList[y]) != 4) ||
+			    (FreeRDPGetBytesPerPixel(formatList[x]) == 1))
+				continue;
+
+			if (!test_gdi_BitBlt_rop_engine(formatList[x], formatList[y]))
+				rc = -1;
+		}
+	}
+
 	return rc;
 }
@@ -0,0 +1,265 @@
+#include <freerdp/gdi/gdi.h>
+
+#include <freerdp/gdi/dc.h>
+#include <freerdp/gdi/region.h>
+#include <freerdp/gdi/bitmap.h>
+
+#include <winpr/crt.h>
+#include <winpr/crypto.h>
+
+#include <freerdp/freerdp.h>
+#include <freerdp/graphics.h>
+
+#include "brush.h"
+#include "clipping.h"
+#include "glyph.h"
+
+typedef struct
+{
+	gdi_glyph_internal glyph;
+	BYTE* aj;
+} test_glyph;
+
+static BOOL test_glyph_init(gdiGlyphAtlas* atlas, test_glyph* glyph, UINT32 cx, UINT32 cy)
+{
+	rdpGlyph* base = (rdpGlyph*)&glyph->glyph.common;
+	const size_t size = 1ull * ((cx + 7) / 8) * cy;
+
+	base->cx = cx;
+	base->cy = cy;
+	glyph->aj = malloc(MAX(size, 1));
+
+	if (!glyph->aj)
+		return FALSE;
+
+	winpr_RAND(glyph->aj, size);
+	return gdi_glyph_atlas_add(atlas, &glyph->glyph, cx, cy, glyph->aj);
+}
+
+/* draw a glyph the way the GDI did before the atlas, as mono bitmap with the glyph ROP */
+static BOOL test_glyph_blt(HGDI_DC hdc, const rdpGlyph* base, const BYTE* aj, INT32 x, INT32 y,
+                           INT32 w, INT32 h, INT32 sx, INT32 sy)
+{
+	BOOL rc = FALSE;
+	HGDI_DC hdcGlyph = gdi_GetDC();
+	HGDI_BITMAP hBmp = NULL;
+	HGDI_BRUSH brush = gdi_CreateSolidBrush(hdc->textColor);
+	BYTE* data = freerdp_glyph_convert(base->cx, base->cy, aj);
+
+	if (!hdcGlyph || !brush || !data)
+		goto fail;
+
+	hdcGlyph->format = PIXEL_FORMAT_MONO;
+	hBmp = gdi_CreateBitmap(base->cx, base->cy, PIXEL_FORMAT_MONO, data);
+
+	if (!hBmp)
+		goto fail;
+
+	data = NULL;
+	gdi_SelectObject(hdcGlyph, (HGDIOBJECT)hBmp);
+	gdi_SelectObject(hdc, (HGDIOBJECT)brush);
+	rc = gdi_BitBlt(hdc, x, y, w, h, hdcGlyph, sx, sy, GDI_GLYPH_ORDER, NULL);
+fail:
+	winpr_aligned_free(data);
+	gdi_DeleteObject((HGDIOBJECT)hBmp);
+	gdi_DeleteObject((HGDIOBJECT)brush);
+	gdi_DeleteDC(hdcGlyph);
+	return rc;
+}
+
+static INT32 test_glyph_x(size_t index)
+{
+	return (INT32)(index * 13) - 6;
+}
+
+static INT32 test_glyph_y(size_t index)
+{
+	return (INT32)(index * 9) % 190;
+}
+
+static BOOL test_glyph_run(UINT32 format)
+{
+	BOOL rc = FALSE;
+	size_t i;
+	size_t size;
+	HGDI_DC hdc = NULL;
+	HGDI_BITMAP hBmp = NULL;
+	BYTE* expected = NULL;
+	BYTE* background = NULL;
+	test_glyph glyphs[24] = { 0 };
+	gdiGlyphAtlas* atlas = gdi_glyph_atlas_new();
+
+	if (!atlas || !(hdc = gdi_GetDC()))
+		goto fail;
+
+	hdc->format = format;
+	hdc->textColor = FreeRDPGetColor(format, 0x12, 0x34, 0x56, 0xFF);
+
+	if (!(hBmp = gdi_CreateCompatibleBitmap(hdc, 320, 200)))
+		goto fail;
+
+	gdi_SelectObject(hdc, (HGDIOBJECT)hBmp);
+	gdi_SetClipRgn(hdc, 4, 2, 300, 190);
+	size = 1ull * hBmp->scanline * hBmp->height;
+	winpr_RAND(hBmp->data, size);
+
+	if (!(expected = malloc(size)) || !(background = malloc(size)))
+		goto fail;
+
+	/* the last glyph does not fit into an atlas page */
+	for (i = 0; i < ARRAYSIZE(glyphs); i++)
+	{
+		const UINT32 cx = (i == ARRAYSIZE(glyphs) - 1) ? 280 : 3 + (UINT32)(i * 5) % 17;
+		const UINT32 cy = 5 + (UINT32)(i * 7) % 23;
+
+		if (!test_glyph_init(atlas, &glyphs[i], cx, cy))
+			goto fail;
+	}
+
+	/* free a few glyphs and add them again to reuse atlas space */
+	for (i = 0; i < ARRAYSIZE(glyphs); i += 3)
+	{
+		const rdpGlyph* base = (const rdpGlyph*)&glyphs[i].glyph.common;
+		gdi_glyph_atlas_remove(&glyphs[i].glyph);
+
+		if (!gdi_glyph_atlas_add(atlas, &glyphs[i].glyph, base->cx, base->cy, glyphs[i].aj))
+			goto fail;
+	}
+
+	memcpy(background, hBmp->data, size);
+
+	for (i = 0; i < ARRAYSIZE(glyphs); i++)
+	{
+		const rdpGlyph* base = (const rdpGlyph*)&glyphs[i].glyph.common;
+
+		if (!test_glyph_blt(hdc, base, glyphs[i].aj, test_glyph_x(i), test_glyph_y(i),
+		                    (INT32)base->cx, (INT32)base->cy, 0, 0))
+			goto fail;
+	}
+
+	memcpy(expected, hBmp->data, size);
+	memcpy(hBmp->data, background, size);
+
+	if (!gdi_glyph_run_begin(atlas, hdc))
+		goto fail;
+
+	for (i = 0; i < ARRAYSIZE(glyphs); i++)
+	{
+		const rdpGlyph* base = (const rdpGlyph*)&glyphs[i].glyph.common;
+
+		if (!gdi_glyph_run_add(atlas, &glyphs[i].glyph, test_glyph_x(i), test_glyph_y(i),
+		                       (INT32)base->cx, (INT32)base->cy, 0, 0))
+			goto fail;
+	}
+
+	if (!gdi_glyph_run_end(atlas))
+		goto fail;
+
+	if (memcmp(hBmp->data, expected, size) != 0)
+		goto fail;
+
+	rc = TRUE;
+fail:
+	for (i = 0; i < ARRAYSIZE(glyphs); i++)
+	{
+		gdi_glyph_atlas_remove(&glyphs[i].glyph);
+		free(glyphs[i].aj);
+	}
+
+	gdi_glyph_atlas_free(atlas);
+	free(expected);
+	free(background);
+	gdi_DeleteObject((HGDIOBJECT)hBmp);
+	gdi_DeleteDC(hdc);
+	return rc;
+}
+
+/* Glyph_Draw without Glyph_BeginDraw draws the glyph right away */
+static BOOL test_glyph_draw_single(void)
+{
+	BOOL rc = FALSE;
+	size_t size;
+	HGDI_DC hdc;
+	rdpContext* context;
+	rdpGlyph* glyph = NULL;
+	BYTE* expected = NULL;
+	BYTE* background = NULL;
+	BYTE aj[2 * 12] = { 0 };
+	freerdp* instance = freerdp_new();
+
+	if (!instance || !freerdp_context_new(instance))
+		goto fail;
+
+	context = instance->context;
+
+	if (!freerdp_settings_set_uint32(context->settings, FreeRDP_DesktopWidth, 64) ||
+	    !freerdp_settings_set_uint32(context->settings, FreeRDP_DesktopHeight, 32) ||
+	    !gdi_init(instance, PIXEL_FORMAT_BGRX32))
+		goto fail;
+
+	hdc = context->gdi->drawing->hdc;
+	hdc->textColor = FreeRDPGetColor(hdc->format, 0x12, 0x34, 0x56, 0xFF);
+	size = 1ull * context->gdi->stride * context->gdi->height;
+	winpr_RAND(aj, sizeof(aj));
+	winpr_RAND(context->gdi->primary_buffer, size);
+
+	if (!(expected = malloc(size)) || !(background = malloc(size)))
+		goto fail;
+
+	if (!(glyph = Glyph_Alloc(context, 0, 0, 11, 12, sizeof(aj), aj)))
+		goto fail;
+
+	memcpy(background, context->gdi->primary_buffer, size);
+
+	if (!test_glyph_blt(hdc, glyph, aj, 7, 5, 11, 12, 0, 0))
+		goto fail;
+
+	memcpy(expected, context->gdi->primary_buffer, size);
+	memcpy(context->gdi->primary_buffer, background, size);
+
+	if (!glyph->Draw(context, glyph, 7, 5, 11, 12, 0, 0, FALSE))
+		goto fail;
+
+	rc = memcmp(context->gdi->primary_buffer, expected, size) == 0;
+fail:
+	if (glyph)
+		glyph->Free(context, glyph);
+
+	free(expected);
+	free(background);
+
+	if (instance)
+	{
+		gdi_free(instance);
+		freerdp_context_free(instance);
+	}
+
+	freerdp_free(instance);
+	return rc;
+}
+
+int TestGdiGlyph(int argc, char* argv[])
+{
+	size_t x;
+	const UINT32 formats[] = { PIXEL_FORMAT_BGRA32, PIXEL_FORMAT_BGRX32, PIXEL_FORMAT_XRGB32,
+		                       PIXEL_FORMAT_RGBX32, PIXEL_FORMAT_RGB24,  PIXEL_FORMAT_RGB16 };
+	WINPR_UNUSED(argc);
+	WINPR_UNUSED(argv);
+
+	for (x = 0; x < ARRAYSIZE(formats); x++)
+	{
+		if (!test_glyph_run(formats[x]))
+		{
+			fprintf(stderr, "glyph run failed for %s\n", FreeRDPGetColorFormatName(formats[x]));
+			return -1;
+		}
+	}
+
+	if (!test_glyph_draw_single())
+	{
+		fprintf(stderr, "glyph draw without a glyph run failed\n");
+		return -1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,242 @@
+/* FreeRDP: A Remote Desktop Protocol Client
+ * Inverse DWT for the progressive codec.
+ * vi:ts=4 sw=4:
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0.
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <freerdp/config.h>
+
+#include <freerdp/types.h>
+#include <freerdp/primitives.h>
+
+#include "prim_internal.h"
+
+/*
+ * Band	    Offset      Dimensions  Size
+ *
+ * HL1      0           31x33       1023
+ * LH1      1023        33x31       1023
+ * HH1      2046        31x31       961
+ *
+ * HL2      3007        16x17       272
+ * LH2      3279        17x16       272
+ * HH2      3551        16x16       256
+ *
+ * HL3      3807        8x9         72
+ * LH3      3879        9x8         72
+ * HH3      3951        8x8         64
+ *
+ * LL3      4015        9x9         81
+ */
+
+static INLINE void general_idwt_x(const INT16* pLowBand, size_t nLowStep, const INT16* pHighBand,
+                                  size_t nHighStep, INT16* pDstBand, size_t nDstStep,
+                                  size_t nLowCount, size_t nHighCount, size_t nDstCount)
+{
+	size_t i;
+	INT16 L0;
+	INT16 H0, H1;
+	INT16 X0, X1, X2;
+
+	for (i = 0; i < nDstCount; i++)
+	{
+		size_t j;
+		const INT16* pL = pLowBand;
+		const INT16* pH = pHighBand;
+		INT16* pX = pDstBand;
+		H0 = *pH++;
+		L0 = *pL++;
+		X0 = L0 - H0;
+		X2 = L0 - H0;
+
+		for (j = 0; j < (nHighCount - 1); j++)
+		{
+			H1 = *pH;
+			pH++;
+			L0 = *pL;
+			pL++;
+			X2 = L0 - ((H0 + H1) / 2);
+			X1 = ((X0 + X2) / 2) + (2 * H0);
+			pX[0] = X0;
+			pX[1] = X1;
+			pX += 2;
+			X0 = X2;
+			H0 = H1;
+		}
+
+		if (nLowCount <= (nHighCount + 1))
+		{
+			if (nLowCount <= nHighCount)
+			{
+				pX[0] = X2;
+				pX[1] = X2 + (2 * H0);
+			}
+			else
+			{
+				L0 = *pL;
+				pL++;
+				X0 = L0 - H0;
+				pX[0] = X2;
+				pX[1] = ((X0 + X2) / 2) + (2 * H0);
+				pX[2] = X0;
+			}
+		}
+		else
+		{
+			L0 = *pL;
+			pL++;
+			X0 = L0 - (H0 / 2);
+			pX[0] = X2;
+			pX[1] = ((X0 + X2) / 2) + (2 * H0);
+			pX[2] = X0;
+			L0 = *pL;
+			pL++;
+			pX[3] = (X0 + L0) / 2;
+		}
+
+		pLowBand += nLowStep;
+		pHighBand += nHighStep;
+		pDstBand += nDstStep;
+	}
+}
+
+static INLINE void general_idwt_y(const INT16* pLowBand, size_t nLowStep, const INT16* pHighBand,
+                                  size_t nHighStep, INT16* pDstBand, size_t nDstStep,
+                                  size_t nLowCount, size_t nHighCount, size_t nDstCount)
+{
+	size_t i;
+	INT16 L0;
+	INT16 H0, H1;
+	INT16 X0, X1, X2;
+
+	for (i = 0; i < nDstCount; i++)
+	{
+		size_t j;
+		const INT16* pL = pLowBand;
+		const INT16* pH = pHighBand;
+		INT16* pX = pDstBand;
+		H0 = *pH;
+		pH += nHighStep;
+		L0 = *pL;
+		pL += nLowStep;
+		X0 = L0 - H0;
+		X2 = L0 - H0;
+
+		for (j = 0; j < (nHighCount - 1); j++)
+		{
+			H1 = *pH;
+			pH += nHighStep;
+			L0 = *pL;
+			pL += nLowStep;
+			X2 = L0 - ((H0 + H1) / 2);
+			X1 = ((X0 + X2) / 2) + (2 * H0);
+			*pX = X0;
+			pX += nDstStep;
+			*pX = X1;
+			pX += nDstStep;
+			X0 = X2;
+			H0 = H1;
+		}
+
+		if (nLowCount <= (nHighCount + 1))
+		{
+			if (nLowCount <= nHighCount)
+			{
+				*pX = X2;
+				pX += nDstStep;
+				*pX = X2 + (2 * H0);
+			}
+			else
+			{
+				L0 = *pL;
+				X0 = L0 - H0;
+				*pX = X2;
+				pX += nDstStep;
+				*pX = ((X0 + X2) / 2) + (2 * H0);
+				pX += nDstStep;
+				*pX = X0;
+			}
+		}
+		else
+		{
+			L0 = *pL;
+			pL += nLowStep;
+			X0 = L0 - (H0 / 2);
+			*pX = X2;
+			pX += nDstStep;
+			*pX = ((X0 + X2) / 2) + (2 * H0);
+			pX += nDstStep;
+			*pX = X0;
+			pX += nDstStep;
+			L0 = *pL;
+			*pX = (X0 + L0) / 2;
+		}
+
+		pLowBand++;
+		pHighBand++;
+		pDstBand++;
+	}
+}
+
+static INLINE void general_dwt_decode_block(INT16* buffer, INT16* temp, size_t level)
+{
+	size_t nDstStepX;
+	size_t nDstStepY;
+	INT16 *HL, *LH;
+	INT16 *HH, *LL;
+	INT16 *L, *H, *LLx;
+
+	const size_t nBandL = dwt_get_band_l_count(level);
+	const size_t nBandH = dwt_get_band_h_count(level);
+	size_t offset = 0;
+
+	HL = &buffer[offset];
+	offset += (nBandH * nBandL);
+	LH = &buffer[offset];
+	offset += (nBandL * nBandH);
+	HH = &buffer[offset];
+	offset += (nBandH * nBandH);
+	LL = &buffer[offset];
+	nDstStepX = (nBandL + nBandH);
+	nDstStepY = (nBandL + nBandH);
+	offset = 0;
+	L = &temp[offset];
+	offset += (nBandL * nDstStepX);
+	H = &temp[offset];
+	LLx = &buffer[0];
+
+	/* horizontal (LL + HL -> L) */
+	general_idwt_x(LL, nBandL, HL, nBandH, L, nDstStepX, nBandL, nBandH, nBandL);
+
+	/* horizontal (LH + HH -> H) */
+	general_idwt_x(LH, nBandL, HH, nBandH, H, nDstStepX, nBandL, nBandH, nBandH);
+
+	/* vertical (L + H -> LL) */
+	general_idwt_y(L, nDstStepX, H, nDstStepX, LLx, nDstStepY, nBandL, nBandH, nBandL + nBandH);
+}
+
+/* ----------------------------------------------------------------------------
+ * Reduce-extrapolate inverse DWT of a 64x64 tile (levels 3, 2 and 1).
+ * pTemp must hold 4096 coefficients.
+ */
+static pstatus_t general_dwtReduceExtrapolateDecode_16s(INT16* pSrcDst, INT16* pTemp)
+{
+	general_dwt_decode_block(&pSrcDst[3807], pTemp, 3);
+	general_dwt_decode_block(&pSrcDst[3007], pTemp, 2);
+	general_dwt_decode_block(&pSrcDst[0], pTemp, 1);
+	return PRIMITIVES_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+void primitives_init_dwt(primitives_t* prims)
+{
+	prims->dwtReduceExtrapolateDecode_16s = general_dwtReduceExtrapolateDecode_16s;
+}
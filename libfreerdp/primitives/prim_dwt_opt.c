@@ -0,0 +1,348 @@
+/* FreeRDP: A Remote Desktop Protocol Client
+ * Optimized inverse DWT for the progressive codec.
+ * vi:ts=4 sw=4:
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0.
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <freerdp/config.h>
+
+#include <freerdp/types.h>
+#include <freerdp/primitives.h>
+#include <winpr/sysinfo.h>
+
+#ifdef WITH_SSE2
+#include <emmintrin.h>
+#elif defined(WITH_NEON)
+#include <arm_neon.h>
+#endif /* WITH_SSE2 else WITH_NEON */
+
+#include "prim_internal.h"
+
+#if defined(WITH_SSE2) || defined(WITH_NEON)
+
+/* The lifting steps below are written once against these helpers, which map to SSE2 or NEON.
+ * Additions and subtractions are done on 8 lanes of 16 bit and wrap like the stores of the
+ * generic version. The sum of two coefficients can exceed 16 bit, so their mean is computed
+ * on 32 bit lanes. Divisions by two round towards zero like the C code. */
+#if defined(WITH_SSE2)
+typedef __m128i dwt_v16;
+
+static INLINE dwt_v16 dwt_load(const INT16* ptr)
+{
+	return _mm_loadu_si128((const __m128i*)ptr);
+}
+
+static INLINE void dwt_store(INT16* ptr, dwt_v16 val)
+{
+	_mm_storeu_si128((__m128i*)ptr, val);
+}
+
+static INLINE void dwt_store_interleaved(INT16* ptr, dwt_v16 even, dwt_v16 odd)
+{
+	_mm_storeu_si128((__m128i*)ptr, _mm_unpacklo_epi16(even, odd));
+	_mm_storeu_si128((__m128i*)&ptr[8], _mm_unpackhi_epi16(even, odd));
+}
+
+static INLINE dwt_v16 dwt_add(dwt_v16 a, dwt_v16 b)
+{
+	return _mm_add_epi16(a, b);
+}
+
+static INLINE dwt_v16 dwt_sub(dwt_v16 a, dwt_v16 b)
+{
+	return _mm_sub_epi16(a, b);
+}
+
+static INLINE dwt_v16 dwt_half(dwt_v16 a)
+{
+	return _mm_srai_epi16(_mm_add_epi16(a, _mm_srli_epi16(a, 15)), 1);
+}
+
+static INLINE __m128i dwt_half_32(__m128i a)
+{
+	return _mm_srai_epi32(_mm_add_epi32(a, _mm_srli_epi32(a, 31)), 1);
+}
+
+/* (a + b) / 2, the result always fits into 16 bit again */
+static INLINE dwt_v16 dwt_avg(dwt_v16 a, dwt_v16 b)
+{
+	const __m128i lo = _mm_add_epi32(_mm_srai_epi32(_mm_unpacklo_epi16(a, a), 16),
+	                                 _mm_srai_epi32(_mm_unpacklo_epi16(b, b), 16));
+	const __m128i hi = _mm_add_epi32(_mm_srai_epi32(_mm_unpackhi_epi16(a, a), 16),
+	                                 _mm_srai_epi32(_mm_unpackhi_epi16(b, b), 16));
+	return _mm_packs_epi32(dwt_half_32(lo), dwt_half_32(hi));
+}
+#else
+typedef int16x8_t dwt_v16;
+
+static INLINE dwt_v16 dwt_load(const INT16* ptr)
+{
+	return vld1q_s16(ptr);
+}
+
+static INLINE void dwt_store(INT16* ptr, dwt_v16 val)
+{
+	vst1q_s16(ptr, val);
+}
+
+static INLINE void dwt_store_interleaved(INT16* ptr, dwt_v16 even, dwt_v16 odd)
+{
+	int16x8x2_t val;
+	val.val[0] = even;
+	val.val[1] = odd;
+	vst2q_s16(ptr, val);
+}
+
+static INLINE dwt_v16 dwt_add(dwt_v16 a, dwt_v16 b)
+{
+	return vaddq_s16(a, b);
+}
+
+static INLINE dwt_v16 dwt_sub(dwt_v16 a, dwt_v16 b)
+{
+	return vsubq_s16(a, b);
+}
+
+static INLINE dwt_v16 dwt_half(dwt_v16 a)
+{
+	const uint16x8_t sign = vshrq_n_u16(vreinterpretq_u16_s16(a), 15);
+	return vshrq_n_s16(vaddq_s16(a, vreinterpretq_s16_u16(sign)), 1);
+}
+
+static INLINE int16x4_t dwt_half_32(int32x4_t a)
+{
+	const uint32x4_t sign = vshrq_n_u32(vreinterpretq_u32_s32(a), 31);
+	return vmovn_s32(vshrq_n_s32(vaddq_s32(a, vreinterpretq_s32_u32(sign)), 1));
+}
+
+/* (a + b) / 2, the result always fits into 16 bit again */
+static INLINE dwt_v16 dwt_avg(dwt_v16 a, dwt_v16 b)
+{
+	const int32x4_t lo = vaddl_s16(vget_low_s16(a), vget_low_s16(b));
+	const int32x4_t hi = vaddl_s16(vget_high_s16(a), vget_high_s16(b));
+	return vcombine_s16(dwt_half_32(lo), dwt_half_32(hi));
+}
+#endif
+
+/* ------------------------------------------------------------------------- */
+static INLINE void opt_idwt_x_row(const INT16* pL, const INT16* pH, INT16* pX, size_t nLowCount,
+                                  size_t nHighCount)
+{
+	size_t k;
+	INT16 L0;
+	INT16 H0;
+	INT16 X0, X2;
+	INT16 even[32];
+
+	/* even outputs first, then the odd ones from their neighbours */
+	even[0] = pL[0] - pH[0];
+
+	for (k = 1; k + 8 <= nHighCount; k += 8)
+		dwt_store(&even[k], dwt_sub(dwt_load(&pL[k]),
+		                            dwt_avg(dwt_load(&pH[k - 1]), dwt_load(&pH[k]))));
+
+	for (; k < nHighCount; k++)
+		even[k] = pL[k] - ((pH[k - 1] + pH[k]) / 2);
+
+	for (k = 0; k + 9 <= nHighCount; k += 8)
+	{
+		const dwt_v16 e0 = dwt_load(&even[k]);
+		const dwt_v16 e1 = dwt_load(&even[k + 1]);
+		const dwt_v16 h = dwt_load(&pH[k]);
+		dwt_store_interleaved(&pX[2 * k], e0, dwt_add(dwt_avg(e0, e1), dwt_add(h, h)));
+	}
+
+	for (; k + 1 < nHighCount; k++)
+	{
+		pX[2 * k] = even[k];
+		pX[2 * k + 1] = ((even[k] + even[k + 1]) / 2) + (2 * pH[k]);
+	}
+
+	pX += 2 * (nHighCount - 1);
+	pL += nHighCount;
+	X2 = even[nHighCount - 1];
+	H0 = pH[nHighCount - 1];
+
+	if (nLowCount <= (nHighCount + 1))
+	{
+		if (nLowCount <= nHighCount)
+		{
+			pX[0] = X2;
+			pX[1] = X2 + (2 * H0);
+		}
+		else
+		{
+			L0 = *pL;
+			X0 = L0 - H0;
+			pX[0] = X2;
+			pX[1] = ((X0 + X2) / 2) + (2 * H0);
+			pX[2] = X0;
+		}
+	}
+	else
+	{
+		L0 = *pL;
+		pL++;
+		X0 = L0 - (H0 / 2);
+		pX[0] = X2;
+		pX[1] = ((X0 + X2) / 2) + (2 * H0);
+		pX[2] = X0;
+		L0 = *pL;
+		pX[3] = (X0 + L0) / 2;
+	}
+}
+
+static INLINE void opt_idwt_x(const INT16* pLowBand, size_t nLowStep, const INT16* pHighBand,
+                              size_t nHighStep, INT16* pDstBand, size_t nDstStep, size_t nLowCount,
+                              size_t nHighCount, size_t nDstCount)
+{
+	size_t i;
+
+	for (i = 0; i < nDstCount; i++)
+	{
+		opt_idwt_x_row(pLowBand, pHighBand, pDstBand, nLowCount, nHighCount);
+		pLowBand += nLowStep;
+		pHighBand += nHighStep;
+		pDstBand += nDstStep;
+	}
+}
+
+/* Columns are independent, 8 of them are processed at once. The last group is aligned to the
+ * end of the band and may recompute columns of the previous one, which gives the same result
+ * as source and destination do not overlap. */
+static INLINE void opt_idwt_y(const INT16* pLowBand, size_t nLowStep, const INT16* pHighBand,
+                              size_t nHighStep, INT16* pDstBand, size_t nDstStep, size_t nLowCount,
+                              size_t nHighCount, size_t nDstCount)
+{
+	size_t i = 0;
+
+	while (i < nDstCount)
+	{
+		size_t j;
+		const INT16* pL = &pLowBand[i];
+		const INT16* pH = &pHighBand[i];
+		INT16* pX = &pDstBand[i];
+		dwt_v16 L0, H0, H1;
+		dwt_v16 X0, X1, X2;
+		H0 = dwt_load(pH);
+		pH += nHighStep;
+		L0 = dwt_load(pL);
+		pL += nLowStep;
+		X0 = dwt_sub(L0, H0);
+		X2 = X0;
+
+		for (j = 0; j < (nHighCount - 1); j++)
+		{
+			H1 = dwt_load(pH);
+			pH += nHighStep;
+			L0 = dwt_load(pL);
+			pL += nLowStep;
+			X2 = dwt_sub(L0, dwt_avg(H0, H1));
+			X1 = dwt_add(dwt_avg(X0, X2), dwt_add(H0, H0));
+			dwt_store(pX, X0);
+			pX += nDstStep;
+			dwt_store(pX, X1);
+			pX += nDstStep;
+			X0 = X2;
+			H0 = H1;
+		}
+
+		if (nLowCount <= (nHighCount + 1))
+		{
+			if (nLowCount <= nHighCount)
+			{
+				dwt_store(pX, X2);
+				pX += nDstStep;
+				dwt_store(pX, dwt_add(X2, dwt_add(H0, H0)));
+			}
+			else
+			{
+				L0 = dwt_load(pL);
+				X0 = dwt_sub(L0, H0);
+				dwt_store(pX, X2);
+				pX += nDstStep;
+				dwt_store(pX, dwt_add(dwt_avg(X0, X2), dwt_add(H0, H0)));
+				pX += nDstStep;
+				dwt_store(pX, X0);
+			}
+		}
+		else
+		{
+			L0 = dwt_load(pL);
+			pL += nLowStep;
+			X0 = dwt_sub(L0, dwt_half(H0));
+			dwt_store(pX, X2);
+			pX += nDstStep;
+			dwt_store(pX, dwt_add(dwt_avg(X0, X2), dwt_add(H0, H0)));
+			pX += nDstStep;
+			dwt_store(pX, X0);
+			pX += nDstStep;
+			L0 = dwt_load(pL);
+			dwt_store(pX, dwt_avg(X0, L0));
+		}
+
+		if (i + 8 == nDstCount)
+			break;
+
+		i += 8;
+
+		if (i + 8 > nDstCount)
+			i = nDstCount - 8;
+	}
+}
+
+static INLINE void opt_dwt_decode_block(INT16* buffer, INT16* temp, size_t level)
+{
+	const size_t nBandL = dwt_get_band_l_count(level);
+	const size_t nBandH = dwt_get_band_h_count(level);
+	const size_t nDstStep = nBandL + nBandH;
+	const INT16* HL = &buffer[0];
+	const INT16* LH = &HL[nBandH * nBandL];
+	const INT16* HH = &LH[nBandL * nBandH];
+	const INT16* LL = &HH[nBandH * nBandH];
+	INT16* L = &temp[0];
+	INT16* H = &temp[nBandL * nDstStep];
+
+	/* horizontal (LL + HL -> L) */
+	opt_idwt_x(LL, nBandL, HL, nBandH, L, nDstStep, nBandL, nBandH, nBandL);
+
+	/* horizontal (LH + HH -> H) */
+	opt_idwt_x(LH, nBandL, HH, nBandH, H, nDstStep, nBandL, nBandH, nBandH);
+
+	/* vertical (L + H -> LL) */
+	opt_idwt_y(L, nDstStep, H, nDstStep, buffer, nDstStep, nBandL, nBandH, nDstStep);
+}
+
+static pstatus_t opt_dwtReduceExtrapolateDecode_16s(INT16* pSrcDst, INT16* pTemp)
+{
+	opt_dwt_decode_block(&pSrcDst[3807], pTemp, 3);
+	opt_dwt_decode_block(&pSrcDst[3007], pTemp, 2);
+	opt_dwt_decode_block(&pSrcDst[0], pTemp, 1);
+	return PRIMITIVES_SUCCESS;
+}
+#endif /* WITH_SSE2 || WITH_NEON */
+
+/* ------------------------------------------------------------------------- */
+void primitives_init_dwt_opt(primitives_t* prims)
+{
+	primitives_init_dwt(prims);
+#if defined(WITH_SSE2)
+
+	if (IsProcessorFeaturePresent(PF_SSE2_INSTRUCTIONS_AVAILABLE))
+		prims->dwtReduceExtrapolateDecode_16s = opt_dwtReduceExtrapolateDecode_16s;
+
+#elif defined(WITH_NEON)
+
+	if (IsProcessorFeaturePresent(PF_ARM_NEON_INSTRUCTIONS_AVAILABLE))
+		prims->dwtReduceExtrapolateDecode_16s = opt_dwtReduceExtrapolateDecode_16s;
+
+#endif /* WITH_SSE2 */
+}
@@ -250,6 +250,20 @@ static INLINE BYTE YUV2B(INT32 Y, INT32 U, INT32 V)
 	return CLIP(b8);
 }
 
+/* Band sizes of the reduce-extrapolate DWT used by the progressive codec. */
+static INLINE size_t dwt_get_band_l_count(size_t level)
+{
+	return (64 >> level) + 1;
+}
+
+static INLINE size_t dwt_get_band_h_count(size_t level)
+{
+	if (level == 1)
+		return (64 >> 1) - 1;
+	else
+		return (64 + (1 << (level - 1))) >> level;
+}
+
 /* Function prototypes for all the init/deinit routines. */
 FREERDP_LOCAL void primitives_init_copy(primitives_t* prims);
 FREERDP_LOCAL void primitives_init_set(primitives_t* prims);
@@ -261,6 +275,7 @@ FREERDP_LOCAL void primitives_init_alphaComp(primitives_t* prims);
 FREERDP_LOCAL void primitives_init_colors(primitives_t* prims);
 FREERDP_LOCAL void primitives_init_YCoCg(primitives_t* prims);
 FREERDP_LOCAL void primitives_init_YUV(primitives_t* prims);
+FREERDP_LOCAL void primitives_init_dwt(primitives_t* prims);
 
 #if defined(WITH_SSE2) || defined(WITH_NEON)
 FREERDP_LOCAL void primitives_init_copy_opt(primitives_t* prims);
@@ -273,6 +288,7 @@ FREERDP_LOCAL void primitives_init_alphaComp_opt(primitives_t* prims);
 FREERDP_LOCAL void primitives_init_colors_opt(primitives_t* prims);
 FREERDP_LOCAL void primitives_init_YCoCg_opt(primitives_t* prims);
 FREERDP_LOCAL void primitives_init_YUV_opt(primitives_t* prims);
+FREERDP_LOCAL void primitives_init_dwt_opt(primitives_t* prims);
 #endif
 
 #if defined(WITH_OPENCL)
@@ -0,0 +1,129 @@
+/* FreeRDP: A Remote Desktop Protocol Client
+ * Test of the progressive codec inverse DWT primitive.
+ * vi:ts=4 sw=4:
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0.
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <freerdp/config.h>
+
+#include <winpr/sysinfo.h>
+#include "prim_test.h"
+
+#define DWT_TILE_SIZE 4096
+
+/* Coefficients come from the network and may use the full 16 bit range. Some runs use only
+ * the extreme values, where every sum of two coefficients overflows 16 bit. */
+static void fill_coefficients(INT16* data, size_t count, size_t run)
+{
+	size_t x;
+	winpr_RAND((BYTE*)data, count * sizeof(INT16));
+
+	switch (run % 4)
+	{
+		case 1:
+			for (x = 0; x < count; x++)
+				data[x] = (data[x] & 1) ? INT16_MAX : INT16_MIN;
+			break;
+
+		case 2:
+			for (x = 0; x < count; x++)
+				data[x] = INT16_MAX;
+			break;
+
+		case 3:
+			for (x = 0; x < count; x++)
+				data[x] = INT16_MIN;
+			break;
+
+		default:
+			break;
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+static BOOL test_dwt_func(void)
+{
+	size_t run;
+
+	for (run = 0; run < 16; run++)
+	{
+		pstatus_t status;
+		INT16 ALIGN(src[DWT_TILE_SIZE]) = { 0 };
+		INT16 ALIGN(d1[DWT_TILE_SIZE]) = { 0 };
+		INT16 ALIGN(d2[DWT_TILE_SIZE]) = { 0 };
+		INT16 ALIGN(t1[DWT_TILE_SIZE]) = { 0 };
+		INT16 ALIGN(t2[DWT_TILE_SIZE]) = { 0 };
+		fill_coefficients(src, DWT_TILE_SIZE, run);
+		memcpy(d1, src, sizeof(src));
+		memcpy(d2, src, sizeof(src));
+		status = generic->dwtReduceExtrapolateDecode_16s(d1, t1);
+
+		if (status != PRIMITIVES_SUCCESS)
+			return FALSE;
+
+		status = optimized->dwtReduceExtrapolateDecode_16s(d2, t2);
+
+		if (status != PRIMITIVES_SUCCESS)
+			return FALSE;
+
+		if (memcmp(d1, d2, sizeof(d1)) != 0)
+		{
+			size_t x;
+
+			for (x = 0; x < DWT_TILE_SIZE; x++)
+			{
+				if (d1[x] != d2[x])
+				{
+					printf("dwt: mismatch at %" PRIuz ": %" PRId16 " != %" PRId16 "\n", x, d1[x],
+					       d2[x]);
+					break;
+				}
+			}
+
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+static int test_dwt_speed(void)
+{
+	INT16 ALIGN(src[DWT_TILE_SIZE]) = { 0 };
+	INT16 ALIGN(temp[DWT_TILE_SIZE]) = { 0 };
+	fill_coefficients(src, DWT_TILE_SIZE, 0);
+
+	if (!speed_test("dwtReduceExtrapolateDecode_16s", "tile", g_Iterations,
+	                (speed_test_fkt)generic->dwtReduceExtrapolateDecode_16s,
+	                (speed_test_fkt)optimized->dwtReduceExtrapolateDecode_16s, src, temp))
+		return FALSE;
+
+	return TRUE;
+}
+
+int TestPrimitivesDWT(int argc, char* argv[])
+{
+	WINPR_UNUSED(argc);
+	WINPR_UNUSED(argv);
+
+	prim_test_setup(FALSE);
+
+	if (!test_dwt_func())
+		return 1;
+
+	if (g_TestPrimitivesPerformance)
+	{
+		if (!test_dwt_speed())
+			return 1;
+	}
+
+	return 0;
+}
@@ -48,6 +48,14 @@
 
 #define TAG PROXY_TAG("client")
 
+/* channel data of the front connection, queued until the client thread sends it.
+ * The data is kept in the referenced receive buffer of the front connection if possible. */
+typedef struct
+{
+	proxyChannelDataEventInfo ev;
+	wStream* s;
+} pfQueuedChannelData;
+
 static void channel_data_free(void* obj);
 static BOOL proxy_server_reactivate(rdpContext* ps, const rdpContext* pc)
 {
@@ -111,6 +119,9 @@ static void pf_client_on_activated(void* ctx, const ActivatedEventArgs* e)
 	/* Register server input/update callbacks only after proxy client is fully activated */
 	pf_server_register_input_callbacks(peer->context->input);
 	pf_server_register_update_callbacks(peer->context->update);
+
+	if (pf_utils_forward_raw_updates(pc->pdata))
+		pf_server_register_raw_update_callbacks(peer->context->update);
 }
 
 static BOOL pf_client_load_rdpsnd(pClientContext* pc)
@@ -254,9 +265,14 @@ static BOOL pf_client_pre_connect(freerdp* instance)
 	 * GlyphCacheSupport must be explicitly set to GLYPH_SUPPORT_NONE.
 	 *
 	 * Also, OrderSupport need to be zeroed, because it is currently not supported.
+	 *
+	 * Raw forwarded updates are not looked at, the client handles what it announced.
 	 */
-	settings->GlyphSupportLevel = GLYPH_SUPPORT_NONE;
-	ZeroMemory(settings->OrderSupport, 32);
+	if (!pf_utils_forward_raw_updates(pc->pdata))
+	{
+		settings->GlyphSupportLevel = GLYPH_SUPPORT_NONE;
+		ZeroMemory(settings->OrderSupport, 32);
+	}
 
 	if (WTSVirtualChannelManagerIsChannelJoined(ps->vcm, DRDYNVC_SVC_CHANNEL_NAME))
 		settings->SupportDynamicChannels = TRUE;
@@ -463,10 +479,25 @@ static BOOL pf_client_on_server_heartbeat(freerdp* instance, BYTE period, BYTE c
 
 static BOOL pf_client_send_channel_data(pClientContext* pc, const proxyChannelDataEventInfo* ev)
 {
+	BOOL rc;
+	pfQueuedChannelData data = { 0 };
+
 	WINPR_ASSERT(pc);
+	WINPR_ASSERT(pc->pdata);
+	WINPR_ASSERT(pc->pdata->ps);
 	WINPR_ASSERT(ev);
 
-	return Queue_Enqueue(pc->cached_server_channel_data, ev);
+	/* called from the receive callback of the front connection, passthrough data still lives
+	 * in its receive buffer and is queued by reference */
+	data.ev = *ev;
+	data.s = freerdp_get_received_stream(&pc->pdata->ps->context, ev->data);
+
+	rc = Queue_Enqueue(pc->cached_server_channel_data, &data);
+
+	if (data.s)
+		Stream_Release(data.s);
+
+	return rc;
 }
 
 static BOOL sendQueuedChannelData(pClientContext* pc)
@@ -477,11 +508,12 @@ static BOOL sendQueuedChannelData(pClientContext* pc)
 
 	if (pc->connected)
 	{
-		proxyChannelDataEventInfo* ev;
+		pfQueuedChannelData* data;
 
 		Queue_Lock(pc->cached_server_channel_data);
-		while (rc && (ev = Queue_Dequeue(pc->cached_server_channel_data)))
+		while (rc && (data = Queue_Dequeue(pc->cached_server_channel_data)))
 		{
+			const proxyChannelDataEventInfo* ev = &data->ev;
 			UINT16 channelId;
 			WINPR_ASSERT(pc->context.instance);
 
@@ -496,7 +528,7 @@ static BOOL sendQueuedChannelData(pClientContext* pc)
 				                                             ev->total_size, ev->flags, ev->data,
 				                                             ev->data_len);
 			}
-			channel_data_free(ev);
+			channel_data_free(data);
 		}
 
 		Queue_Unlock(pc->cached_server_channel_data);
@@ -548,6 +580,16 @@ static BOOL pf_client_post_connect(freerdp* instance)
 
 	pf_client_register_update_callbacks(update);
 
+	/* the capabilities of both sides are known now, raw updates are only forwarded if the
+	 * client takes them as large as the target may send them */
+	if (pf_utils_forward_raw_updates(pc->pdata))
+	{
+		PROXY_LOG_INFO(TAG, pc, "forwarding raw updates");
+		pf_client_register_raw_update_callbacks(update);
+	}
+	else if (config->ForwardRawUpdates)
+		PROXY_LOG_WARN(TAG, pc, "client does not take the updates of the target as they are");
+
 	/* virtual channels receive data hook */
 	pc->client_receive_channel_data_original = instance->ReceiveChannelData;
 	instance->ReceiveChannelData = pf_client_receive_channel_data_hook;
@@ -908,13 +950,18 @@ void channel_data_free(void* obj)
 		const void* cpv;
 		void* pv;
 	} cnv;
-	proxyChannelDataEventInfo* dst = obj;
+	pfQueuedChannelData* dst = obj;
 	if (dst)
 	{
-		cnv.cpv = dst->data;
-		free(cnv.pv);
+		if (dst->s)
+			Stream_Release(dst->s);
+		else
+		{
+			cnv.cpv = dst->ev.data;
+			free(cnv.pv);
+		}
 
-		cnv.cpv = dst->channel_name;
+		cnv.cpv = dst->ev.channel_name;
 		free(cnv.pv);
 		free(dst);
 	}
@@ -927,28 +974,40 @@ static void* channel_data_copy(const void* obj)
 		const void* cpv;
 		void* pv;
 	} cnv;
-	const proxyChannelDataEventInfo* src = obj;
-	proxyChannelDataEventInfo* dst;
+	const pfQueuedChannelData* src = obj;
+	pfQueuedChannelData* dst;
 
 	WINPR_ASSERT(src);
 
-	dst = calloc(1, sizeof(proxyChannelDataEventInfo));
+	dst = calloc(1, sizeof(pfQueuedChannelData));
 	if (!dst)
 		goto fail;
 
-	*dst = *src;
-	if (src->channel_name)
+	dst->ev = src->ev;
+	dst->ev.channel_name = NULL;
+	dst->ev.data = NULL;
+	if (src->ev.channel_name)
 	{
-		dst->channel_name = _strdup(src->channel_name);
-		if (!dst->channel_name)
+		dst->ev.channel_name = _strdup(src->ev.channel_name);
+		if (!dst->ev.channel_name)
 			goto fail;
 	}
-	dst->data = malloc(src->data_len);
-	if (!dst->data)
+
+	/* keep the chunk in the receive buffer it arrived in */
+	if (src->s)
+	{
+		Stream_AddRef(src->s);
+		dst->s = src->s;
+		dst->ev.data = src->ev.data;
+		return dst;
+	}
+
+	dst->ev.data = malloc(src->ev.data_len);
+	if (!dst->ev.data)
 		goto fail;
 
-	cnv.cpv = dst->data;
-	memcpy(cnv.pv, src->data, src->data_len);
+	cnv.cpv = dst->ev.data;
+	memcpy(cnv.pv, src->ev.data, src->ev.data_len);
 	return dst;
 
 fail:
@@ -311,6 +311,8 @@ static BOOL pf_config_load_gfx_settings(wIniFile* ini, proxyConfig* config)
 {
 	WINPR_ASSERT(config);
 	config->DecodeGFX = pf_config_get_bool(ini, "GFXSettings", "DecodeGFX", FALSE);
+	config->ForwardRawUpdates =
+	    pf_config_get_bool(ini, "GFXSettings", "ForwardRawUpdates", FALSE);
 	return TRUE;
 }
 
@@ -522,6 +524,8 @@ BOOL pf_server_config_dump(const char* file)
 	/* GFX configuration */
 	if (IniFile_SetKeyValueString(ini, "GFXSettings", "DecodeGFX", "false") < 0)
 		goto fail;
+	if (IniFile_SetKeyValueString(ini, "GFXSettings", "ForwardRawUpdates", "false") < 0)
+		goto fail;
 
 	/* Certificate configuration */
 	if (IniFile_SetKeyValueString(ini, "Certificates", "CertificateFile",
@@ -675,6 +679,7 @@ void pf_server_config_print(const proxyConfig* config)
 
 	CONFIG_PRINT_SECTION("GFXSettings");
 	CONFIG_PRINT_BOOL(config, DecodeGFX);
+	CONFIG_PRINT_BOOL(config, ForwardRawUpdates);
 
 	/* modules */
 	CONFIG_PRINT_SECTION("Plugins/Modules");
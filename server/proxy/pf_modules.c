@@ -39,11 +39,27 @@
 
 #define MODULE_ENTRY_POINT "proxy_module_entry_point"
 
+typedef struct
+{
+	proxyPlugin* plugin;
+	proxyHookFn fn;
+} proxyModuleCallback;
+
+/* the plugins subscribed to a hook or filter, in registration order */
+typedef struct
+{
+	size_t count;
+	proxyModuleCallback* callbacks;
+} proxyModuleDispatch;
+
 struct proxy_module
 {
 	proxyPluginsManager mgr;
 	wArrayList* plugins;
 	wArrayList* handles;
+
+	proxyModuleDispatch hooks[HOOK_LAST];
+	proxyModuleDispatch filters[FILTER_LAST];
 };
 
 static const char* pf_modules_get_filter_type_string(PF_FILTER_TYPE result)
@@ -118,101 +134,123 @@ static const char* pf_modules_get_hook_type_string(PF_HOOK_TYPE result)
 	}
 }
 
-static BOOL pf_modules_proxy_ArrayList_ForEachFkt(void* data, size_t index, va_list ap)
+static proxyHookFn pf_modules_get_hook(const proxyPlugin* plugin, PF_HOOK_TYPE type)
 {
-	proxyPlugin* plugin = (proxyPlugin*)data;
-	PF_HOOK_TYPE type;
-	proxyData* pdata;
-	void* custom;
-	BOOL ok = FALSE;
-
-	WINPR_UNUSED(index);
-
-	type = va_arg(ap, PF_HOOK_TYPE);
-	pdata = va_arg(ap, proxyData*);
-	custom = va_arg(ap, void*);
-
-	WLog_VRB(TAG, "running hook %s.%s", plugin->name, pf_modules_get_hook_type_string(type));
+	WINPR_ASSERT(plugin);
 
 	switch (type)
 	{
 		case HOOK_TYPE_CLIENT_INIT_CONNECT:
-			ok = IFCALLRESULT(TRUE, plugin->ClientInitConnect, plugin, pdata, custom);
-			break;
+			return plugin->ClientInitConnect;
 		case HOOK_TYPE_CLIENT_UNINIT_CONNECT:
-			ok = IFCALLRESULT(TRUE, plugin->ClientUninitConnect, plugin, pdata, custom);
-			break;
+			return plugin->ClientUninitConnect;
 		case HOOK_TYPE_CLIENT_PRE_CONNECT:
-			ok = IFCALLRESULT(TRUE, plugin->ClientPreConnect, plugin, pdata, custom);
-			break;
-
+			return plugin->ClientPreConnect;
 		case HOOK_TYPE_CLIENT_POST_CONNECT:
-			ok = IFCALLRESULT(TRUE, plugin->ClientPostConnect, plugin, pdata, custom);
-			break;
-
+			return plugin->ClientPostConnect;
 		case HOOK_TYPE_CLIENT_REDIRECT:
-			ok = IFCALLRESULT(TRUE, plugin->ClientRedirect, plugin, pdata, custom);
-			break;
-
+			return plugin->ClientRedirect;
 		case HOOK_TYPE_CLIENT_POST_DISCONNECT:
-			ok = IFCALLRESULT(TRUE, plugin->ClientPostDisconnect, plugin, pdata, custom);
-			break;
-
+			return plugin->ClientPostDisconnect;
 		case HOOK_TYPE_CLIENT_VERIFY_X509:
-			ok = IFCALLRESULT(TRUE, plugin->ClientX509Certificate, plugin, pdata, custom);
-			break;
-
+			return plugin->ClientX509Certificate;
 		case HOOK_TYPE_CLIENT_LOGIN_FAILURE:
-			ok = IFCALLRESULT(TRUE, plugin->ClientLoginFailure, plugin, pdata, custom);
-			break;
-
+			return plugin->ClientLoginFailure;
 		case HOOK_TYPE_CLIENT_END_PAINT:
-			ok = IFCALLRESULT(TRUE, plugin->ClientEndPaint, plugin, pdata, custom);
-			break;
-
+			return plugin->ClientEndPaint;
 		case HOOK_TYPE_CLIENT_LOAD_CHANNELS:
-			ok = IFCALLRESULT(TRUE, plugin->ClientLoadChannels, plugin, pdata, custom);
-			break;
-
+			return plugin->ClientLoadChannels;
 		case HOOK_TYPE_SERVER_POST_CONNECT:
-			ok = IFCALLRESULT(TRUE, plugin->ServerPostConnect, plugin, pdata, custom);
-			break;
-
+			return plugin->ServerPostConnect;
 		case HOOK_TYPE_SERVER_ACTIVATE:
-			ok = IFCALLRESULT(TRUE, plugin->ServerPeerActivate, plugin, pdata, custom);
-			break;
-
+			return plugin->ServerPeerActivate;
 		case HOOK_TYPE_SERVER_CHANNELS_INIT:
-			ok = IFCALLRESULT(TRUE, plugin->ServerChannelsInit, plugin, pdata, custom);
-			break;
-
+			return plugin->ServerChannelsInit;
 		case HOOK_TYPE_SERVER_CHANNELS_FREE:
-			ok = IFCALLRESULT(TRUE, plugin->ServerChannelsFree, plugin, pdata, custom);
-			break;
-
+			return plugin->ServerChannelsFree;
 		case HOOK_TYPE_SERVER_SESSION_END:
-			ok = IFCALLRESULT(TRUE, plugin->ServerSessionEnd, plugin, pdata, custom);
-			break;
-
+			return plugin->ServerSessionEnd;
 		case HOOK_TYPE_SERVER_SESSION_INITIALIZE:
-			ok = IFCALLRESULT(TRUE, plugin->ServerSessionInitialize, plugin, pdata, custom);
-			break;
-
+			return plugin->ServerSessionInitialize;
 		case HOOK_TYPE_SERVER_SESSION_STARTED:
-			ok = IFCALLRESULT(TRUE, plugin->ServerSessionStarted, plugin, pdata, custom);
-			break;
-
+			return plugin->ServerSessionStarted;
 		case HOOK_LAST:
 		default:
-			WLog_ERR(TAG, "invalid hook called");
+			return NULL;
 	}
+}
 
-	if (!ok)
+static proxyFilterFn pf_modules_get_filter(const proxyPlugin* plugin, PF_FILTER_TYPE type)
+{
+	WINPR_ASSERT(plugin);
+
+	switch (type)
 	{
-		WLog_INFO(TAG, "plugin %s, hook %s failed!", plugin->name,
-		          pf_modules_get_hook_type_string(type));
+		case FILTER_TYPE_KEYBOARD:
+			return plugin->KeyboardEvent;
+		case FILTER_TYPE_MOUSE:
+			return plugin->MouseEvent;
+		case FILTER_TYPE_CLIENT_PASSTHROUGH_CHANNEL_DATA:
+			return plugin->ClientChannelData;
+		case FILTER_TYPE_SERVER_PASSTHROUGH_CHANNEL_DATA:
+			return plugin->ServerChannelData;
+		case FILTER_TYPE_CLIENT_PASSTHROUGH_CHANNEL_CREATE:
+			return plugin->ChannelCreate;
+		case FILTER_TYPE_CLIENT_PASSTHROUGH_DYN_CHANNEL_CREATE:
+			return plugin->DynamicChannelCreate;
+		case FILTER_TYPE_SERVER_FETCH_TARGET_ADDR:
+			return plugin->ServerFetchTargetAddr;
+		case FILTER_TYPE_SERVER_PEER_LOGON:
+			return plugin->ServerPeerLogon;
+		case FILTER_LAST:
+		default:
+			return NULL;
+	}
+}
+
+static BOOL pf_modules_dispatch_add(proxyModuleDispatch* dispatch, proxyPlugin* plugin,
+                                    proxyHookFn fn)
+{
+	proxyModuleCallback* callbacks;
+
+	WINPR_ASSERT(dispatch);
+
+	if (!fn)
+		return TRUE;
+
+	callbacks = realloc(dispatch->callbacks, (dispatch->count + 1) * sizeof(proxyModuleCallback));
+
+	if (!callbacks)
 		return FALSE;
+
+	callbacks[dispatch->count].plugin = plugin;
+	callbacks[dispatch->count].fn = fn;
+	dispatch->callbacks = callbacks;
+	dispatch->count++;
+	return TRUE;
+}
+
+/* resolve the hooks and filters of a registered plugin into the dispatch tables */
+static BOOL pf_modules_subscribe_plugin(proxyModule* module, proxyPlugin* plugin)
+{
+	int type;
+
+	WINPR_ASSERT(module);
+
+	for (type = 0; type < HOOK_LAST; type++)
+	{
+		if (!pf_modules_dispatch_add(&module->hooks[type], plugin,
+		                             pf_modules_get_hook(plugin, (PF_HOOK_TYPE)type)))
+			return FALSE;
+	}
+
+	for (type = 0; type < FILTER_LAST; type++)
+	{
+		if (!pf_modules_dispatch_add(&module->filters[type], plugin,
+		                             pf_modules_get_filter(plugin, (PF_FILTER_TYPE)type)))
+			return FALSE;
 	}
+
 	return TRUE;
 }
 
@@ -224,74 +262,35 @@ static BOOL pf_modules_proxy_ArrayList_ForEachFkt(void* data, size_t index, va_l
  */
 BOOL pf_modules_run_hook(proxyModule* module, PF_HOOK_TYPE type, proxyData* pdata, void* custom)
 {
-	WINPR_ASSERT(module);
-	WINPR_ASSERT(module->plugins);
-	return ArrayList_ForEach(module->plugins, pf_modules_proxy_ArrayList_ForEachFkt, type, pdata,
-	                         custom);
-}
-
-static BOOL pf_modules_ArrayList_ForEachFkt(void* data, size_t index, va_list ap)
-{
-	proxyPlugin* plugin = (proxyPlugin*)data;
-	PF_FILTER_TYPE type;
-	proxyData* pdata;
-	void* param;
-	BOOL result = FALSE;
-
-	WINPR_UNUSED(index);
-
-	type = va_arg(ap, PF_FILTER_TYPE);
-	pdata = va_arg(ap, proxyData*);
-	param = va_arg(ap, void*);
+	size_t index;
+	const proxyModuleDispatch* dispatch;
 
-	WLog_VRB(TAG, "[%s]: running filter: %s", __FUNCTION__, plugin->name);
+	WINPR_ASSERT(module);
 
-	switch (type)
+	if ((type < 0) || (type >= HOOK_LAST))
 	{
-		case FILTER_TYPE_KEYBOARD:
-			result = IFCALLRESULT(TRUE, plugin->KeyboardEvent, plugin, pdata, param);
-			break;
-
-		case FILTER_TYPE_MOUSE:
-			result = IFCALLRESULT(TRUE, plugin->MouseEvent, plugin, pdata, param);
-			break;
-
-		case FILTER_TYPE_CLIENT_PASSTHROUGH_CHANNEL_DATA:
-			result = IFCALLRESULT(TRUE, plugin->ClientChannelData, plugin, pdata, param);
-			break;
-
-		case FILTER_TYPE_SERVER_PASSTHROUGH_CHANNEL_DATA:
-			result = IFCALLRESULT(TRUE, plugin->ServerChannelData, plugin, pdata, param);
-			break;
-
-		case FILTER_TYPE_CLIENT_PASSTHROUGH_CHANNEL_CREATE:
-			result = IFCALLRESULT(TRUE, plugin->ChannelCreate, plugin, pdata, param);
-			break;
+		WLog_ERR(TAG, "invalid hook called");
+		return FALSE;
+	}
 
-		case FILTER_TYPE_CLIENT_PASSTHROUGH_DYN_CHANNEL_CREATE:
-			result = IFCALLRESULT(TRUE, plugin->DynamicChannelCreate, plugin, pdata, param);
-			break;
+	dispatch = &module->hooks[type];
 
-		case FILTER_TYPE_SERVER_FETCH_TARGET_ADDR:
-			result = IFCALLRESULT(TRUE, plugin->ServerFetchTargetAddr, plugin, pdata, param);
-			break;
+	for (index = 0; index < dispatch->count; index++)
+	{
+		const proxyModuleCallback* cb = &dispatch->callbacks[index];
 
-		case FILTER_TYPE_SERVER_PEER_LOGON:
-			result = IFCALLRESULT(TRUE, plugin->ServerPeerLogon, plugin, pdata, param);
-			break;
+		WLog_VRB(TAG, "running hook %s.%s", cb->plugin->name,
+		         pf_modules_get_hook_type_string(type));
 
-		case FILTER_LAST:
-		default:
-			WLog_ERR(TAG, "invalid filter called");
+		if (!cb->fn(cb->plugin, pdata, custom))
+		{
+			WLog_INFO(TAG, "plugin %s, hook %s failed!", cb->plugin->name,
+			          pf_modules_get_hook_type_string(type));
+			return FALSE;
+		}
 	}
 
-	if (!result)
-	{
-		/* current filter return FALSE, no need to run other filters. */
-		WLog_DBG(TAG, "plugin %s, filter type [%s] returned FALSE", plugin->name,
-		         pf_modules_get_filter_type_string(type));
-	}
-	return result;
+	return TRUE;
 }
 
 /*
@@ -302,10 +301,35 @@ static BOOL pf_modules_ArrayList_ForEachFkt(void* data, size_t index, va_list ap
  */
 BOOL pf_modules_run_filter(proxyModule* module, PF_FILTER_TYPE type, proxyData* pdata, void* param)
 {
+	size_t index;
+	const proxyModuleDispatch* dispatch;
+
 	WINPR_ASSERT(module);
-	WINPR_ASSERT(module->plugins);
 
-	return ArrayList_ForEach(module->plugins, pf_modules_ArrayList_ForEachFkt, type, pdata, param);
+	if ((type < 0) || (type >= FILTER_LAST))
+	{
+		WLog_ERR(TAG, "invalid filter called");
+		return FALSE;
+	}
+
+	dispatch = &module->filters[type];
+
+	for (index = 0; index < dispatch->count; index++)
+	{
+		const proxyModuleCallback* cb = &dispatch->callbacks[index];
+
+		WLog_VRB(TAG, "[%s]: running filter: %s", __FUNCTION__, cb->plugin->name);
+
+		if (!cb->fn(cb->plugin, pdata, param))
+		{
+			/* current filter return FALSE, no need to run other filters. */
+			WLog_DBG(TAG, "plugin %s, filter type [%s] returned FALSE", cb->plugin->name,
+			         pf_modules_get_filter_type_string(type));
+			return FALSE;
+		}
+	}
+
+	return TRUE;
 }
 
 /*
@@ -386,6 +410,7 @@ static BOOL pf_modules_register_plugin(proxyPluginsManager* mgr,
                                        const proxyPlugin* plugin_to_register)
 {
 	proxyPlugin internal = { 0 };
+	proxyPlugin* plugin;
 	proxyModule* module = (proxyModule*)mgr;
 	WINPR_ASSERT(module);
 
@@ -406,6 +431,16 @@ static BOOL pf_modules_register_plugin(proxyPluginsManager* mgr,
 		return FALSE;
 	}
 
+	/* the list holds a copy of the plugin, the callbacks are passed that one */
+	plugin = ArrayList_GetItem(module->plugins, ArrayList_Count(module->plugins) - 1);
+
+	if (!pf_modules_subscribe_plugin(module, plugin))
+	{
+		WLog_ERR(TAG, "[%s]: failed subscribing plugin: %s", __FUNCTION__,
+		         plugin_to_register->name);
+		return FALSE;
+	}
+
 	return TRUE;
 }
 
@@ -430,6 +465,12 @@ BOOL pf_modules_is_plugin_loaded(proxyModule* module, const char* plugin_name)
 	return ArrayList_ForEach(module->plugins, pf_modules_load_ArrayList_ForEachFkt, plugin_name);
 }
 
+BOOL pf_modules_needs_graphics(proxyModule* module)
+{
+	WINPR_ASSERT(module);
+	return module->hooks[HOOK_TYPE_CLIENT_END_PAINT].count > 0;
+}
+
 static BOOL pf_modules_print_ArrayList_ForEachFkt(void* data, size_t index, va_list ap)
 {
 	proxyPlugin* plugin = (proxyPlugin*)data;
@@ -595,9 +636,17 @@ error:
 
 void pf_modules_free(proxyModule* module)
 {
+	size_t x;
+
 	if (!module)
 		return;
 
+	for (x = 0; x < ARRAYSIZE(module->hooks); x++)
+		free(module->hooks[x].callbacks);
+
+	for (x = 0; x < ARRAYSIZE(module->filters); x++)
+		free(module->filters[x].callbacks);
+
 	ArrayList_Free(module->plugins);
 	ArrayList_Free(module->handles);
 	free(module);
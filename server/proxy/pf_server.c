@@ -470,8 +470,9 @@ static BOOL pf_server_initialize_peer_connection(freerdp_peer* peer)
 	pdata->module = server->module;
 	config = pdata->config = server->config;
 
-	/* currently not supporting GDI orders */
-	ZeroMemory(settings->OrderSupport, 32);
+	/* currently not supporting GDI orders, unless they are forwarded as they are */
+	if (!pf_utils_forward_raw_updates(pdata))
+		ZeroMemory(settings->OrderSupport, 32);
 
 	WINPR_ASSERT(peer->context->update);
 	peer->context->update->autoCalculateBitmapData = FALSE;
@@ -712,6 +713,10 @@ out_free_peer:
 		WaitForSingleObject(pdata->client_thread, INFINITE);
 	}
 
+	/* queued channel data references receive buffers of the peer */
+	if (pdata && pdata->pc)
+		Queue_Clear(pdata->pc->cached_server_channel_data);
+
 	{
 		ArrayList_Lock(server->peer_list);
 		ArrayList_Remove(server->peer_list, args->thread);
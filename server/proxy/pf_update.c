@@ -61,6 +61,18 @@ static BOOL pf_server_suppress_output(rdpContext* context, BYTE allow, const REC
 	return pc->update->SuppressOutput(pc, allow, area);
 }
 
+static BOOL pf_server_surface_frame_acknowledge(rdpContext* context, UINT32 frameId)
+{
+	pServerContext* ps = (pServerContext*)context;
+	rdpContext* pc;
+	WINPR_ASSERT(ps);
+	WINPR_ASSERT(ps->pdata);
+	pc = (rdpContext*)ps->pdata->pc;
+	WINPR_ASSERT(pc);
+	WINPR_ASSERT(pc->update);
+	return IFCALLRESULT(TRUE, pc->update->SurfaceFrameAcknowledge, pc, frameId);
+}
+
 /* Proxy from PC to PS */
 
 /**
@@ -113,6 +125,21 @@ static BOOL pf_client_end_paint(rdpContext* context)
 	return TRUE;
 }
 
+static BOOL pf_client_raw_update(rdpContext* context, BYTE updateCode, wStream* s)
+{
+	pClientContext* pc = (pClientContext*)context;
+	proxyData* pdata;
+	rdpContext* ps;
+	WINPR_ASSERT(pc);
+	pdata = pc->pdata;
+	WINPR_ASSERT(pdata);
+	ps = (rdpContext*)pdata->ps;
+	WINPR_ASSERT(ps);
+	WINPR_ASSERT(ps->update);
+	WINPR_ASSERT(ps->update->RawUpdate);
+	return ps->update->RawUpdate(ps, updateCode, s);
+}
+
 static BOOL pf_client_bitmap_update(rdpContext* context, const BITMAP_UPDATE* bitmap)
 {
 	pClientContext* pc = (pClientContext*)context;
@@ -592,6 +619,19 @@ void pf_server_register_update_callbacks(rdpUpdate* update)
 	update->SuppressOutput = pf_server_suppress_output;
 }
 
+void pf_server_register_raw_update_callbacks(rdpUpdate* update)
+{
+	WINPR_ASSERT(update);
+	/* the client sees the frames of the target, its acknowledges go there too */
+	update->SurfaceFrameAcknowledge = pf_server_surface_frame_acknowledge;
+}
+
+void pf_client_register_raw_update_callbacks(rdpUpdate* update)
+{
+	WINPR_ASSERT(update);
+	update->RawUpdate = pf_client_raw_update;
+}
+
 void pf_client_register_update_callbacks(rdpUpdate* update)
 {
 	WINPR_ASSERT(update);
@@ -31,4 +31,8 @@
 void pf_server_register_update_callbacks(rdpUpdate* update);
 void pf_client_register_update_callbacks(rdpUpdate* update);
 
+/* Relay the updates of the target as they are, see pf_utils_forward_raw_updates */
+void pf_server_register_raw_update_callbacks(rdpUpdate* update);
+void pf_client_register_raw_update_callbacks(rdpUpdate* update);
+
 #endif /* FREERDP_SERVER_PROXY_PFUPDATE_H */
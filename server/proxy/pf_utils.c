@@ -24,6 +24,7 @@
 
 #include <freerdp/server/proxy/proxy_log.h>
 #include "pf_utils.h"
+#include "proxy_modules.h"
 
 #define TAG PROXY_TAG("utils")
 
@@ -79,6 +80,37 @@ BOOL pf_utils_is_passthrough(const proxyConfig* config)
 	return TRUE;
 }
 
+BOOL pf_utils_forward_raw_updates(const proxyData* pdata)
+{
+	const rdpSettings* front;
+	const rdpSettings* target;
+
+	WINPR_ASSERT(pdata);
+	WINPR_ASSERT(pdata->config);
+
+	if (!pdata->config->ForwardRawUpdates)
+		return FALSE;
+
+	if (pf_modules_needs_graphics(pdata->module))
+		return FALSE;
+
+	/* raw updates are sent to the client as fast-path PDUs of the size the target chose */
+	WINPR_ASSERT(pdata->ps);
+	front = pdata->ps->context.settings;
+	WINPR_ASSERT(front);
+
+	if (!freerdp_settings_get_bool(front, FreeRDP_FastPathOutput))
+		return FALSE;
+
+	if (!pdata->pc)
+		return TRUE;
+
+	target = pdata->pc->context.settings;
+	WINPR_ASSERT(target);
+	return freerdp_settings_get_uint32(front, FreeRDP_MultifragMaxRequestSize) >=
+	       freerdp_settings_get_uint32(target, FreeRDP_MultifragMaxRequestSize);
+}
+
 const char* pf_utils_channel_mode_string(pf_utils_channel_mode mode)
 {
 	switch (mode)
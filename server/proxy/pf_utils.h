@@ -40,4 +40,14 @@ const char* pf_utils_channel_mode_string(pf_utils_channel_mode mode);
 
 BOOL pf_utils_is_passthrough(const proxyConfig* config);
 
+/**
+ * @brief pf_utils_forward_raw_updates Checks if the updates of the target are relayed to the
+ *          client without parsing them.
+ *
+ * @param pdata The session to check. Must NOT be NULL.
+ * @return TRUE if raw forwarding is configured, no plugin needs the decoded graphics and the
+ *          client accepts fast-path updates as large as the ones the target may send.
+ */
+BOOL pf_utils_forward_raw_updates(const proxyData* pdata);
+
 #endif /* FREERDP_SERVER_PROXY_PFUTILS_H */
@@ -81,6 +81,12 @@ extern "C"
 	BOOL pf_modules_is_plugin_loaded(proxyModule* module, const char* plugin_name);
 	void pf_modules_list_loaded_plugins(proxyModule* module);
 
+	/**
+	 * @brief pf_modules_needs_graphics Checks if a plugin inspects the graphics of the target
+	 * @return TRUE if a plugin hooks HOOK_TYPE_CLIENT_END_PAINT
+	 */
+	BOOL pf_modules_needs_graphics(proxyModule* module);
+
 	BOOL pf_modules_run_filter(proxyModule* module, PF_FILTER_TYPE type, proxyData* pdata,
 	                           void* param);
 	BOOL pf_modules_run_hook(proxyModule* module, PF_HOOK_TYPE type, proxyData* pdata,
@@ -2004,17 +2004,13 @@ static int shadow_client_subsystem_process_message(rdpShadowClient* client, wMes
 
 		case SHADOW_MSG_OUT_AUDIO_OUT_SAMPLES_ID:
 		{
-			const SHADOW_MSG_OUT_AUDIO_OUT_SAMPLES* msg =
-			    (const SHADOW_MSG_OUT_AUDIO_OUT_SAMPLES*)message->wParam;
+			SHADOW_MSG_OUT_AUDIO_OUT_SAMPLES* msg =
+			    (SHADOW_MSG_OUT_AUDIO_OUT_SAMPLES*)message->wParam;
 
 			WINPR_ASSERT(msg);
 
 			if (client->activated && client->rdpsnd && client->rdpsnd->Activated)
-			{
-				client->rdpsnd->src_format = msg->audio_format;
-				IFCALL(client->rdpsnd->SendSamples, client->rdpsnd, msg->buf, msg->nFrames,
-				       msg->wTimestamp);
-			}
+				shadow_client_rdpsnd_send_samples(client, msg);
 
 			break;
 		}
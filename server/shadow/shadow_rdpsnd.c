@@ -19,6 +19,10 @@
 #include <freerdp/config.h>
 
 #include <winpr/crt.h>
+#include <winpr/stream.h>
+#include <winpr/collections.h>
+#include <winpr/sysinfo.h>
+#include <winpr/interlocked.h>
 #include <freerdp/log.h>
 #include <freerdp/codec/dsp.h>
 #include <freerdp/server/server-common.h>
@@ -29,6 +33,439 @@
 
 #define TAG SERVER_TAG("shadow")
 
+#define SHADOW_RDPSND_LATENCY 50    /* ms, same as the rdpsnd server default */
+#define SHADOW_RDPSND_CACHE_SIZE 16 /* encoded messages kept for clients lagging behind */
+#define SHADOW_RDPSND_VERSION_WAVE2 0x08 /* CHANNEL_VERSION_WIN_8, needed for pre-encoded data */
+
+typedef struct
+{
+	UINT64 sequence;
+	UINT32 audioTimeStamp;                 /* tick count when the samples were encoded */
+	SHADOW_MSG_OUT_AUDIO_OUT_SAMPLES* msg; /* referenced as long as it is cached */
+	wStream* packets;                      /* sequence of UINT32 length + encoded data */
+} SHADOW_RDPSND_CACHE_ENTRY;
+
+typedef struct rdp_shadow_audio_encoder rdpShadowAudioEncoder;
+
+/**
+ * Clients that agreed on the same format share one encoder.
+ * The samples of each message are encoded once and the resulting packets are sent to
+ * every attached client, block numbers and timestamps are still handled per client.
+ */
+struct rdp_shadow_audio_encoder
+{
+	size_t refCount;
+	AUDIO_FORMAT format;
+	AUDIO_FORMAT srcFormat;
+	FREERDP_DSP_CONTEXT* dsp;
+	wStream* encoded;
+	BYTE* buffer;
+	size_t bufferFrames;
+	size_t pendingFrames;
+	size_t bytesPerFrame;
+	UINT64 sequence;
+	SHADOW_RDPSND_CACHE_ENTRY cache[SHADOW_RDPSND_CACHE_SIZE];
+};
+
+struct rdp_shadow_audio_client
+{
+	rdpShadowAudioEncoder* encoder;
+	UINT64 sequence; /* encoder sequence of the last message handled by the client */
+	wStream* packets;
+};
+
+static BOOL shadow_rdpsnd_format_equal(const AUDIO_FORMAT* a, const AUDIO_FORMAT* b)
+{
+	return (a->wFormatTag == b->wFormatTag) && (a->nChannels == b->nChannels) &&
+	       (a->nSamplesPerSec == b->nSamplesPerSec) && (a->wBitsPerSample == b->wBitsPerSample) &&
+	       (a->nBlockAlign == b->nBlockAlign);
+}
+
+static void shadow_rdpsnd_cache_entry_reset(SHADOW_RDPSND_CACHE_ENTRY* entry)
+{
+	SHADOW_MSG_OUT* msg;
+
+	if (!entry->msg)
+		return;
+
+	msg = &entry->msg->common;
+	entry->msg = NULL;
+
+	if (InterlockedDecrement(&(msg->refCount)) <= 0)
+	{
+		IFCALL(msg->Free, SHADOW_MSG_OUT_AUDIO_OUT_SAMPLES_ID, msg);
+	}
+}
+
+static void shadow_audio_encoder_free(rdpShadowAudioEncoder* encoder)
+{
+	size_t index;
+
+	if (!encoder)
+		return;
+
+	for (index = 0; index < ARRAYSIZE(encoder->cache); index++)
+	{
+		shadow_rdpsnd_cache_entry_reset(&encoder->cache[index]);
+		Stream_Free(encoder->cache[index].packets, TRUE);
+	}
+
+	Stream_Free(encoder->encoded, TRUE);
+	freerdp_dsp_context_free(encoder->dsp);
+	audio_format_free(&encoder->format);
+	audio_format_free(&encoder->srcFormat);
+	free(encoder->buffer);
+	free(encoder);
+}
+
+static rdpShadowAudioEncoder* shadow_audio_encoder_new(const AUDIO_FORMAT* format)
+{
+	size_t index;
+	rdpShadowAudioEncoder* encoder = calloc(1, sizeof(rdpShadowAudioEncoder));
+
+	if (!encoder)
+		return NULL;
+
+	if (!audio_format_copy(format, &encoder->format))
+		goto fail;
+
+	encoder->dsp = freerdp_dsp_context_new(TRUE);
+	encoder->encoded = Stream_New(NULL, 4096);
+
+	if (!encoder->dsp || !encoder->encoded)
+		goto fail;
+
+	for (index = 0; index < ARRAYSIZE(encoder->cache); index++)
+	{
+		encoder->cache[index].packets = Stream_New(NULL, 4096);
+
+		if (!encoder->cache[index].packets)
+			goto fail;
+	}
+
+	return encoder;
+fail:
+	shadow_audio_encoder_free(encoder);
+	return NULL;
+}
+
+static BOOL shadow_audio_encoder_set_source(rdpShadowAudioEncoder* encoder,
+                                            const AUDIO_FORMAT* srcFormat)
+{
+	BYTE* buffer;
+	size_t frames;
+	size_t bytesPerFrame;
+
+	if (encoder->bytesPerFrame && shadow_rdpsnd_format_equal(&encoder->srcFormat, srcFormat))
+		return TRUE;
+
+	audio_format_free(&encoder->srcFormat);
+	encoder->bytesPerFrame = 0;
+
+	if (!audio_format_copy(srcFormat, &encoder->srcFormat))
+		return FALSE;
+
+	frames = srcFormat->nSamplesPerSec * SHADOW_RDPSND_LATENCY / 1000;
+
+	if (frames < 1)
+		frames = 1;
+
+	bytesPerFrame = srcFormat->nChannels * srcFormat->wBitsPerSample / 8u;
+	buffer = realloc(encoder->buffer, frames * bytesPerFrame);
+
+	if (!buffer)
+		return FALSE;
+
+	encoder->buffer = buffer;
+	encoder->bufferFrames = frames;
+	encoder->pendingFrames = 0;
+	encoder->bytesPerFrame = bytesPerFrame;
+	return freerdp_dsp_context_reset(encoder->dsp, &encoder->format, 0u);
+}
+
+static BOOL shadow_audio_encoder_flush(rdpShadowAudioEncoder* encoder, wStream* packets)
+{
+	size_t length;
+	const size_t size = encoder->pendingFrames * encoder->bytesPerFrame;
+
+	encoder->pendingFrames = 0;
+	Stream_SetPosition(encoder->encoded, 0);
+
+	if (!freerdp_dsp_encode(encoder->dsp, &encoder->srcFormat, encoder->buffer, size,
+	                        encoder->encoded))
+		return FALSE;
+
+	length = Stream_GetPosition(encoder->encoded);
+
+	/* the codec may keep partial blocks for the next packet */
+	if (length == 0)
+		return TRUE;
+
+	/* same padding as the rdpsnd server applies to data it encodes itself */
+	if ((encoder->format.nBlockAlign > 0) && ((length % encoder->format.nBlockAlign) != 0))
+	{
+		const size_t pad = encoder->format.nBlockAlign - length % encoder->format.nBlockAlign;
+
+		if (!Stream_EnsureRemainingCapacity(encoder->encoded, pad))
+			return FALSE;
+
+		Stream_Zero(encoder->encoded, pad);
+		length += pad;
+	}
+
+	if ((length > UINT32_MAX) || !Stream_EnsureRemainingCapacity(packets, 4 + length))
+		return FALSE;
+
+	Stream_Write_UINT32(packets, (UINT32)length);
+	Stream_Write(packets, Stream_Buffer(encoder->encoded), length);
+	return TRUE;
+}
+
+static SHADOW_RDPSND_CACHE_ENTRY* shadow_audio_encoder_encode(rdpShadowAudioEncoder* encoder,
+                                                              SHADOW_MSG_OUT_AUDIO_OUT_SAMPLES* msg)
+{
+	const BYTE* src = msg->buf;
+	size_t nframes = msg->nFrames;
+	SHADOW_RDPSND_CACHE_ENTRY* entry =
+	    &encoder->cache[(encoder->sequence + 1) % ARRAYSIZE(encoder->cache)];
+
+	if (!shadow_audio_encoder_set_source(encoder, msg->audio_format))
+		return NULL;
+
+	shadow_rdpsnd_cache_entry_reset(entry);
+	Stream_SetPosition(entry->packets, 0);
+
+	while (nframes > 0)
+	{
+		const size_t cframes = MIN(nframes, encoder->bufferFrames - encoder->pendingFrames);
+		const size_t cframesize = cframes * encoder->bytesPerFrame;
+
+		CopyMemory(encoder->buffer + encoder->pendingFrames * encoder->bytesPerFrame, src,
+		           cframesize);
+		src += cframesize;
+		nframes -= cframes;
+		encoder->pendingFrames += cframes;
+
+		if (encoder->pendingFrames >= encoder->bufferFrames)
+		{
+			if (!shadow_audio_encoder_flush(encoder, entry->packets))
+				return NULL;
+		}
+	}
+
+	Stream_SealLength(entry->packets);
+	InterlockedIncrement(&(msg->common.refCount));
+	entry->msg = msg;
+	entry->audioTimeStamp = (UINT32)GetTickCount64();
+	entry->sequence = ++encoder->sequence;
+	return entry;
+}
+
+/**
+ * Get the encoded packets for a message.
+ * The first client to see a message encodes it, all others find it in the cache.
+ * A message that is neither cached nor newer than the last one encoded was already dropped
+ * from the cache by clients further ahead. Encoding it again would feed the stateful codec
+ * out of order, so the client skips it and catches up with the next messages.
+ */
+static const SHADOW_RDPSND_CACHE_ENTRY*
+shadow_audio_encoder_get(rdpShadowAudioClient* audio, SHADOW_MSG_OUT_AUDIO_OUT_SAMPLES* msg)
+{
+	size_t index;
+	rdpShadowAudioEncoder* encoder = audio->encoder;
+	const SHADOW_RDPSND_CACHE_ENTRY* entry = NULL;
+
+	for (index = 0; index < ARRAYSIZE(encoder->cache); index++)
+	{
+		if (encoder->cache[index].msg == msg)
+		{
+			entry = &encoder->cache[index];
+			break;
+		}
+	}
+
+	if (!entry)
+	{
+		if (audio->sequence < encoder->sequence)
+		{
+			audio->sequence++;
+			return NULL;
+		}
+
+		entry = shadow_audio_encoder_encode(encoder, msg);
+
+		if (!entry)
+			return NULL;
+	}
+
+	audio->sequence = entry->sequence;
+	return entry;
+}
+
+void shadow_client_rdpsnd_detach(rdpShadowClient* client)
+{
+	wArrayList* encoders;
+	rdpShadowAudioClient* audio;
+
+	WINPR_ASSERT(client);
+	WINPR_ASSERT(client->server);
+
+	audio = client->audio;
+
+	if (!audio)
+		return;
+
+	encoders = client->server->audioEncoders;
+	ArrayList_Lock(encoders);
+	client->audio = NULL;
+
+	if (--audio->encoder->refCount == 0)
+	{
+		ArrayList_Remove(encoders, audio->encoder);
+		shadow_audio_encoder_free(audio->encoder);
+	}
+
+	ArrayList_Unlock(encoders);
+	Stream_Free(audio->packets, TRUE);
+	free(audio);
+}
+
+void shadow_client_rdpsnd_attach(rdpShadowClient* client, const AUDIO_FORMAT* format)
+{
+	size_t index;
+	wArrayList* encoders;
+	rdpShadowAudioClient* audio;
+	rdpShadowAudioEncoder* encoder = NULL;
+
+	WINPR_ASSERT(client);
+	WINPR_ASSERT(client->server);
+
+	shadow_client_rdpsnd_detach(client);
+
+	if (!freerdp_dsp_supports_format(format, TRUE))
+		return;
+
+	audio = calloc(1, sizeof(rdpShadowAudioClient));
+
+	if (!audio)
+		return;
+
+	audio->packets = Stream_New(NULL, 4096);
+
+	if (!audio->packets)
+	{
+		free(audio);
+		return;
+	}
+
+	encoders = client->server->audioEncoders;
+	ArrayList_Lock(encoders);
+
+	for (index = 0; index < ArrayList_Count(encoders); index++)
+	{
+		rdpShadowAudioEncoder* cur = ArrayList_GetItem(encoders, index);
+
+		if (shadow_rdpsnd_format_equal(&cur->format, format))
+		{
+			encoder = cur;
+			break;
+		}
+	}
+
+	if (!encoder)
+	{
+		encoder = shadow_audio_encoder_new(format);
+
+		if (encoder && !ArrayList_Append(encoders, encoder))
+		{
+			shadow_audio_encoder_free(encoder);
+			encoder = NULL;
+		}
+	}
+
+	if (encoder)
+	{
+		encoder->refCount++;
+		audio->encoder = encoder;
+		audio->sequence = encoder->sequence;
+		client->audio = audio;
+	}
+
+	ArrayList_Unlock(encoders);
+
+	if (!encoder)
+	{
+		WLog_WARN(TAG, "No shared audio encoder, encoding samples for this client only");
+		Stream_Free(audio->packets, TRUE);
+		free(audio);
+	}
+}
+
+void shadow_client_rdpsnd_send_samples(rdpShadowClient* client,
+                                       SHADOW_MSG_OUT_AUDIO_OUT_SAMPLES* msg)
+{
+	BOOL shared = FALSE;
+	UINT32 audioTimeStamp = 0;
+	wArrayList* encoders;
+	RdpsndServerContext* rdpsnd;
+
+	WINPR_ASSERT(client);
+	WINPR_ASSERT(client->server);
+	WINPR_ASSERT(msg);
+
+	rdpsnd = client->rdpsnd;
+	WINPR_ASSERT(rdpsnd);
+
+	/* Only copying the encoded packets is done under the lock, the channel writes are not */
+	encoders = client->server->audioEncoders;
+	ArrayList_Lock(encoders);
+
+	if (client->audio)
+	{
+		wStream* packets = client->audio->packets;
+		const SHADOW_RDPSND_CACHE_ENTRY* entry = shadow_audio_encoder_get(client->audio, msg);
+
+		shared = TRUE;
+
+		if (!entry || !Stream_EnsureCapacity(packets, Stream_Length(entry->packets)))
+		{
+			ArrayList_Unlock(encoders);
+			return;
+		}
+
+		Stream_SetPosition(packets, 0);
+		Stream_Write(packets, Stream_Buffer(entry->packets), Stream_Length(entry->packets));
+		Stream_SealLength(packets);
+		Stream_SetPosition(packets, 0);
+		audioTimeStamp = entry->audioTimeStamp;
+	}
+
+	ArrayList_Unlock(encoders);
+
+	if (shared)
+	{
+		wStream* s = client->audio->packets;
+
+		while (Stream_GetRemainingLength(s) >= 4)
+		{
+			UINT32 length;
+			Stream_Read_UINT32(s, length);
+
+			if (Stream_GetRemainingLength(s) < length)
+				break;
+
+			IFCALL(rdpsnd->SendSamples2, rdpsnd, rdpsnd->selected_client_format,
+			       Stream_Pointer(s), length, msg->wTimestamp, audioTimeStamp);
+			Stream_Seek(s, length);
+		}
+	}
+	else
+	{
+		rdpsnd->src_format = msg->audio_format;
+		IFCALL(rdpsnd->SendSamples, rdpsnd, msg->buf, msg->nFrames, msg->wTimestamp);
+	}
+}
+
 static void rdpsnd_activated(RdpsndServerContext* context)
 {
 	const AUDIO_FORMAT* agreed_format = NULL;
@@ -56,6 +493,9 @@ static void rdpsnd_activated(RdpsndServerContext* context)
 	}
 
 	context->SelectFormat(context, i);
+
+	if (context->clientVersion >= SHADOW_RDPSND_VERSION_WAVE2)
+		shadow_client_rdpsnd_attach((rdpShadowClient*)context->data, &context->client_formats[i]);
 }
 
 int shadow_client_rdpsnd_init(rdpShadowClient* client)
@@ -92,6 +532,7 @@ void shadow_client_rdpsnd_uninit(rdpShadowClient* client)
 {
 	if (client->rdpsnd)
 	{
+		shadow_client_rdpsnd_detach(client);
 		client->rdpsnd->Stop(client->rdpsnd);
 		rdpsnd_server_context_free(client->rdpsnd);
 		client->rdpsnd = NULL;
@@ -31,6 +31,10 @@ extern "C"
 
 	int shadow_client_rdpsnd_init(rdpShadowClient* client);
 	void shadow_client_rdpsnd_uninit(rdpShadowClient* client);
+	void shadow_client_rdpsnd_send_samples(rdpShadowClient* client,
+	                                       SHADOW_MSG_OUT_AUDIO_OUT_SAMPLES* msg);
+	void shadow_client_rdpsnd_attach(rdpShadowClient* client, const AUDIO_FORMAT* format);
+	void shadow_client_rdpsnd_detach(rdpShadowClient* client);
 
 #ifdef __cplusplus
 }
@@ -392,6 +392,10 @@ int shadow_server_parse_command_line(rdpShadowServer* server, int argc, char** a
 			if (!freerdp_settings_set_bool(settings, FreeRDP_GfxAVC444, arg->Value ? TRUE : FALSE))
 				return COMMAND_LINE_ERROR;
 		}
+		CommandLineSwitchCase(arg, "gfx-avc444-adaptive")
+		{
+			server->h264AdaptiveLumaOnly = arg->Value ? TRUE : FALSE;
+		}
 		CommandLineSwitchCase(arg, "keytab")
 		{
 			if (!freerdp_settings_set_string(settings, FreeRDP_KerberosKeytab, arg->Value))
@@ -824,6 +828,9 @@ int shadow_server_init(rdpShadowServer* server)
 	if (!(server->clients = ArrayList_New(TRUE)))
 		goto fail_client_array;
 
+	if (!(server->audioEncoders = ArrayList_New(TRUE)))
+		goto fail_audio_encoders;
+
 	if (!(server->StopEvent = CreateEvent(NULL, TRUE, FALSE, NULL)))
 		goto fail_stop_event;
 
@@ -875,6 +882,9 @@ fail_server_lock:
 	CloseHandle(server->StopEvent);
 	server->StopEvent = NULL;
 fail_stop_event:
+	ArrayList_Free(server->audioEncoders);
+	server->audioEncoders = NULL;
+fail_audio_encoders:
 	ArrayList_Free(server->clients);
 	server->clients = NULL;
 fail_client_array:
@@ -903,6 +913,8 @@ int shadow_server_uninit(rdpShadowServer* server)
 	server->StopEvent = NULL;
 	ArrayList_Free(server->clients);
 	server->clients = NULL;
+	ArrayList_Free(server->audioEncoders);
+	server->audioEncoders = NULL;
 	return 1;
 }
 
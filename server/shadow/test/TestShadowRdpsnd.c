@@ -0,0 +1,213 @@
+#include <stdio.h>
+
+#include <winpr/crt.h>
+#include <winpr/collections.h>
+
+#include <freerdp/codec/audio.h>
+#include <freerdp/server/rdpsnd.h>
+#include <freerdp/server/shadow.h>
+
+#include "../shadow_rdpsnd.h"
+
+#define TEST_FRAMES 2205 /* one SHADOW_RDPSND_LATENCY (50ms) chunk at 44.1kHz */
+#define TEST_BYTES_PER_FRAME 4
+#define TEST_LAG_MESSAGES 17 /* one more than the encoder caches */
+
+typedef struct
+{
+	size_t calls;
+	size_t size;
+	BYTE data[TEST_FRAMES * TEST_BYTES_PER_FRAME];
+} test_rdpsnd_client;
+
+static AUDIO_FORMAT test_format = { WAVE_FORMAT_PCM, 2, 44100, 176400, 4, 16, 0, NULL };
+static test_rdpsnd_client test_data[2];
+
+static UINT test_send_samples2(RdpsndServerContext* context, UINT16 formatNo, const void* buf,
+                               size_t size, UINT16 timestamp, UINT32 audioTimeStamp)
+{
+	test_rdpsnd_client* data = context->data;
+
+	WINPR_UNUSED(formatNo);
+	WINPR_UNUSED(timestamp);
+	WINPR_UNUSED(audioTimeStamp);
+
+	if (size > sizeof(data->data))
+		return ERROR_INVALID_DATA;
+
+	data->calls++;
+	data->size = size;
+	memcpy(data->data, buf, size);
+	return CHANNEL_RC_OK;
+}
+
+static UINT test_send_samples(RdpsndServerContext* context, const void* buf, size_t nframes,
+                              UINT16 wTimestamp)
+{
+	WINPR_UNUSED(context);
+	WINPR_UNUSED(buf);
+	WINPR_UNUSED(nframes);
+	WINPR_UNUSED(wTimestamp);
+
+	fprintf(stderr, "shared encoder not used\n");
+	return ERROR_INTERNAL_ERROR;
+}
+
+static void test_free_msg(UINT32 id, SHADOW_MSG_OUT* msg)
+{
+	WINPR_UNUSED(id);
+	WINPR_UNUSED(msg);
+}
+
+static void test_msg_init(SHADOW_MSG_OUT_AUDIO_OUT_SAMPLES* msg, BYTE* buf, BYTE seed)
+{
+	size_t x;
+
+	for (x = 0; x < TEST_FRAMES * TEST_BYTES_PER_FRAME; x++)
+		buf[x] = (BYTE)(seed + x);
+
+	msg->common.refCount = 1;
+	msg->common.Free = test_free_msg;
+	msg->audio_format = &test_format;
+	msg->buf = buf;
+	msg->nFrames = TEST_FRAMES;
+	msg->wTimestamp = seed;
+}
+
+static BOOL test_received(const test_rdpsnd_client* data, const BYTE* buf, size_t calls)
+{
+	if (data->calls != calls)
+	{
+		fprintf(stderr, "expected %" PRIuz " packets, got %" PRIuz "\n", calls, data->calls);
+		return FALSE;
+	}
+
+	if (data->size != TEST_FRAMES * TEST_BYTES_PER_FRAME)
+		return FALSE;
+
+	return memcmp(data->data, buf, data->size) == 0;
+}
+
+int TestShadowRdpsnd(int argc, char* argv[])
+{
+	int rc = -1;
+	size_t x;
+	rdpShadowServer server = { 0 };
+	rdpShadowClient clients[2] = { 0 };
+	RdpsndServerContext rdpsnd[2] = { 0 };
+	SHADOW_MSG_OUT_AUDIO_OUT_SAMPLES msg1 = { 0 };
+	SHADOW_MSG_OUT_AUDIO_OUT_SAMPLES msg2 = { 0 };
+	SHADOW_MSG_OUT_AUDIO_OUT_SAMPLES lag[TEST_LAG_MESSAGES] = { 0 };
+	BYTE* buf1 = calloc(TEST_FRAMES, TEST_BYTES_PER_FRAME);
+	BYTE* buf2 = calloc(TEST_FRAMES, TEST_BYTES_PER_FRAME);
+
+	WINPR_UNUSED(argc);
+	WINPR_UNUSED(argv);
+
+	server.audioEncoders = ArrayList_New(TRUE);
+
+	if (!buf1 || !buf2 || !server.audioEncoders)
+		goto fail;
+
+	test_msg_init(&msg1, buf1, 1);
+	test_msg_init(&msg2, buf2, 2);
+
+	for (x = 0; x < ARRAYSIZE(lag); x++)
+		test_msg_init(&lag[x], buf2, 2);
+
+	for (x = 0; x < ARRAYSIZE(clients); x++)
+	{
+		rdpsnd[x].data = &test_data[x];
+		rdpsnd[x].SendSamples = test_send_samples;
+		rdpsnd[x].SendSamples2 = test_send_samples2;
+		clients[x].server = &server;
+		clients[x].rdpsnd = &rdpsnd[x];
+	}
+
+	/* Clients with the same format share one encoder */
+	shadow_client_rdpsnd_attach(&clients[0], &test_format);
+
+	if (!clients[0].audio)
+		goto fail;
+
+	/* The first message is only sent to the first client, the second one misses it */
+	shadow_client_rdpsnd_send_samples(&clients[0], &msg1);
+
+	if (!test_received(&test_data[0], buf1, 1))
+		goto fail;
+
+	shadow_client_rdpsnd_attach(&clients[1], &test_format);
+
+	if (!clients[1].audio || (ArrayList_Count(server.audioEncoders) != 1))
+	{
+		fprintf(stderr, "clients with the same format do not share an encoder\n");
+		goto fail;
+	}
+
+	/* The late client starts with the next message */
+	shadow_client_rdpsnd_send_samples(&clients[1], &msg2);
+
+	if (!test_received(&test_data[1], buf2, 1))
+		goto fail;
+
+	/* The second client encoded the message, the first one finds it in the cache */
+	shadow_client_rdpsnd_send_samples(&clients[0], &msg2);
+
+	if (!test_received(&test_data[0], buf2, 2))
+		goto fail;
+
+	if ((msg1.common.refCount != 2) || (msg2.common.refCount != 2))
+	{
+		fprintf(stderr, "messages were not encoded exactly once\n");
+		goto fail;
+	}
+
+	/* The first client runs ahead further than the cache reaches */
+	for (x = 0; x < ARRAYSIZE(lag); x++)
+		shadow_client_rdpsnd_send_samples(&clients[0], &lag[x]);
+
+	if (!test_received(&test_data[0], buf2, 2 + ARRAYSIZE(lag)))
+		goto fail;
+
+	/* The lagging client skips the dropped message instead of encoding it again */
+	shadow_client_rdpsnd_send_samples(&clients[1], &lag[0]);
+
+	if ((lag[0].common.refCount != 1) || !test_received(&test_data[1], buf2, 1))
+	{
+		fprintf(stderr, "message dropped from the cache was encoded again\n");
+		goto fail;
+	}
+
+	/* and is back in sync with the cached messages */
+	for (x = 1; x < ARRAYSIZE(lag); x++)
+		shadow_client_rdpsnd_send_samples(&clients[1], &lag[x]);
+
+	if (!test_received(&test_data[1], buf2, ARRAYSIZE(lag)))
+		goto fail;
+
+	rc = 0;
+fail:
+	for (x = 0; x < ARRAYSIZE(clients); x++)
+	{
+		if (clients[x].server)
+			shadow_client_rdpsnd_detach(&clients[x]);
+	}
+
+	for (x = 0; x < ARRAYSIZE(lag); x++)
+	{
+		if ((rc == 0) && (lag[x].common.refCount != 1))
+			rc = -1;
+	}
+
+	if ((rc == 0) && ((msg1.common.refCount != 1) || (msg2.common.refCount != 1) ||
+	                  (ArrayList_Count(server.audioEncoders) != 0)))
+	{
+		fprintf(stderr, "encoder not released after the last client detached\n");
+		rc = -1;
+	}
+
+	ArrayList_Free(server.audioEncoders);
+	free(buf1);
+	free(buf2);
+	return rc;
+}
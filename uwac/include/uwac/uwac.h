@@ -535,7 +535,7 @@ extern "C"
 	 *
 	 * @param window the UwacWindow to refresh
 	 * @param copyContentForNextFrame if true the content to display is copied in the next drawing
-	 *buffer
+	 *buffer. Only the regions damaged since that buffer was last displayed are copied.
 	 * @return UWAC_SUCCESS if the operation was successful
 	 */
 	UWAC_API UwacReturnCode UwacWindowSubmitBuffer(UwacWindow* window,
@@ -221,9 +221,13 @@ struct uwac_buffer
 	struct wl_buffer* wayland_buffer;
 	void* data;
 	size_t size;
+	uint64_t frame; /* frame whose content the buffer holds, 0 if undefined */
 };
 typedef struct uwac_buffer UwacBuffer;
 
+/** @brief number of submitted frames whose damage is remembered per window */
+#define UWAC_DAMAGE_HISTORY 8
+
 /** @brief a window */
 struct uwac_window
 {
@@ -235,6 +239,13 @@ struct uwac_window
 	int nbuffers;
 	UwacBuffer* buffers;
 
+	uint64_t frameCount;
+#ifdef HAVE_PIXMAN_REGION
+	pixman_region32_t damageHistory[UWAC_DAMAGE_HISTORY];
+#else
+	REGION16 damageHistory[UWAC_DAMAGE_HISTORY];
+#endif
+
 	struct wl_region* opaque_region;
 	struct wl_region* input_region;
 	ssize_t drawingBufferIdx;
@@ -78,6 +78,36 @@ static void UwacWindowDestroyBuffers(UwacWindow* w)
 	w->nbuffers = 0;
 	free(w->buffers);
 	w->buffers = NULL;
+	/* the damage history refers to the content of the destroyed buffers */
+	w->frameCount = 0;
+}
+
+static void UwacWindowInitDamageHistory(UwacWindow* w)
+{
+	int i;
+
+	for (i = 0; i < UWAC_DAMAGE_HISTORY; i++)
+	{
+#ifdef HAVE_PIXMAN_REGION
+		pixman_region32_init(&w->damageHistory[i]);
+#else
+		region16_init(&w->damageHistory[i]);
+#endif
+	}
+}
+
+static void UwacWindowDestroyDamageHistory(UwacWindow* w)
+{
+	int i;
+
+	for (i = 0; i < UWAC_DAMAGE_HISTORY; i++)
+	{
+#ifdef HAVE_PIXMAN_REGION
+		pixman_region32_fini(&w->damageHistory[i]);
+#else
+		region16_uninit(&w->damageHistory[i]);
+#endif
+	}
 }
 
 static int UwacWindowShmAllocBuffers(UwacWindow* w, int nbuffers, int allocSize, uint32_t width,
@@ -464,6 +494,7 @@ UwacWindow* UwacCreateWindowShm(UwacDisplay* display, uint32_t width, uint32_t h
 	w->width = width;
 	w->height = height;
 	w->stride = width * bppFromShmFormat(format);
+	UwacWindowInitDamageHistory(w);
 	allocSize = w->stride * height;
 	ret = UwacWindowShmAllocBuffers(w, UWAC_INITIAL_BUFFERS, allocSize, width, height, format);
 
@@ -560,6 +591,7 @@ out_error_shell:
 out_error_surface:
 	UwacWindowDestroyBuffers(w);
 out_error_free:
+	UwacWindowDestroyDamageHistory(w);
 	free(w);
 	return NULL;
 }
@@ -595,6 +627,7 @@ UwacReturnCode UwacDestroyWindow(UwacWindow** pwindow)
 
 	wl_surface_destroy(w->surface);
 	wl_list_remove(&w->link);
+	UwacWindowDestroyDamageHistory(w);
 	free(w);
 	*pwindow = NULL;
 	return UWAC_SUCCESS;
@@ -748,6 +781,161 @@ UwacReturnCode UwacWindowAddDamage(UwacWindow* window, uint32_t x, uint32_t y, u
 }
 #endif
 
+static void UwacWindowCopyRect(UwacWindow* window, UwacBuffer* dst, const UwacBuffer* src,
+                               int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+	int32_t y;
+	size_t offset, length;
+	const size_t bpp = bppFromShmFormat(window->format);
+
+	if (x1 < 0)
+		x1 = 0;
+	if (y1 < 0)
+		y1 = 0;
+	if (x2 > window->width)
+		x2 = window->width;
+	if (y2 > window->height)
+		y2 = window->height;
+
+	if ((x1 >= x2) || (y1 >= y2))
+		return;
+
+	offset = y1 * 1ULL * window->stride + x1 * bpp;
+	length = (x2 - x1) * bpp;
+
+	/* full rows are contiguous in memory */
+	if (length == (size_t)window->stride)
+	{
+		memcpy((char*)dst->data + offset, (const char*)src->data + offset,
+		       length * (y2 - y1));
+		return;
+	}
+
+	for (y = y1; y < y2; y++, offset += window->stride)
+		memcpy((char*)dst->data + offset, (const char*)src->data + offset, length);
+}
+
+/* the damage history is incomplete, force full copies until every buffer was refreshed */
+static void UwacWindowInvalidateContent(UwacWindow* window)
+{
+	int i;
+
+	for (i = 0; i < window->nbuffers; i++)
+		window->buffers[i].frame = 0;
+}
+
+#ifdef HAVE_PIXMAN_REGION
+static void UwacWindowRecordDamage(UwacWindow* window, UwacBuffer* buffer)
+{
+	/* only a buffer that was up to date with the previous frame holds the full frame content */
+	const bool complete = (buffer->frame == window->frameCount);
+
+	window->frameCount++;
+	if (!pixman_region32_copy(&window->damageHistory[window->frameCount % UWAC_DAMAGE_HISTORY],
+	                          &buffer->damage))
+		UwacWindowInvalidateContent(window);
+
+	buffer->frame = complete ? window->frameCount : 0;
+}
+
+static bool UwacWindowCopyDamage(UwacWindow* window, UwacBuffer* dst, const UwacBuffer* src)
+{
+	int nrects, i;
+	uint64_t frame;
+	const pixman_box32_t* box;
+	pixman_region32_t damage;
+
+	pixman_region32_init(&damage);
+
+	for (frame = dst->frame + 1; frame <= src->frame; frame++)
+	{
+		if (!pixman_region32_union(&damage, &damage,
+		                           &window->damageHistory[frame % UWAC_DAMAGE_HISTORY]))
+		{
+			pixman_region32_fini(&damage);
+			return false;
+		}
+	}
+
+	box = pixman_region32_rectangles(&damage, &nrects);
+
+	for (i = 0; i < nrects; i++, box++)
+		UwacWindowCopyRect(window, dst, src, box->x1, box->y1, box->x2, box->y2);
+
+	pixman_region32_fini(&damage);
+	return true;
+}
+#else
+static void UwacWindowRecordDamage(UwacWindow* window, UwacBuffer* buffer)
+{
+	/* only a buffer that was up to date with the previous frame holds the full frame content */
+	const bool complete = (buffer->frame == window->frameCount);
+
+	window->frameCount++;
+	if (!region16_copy(&window->damageHistory[window->frameCount % UWAC_DAMAGE_HISTORY],
+	                   &buffer->damage))
+		UwacWindowInvalidateContent(window);
+
+	buffer->frame = complete ? window->frameCount : 0;
+}
+
+static bool UwacWindowCopyDamage(UwacWindow* window, UwacBuffer* dst, const UwacBuffer* src)
+{
+	uint32_t nrects, i;
+	uint64_t frame;
+	const RECTANGLE_16* box;
+	REGION16 damage;
+
+	region16_init(&damage);
+
+	for (frame = dst->frame + 1; frame <= src->frame; frame++)
+	{
+		const REGION16* history = &window->damageHistory[frame % UWAC_DAMAGE_HISTORY];
+		const RECTANGLE_16* rect = region16_rects(history, &nrects);
+
+		for (i = 0; i < nrects; i++, rect++)
+		{
+			if (!region16_union_rect(&damage, &damage, rect))
+			{
+				region16_uninit(&damage);
+				return false;
+			}
+		}
+	}
+
+	box = region16_rects(&damage, &nrects);
+
+	for (i = 0; i < nrects; i++, box++)
+		UwacWindowCopyRect(window, dst, src, box->left, box->top, box->right, box->bottom);
+
+	region16_uninit(&damage);
+	return true;
+}
+#endif
+
+/**
+ * Brings dst up to date with the content of src. If dst holds a frame that is still covered
+ * by the damage history only the regions changed since then are copied.
+ */
+static void UwacWindowCopyContent(UwacWindow* window, UwacBuffer* dst, UwacBuffer* src)
+{
+	const uint64_t age = src->frame - dst->frame;
+
+	if ((dst->frame != 0) && (dst->frame == src->frame))
+		return;
+
+	if ((dst->frame == 0) || (src->frame == 0) || (dst->frame > src->frame) ||
+	    (age > UWAC_DAMAGE_HISTORY) || !UwacWindowCopyDamage(window, dst, src))
+	{
+		memcpy(dst->data, src->data, window->stride * window->height * 1ULL);
+
+		/* src holds the current frame, both buffers are up to date again */
+		src->frame = window->frameCount;
+	}
+
+	dst->frame = src->frame;
+}
+
 UwacReturnCode UwacWindowGetDrawingBufferGeometry(UwacWindow* window, UwacSize* geometry,
                                                   size_t* stride)
 {
@@ -787,9 +975,10 @@ UwacReturnCode UwacWindowSubmitBuffer(UwacWindow* window, bool copyContentForNex
 	if ((!nextDrawingBuffer) || (window->drawingBufferIdx < 0))
 		return UWAC_ERROR_NOMEMORY;
 
+	UwacWindowRecordDamage(window, pendingBuffer);
+
 	if (copyContentForNextFrame)
-		memcpy(nextDrawingBuffer->data, pendingBuffer->data,
-		       window->stride * window->height * 1ULL);
+		UwacWindowCopyContent(window, nextDrawingBuffer, pendingBuffer);
 
 	UwacSubmitBufferPtr(window, pendingBuffer);
 	return UWAC_SUCCESS;
@@ -194,6 +194,10 @@ extern "C"
 
 #endif
 
+	/* 64-bit counters built on InterlockedCompareExchange64, both return the previous value */
+	WINPR_API LONGLONG winpr_InterlockedExchangeAdd64(LONGLONG volatile* Addend, LONGLONG Value);
+	WINPR_API LONGLONG winpr_InterlockedMax64(LONGLONG volatile* Target, LONGLONG Value);
+
 	/* Doubly-Linked List */
 
 	WINPR_API VOID InitializeListHead(WINPR_PLIST_ENTRY ListHead);
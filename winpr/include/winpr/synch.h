@@ -417,6 +417,17 @@ extern "C"
 
 	WINPR_API void* GetEventWaitObject(HANDLE hEvent);
 
+	/**
+	 * Critical section contention statistics, only recorded by builds with
+	 * WITH_CRITICAL_SECTION_STATS when the WINPR_CRITICAL_SECTION_STATS environment variable
+	 * is set. A value above 0 logs a report every that many seconds.
+	 *
+	 * Statistics are kept per name or, for unnamed sections, per creation call site.
+	 */
+	WINPR_API BOOL winpr_critical_section_set_name(LPCRITICAL_SECTION lpCriticalSection,
+	                                               const char* name);
+	WINPR_API void winpr_critical_section_log_stats(const char* tag, DWORD level);
+
 #ifdef __cplusplus
 }
 #endif
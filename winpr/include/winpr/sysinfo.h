@@ -319,6 +319,9 @@ extern "C"
 
 	WINPR_API DWORD GetTickCountPrecise(void);
 
+	/** Monotonic time stamp in nanoseconds, only meaningful as a difference of two calls */
+	WINPR_API UINT64 winpr_GetTickCount64NS(void);
+
 	WINPR_API BOOL IsProcessorFeaturePresentEx(DWORD ProcessorFeature);
 
 /* extended flags */
@@ -405,6 +405,33 @@ LONGLONG InterlockedCompareExchange64(LONGLONG volatile* Destination, LONGLONG E
 
 #endif
 
+LONGLONG winpr_InterlockedExchangeAdd64(LONGLONG volatile* Addend, LONGLONG Value)
+{
+	LONGLONG cur;
+
+	do
+	{
+		cur = *Addend;
+	} while (InterlockedCompareExchange64(Addend, cur + Value, cur) != cur);
+
+	return cur;
+}
+
+LONGLONG winpr_InterlockedMax64(LONGLONG volatile* Target, LONGLONG Value)
+{
+	LONGLONG cur;
+
+	do
+	{
+		cur = *Target;
+
+		if (cur >= Value)
+			break;
+	} while (InterlockedCompareExchange64(Target, Value, cur) != cur);
+
+	return cur;
+}
+
 /* Doubly-Linked List */
 
 /**
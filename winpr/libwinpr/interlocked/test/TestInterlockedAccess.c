@@ -192,6 +192,40 @@ int TestInterlockedAccess(int argc, char* argv[])
 		return -1;
 	}
 
+	/* winpr_InterlockedExchangeAdd64 */
+
+	*Destination64 = 0x100000000LL;
+
+	oldValue64 = winpr_InterlockedExchangeAdd64(Destination64, 0x200000005LL);
+
+	if ((oldValue64 != 0x100000000LL) || (*Destination64 != 0x300000005LL))
+	{
+		printf("winpr_InterlockedExchangeAdd64 failure: Actual: 0x%016" PRIX64
+		       ", Expected: 0x300000005\n",
+		       *Destination64);
+		return -1;
+	}
+
+	/* winpr_InterlockedMax64 */
+
+	oldValue64 = winpr_InterlockedMax64(Destination64, 0x200000000LL);
+
+	if ((oldValue64 != 0x300000005LL) || (*Destination64 != 0x300000005LL))
+	{
+		printf("winpr_InterlockedMax64 failure: Actual: 0x%016" PRIX64 ", Expected: 0x300000005\n",
+		       *Destination64);
+		return -1;
+	}
+
+	oldValue64 = winpr_InterlockedMax64(Destination64, 0x400000000LL);
+
+	if ((oldValue64 != 0x300000005LL) || (*Destination64 != 0x400000000LL))
+	{
+		printf("winpr_InterlockedMax64 failure: Actual: 0x%016" PRIX64 ", Expected: 0x400000000\n",
+		       *Destination64);
+		return -1;
+	}
+
 	winpr_aligned_free(Addend);
 	winpr_aligned_free(Target);
 	winpr_aligned_free(Destination);
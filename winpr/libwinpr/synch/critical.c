@@ -32,6 +32,13 @@
 #include <unistd.h>
 #endif
 
+#if defined(WITH_CRITICAL_SECTION_STATS) && !defined(_WIN32)
+#include <pthread.h>
+#ifdef HAVE_EXECINFO_H
+#include <execinfo.h>
+#endif
+#endif
+
 #if defined(__APPLE__)
 #include <mach/task.h>
 #include <mach/mach.h>
@@ -43,13 +50,404 @@
 #include "../log.h"
 #define TAG WINPR_TAG("synch.critical")
 
+#if defined(WITH_CRITICAL_SECTION_STATS)
+
+#define CRITICAL_SECTION_WAIT_BUCKETS 16
+
+/* Statistics of all critical sections sharing a name or creation call site. The records live
+ * until the process exits, they are few and may be reported after the sections are deleted. */
+typedef struct s_critical_section_stats
+{
+	struct s_critical_section_stats* next;
+	const void* site;
+	char* name;
+	LONGLONG sections;
+	LONGLONG acquisitions;
+	LONGLONG contentions;
+	LONGLONG tryFailures;
+	LONGLONG waitTimeNS;
+	LONGLONG holdTimeNS;
+	LONGLONG maxHoldTimeNS;
+	/* bucket n counts waits shorter than 2^n microseconds, the last one all longer waits */
+	LONGLONG waitHistogram[CRITICAL_SECTION_WAIT_BUCKETS];
+} CRITICAL_SECTION_STATS;
+
+/* stored in RTL_CRITICAL_SECTION::DebugInfo */
+typedef struct
+{
+	CRITICAL_SECTION_STATS* stats;
+	UINT64 acquired; /* written by the owning thread only */
+} CRITICAL_SECTION_DEBUG_INFO;
+
+static pthread_once_t stats_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static CRITICAL_SECTION_STATS* stats_list = NULL;
+static BOOL stats_enabled = FALSE;
+static DWORD stats_interval = 0;
+
+static void* critical_section_stats_report(void* arg)
+{
+	WINPR_UNUSED(arg);
+
+	while (TRUE)
+	{
+		sleep(stats_interval);
+		winpr_critical_section_log_stats(TAG, WLOG_INFO);
+	}
+
+	return NULL;
+}
+
+static void critical_section_stats_init(void)
+{
+	const char* env = getenv("WINPR_CRITICAL_SECTION_STATS");
+
+	if (!env)
+		return;
+
+	stats_enabled = TRUE;
+	stats_interval = strtoul(env, NULL, 0);
+
+	if (stats_interval > 0)
+	{
+		pthread_t thread;
+
+		if (pthread_create(&thread, NULL, critical_section_stats_report, NULL) == 0)
+			pthread_detach(thread);
+	}
+}
+
+/* must be called with stats_mutex held */
+static CRITICAL_SECTION_STATS* critical_section_stats_find(const void* site, const char* name)
+{
+	CRITICAL_SECTION_STATS* stats;
+
+	for (stats = stats_list; stats; stats = stats->next)
+	{
+		if (name ? (stats->name && (strcmp(stats->name, name) == 0))
+		         : (!stats->name && (stats->site == site)))
+			return stats;
+	}
+
+	stats = calloc(1, sizeof(CRITICAL_SECTION_STATS));
+
+	if (!stats)
+		return NULL;
+
+	stats->site = site;
+
+	if (name && !(stats->name = _strdup(name)))
+	{
+		free(stats);
+		return NULL;
+	}
+
+	stats->next = stats_list;
+	stats_list = stats;
+	return stats;
+}
+
+static void critical_section_stats_attach(LPCRITICAL_SECTION lpCriticalSection, const void* site)
+{
+	CRITICAL_SECTION_DEBUG_INFO* info;
+
+	pthread_once(&stats_once, critical_section_stats_init);
+
+	if (!stats_enabled)
+		return;
+
+	info = calloc(1, sizeof(CRITICAL_SECTION_DEBUG_INFO));
+
+	if (!info)
+		return;
+
+	pthread_mutex_lock(&stats_mutex);
+	info->stats = critical_section_stats_find(site, NULL);
+	pthread_mutex_unlock(&stats_mutex);
+
+	if (!info->stats)
+	{
+		free(info);
+		return;
+	}
+
+	winpr_InterlockedExchangeAdd64(&info->stats->sections, 1);
+	lpCriticalSection->DebugInfo = info;
+}
+
+static void critical_section_stats_detach(LPCRITICAL_SECTION lpCriticalSection)
+{
+	free(lpCriticalSection->DebugInfo);
+	lpCriticalSection->DebugInfo = NULL;
+}
+
+static UINT64 critical_section_stats_start(LPCRITICAL_SECTION lpCriticalSection)
+{
+	return lpCriticalSection->DebugInfo ? winpr_GetTickCount64NS() : 0;
+}
+
+static void critical_section_stats_acquired(LPCRITICAL_SECTION lpCriticalSection, UINT64 start,
+                                            BOOL contended)
+{
+	UINT64 now;
+	CRITICAL_SECTION_STATS* stats;
+	CRITICAL_SECTION_DEBUG_INFO* info = lpCriticalSection->DebugInfo;
+
+	if (!info)
+		return;
+
+	now = winpr_GetTickCount64NS();
+	stats = info->stats;
+	winpr_InterlockedExchangeAdd64(&stats->acquisitions, 1);
+
+	if (contended)
+	{
+		size_t bucket = 0;
+		const UINT64 wait = start ? now - start : 0;
+		UINT64 us = wait / 1000;
+
+		while (us && (bucket < CRITICAL_SECTION_WAIT_BUCKETS - 1))
+		{
+			us >>= 1;
+			bucket++;
+		}
+
+		winpr_InterlockedExchangeAdd64(&stats->contentions, 1);
+		winpr_InterlockedExchangeAdd64(&stats->waitTimeNS, (LONGLONG)wait);
+		winpr_InterlockedExchangeAdd64(&stats->waitHistogram[bucket], 1);
+	}
+
+	info->acquired = now;
+}
+
+static void critical_section_stats_released(LPCRITICAL_SECTION lpCriticalSection)
+{
+	LONGLONG hold;
+	CRITICAL_SECTION_DEBUG_INFO* info = lpCriticalSection->DebugInfo;
+
+	if (!info)
+		return;
+
+	hold = (LONGLONG)(winpr_GetTickCount64NS() - info->acquired);
+	winpr_InterlockedExchangeAdd64(&info->stats->holdTimeNS, hold);
+	winpr_InterlockedMax64(&info->stats->maxHoldTimeNS, hold);
+}
+
+static void critical_section_stats_try_failed(LPCRITICAL_SECTION lpCriticalSection)
+{
+	CRITICAL_SECTION_DEBUG_INFO* info = lpCriticalSection->DebugInfo;
+
+	if (info)
+		winpr_InterlockedExchangeAdd64(&info->stats->tryFailures, 1);
+}
+
+static int critical_section_stats_compare(const void* pa, const void* pb)
+{
+	const CRITICAL_SECTION_STATS* a = (const CRITICAL_SECTION_STATS*)pa;
+	const CRITICAL_SECTION_STATS* b = (const CRITICAL_SECTION_STATS*)pb;
+
+	if (a->waitTimeNS != b->waitTimeNS)
+		return (a->waitTimeNS < b->waitTimeNS) ? 1 : -1;
+
+	return (a->contentions < b->contentions) ? 1 : (a->contentions > b->contentions) ? -1 : 0;
+}
+
+static void critical_section_stats_site_name(const CRITICAL_SECTION_STATS* stats, char* buffer,
+                                             size_t size)
+{
+	if (stats->name)
+	{
+		_snprintf(buffer, size, "%s", stats->name);
+		return;
+	}
+
+#ifdef HAVE_EXECINFO_H
+	{
+		void* site = (void*)stats->site;
+		char** symbols = backtrace_symbols(&site, 1);
+
+		if (symbols)
+		{
+			_snprintf(buffer, size, "%s", symbols[0]);
+			free(symbols);
+			return;
+		}
+	}
+#endif
+
+	_snprintf(buffer, size, "%p", stats->site);
+}
+
+BOOL winpr_critical_section_set_name(LPCRITICAL_SECTION lpCriticalSection, const char* name)
+{
+	CRITICAL_SECTION_STATS* stats;
+	CRITICAL_SECTION_DEBUG_INFO* info;
+
+	if (!lpCriticalSection || !name)
+		return FALSE;
+
+	info = lpCriticalSection->DebugInfo;
+
+	if (!info)
+		return TRUE;
+
+	pthread_mutex_lock(&stats_mutex);
+	stats = critical_section_stats_find(NULL, name);
+	pthread_mutex_unlock(&stats_mutex);
+
+	if (!stats)
+		return FALSE;
+
+	winpr_InterlockedExchangeAdd64(&info->stats->sections, -1);
+	winpr_InterlockedExchangeAdd64(&stats->sections, 1);
+	info->stats = stats;
+	return TRUE;
+}
+
+void winpr_critical_section_log_stats(const char* tag, DWORD level)
+{
+	size_t i, j, count = 0;
+	CRITICAL_SECTION_STATS* cur;
+	CRITICAL_SECTION_STATS* snapshot;
+	wLog* log = WLog_Get(tag);
+
+	if (!stats_enabled || !WLog_IsLevelActive(log, level))
+		return;
+
+	/* copy the records, logging takes critical sections which must not wait for stats_mutex */
+	pthread_mutex_lock(&stats_mutex);
+
+	for (cur = stats_list; cur; cur = cur->next)
+		count++;
+
+	snapshot = calloc(count, sizeof(CRITICAL_SECTION_STATS));
+
+	for (cur = stats_list, i = 0; snapshot && cur; cur = cur->next)
+	{
+		if (cur->acquisitions > 0)
+			snapshot[i++] = *cur;
+	}
+
+	pthread_mutex_unlock(&stats_mutex);
+
+	if (!snapshot)
+		return;
+
+	count = i;
+	qsort(snapshot, count, sizeof(CRITICAL_SECTION_STATS), critical_section_stats_compare);
+	WLog_Print(log, level, "critical section statistics, %" PRIuz " sites:", count);
+
+	for (i = 0; i < count; i++)
+	{
+		char site[256] = { 0 };
+		char histogram[CRITICAL_SECTION_WAIT_BUCKETS * 32] = { 0 };
+		size_t pos = 0;
+		const CRITICAL_SECTION_STATS* stats = &snapshot[i];
+
+		for (j = 0; j < CRITICAL_SECTION_WAIT_BUCKETS; j++)
+		{
+			int rc;
+			const BOOL last = (j == CRITICAL_SECTION_WAIT_BUCKETS - 1);
+
+			if (stats->waitHistogram[j] == 0)
+				continue;
+
+			rc = _snprintf(&histogram[pos], sizeof(histogram) - pos, " %s%" PRIuz "us:%" PRId64,
+			               last ? ">=" : "<", (size_t)1 << (last ? j - 1 : j),
+			               stats->waitHistogram[j]);
+
+			if ((rc < 0) || ((size_t)rc >= sizeof(histogram) - pos))
+				break;
+
+			pos += (size_t)rc;
+		}
+
+		critical_section_stats_site_name(stats, site, sizeof(site));
+		WLog_Print(log, level,
+		           "%s: sections=%" PRId64 " acquired=%" PRId64 " contended=%" PRId64
+		           " tryfailed=%" PRId64 " wait=%" PRId64 "us hold=%" PRId64 "us maxhold=%" PRId64
+		           "us waits:%s",
+		           site, stats->sections, stats->acquisitions, stats->contentions,
+		           stats->tryFailures, stats->waitTimeNS / 1000, stats->holdTimeNS / 1000,
+		           stats->maxHoldTimeNS / 1000, histogram);
+	}
+
+	free(snapshot);
+}
+
+#define CRITICAL_SECTION_CALL_SITE() __builtin_return_address(0)
+
+#else
+
+static void critical_section_stats_attach(LPCRITICAL_SECTION lpCriticalSection, const void* site)
+{
+	WINPR_UNUSED(lpCriticalSection);
+	WINPR_UNUSED(site);
+}
+
+static void critical_section_stats_detach(LPCRITICAL_SECTION lpCriticalSection)
+{
+	WINPR_UNUSED(lpCriticalSection);
+}
+
+static UINT64 critical_section_stats_start(LPCRITICAL_SECTION lpCriticalSection)
+{
+	WINPR_UNUSED(lpCriticalSection);
+	return 0;
+}
+
+static void critical_section_stats_acquired(LPCRITICAL_SECTION lpCriticalSection, UINT64 start,
+                                            BOOL contended)
+{
+	WINPR_UNUSED(lpCriticalSection);
+	WINPR_UNUSED(start);
+	WINPR_UNUSED(contended);
+}
+
+static void critical_section_stats_released(LPCRITICAL_SECTION lpCriticalSection)
+{
+	WINPR_UNUSED(lpCriticalSection);
+}
+
+static void critical_section_stats_try_failed(LPCRITICAL_SECTION lpCriticalSection)
+{
+	WINPR_UNUSED(lpCriticalSection);
+}
+
+#define CRITICAL_SECTION_CALL_SITE() NULL
+
+BOOL winpr_critical_section_set_name(LPCRITICAL_SECTION lpCriticalSection, const char* name)
+{
+	WINPR_UNUSED(lpCriticalSection);
+	WINPR_UNUSED(name);
+	return TRUE;
+}
+
+void winpr_critical_section_log_stats(const char* tag, DWORD level)
+{
+	WINPR_UNUSED(tag);
+	WINPR_UNUSED(level);
+}
+
+#endif /* WITH_CRITICAL_SECTION_STATS */
+
+static BOOL critical_section_init(LPCRITICAL_SECTION lpCriticalSection, DWORD dwSpinCount,
+                                  DWORD Flags, const void* site);
+
 VOID InitializeCriticalSection(LPCRITICAL_SECTION lpCriticalSection)
 {
-	InitializeCriticalSectionEx(lpCriticalSection, 0, 0);
+	critical_section_init(lpCriticalSection, 0, 0, CRITICAL_SECTION_CALL_SITE());
 }
 
 BOOL InitializeCriticalSectionEx(LPCRITICAL_SECTION lpCriticalSection, DWORD dwSpinCount,
                                  DWORD Flags)
+{
+	return critical_section_init(lpCriticalSection, dwSpinCount, Flags,
+	                             CRITICAL_SECTION_CALL_SITE());
+}
+
+static BOOL critical_section_init(LPCRITICAL_SECTION lpCriticalSection, DWORD dwSpinCount,
+                                  DWORD Flags, const void* site)
 {
 	/**
 	 * See http://msdn.microsoft.com/en-us/library/ff541979(v=vs.85).aspx
@@ -89,6 +487,7 @@ BOOL InitializeCriticalSectionEx(LPCRITICAL_SECTION lpCriticalSection, DWORD dwS
 
 #endif
 	SetCriticalSectionSpinCount(lpCriticalSection, dwSpinCount);
+	critical_section_stats_attach(lpCriticalSection, site);
 	return TRUE;
 out_fail:
 	free(lpCriticalSection->LockSemaphore);
@@ -97,7 +496,7 @@ out_fail:
 
 BOOL InitializeCriticalSectionAndSpinCount(LPCRITICAL_SECTION lpCriticalSection, DWORD dwSpinCount)
 {
-	return InitializeCriticalSectionEx(lpCriticalSection, dwSpinCount, 0);
+	return critical_section_init(lpCriticalSection, dwSpinCount, 0, CRITICAL_SECTION_CALL_SITE());
 }
 
 DWORD SetCriticalSectionSpinCount(LPCRITICAL_SECTION lpCriticalSection, DWORD dwSpinCount)
@@ -140,15 +539,50 @@ static VOID _UnWaitCriticalSection(LPCRITICAL_SECTION lpCriticalSection)
 #endif
 }
 
+static BOOL critical_section_try_enter(LPCRITICAL_SECTION lpCriticalSection)
+{
+	HANDLE current_thread = (HANDLE)(ULONG_PTR)GetCurrentThreadId();
+
+	/* Atomically acquire the the lock if the section is free. */
+	if (InterlockedCompareExchange(&lpCriticalSection->LockCount, 0, -1) == -1)
+	{
+		lpCriticalSection->RecursionCount = 1;
+		lpCriticalSection->OwningThread = current_thread;
+		critical_section_stats_acquired(lpCriticalSection, 0, FALSE);
+		return TRUE;
+	}
+
+	/* Section is already locked. Check if it is owned by the current thread. */
+	if (lpCriticalSection->OwningThread == current_thread)
+	{
+		/* Recursion, return success */
+		lpCriticalSection->RecursionCount++;
+		InterlockedIncrement(&lpCriticalSection->LockCount);
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
 VOID EnterCriticalSection(LPCRITICAL_SECTION lpCriticalSection)
 {
+	UINT64 start = 0;
+	BOOL contended = FALSE;
+	/* The spin path is not compiled, winpr/CMakeLists.txt defines
+	 * WINPR_CRITICAL_SECTION_DISABLE_SPINCOUNT wherever this implementation is used. */
 #if !defined(WINPR_CRITICAL_SECTION_DISABLE_SPINCOUNT)
 	ULONG SpinCount = lpCriticalSection->SpinCount;
 
 	/* If we're lucky or if the current thread is already owner we can return early */
-	if (SpinCount && TryEnterCriticalSection(lpCriticalSection))
+	if (SpinCount && critical_section_try_enter(lpCriticalSection))
 		return;
 
+	if (SpinCount)
+	{
+		start = critical_section_stats_start(lpCriticalSection);
+		contended = TRUE;
+	}
+
 	/* Spin requested times but don't compete with another waiting thread */
 	while (SpinCount-- && lpCriticalSection->LockCount < 1)
 	{
@@ -157,6 +591,7 @@ VOID EnterCriticalSection(LPCRITICAL_SECTION lpCriticalSection)
 		{
 			lpCriticalSection->RecursionCount = 1;
 			lpCriticalSection->OwningThread = (HANDLE)(ULONG_PTR)GetCurrentThreadId();
+			critical_section_stats_acquired(lpCriticalSection, start, contended);
 			return;
 		}
 
@@ -185,36 +620,31 @@ VOID EnterCriticalSection(LPCRITICAL_SECTION lpCriticalSection)
 			return;
 		}
 
+		if (!start)
+			start = critical_section_stats_start(lpCriticalSection);
+
 		/* Section is locked by another thread. We have to wait. */
 		_WaitForCriticalSection(lpCriticalSection);
+
+		/* We got the lock. Own it ... */
+		lpCriticalSection->RecursionCount = 1;
+		lpCriticalSection->OwningThread = (HANDLE)(ULONG_PTR)GetCurrentThreadId();
+		critical_section_stats_acquired(lpCriticalSection, start, TRUE);
+		return;
 	}
 
 	/* We got the lock. Own it ... */
 	lpCriticalSection->RecursionCount = 1;
 	lpCriticalSection->OwningThread = (HANDLE)(ULONG_PTR)GetCurrentThreadId();
+	critical_section_stats_acquired(lpCriticalSection, start, contended);
 }
 
 BOOL TryEnterCriticalSection(LPCRITICAL_SECTION lpCriticalSection)
 {
-	HANDLE current_thread = (HANDLE)(ULONG_PTR)GetCurrentThreadId();
-
-	/* Atomically acquire the the lock if the section is free. */
-	if (InterlockedCompareExchange(&lpCriticalSection->LockCount, 0, -1) == -1)
-	{
-		lpCriticalSection->RecursionCount = 1;
-		lpCriticalSection->OwningThread = current_thread;
+	if (critical_section_try_enter(lpCriticalSection))
 		return TRUE;
-	}
-
-	/* Section is already locked. Check if it is owned by the current thread. */
-	if (lpCriticalSection->OwningThread == current_thread)
-	{
-		/* Recursion, return success */
-		lpCriticalSection->RecursionCount++;
-		InterlockedIncrement(&lpCriticalSection->LockCount);
-		return TRUE;
-	}
 
+	critical_section_stats_try_failed(lpCriticalSection);
 	return FALSE;
 }
 
@@ -223,6 +653,8 @@ VOID LeaveCriticalSection(LPCRITICAL_SECTION lpCriticalSection)
 	/* Decrement RecursionCount and check if this is the last LeaveCriticalSection call ...*/
 	if (--lpCriticalSection->RecursionCount < 1)
 	{
+		critical_section_stats_released(lpCriticalSection);
+
 		/* Last recursion, clear owner, unlock and if there are other waiting threads ... */
 		lpCriticalSection->OwningThread = NULL;
 
@@ -240,6 +672,7 @@ VOID LeaveCriticalSection(LPCRITICAL_SECTION lpCriticalSection)
 
 VOID DeleteCriticalSection(LPCRITICAL_SECTION lpCriticalSection)
 {
+	critical_section_stats_detach(lpCriticalSection);
 	lpCriticalSection->LockCount = -1;
 	lpCriticalSection->SpinCount = 0;
 	lpCriticalSection->RecursionCount = 0;
@@ -257,4 +690,19 @@ VOID DeleteCriticalSection(LPCRITICAL_SECTION lpCriticalSection)
 	}
 }
 
+#else
+
+BOOL winpr_critical_section_set_name(LPCRITICAL_SECTION lpCriticalSection, const char* name)
+{
+	WINPR_UNUSED(lpCriticalSection);
+	WINPR_UNUSED(name);
+	return TRUE;
+}
+
+void winpr_critical_section_log_stats(const char* tag, DWORD level)
+{
+	WINPR_UNUSED(tag);
+	WINPR_UNUSED(level);
+}
+
 #endif
@@ -1,11 +1,14 @@
 
 #include <stdio.h>
+#include <winpr/config.h>
 #include <winpr/crt.h>
 #include <winpr/windows.h>
 #include <winpr/synch.h>
 #include <winpr/sysinfo.h>
 #include <winpr/thread.h>
 #include <winpr/interlocked.h>
+#include <winpr/environment.h>
+#include <winpr/wlog.h>
 
 #define TEST_SYNC_CRITICAL_TEST1_RUNTIME_MS 50
 #define TEST_SYNC_CRITICAL_TEST1_RUNS 4
@@ -308,6 +311,125 @@ fail:
 	return 1;
 }
 
+#if defined(WITH_CRITICAL_SECTION_STATS) && !defined(_WIN32)
+#define TEST_SYNC_CRITICAL_STATS_NAME "TestSynchCritical.stats"
+
+static CRITICAL_SECTION statsCritical;
+static char statsReport[1024] = { 0 };
+
+static BOOL TestSynchCritical_StatsMessage(const wLogMessage* msg)
+{
+	const char* prefix = TEST_SYNC_CRITICAL_STATS_NAME ":";
+
+	if (strncmp(msg->TextString, prefix, strlen(prefix)) == 0)
+		sprintf_s(statsReport, sizeof(statsReport), "%s", msg->TextString);
+
+	return TRUE;
+}
+
+static DWORD WINAPI TestSynchCritical_StatsTryEnter(LPVOID arg)
+{
+	WINPR_UNUSED(arg);
+	return TryEnterCriticalSection(&statsCritical) ? 1 : 0;
+}
+
+static DWORD WINAPI TestSynchCritical_StatsEnter(LPVOID arg)
+{
+	WINPR_UNUSED(arg);
+	EnterCriticalSection(&statsCritical);
+	LeaveCriticalSection(&statsCritical);
+	return 0;
+}
+
+static BOOL TestSynchCritical_StatsThread(LPTHREAD_START_ROUTINE fkt, BOOL waitForBlock)
+{
+	DWORD dwThreadExitCode = 1;
+	HANDLE hThread;
+
+	EnterCriticalSection(&statsCritical);
+
+	if (!(hThread = CreateThread(NULL, 0, fkt, NULL, 0, NULL)))
+	{
+		LeaveCriticalSection(&statsCritical);
+		return FALSE;
+	}
+
+	/* the waiting thread has incremented the lock count */
+	while (waitForBlock && (statsCritical.LockCount < 1))
+		Sleep(1);
+
+	if (!waitForBlock)
+		WaitForSingleObject(hThread, INFINITE);
+
+	LeaveCriticalSection(&statsCritical);
+	WaitForSingleObject(hThread, INFINITE);
+	GetExitCodeThread(hThread, &dwThreadExitCode);
+	CloseHandle(hThread);
+	return dwThreadExitCode == 0;
+}
+
+/* the statistics are enabled by the environment when the first section is initialized */
+static BOOL TestSynchCritical_Stats(void)
+{
+	LONGLONG sections = 0;
+	LONGLONG acquired = 0;
+	LONGLONG contended = 0;
+	LONGLONG tryFailed = 0;
+	wLogCallbacks callbacks = { 0 };
+	wLog* root = WLog_GetRoot();
+	wLog* log = WLog_Get("com.winpr.test.synch");
+
+	InitializeCriticalSection(&statsCritical);
+
+	if (!winpr_critical_section_set_name(&statsCritical, TEST_SYNC_CRITICAL_STATS_NAME))
+	{
+		printf("CriticalSection failure: winpr_critical_section_set_name failed\n");
+		return FALSE;
+	}
+
+	/* uncontended, a failed try and a contended acquisition */
+	EnterCriticalSection(&statsCritical);
+	LeaveCriticalSection(&statsCritical);
+
+	if (!TestSynchCritical_StatsThread(TestSynchCritical_StatsTryEnter, FALSE) ||
+	    !TestSynchCritical_StatsThread(TestSynchCritical_StatsEnter, TRUE))
+	{
+		printf("CriticalSection failure: statistics threads failed\n");
+		return FALSE;
+	}
+
+	DeleteCriticalSection(&statsCritical);
+
+	callbacks.message = TestSynchCritical_StatsMessage;
+	WLog_SetLogAppenderType(root, WLOG_APPENDER_CALLBACK);
+
+	if (!WLog_ConfigureAppender(WLog_GetLogAppender(root), "callbacks", &callbacks))
+		return FALSE;
+
+	WLog_SetLogLevel(log, WLOG_INFO);
+	winpr_critical_section_log_stats("com.winpr.test.synch", WLOG_INFO);
+	WLog_SetLogAppenderType(root, WLOG_APPENDER_CONSOLE);
+
+	if (sscanf(statsReport,
+	           TEST_SYNC_CRITICAL_STATS_NAME ": sections=%" SCNd64 " acquired=%" SCNd64
+	                                         " contended=%" SCNd64 " tryfailed=%" SCNd64,
+	           &sections, &acquired, &contended, &tryFailed) != 4)
+	{
+		printf("CriticalSection failure: no statistics for %s\n", TEST_SYNC_CRITICAL_STATS_NAME);
+		return FALSE;
+	}
+
+	/* the deleted section still counts, the records outlive their sections */
+	if ((sections != 1) || (acquired != 4) || (contended != 1) || (tryFailed != 1))
+	{
+		printf("CriticalSection failure: unexpected statistics '%s'\n", statsReport);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+#endif
+
 int TestSynchCritical(int argc, char* argv[])
 {
 	BOOL bThreadTerminated = FALSE;
@@ -319,6 +441,12 @@ int TestSynchCritical(int argc, char* argv[])
 	WINPR_UNUSED(argc);
 	WINPR_UNUSED(argv);
 
+#if defined(WITH_CRITICAL_SECTION_STATS) && !defined(_WIN32)
+	if (!SetEnvironmentVariableA("WINPR_CRITICAL_SECTION_STATS", "0") ||
+	    !TestSynchCritical_Stats())
+		return -1;
+#endif
+
 	dwDeadLockDetectionTimeMs =
 	    2 * TEST_SYNC_CRITICAL_TEST1_RUNTIME_MS * TEST_SYNC_CRITICAL_TEST1_RUNS;
 
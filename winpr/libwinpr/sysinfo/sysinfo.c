@@ -852,6 +852,28 @@ DWORD GetTickCountPrecise(void)
 #endif
 }
 
+UINT64 winpr_GetTickCount64NS(void)
+{
+#ifdef _WIN32
+	LARGE_INTEGER freq;
+	LARGE_INTEGER current;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&current);
+	return (UINT64)(current.QuadPart / freq.QuadPart) * 1000000000ULL +
+	       (UINT64)(current.QuadPart % freq.QuadPart) * 1000000000ULL / (UINT64)freq.QuadPart;
+#else
+	struct timespec ts = { 0 };
+#if defined(__linux__)
+	if (clock_gettime(CLOCK_MONOTONIC_RAW, &ts) != 0)
+		return 0;
+#else
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+		return 0;
+#endif
+	return (UINT64)ts.tv_sec * 1000000000ULL + (UINT64)ts.tv_nsec;
+#endif
+}
+
 BOOL IsProcessorFeaturePresentEx(DWORD ProcessorFeature)
 {
 	BOOL ret = FALSE;
@@ -779,6 +779,7 @@ wHashTable* HashTable_New(BOOL synchronized)
 
 	table->synchronized = synchronized;
 	InitializeCriticalSectionAndSpinCount(&(table->lock), 4000);
+	winpr_critical_section_set_name(&(table->lock), "HashTable");
 	table->numOfBuckets = 64;
 	table->numOfElements = 0;
 	table->bucketArray = (wKeyValuePair**)calloc(table->numOfBuckets, sizeof(wKeyValuePair*));
@@ -245,6 +245,8 @@ wMessageQueue* MessageQueue_New(const wObject* callback)
 	if (!InitializeCriticalSectionAndSpinCount(&queue->lock, 4000))
 		goto fail;
 
+	winpr_critical_section_set_name(&queue->lock, "MessageQueue");
+
 	if (!MessageQueue_EnsureCapacity(queue, 32))
 		goto fail;
 
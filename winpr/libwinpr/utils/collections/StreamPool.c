@@ -377,6 +377,7 @@ wStreamPool* StreamPool_New(BOOL synchronized, size_t defaultSize)
 			goto fail;
 
 		InitializeCriticalSectionAndSpinCount(&pool->lock, 4000);
+		winpr_critical_section_set_name(&pool->lock, "StreamPool");
 	}
 
 	return pool;
@@ -145,6 +145,7 @@ static wLogAppender* WLog_Appender_New(wLog* log, DWORD logAppenderType)
 	}
 
 	InitializeCriticalSectionAndSpinCount(&appender->lock, 4000);
+	winpr_critical_section_set_name(&appender->lock, "wLogAppender");
 
 	return appender;
 }
@@ -907,6 +907,7 @@ wLog* WLog_New(LPCSTR name, wLog* rootLogger)
 	}
 
 	InitializeCriticalSectionAndSpinCount(&log->lock, 4000);
+	winpr_critical_section_set_name(&log->lock, "wLog");
 
 	return log;
 out_fail: